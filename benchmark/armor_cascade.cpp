@@ -0,0 +1,126 @@
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include <opencv2/core.hpp>
+#include <opencv2/videoio.hpp>
+#include <glog/logging.h>
+#include "detector-armor/detector_armor.h"
+#include "detector-armor/detector_armor_cascade.h"
+#include "detector-armor/detector_armor_decoder.h"
+
+constexpr float kMatchIouThreshold = 0.5;  ///< Min IoU of a cascade box matching a reference box.
+
+/// \brief Cascade policies to compare.
+const std::vector<std::pair<std::string, ArmorCascade::Policy>> kPolicies = {
+        {"skip empty, verify in ROI", {true, 2.f, 3.f, 0.5f}},
+        {"skip empty, verify in full frame", {true, 2.f, 3.f, 0.f}},
+        {"verify in ROI without skipping", {false, 2.f, 3.f, 0.5f}},
+        {"skip empty, accept confident proposals", {true, 0.8f, 3.f, 0.5f}},
+};
+
+/// \brief Statistics of a policy against armor detector.
+struct PolicyStatistics {
+    uint64_t matched = 0;  ///< Number of matched reference boxes.
+    uint64_t boxes = 0;    ///< Number of cascade boxes.
+};
+
+/// \brief Count reference boxes matched by cascade boxes with the same color.
+uint64_t Match(const std::vector<bbox_t> &boxes, const std::vector<bbox_t> &references) {
+    std::vector<bool> used(boxes.size(), false);
+    uint64_t matched = 0;
+    for (const auto &reference: references)
+        for (size_t i = 0; i < boxes.size(); ++i)
+            if (!used[i] && boxes[i].color == reference.color
+                && ArmorDecoder::QuadIoU(boxes[i].points, reference.points) > kMatchIouThreshold) {
+                used[i] = true;
+                ++matched;
+                break;
+            }
+    return matched;
+}
+
+int main(int argc, char *argv[]) {
+    google::InitGoogleLogging(argv[0]);
+    const std::string model_file = argc > 1 ? argv[1] : "../assets/models/armor_detector_model.onnx";
+    const std::string config_file = argc > 2 ? argv[2] : "../config/sentry/light-bar-param.yaml";
+    std::vector<std::string> video_files;
+    for (int i = 3; i < argc; ++i)
+        video_files.emplace_back(argv[i]);
+    if (video_files.empty())
+        video_files = {"../assets/armor_blue_24.avi", "../assets/one_armor.mkv", "../assets/rune_red.mp4"};
+
+    printf("Benchmark for two-stage armor detector cascade, against armor detector on every frame.\n");
+    printf("Usage: %s [model file] [light-bar config file] [video files...]\n", argv[0]);
+    printf("================================================\n");
+
+    ArmorDetector detector;
+    if (!detector.Initialize(model_file)) {
+        printf("Failed to initialize armor detector.\n");
+        return 1;
+    }
+    LightBarDetector light_bar_detector;
+    if (!light_bar_detector.Initialize(config_file)) {
+        printf("Failed to initialize light-bar detector.\n");
+        return 1;
+    }
+    std::vector<std::unique_ptr<ArmorCascade>> cascades;
+    for (const auto &policy: kPolicies) {
+        cascades.emplace_back(std::make_unique<ArmorCascade>());
+        cascades.back()->Initialize(policy.second, light_bar_detector.GetParameters());
+    }
+
+    std::vector<PolicyStatistics> statistics(kPolicies.size());
+    std::vector<bbox_t> references, boxes;
+    uint64_t num_frames = 0, num_references = 0;
+    double detection_time = 0;
+    for (const auto &video_file: video_files) {
+        cv::VideoCapture video(video_file);
+        if (!video.isOpened()) {
+            printf("Failed to open video %s.\n", video_file.c_str());
+            continue;
+        }
+        cv::Mat image;
+        while (video.read(image)) {
+            Frame frame(image, num_frames++);
+            const auto start_time = std::chrono::steady_clock::now();
+            detector(frame, references);
+            detection_time += std::chrono::duration<double, std::milli>(
+                    std::chrono::steady_clock::now() - start_time).count();
+            num_references += references.size();
+
+            for (size_t i = 0; i < cascades.size(); ++i) {
+                (*cascades[i])(detector, frame, boxes);
+                statistics[i].matched += Match(boxes, references);
+                statistics[i].boxes += boxes.size();
+            }
+        }
+    }
+    if (!num_frames) {
+        printf("No frame is replayed.\n");
+        return 1;
+    }
+
+    printf("Replayed %lu frames with %lu reference boxes.\n", (unsigned long) num_frames,
+           (unsigned long) num_references);
+    printf("Armor detector only: %lf ms per frame.\n", detection_time / double(num_frames));
+    printf("================================================\n");
+    for (size_t i = 0; i < cascades.size(); ++i) {
+        const auto cascade_statistics = cascades[i]->GetStatistics();
+        printf("Policy: %s.\n", kPolicies[i].first.c_str());
+        printf("Decisions:");
+        for (int decision = 0; decision < ArmorCascade::SIZE; ++decision)
+            printf(" %s %lf%%", ArmorCascade::DecisionName(ArmorCascade::Decisions(decision)),
+                   100. * double(cascade_statistics.decisions[decision]) / double(num_frames));
+        printf(".\n");
+        printf("Latency: %lf ms per frame, light-bar detector %lf ms, armor detector %lf ms.\n",
+               cascade_statistics.average_time, cascade_statistics.average_proposal_time,
+               cascade_statistics.average_detection_time);
+        printf("Boxes: %lu, recall: %lf%%.\n", (unsigned long) statistics[i].boxes,
+               num_references ? 100. * double(statistics[i].matched) / double(num_references) : 0.);
+        printf("------------------------------------------------\n");
+    }
+    return 0;
+}
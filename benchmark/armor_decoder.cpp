@@ -0,0 +1,158 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <vector>
+#include <opencv2/core.hpp>
+#include "detector-armor/detector_armor_decoder.h"
+
+const int kTopkNum = ArmorDecoder::kTopkNum;
+const int kBoxSize = ArmorDecoder::kBoxSize;
+const int kTensorSize = kTopkNum * kBoxSize;
+const int kSyntheticTensors = 256;
+const int kRepeats = 100;
+
+/**
+ * \brief Load top-k tensors dumped by srm-vision with --detector_dump flag.
+ * \return All tensors in a continuous buffer.
+ */
+std::vector<float> LoadTensors(const char *file_path) {
+    std::ifstream file(file_path, std::ios::binary | std::ios::ate);
+    if (!file)
+        return {};
+    const auto size = size_t(file.tellg()) / (kTensorSize * sizeof(float)) * kTensorSize;
+    std::vector<float> tensors(size);
+    file.seekg(0);
+    file.read((char *) tensors.data(), std::streamsize(size * sizeof(float)));
+    return tensors;
+}
+
+/// \brief Generate top-k tensors with several armors, each detected by a cluster of duplicated boxes.
+std::vector<float> SyntheticTensors() {
+    std::vector<float> tensors(size_t(kSyntheticTensors) * kTensorSize);
+    cv::RNG rng(0x5f3759df);
+    for (int t = 0; t < kSyntheticTensors; ++t) {
+        float *tensor = tensors.data() + size_t(t) * kTensorSize;
+        const int num_armors = rng.uniform(1, 5);
+        std::vector<float> confidences(kTopkNum);
+        for (auto &confidence: confidences)
+            confidence = float(rng.gaussian(3)) - 4;
+        std::sort(confidences.rbegin(), confidences.rend());
+        for (int i = 0; i < kTopkNum; ++i) {
+            float *box = tensor + i * kBoxSize;
+            const int armor = i % num_armors;
+            const float center_x = 100.f + 120.f * float(armor) + float(rng.gaussian(2));
+            const float center_y = 150.f + 40.f * float(armor) + float(rng.gaussian(2));
+            const float width = 24.f + float(rng.gaussian(1)), height = 10.f + float(rng.gaussian(1));
+            const float corners[8] = {-1, -1, -1, 1, 1, 1, 1, -1};
+            for (int k = 0; k < 4; ++k) {
+                box[2 * k] = center_x + corners[2 * k] * width / 2;
+                box[2 * k + 1] = center_y + corners[2 * k + 1] * height / 2;
+            }
+            box[8] = confidences[i];
+            for (int k = 9; k < kBoxSize; ++k)
+                box[k] = float(rng.gaussian(1));
+        }
+    }
+    return tensors;
+}
+
+inline float InvSigmoid(float x) { return -std::log(1 / x - 1); }
+
+inline int ArgMax(const float *ptr, int len) {
+    int arg_max = 0;
+    for (int i = 1; i < len; ++i)
+        if (ptr[i] > ptr[arg_max])
+            arg_max = i;
+    return arg_max;
+}
+
+inline cv::Rect2f BoundingRect(const float points[8]) {
+    const float min_x = std::min({points[0], points[2], points[4], points[6]});
+    const float min_y = std::min({points[1], points[3], points[5], points[7]});
+    const float max_x = std::max({points[0], points[2], points[4], points[6]});
+    const float max_y = std::max({points[1], points[3], points[5], points[7]});
+    return {min_x, min_y, max_x - min_x, max_y - min_y};
+}
+
+/// \brief Previous post-processing, box by box with AABB overlap suppression.
+std::vector<bbox_t> ReferenceDecode(const float *output_topk, float fx, float fy) {
+    std::vector<bbox_t> result;
+    result.reserve(kTopkNum);
+    std::vector<uint8_t> removed(kTopkNum);
+    for (int i = 0; i < kTopkNum; ++i) {
+        auto *box_buffer = output_topk + i * kBoxSize;
+        if (box_buffer[8] < InvSigmoid(0.1f))
+            break;
+        else if (removed[i])
+            continue;
+        result.emplace_back();
+        auto &box = result.back();
+        memcpy(&box.points, box_buffer, 8 * sizeof(float));
+        for (auto &point: box.points)
+            point.x *= fx, point.y *= fy;
+        box.confidence = 1 / (1 + std::exp(-box_buffer[8]));
+        box.color = ArgMax(box_buffer + 9, 4);
+        box.id = ArgMax(box_buffer + 13, 7);
+        for (int j = i + 1; j < kTopkNum; ++j) {
+            auto *box2_buffer = output_topk + j * kBoxSize;
+            if (box2_buffer[8] < InvSigmoid(0.1f))
+                break;
+            else if (removed[j])
+                continue;
+            if ((BoundingRect(box_buffer) & BoundingRect(box2_buffer)).area() > 0)
+                removed[j] = true;
+        }
+    }
+    return result;
+}
+
+int main(int argc, char *argv[]) {
+    std::vector<float> tensors;
+    if (argc > 1)
+        tensors = LoadTensors(argv[1]);
+    const bool captured = !tensors.empty();
+    if (!captured)
+        tensors = SyntheticTensors();
+    const size_t num_tensors = tensors.size() / kTensorSize;
+    const float fx = 2.f, fy = 1024.f / 384.f;
+
+    printf("Benchmark for armor detector decoder. Based on %zu %s top-k tensors repeated %d times.\n",
+           num_tensors, captured ? "captured" : "synthetic", kRepeats);
+    printf("Pass a file dumped by --detector_dump flag as the first argument to use captured tensors.\n");
+    printf("================================================\n");
+
+    size_t total_boxes = 0;
+    {
+        printf("Testing previous decoder with AABB overlap suppression:\n");
+        auto start_time = std::chrono::steady_clock::now();
+        for (int r = 0; r < kRepeats; ++r)
+            for (size_t t = 0; t < num_tensors; ++t)
+                total_boxes += ReferenceDecode(tensors.data() + t * kTensorSize, fx, fy).size();
+        auto time = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start_time).count();
+        printf("Average time: %lf us.\n", time / double(kRepeats * num_tensors));
+        printf("Average boxes: %lf.\n", double(total_boxes) / double(kRepeats * num_tensors));
+        printf("------------------------------------------------\n");
+    }
+
+    for (float iou_threshold: {0.f, ArmorDecoder::kDefaultIouThreshold}) {
+        printf("Testing SoA decoder with quadrilateral IoU threshold %f:\n", iou_threshold);
+        ArmorDecoder decoder(ArmorDecoder::kDefaultKeepThreshold, iou_threshold);
+        std::vector<bbox_t> boxes;
+        total_boxes = 0;
+        auto start_time = std::chrono::steady_clock::now();
+        for (int r = 0; r < kRepeats; ++r)
+            for (size_t t = 0; t < num_tensors; ++t) {
+                decoder.Decode(tensors.data() + t * kTensorSize, fx, fy, boxes);
+                total_boxes += boxes.size();
+            }
+        auto time = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start_time).count();
+        printf("Average time: %lf us.\n", time / double(kRepeats * num_tensors));
+        printf("Average boxes: %lf.\n", double(total_boxes) / double(kRepeats * num_tensors));
+        printf("------------------------------------------------\n");
+    }
+
+    return 0;
+}
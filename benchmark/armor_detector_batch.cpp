@@ -0,0 +1,65 @@
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <opencv2/core.hpp>
+#include <glog/logging.h>
+#include "detector-armor/detector_armor.h"
+
+const int kNumImages = 8;
+const int kRepeats = 20;
+const int kMaxBatchSizes[] = {1, 2, 4, 8};
+
+int main(int argc, char *argv[]) {
+    google::InitGoogleLogging(argv[0]);
+    const std::string model_file = argc > 1 ? argv[1] : "../assets/models/armor_detector_model.onnx";
+    const std::string backend_type = argc > 2 ? argv[2] : "";
+
+    printf("Benchmark for batched armor detector. Based on %d images of 1280x1024 repeated %d times.\n",
+           kNumImages, kRepeats);
+    printf("Usage: %s [model file] [backend type]\n", argv[0]);
+    printf("================================================\n");
+
+    ArmorDetector detector;
+    if (!detector.Initialize(model_file, backend_type)) {
+        printf("Failed to initialize armor detector.\n");
+        return 1;
+    }
+
+    std::vector<cv::Mat> images;
+    cv::RNG rng(0x5f3759df);
+    for (int i = 0; i < kNumImages; ++i) {
+        images.emplace_back(1024, 1280, CV_8UC3);
+        rng.fill(images.back(), cv::RNG::UNIFORM, cv::Scalar::all(0), cv::Scalar::all(256));
+    }
+
+    // Warm up.
+    std::vector<bbox_t> boxes;
+    detector(images.front(), boxes);
+
+    {
+        printf("Testing sequential calls:\n");
+        auto start_time = std::chrono::steady_clock::now();
+        for (int r = 0; r < kRepeats; ++r)
+            for (const auto &image: images)
+                detector(image, boxes);
+        auto time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+        printf("Throughput: %lf images per second.\n", kRepeats * kNumImages / time);
+        printf("------------------------------------------------\n");
+    }
+
+    for (auto max_batch_size: kMaxBatchSizes) {
+        detector.SetMaxBatchSize(max_batch_size);
+        printf("Testing batched calls with max batch size %d (%d used by backend):\n",
+               max_batch_size, detector.MaxBatchSize());
+        std::vector<std::vector<bbox_t>> batch_boxes;
+        auto start_time = std::chrono::steady_clock::now();
+        for (int r = 0; r < kRepeats; ++r)
+            detector(images, batch_boxes);
+        auto time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+        printf("Throughput: %lf images per second.\n", kRepeats * kNumImages / time);
+        printf("------------------------------------------------\n");
+    }
+
+    return 0;
+}
@@ -0,0 +1,155 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <opencv2/core.hpp>
+#include <opencv2/videoio.hpp>
+#include <glog/logging.h>
+#include "detector-armor/detector_armor.h"
+#include "detector-armor/detector_armor_decoder.h"
+
+constexpr float kMatchIouThreshold = 0.5;      ///< Min IoU of matched boxes of fp32 and INT8 models.
+constexpr double kDefaultMinAgreement = 0.95;  ///< Default min precision and recall against fp32 model.
+
+/// \brief Accumulated comparison of INT8 boxes against fp32 boxes.
+struct Comparison {
+    uint64_t num_frames = 0;       ///< Number of replayed frames.
+    uint64_t reference_boxes = 0;  ///< Number of fp32 boxes.
+    uint64_t boxes = 0;            ///< Number of INT8 boxes.
+    uint64_t matched = 0;          ///< Number of matched boxes with the same color and id.
+    double corner_error = 0;       ///< Total mean corner distance of matched boxes in pixels.
+    double confidence_error = 0;   ///< Total absolute confidence difference of matched boxes.
+    double reference_time = 0;     ///< Total fp32 inference time in milliseconds.
+    double time = 0;               ///< Total INT8 inference time in milliseconds.
+};
+
+/**
+ * \brief Greedily match INT8 boxes to fp32 boxes with the same color and id.
+ * \param [in] boxes Boxes of INT8 model.
+ * \param [in] references Boxes of fp32 model.
+ * \param [in,out] comparison Accumulated comparison.
+ */
+void Match(const std::vector<bbox_t> &boxes, const std::vector<bbox_t> &references, Comparison &comparison) {
+    std::vector<bool> used(references.size(), false);
+    for (const auto &box: boxes) {
+        int best = -1;
+        float best_iou = kMatchIouThreshold;
+        for (size_t i = 0; i < references.size(); ++i) {
+            if (used[i] || references[i].color != box.color || references[i].id != box.id)
+                continue;
+            const float iou = ArmorDecoder::QuadIoU(box.points, references[i].points);
+            if (iou > best_iou)
+                best = int(i), best_iou = iou;
+        }
+        if (best < 0)
+            continue;
+        used[best] = true;
+        ++comparison.matched;
+        double distance = 0;
+        for (int j = 0; j < 4; ++j)
+            distance += cv::norm(box.points[j] - references[best].points[j]);
+        comparison.corner_error += distance / 4;
+        comparison.confidence_error += std::abs(box.confidence - references[best].confidence);
+    }
+    comparison.boxes += boxes.size();
+    comparison.reference_boxes += references.size();
+}
+
+/// \brief Replay a video with fp32 and INT8 models.
+void Replay(const std::string &video_file, ArmorDetector &reference_detector, ArmorDetector &detector,
+            Comparison &comparison) {
+    cv::VideoCapture video(video_file);
+    if (!video.isOpened()) {
+        printf("Failed to open video %s.\n", video_file.c_str());
+        return;
+    }
+
+    std::vector<bbox_t> references, boxes;
+    cv::Mat image;
+    while (video.read(image)) {
+        Frame frame(image, comparison.num_frames++);
+        auto start_time = std::chrono::steady_clock::now();
+        reference_detector(frame, references);
+        comparison.reference_time += std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - start_time).count();
+
+        start_time = std::chrono::steady_clock::now();
+        detector(frame, boxes);
+        comparison.time += std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - start_time).count();
+        Match(boxes, references, comparison);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    google::InitGoogleLogging(argv[0]);
+    const std::string model_file = argc > 1 ? argv[1] : "../assets/models/armor_detector_model.onnx";
+    const double min_agreement = argc > 2 ? std::atof(argv[2]) : kDefaultMinAgreement;
+    std::vector<std::string> video_files;
+    for (int i = 3; i < argc; ++i)
+        video_files.emplace_back(argv[i]);
+    if (video_files.empty())
+        video_files = {"../assets/armor_blue_24.avi", "../assets/one_armor.mkv"};
+
+    printf("Benchmark for INT8 quantized armor detector, with accuracy regression check against fp32 model.\n");
+    printf("Usage: %s [model file] [min precision and recall] [video files...]\n", argv[0]);
+    printf("================================================\n");
+
+    ArmorDetector reference_detector, detector;
+    if (!reference_detector.Initialize(model_file, "opencv")) {
+        printf("Failed to initialize fp32 armor detector.\n");
+        return 1;
+    }
+    if (!detector.Initialize(model_file, "opencv-int8")) {
+        printf("Failed to initialize INT8 armor detector, run tool-armor-detector-calibration first.\n");
+        return 1;
+    }
+
+    Comparison total;
+    for (const auto &video_file: video_files) {
+        Comparison comparison;
+        Replay(video_file, reference_detector, detector, comparison);
+        if (!comparison.num_frames)
+            continue;
+        printf("Replayed %s with %lu frames.\n", video_file.c_str(), (unsigned long) comparison.num_frames);
+        printf("fp32: %lf ms per frame, INT8: %lf ms per frame, speedup: %lfx.\n",
+               comparison.reference_time / double(comparison.num_frames),
+               comparison.time / double(comparison.num_frames),
+               comparison.time > 0 ? comparison.reference_time / comparison.time : 0.);
+        printf("------------------------------------------------\n");
+        total.num_frames += comparison.num_frames;
+        total.reference_boxes += comparison.reference_boxes;
+        total.boxes += comparison.boxes;
+        total.matched += comparison.matched;
+        total.corner_error += comparison.corner_error;
+        total.confidence_error += comparison.confidence_error;
+        total.reference_time += comparison.reference_time;
+        total.time += comparison.time;
+    }
+    if (!total.num_frames) {
+        printf("No frame is replayed.\n");
+        return 1;
+    }
+
+    const double precision = total.boxes ? double(total.matched) / double(total.boxes) : 1;
+    const double recall = total.reference_boxes ? double(total.matched) / double(total.reference_boxes) : 1;
+    printf("================================================\n");
+    printf("Total %lu frames, fp32: %lf ms per frame, INT8: %lf ms per frame, speedup: %lfx.\n",
+           (unsigned long) total.num_frames,
+           total.reference_time / double(total.num_frames), total.time / double(total.num_frames),
+           total.time > 0 ? total.reference_time / total.time : 0.);
+    printf("Boxes: %lu of fp32, %lu of INT8, %lu matched with the same color and id.\n",
+           (unsigned long) total.reference_boxes, (unsigned long) total.boxes, (unsigned long) total.matched);
+    printf("Precision: %lf%%, recall: %lf%%, mean corner error: %lf px, mean confidence error: %lf.\n",
+           100 * precision, 100 * recall,
+           total.matched ? total.corner_error / double(total.matched) : 0.,
+           total.matched ? total.confidence_error / double(total.matched) : 0.);
+    if (precision < min_agreement || recall < min_agreement) {
+        printf("Accuracy regression check FAILED, min precision and recall: %lf%%.\n", 100 * min_agreement);
+        return 1;
+    }
+    printf("Accuracy regression check passed, min precision and recall: %lf%%.\n", 100 * min_agreement);
+    return 0;
+}
@@ -0,0 +1,131 @@
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <opencv2/core.hpp>
+#include <opencv2/videoio.hpp>
+#include <glog/logging.h>
+#include "detector-armor/detector_armor.h"
+#include "detector-armor/detector_armor_decoder.h"
+#include "detector-armor/detector_armor_light_bar.h"
+
+constexpr float kMatchIouThreshold = 0.5;  ///< Min IoU of matched boxes of two detectors.
+
+/**
+ * \brief Greedily match boxes of light-bar detector to boxes of armor detector with the same color.
+ * \param [in] boxes Boxes of light-bar detector.
+ * \param [in] references Boxes of armor detector.
+ * \param [out] matched_ids Number of matched boxes with the same id.
+ * \return Number of matched boxes.
+ */
+uint64_t Match(const std::vector<bbox_t> &boxes, const std::vector<bbox_t> &references, uint64_t &matched_ids) {
+    std::vector<bool> used(references.size(), false);
+    uint64_t matched = 0;
+    matched_ids = 0;
+    for (const auto &box: boxes) {
+        int best = -1;
+        float best_iou = kMatchIouThreshold;
+        for (size_t i = 0; i < references.size(); ++i) {
+            if (used[i] || references[i].color != box.color)
+                continue;
+            const float iou = ArmorDecoder::QuadIoU(box.points, references[i].points);
+            if (iou > best_iou)
+                best = int(i), best_iou = iou;
+        }
+        if (best < 0)
+            continue;
+        used[best] = true;
+        ++matched;
+        matched_ids += references[best].id == box.id;
+    }
+    return matched;
+}
+
+/**
+ * \brief Replay a video with armor detector and light-bar detectors.
+ * \details Armor detector is the reference, precision and recall of light-bar detector are measured against it.
+ */
+void Replay(const std::string &video_file, ArmorDetector &detector,
+            LightBarDetector &single_stripe_detector, LightBarDetector &light_bar_detector) {
+    cv::VideoCapture video(video_file);
+    if (!video.isOpened()) {
+        printf("Failed to open video %s.\n", video_file.c_str());
+        return;
+    }
+
+    std::vector<bbox_t> references, boxes;
+    uint64_t num_frames = 0, num_references = 0, num_boxes = 0, matched = 0, matched_ids = 0;
+    double detection_time = 0, single_stripe_time = 0, light_bar_time = 0;
+    cv::Mat image;
+    while (video.read(image)) {
+        Frame frame(image, num_frames++);
+        auto start_time = std::chrono::steady_clock::now();
+        detector(frame, references);
+        detection_time += std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - start_time).count();
+
+        start_time = std::chrono::steady_clock::now();
+        single_stripe_detector(frame, boxes);
+        single_stripe_time += std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - start_time).count();
+
+        start_time = std::chrono::steady_clock::now();
+        light_bar_detector(frame, boxes);
+        light_bar_time += std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - start_time).count();
+
+        uint64_t frame_matched_ids;
+        matched += Match(boxes, references, frame_matched_ids);
+        matched_ids += frame_matched_ids;
+        num_references += references.size();
+        num_boxes += boxes.size();
+    }
+    if (!num_frames) {
+        printf("No frame in video %s.\n", video_file.c_str());
+        return;
+    }
+
+    printf("Replaying %s with %lu frames.\n", video_file.c_str(), (unsigned long) num_frames);
+    printf("------------------------------------------------\n");
+    printf("Armor detector: %lf ms per frame, %lu boxes.\n",
+           detection_time / double(num_frames), (unsigned long) num_references);
+    printf("Light-bar detector: %lf ms per frame in 1 stripe, %lf ms per frame in stripes, %lu boxes.\n",
+           single_stripe_time / double(num_frames), light_bar_time / double(num_frames), (unsigned long) num_boxes);
+    printf("Matched boxes: %lu, with the same id: %lu.\n", (unsigned long) matched, (unsigned long) matched_ids);
+    printf("Precision: %lf%%, recall: %lf%%.\n",
+           num_boxes ? 100. * double(matched) / double(num_boxes) : 0.,
+           num_references ? 100. * double(matched) / double(num_references) : 0.);
+}
+
+int main(int argc, char *argv[]) {
+    google::InitGoogleLogging(argv[0]);
+    const std::string model_file = argc > 1 ? argv[1] : "../assets/models/armor_detector_model.onnx";
+    const std::string config_file = argc > 2 ? argv[2] : "../config/sentry/light-bar-param.yaml";
+    std::vector<std::string> video_files;
+    for (int i = 3; i < argc; ++i)
+        video_files.emplace_back(argv[i]);
+    if (video_files.empty())
+        video_files = {"../assets/armor_blue_24.avi", "../assets/one_armor.mkv"};
+
+    printf("Benchmark for light-bar armor detector.\n");
+    printf("Usage: %s [model file] [config file] [video files...]\n", argv[0]);
+    printf("================================================\n");
+
+    ArmorDetector detector;
+    if (!detector.Initialize(model_file)) {
+        printf("Failed to initialize armor detector.\n");
+        return 1;
+    }
+    LightBarDetector single_stripe_detector, light_bar_detector;
+    if (!single_stripe_detector.Initialize(config_file, 1) || !light_bar_detector.Initialize(config_file)) {
+        printf("Failed to initialize light-bar detector.\n");
+        return 1;
+    }
+    printf("Stripes: %d, IoU threshold of matching: %f.\n", cv::getNumThreads(), kMatchIouThreshold);
+    printf("================================================\n");
+    for (const auto &video_file: video_files) {
+        Replay(video_file, detector, single_stripe_detector, light_bar_detector);
+        printf("================================================\n");
+    }
+    return 0;
+}
@@ -0,0 +1,146 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <utility>
+#include <vector>
+#include <opencv2/core.hpp>
+#include <opencv2/videoio.hpp>
+#include <glog/logging.h>
+#include "detector-armor/detector_armor.h"
+#include "detector-armor/detector_armor_decoder.h"
+#include "detector-armor/detector_armor_tiler.h"
+
+constexpr float kMatchIouThreshold = 0.5;  ///< Min IoU of a detected box matching a reference box.
+constexpr int kDefaultCanvasScale = 2;     ///< Default size of simulated high resolution frame relative to video.
+
+/// \brief Tiling layouts to compare, the first one is the whole frame without tiling.
+const std::vector<std::pair<std::string, ArmorTiler::Layout>> kLayouts = {
+        {"whole frame", {}},
+        {"scale 1.0, overlap 64, with whole frame", {1.f, 64, true, 0.3f}},
+        {"scale 1.0, overlap 64, tiles only", {1.f, 64, false, 0.3f}},
+        {"scale 1.5, overlap 96, with whole frame", {1.5f, 96, true, 0.3f}},
+        {"scale 2.0, overlap 128, with whole frame", {2.f, 128, true, 0.3f}},
+};
+
+/// \brief Statistics of a tiling layout.
+struct LayoutStatistics {
+    uint64_t matched = 0;  ///< Number of matched reference boxes.
+    uint64_t boxes = 0;    ///< Number of detected boxes.
+    double time = 0;       ///< Total detection time in milliseconds.
+};
+
+/// \brief Count reference boxes matched by detected boxes with the same color.
+uint64_t Match(const std::vector<bbox_t> &boxes, const std::vector<bbox_t> &references) {
+    std::vector<bool> used(boxes.size(), false);
+    uint64_t matched = 0;
+    for (const auto &reference: references)
+        for (size_t i = 0; i < boxes.size(); ++i)
+            if (!used[i] && boxes[i].color == reference.color
+                && ArmorDecoder::QuadIoU(boxes[i].points, reference.points) > kMatchIouThreshold) {
+                used[i] = true;
+                ++matched;
+                break;
+            }
+    return matched;
+}
+
+/**
+ * \brief Replay a video as far targets in high resolution frames.
+ * \details Each video frame is placed at the center of a black canvas canvas_scale times its size,
+ *   which is what a higher resolution sensor sees. Boxes detected in the original frame are references,
+ *   since targets keep their pixels in the canvas but shrink canvas_scale times more in whole frame detection.
+ */
+void Replay(const std::string &video_file, int canvas_scale, ArmorDetector &detector,
+            std::vector<LayoutStatistics> &statistics, uint64_t &num_frames, uint64_t &num_references,
+            cv::Size &canvas_size) {
+    cv::VideoCapture video(video_file);
+    if (!video.isOpened()) {
+        printf("Failed to open video %s.\n", video_file.c_str());
+        return;
+    }
+
+    ArmorTiler tiler;
+    std::vector<bbox_t> references, boxes;
+    cv::Mat image, canvas;
+    while (video.read(image)) {
+        ++num_frames;
+        detector(image, references);
+        const cv::Point offset((canvas_scale - 1) * image.cols / 2, (canvas_scale - 1) * image.rows / 2);
+        for (auto &reference: references)
+            for (auto &point: reference.points)
+                point.x += (float) offset.x, point.y += (float) offset.y;
+        num_references += references.size();
+
+        canvas.create(image.rows * canvas_scale, image.cols * canvas_scale, CV_8UC3);
+        canvas_size = canvas.size();
+        canvas.setTo(cv::Scalar::all(0));
+        image.copyTo(canvas({offset, image.size()}));
+
+        for (size_t i = 0; i < kLayouts.size(); ++i) {
+            const auto start_time = std::chrono::steady_clock::now();
+            if (i == 0)
+                detector(canvas, boxes);
+            else {
+                tiler.Initialize(kLayouts[i].second);
+                tiler(detector, canvas, boxes);
+            }
+            statistics[i].time += std::chrono::duration<double, std::milli>(
+                    std::chrono::steady_clock::now() - start_time).count();
+            statistics[i].matched += Match(boxes, references);
+            statistics[i].boxes += boxes.size();
+        }
+    }
+}
+
+int main(int argc, char *argv[]) {
+    google::InitGoogleLogging(argv[0]);
+    const std::string model_file = argc > 1 ? argv[1] : "../assets/models/armor_detector_model.onnx";
+    const int canvas_scale = std::max(argc > 2 ? std::atoi(argv[2]) : kDefaultCanvasScale, 1);
+    std::vector<std::string> video_files;
+    for (int i = 3; i < argc; ++i)
+        video_files.emplace_back(argv[i]);
+    if (video_files.empty())
+        video_files = {"../assets/armor_blue_24.avi", "../assets/one_armor.mkv"};
+
+    printf("Benchmark for tiled armor detection. Based on video frames placed in %dx larger canvases.\n",
+           canvas_scale);
+    printf("Usage: %s [model file] [canvas scale] [video files...]\n", argv[0]);
+    printf("================================================\n");
+
+    ArmorDetector detector;
+    if (!detector.Initialize(model_file)) {
+        printf("Failed to initialize armor detector.\n");
+        return 1;
+    }
+
+    std::vector<LayoutStatistics> statistics(kLayouts.size());
+    uint64_t num_frames = 0, num_references = 0;
+    cv::Size canvas_size;
+    for (const auto &video_file: video_files)
+        Replay(video_file, canvas_scale, detector, statistics, num_frames, num_references, canvas_size);
+    if (!num_frames) {
+        printf("No frame is replayed.\n");
+        return 1;
+    }
+    printf("Replayed %lu frames with %lu reference boxes.\n", (unsigned long) num_frames,
+           (unsigned long) num_references);
+    printf("================================================\n");
+
+    std::vector<cv::Rect> tiles;
+    for (size_t i = 0; i < kLayouts.size(); ++i) {
+        printf("Layout: %s", kLayouts[i].first.c_str());
+        if (i > 0) {
+            ArmorTiler::Split(canvas_size, kLayouts[i].second, tiles);
+            printf(", %lu tiles for %dx%d frames", (unsigned long) tiles.size(), canvas_size.width,
+                   canvas_size.height);
+        }
+        printf(".\n");
+        printf("Latency: %lf ms per frame, boxes: %lu, recall: %lf%%.\n",
+               statistics[i].time / double(num_frames), (unsigned long) statistics[i].boxes,
+               num_references ? 100. * double(statistics[i].matched) / double(num_references) : 0.);
+        printf("------------------------------------------------\n");
+    }
+    return 0;
+}
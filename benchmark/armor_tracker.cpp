@@ -0,0 +1,113 @@
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+#include <opencv2/videoio.hpp>
+#include <glog/logging.h>
+#include "detector-armor/detector_armor.h"
+#include "detector-armor/detector_armor_tracker.h"
+
+const unsigned int kMaxIntervals[] = {2, 4, 8, 16};
+
+/// \brief Accumulated results of a tracker.
+struct TrackerResult {
+    explicit TrackerResult(unsigned int max_interval) : tracker(max_interval) {}
+
+    ArmorTracker tracker;
+    std::vector<bbox_t> boxes;
+    double total_time = 0;
+    double drift = 0;
+    int drift_samples = 0;
+    int unmatched_boxes = 0;
+};
+
+/**
+ * \brief Replay a video with full detection and with detect-every-N tracking.
+ * \details Full detection output of every frame is used as reference of tracked boxes,
+ *   and its detection time is reused for detected frames of tracking mode.
+ */
+void Replay(const std::string &video_file, ArmorDetector &detector) {
+    cv::VideoCapture video(video_file);
+    if (!video.isOpened()) {
+        printf("Failed to open video %s.\n", video_file.c_str());
+        return;
+    }
+
+    std::vector<std::unique_ptr<TrackerResult>> results;
+    for (auto max_interval: kMaxIntervals)
+        results.emplace_back(std::make_unique<TrackerResult>(max_interval));
+
+    std::vector<bbox_t> reference;
+    double total_time = 0;
+    size_t num_frames = 0;
+    cv::Mat image;
+    while (video.read(image)) {
+        Frame frame(image.clone(), num_frames++);
+        auto start_time = std::chrono::steady_clock::now();
+        detector(frame, reference);
+        const auto detection_time =
+                std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+        total_time += detection_time;
+
+        for (auto &result: results) {
+            start_time = std::chrono::steady_clock::now();
+            if (result->tracker.Track(frame, result->boxes)) {
+                result->total_time +=
+                        std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+                int matched;
+                const auto drift = ArmorTracker::Drift(result->boxes, reference, matched);
+                if (matched) {
+                    result->drift += drift;
+                    ++result->drift_samples;
+                }
+                result->unmatched_boxes += int(result->boxes.size()) - matched;
+            } else {
+                result->tracker.Update(frame, reference);
+                result->total_time +=
+                        std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count()
+                        + detection_time;
+            }
+        }
+    }
+
+    printf("Replaying %s with %zu frames.\n", video_file.c_str(), num_frames);
+    printf("------------------------------------------------\n");
+    printf("Full detection: %lf fps.\n", double(num_frames) / total_time);
+    printf("------------------------------------------------\n");
+    for (const auto &result: results) {
+        const auto statistics = result->tracker.GetStatistics();
+        printf("Tracking with max interval %u:\n", result->tracker.MaxInterval());
+        printf("Effective speed: %lf fps.\n", double(num_frames) / result->total_time);
+        printf("Detected frames: %lu, tracked frames: %lu.\n",
+               (unsigned long) statistics.detected_frames, (unsigned long) statistics.tracked_frames);
+        printf("Average drift against full detection: %lf px, unmatched tracked boxes: %d.\n",
+               result->drift_samples ? result->drift / result->drift_samples : 0., result->unmatched_boxes);
+        printf("------------------------------------------------\n");
+    }
+}
+
+int main(int argc, char *argv[]) {
+    google::InitGoogleLogging(argv[0]);
+    const std::string model_file = argc > 1 ? argv[1] : "../assets/models/armor_detector_model.onnx";
+    std::vector<std::string> video_files;
+    for (int i = 2; i < argc; ++i)
+        video_files.emplace_back(argv[i]);
+    if (video_files.empty())
+        video_files = {"../assets/armor_blue_24.avi", "../assets/one_armor.mkv"};
+
+    printf("Benchmark for armor tracker between detections.\n");
+    printf("Usage: %s [model file] [video files...]\n", argv[0]);
+    printf("================================================\n");
+
+    ArmorDetector detector;
+    if (!detector.Initialize(model_file)) {
+        printf("Failed to initialize armor detector.\n");
+        return 1;
+    }
+    for (const auto &video_file: video_files) {
+        Replay(video_file, detector);
+        printf("================================================\n");
+    }
+    return 0;
+}
@@ -0,0 +1,124 @@
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "data-structure/buffer.h"
+
+const size_t kElements = 1 << 22;
+const unsigned int kBufferSize = 256;
+
+/// \brief Bounded ring buffer guarded by a single mutex, for reference.
+class MutexBuffer {
+public:
+    bool Push(size_t obj) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (tail_ - head_ == kBufferSize)
+            return false;
+        data_[tail_++ & (kBufferSize - 1)] = obj;
+        return true;
+    }
+
+    bool Pop(size_t &obj) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (head_ == tail_)
+            return false;
+        obj = data_[head_++ & (kBufferSize - 1)];
+        return true;
+    }
+
+private:
+    size_t data_[kBufferSize]{};
+    size_t head_ = 0, tail_ = 0;
+    std::mutex mutex_;
+};
+
+/**
+ * \brief Push all elements with several producers and pop them with one consumer.
+ * \return Time in seconds.
+ */
+template<typename Buffer>
+double Contention(Buffer &buffer, unsigned int producers, size_t &checksum) {
+    auto start_time = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (unsigned int p = 0; p < producers; ++p)
+        threads.emplace_back([&buffer, p, producers] {
+            for (size_t i = p; i < kElements; i += producers)
+                while (!buffer.Push(size_t(i)))
+                    std::this_thread::yield();
+        });
+    checksum = 0;
+    size_t obj;
+    for (size_t received = 0; received < kElements;)
+        if (buffer.Pop(obj)) {
+            checksum += obj;
+            ++received;
+        } else
+            std::this_thread::yield();
+    for (auto &thread: threads)
+        thread.join();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+}
+
+void PrintResult(double time, size_t checksum) {
+    printf("Total time: %lf seconds, %lf M elements per second.\n", time, double(kElements) / time * 1e-6);
+    printf("Checksum: %s.\n", checksum == kElements * (kElements - 1) / 2 ? "passed" : "FAILED");
+    printf("------------------------------------------------\n");
+}
+
+int main([[maybe_unused]] int argc, [[maybe_unused]] char *argv[]) {
+    printf("Benchmark for ring buffers. Based on %u elements and buffer size %u.\n",
+           (unsigned int) kElements, kBufferSize);
+    printf("================================================\n");
+
+    size_t checksum;
+
+    for (unsigned int producers: {1u, 2u, 4u}) {
+        {
+            printf("Testing mutex guarded buffer with %u producer(s):\n", producers);
+            auto buffer = std::make_unique<MutexBuffer>();
+            auto time = Contention(*buffer, producers, checksum);
+            PrintResult(time, checksum);
+        }
+
+        if (producers == 1) {
+            printf("Testing SPSC buffer:\n");
+            auto buffer = std::make_unique<SPSCBuffer<size_t, kBufferSize, BufferPolicy::kReject>>();
+            auto time = Contention(*buffer, producers, checksum);
+            PrintResult(time, checksum);
+        }
+
+        {
+            printf("Testing MPSC buffer with %u producer(s):\n", producers);
+            auto buffer = std::make_unique<MPSCBuffer<size_t, kBufferSize, BufferPolicy::kReject>>();
+            auto time = Contention(*buffer, producers, checksum);
+            PrintResult(time, checksum);
+        }
+    }
+
+    {
+        printf("Testing SPSC buffer keeping the latest elements with a waiting consumer:\n");
+        auto buffer = std::make_unique<SPSCBuffer<size_t, 4>>();
+        auto start_time = std::chrono::steady_clock::now();
+        std::thread producer([&buffer] {
+            for (size_t i = 1; i <= kElements; ++i)
+                buffer->Push(size_t(i));
+        });
+        size_t obj = 0, received = 0, last = 0;
+        bool ordered = true;
+        while (last != kElements && buffer->WaitPop(obj, std::chrono::milliseconds(100))) {
+            ordered &= obj > last;
+            last = obj;
+            ++received;
+        }
+        producer.join();
+        auto time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+        printf("Total time: %lf seconds, received %zu, dropped %zu.\n",
+               time, received, (size_t) buffer->Dropped());
+        printf("Order and latest element: %s.\n", ordered && last == kElements ? "passed" : "FAILED");
+        printf("------------------------------------------------\n");
+    }
+
+    return 0;
+}
@@ -0,0 +1,98 @@
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <opencv2/videoio.hpp>
+#include <glog/logging.h>
+#include "detector-armor/detector_armor.h"
+#include "detector-armor/detector_armor_color_gate.h"
+
+/**
+ * \brief Replay a video with and without color gate.
+ * \details Armor detector runs on every frame as reference, a false negative is a frame rejected by gate
+ *   where detector finds any box.
+ */
+void Replay(const std::string &video_file, ArmorDetector &detector, ColorGate &gate) {
+    cv::VideoCapture video(video_file);
+    if (!video.isOpened()) {
+        printf("Failed to open video %s.\n", video_file.c_str());
+        return;
+    }
+
+    std::vector<bbox_t> boxes;
+    uint64_t num_frames = 0, target_frames = 0, rejected_frames = 0, false_negatives = 0;
+    double detection_time = 0, gated_detection_time = 0, gate_time = 0;
+    cv::Mat image;
+    while (video.read(image)) {
+        Frame frame(image, num_frames++);
+        auto start_time = std::chrono::steady_clock::now();
+        const bool passed = gate(frame);
+        gate_time += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_time).count();
+
+        start_time = std::chrono::steady_clock::now();
+        detector(frame, boxes);
+        const auto time = std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - start_time).count();
+        detection_time += time;
+        if (passed)
+            gated_detection_time += time;
+        else
+            ++rejected_frames;
+
+        if (!boxes.empty()) {
+            ++target_frames;
+            false_negatives += !passed;
+        }
+    }
+    if (!num_frames) {
+        printf("No frame in video %s.\n", video_file.c_str());
+        return;
+    }
+
+    printf("Replaying %s with %lu frames, %lu of them with targets.\n",
+           video_file.c_str(), (unsigned long) num_frames, (unsigned long) target_frames);
+    printf("------------------------------------------------\n");
+    printf("Without gate: %lf ms per frame.\n", detection_time / double(num_frames));
+    printf("With gate: %lf ms per frame, gate %lf ms per frame.\n",
+           (gated_detection_time + gate_time) / double(num_frames), gate_time / double(num_frames));
+    printf("Skipped frames: %lu (%lf%%).\n",
+           (unsigned long) rejected_frames, 100. * double(rejected_frames) / double(num_frames));
+    printf("False negatives: %lu (%lf%% of frames with targets).\n", (unsigned long) false_negatives,
+           target_frames ? 100. * double(false_negatives) / double(target_frames) : 0.);
+}
+
+int main(int argc, char *argv[]) {
+    google::InitGoogleLogging(argv[0]);
+    const std::string model_file = argc > 1 ? argv[1] : "../assets/models/armor_detector_model.onnx";
+    const std::string config_file = argc > 2 ? argv[2] : "../config/sentry/color-gate-param.yaml";
+    std::vector<std::string> video_files;
+    for (int i = 3; i < argc; ++i)
+        video_files.emplace_back(argv[i]);
+    if (video_files.empty())
+        video_files = {"../assets/armor_blue_24.avi", "../assets/one_armor.mkv", "../assets/rune_red.mp4"};
+
+    printf("Benchmark for color gate of armor detector.\n");
+    printf("Usage: %s [model file] [config file] [video files...]\n", argv[0]);
+    printf("================================================\n");
+
+    ArmorDetector detector;
+    if (!detector.Initialize(model_file)) {
+        printf("Failed to initialize armor detector.\n");
+        return 1;
+    }
+    ColorGate gate;
+    if (!gate.Initialize(config_file)) {
+        printf("Failed to load color gate config.\n");
+        return 1;
+    }
+    const auto &thresholds = gate.GetThresholds();
+    printf("Color: %d, difference: %d, brightness: %d, min pixels: %d, row step: %d.\n",
+           thresholds.color, thresholds.difference_threshold, thresholds.brightness_threshold,
+           thresholds.min_pixels, thresholds.row_step);
+    printf("================================================\n");
+    for (const auto &video_file: video_files) {
+        Replay(video_file, detector, gate);
+        printf("================================================\n");
+    }
+    return 0;
+}
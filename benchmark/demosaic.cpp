@@ -0,0 +1,113 @@
+#include <chrono>
+#include <cstdio>
+#include <opencv2/imgproc.hpp>
+#include "image-processing/demosaic.h"
+
+const int kWidth = 1280;
+const int kHeight = 1024;
+const int kExperiments = 200;
+const cv::Size kTensorSize(640, 384);
+
+/// \brief Generate a synthetic RGGB Bayer frame with smooth gradients and some noise.
+cv::Mat SyntheticBayer(int bits) {
+    cv::Mat raw(kHeight, kWidth, bits == 8 ? CV_8UC1 : CV_16UC1);
+    cv::RNG rng(0x5f3759df);
+    const int max_value = (1 << bits) - 1;
+    for (int y = 0; y < kHeight; ++y)
+        for (int x = 0; x < kWidth; ++x) {
+            int value = (x * 3 + y * 2 + ((x & 1) + (y & 1)) * 40) % (max_value + 1);
+            value = std::min(max_value, std::max(0, value + int(rng.gaussian(max_value / 64.))));
+            if (bits == 8)
+                raw.at<uint8_t>(y, x) = uint8_t(value);
+            else
+                raw.at<uint16_t>(y, x) = uint16_t(value);
+        }
+    return raw;
+}
+
+template<typename Function>
+double Measure(Function function) {
+    auto start_time = std::chrono::steady_clock::now();
+    for (int i = 0; i < kExperiments; ++i)
+        function();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_time).count()
+           / kExperiments;
+}
+
+/// \return Max channel difference without 1 pixel border.
+double MaxDifference(const cv::Mat &a, const cv::Mat &b) {
+    cv::Rect roi(1, 1, kWidth - 2, kHeight - 2);
+    double max_value;
+    cv::Mat difference;
+    cv::absdiff(a(roi), b(roi), difference);
+    cv::minMaxLoc(difference.reshape(1), nullptr, &max_value);
+    return max_value;
+}
+
+int main([[maybe_unused]] int argc, [[maybe_unused]] char *argv[]) {
+    printf("Benchmark for Bayer demosaic. Based on %d experiments of %dx%d synthetic RGGB frames.\n",
+           kExperiments, kWidth, kHeight);
+    printf("================================================\n");
+
+    for (int bits: {8, 10, 12}) {
+        cv::Mat raw = SyntheticBayer(bits), raw_8, rgb, reference, bgr;
+
+        {
+            printf("Testing RAW%d two-pass path (to 8 bits, OpenCV demosaic to RGB, RGB to BGR):\n", bits);
+            auto time = Measure([&] {
+                if (bits == 8)
+                    raw_8 = raw;
+                else
+                    raw.convertTo(raw_8, CV_8U, 1. / (1 << (bits - 8)));
+                // OpenCV names Bayer patterns by the second row, so sensor RGGB is BayerBG.
+                cv::cvtColor(raw_8, rgb, cv::COLOR_BayerBG2RGB);
+                cv::cvtColor(rgb, reference, cv::COLOR_RGB2BGR);
+            });
+            printf("Average time: %lf ms.\n", time);
+            printf("------------------------------------------------\n");
+        }
+
+        {
+            printf("Testing RAW%d single-pass demosaic:\n", bits);
+            auto time = Measure([&] { demosaic::BayerToBGR(raw, bgr, demosaic::kRGGB, bits); });
+            printf("Average time: %lf ms.\n", time);
+            printf("Max difference from two-pass path: %lf.\n", MaxDifference(bgr, reference));
+            printf("------------------------------------------------\n");
+        }
+
+        {
+            printf("Testing RAW%d multi-threaded single-pass demosaic with %d threads:\n",
+                   bits, cv::getNumThreads());
+            auto time = Measure([&] { demosaic::BayerToBGRParallel(raw, bgr, demosaic::kRGGB, bits); });
+            printf("Average time: %lf ms.\n", time);
+            printf("Max difference from two-pass path: %lf.\n", MaxDifference(bgr, reference));
+            printf("------------------------------------------------\n");
+        }
+
+        cv::Mat tensor_reference, tensor;
+        {
+            printf("Testing RAW%d detector input from BGR (demosaic, to RGB, resize, to float):\n", bits);
+            auto time = Measure([&] {
+                demosaic::BayerToBGRParallel(raw, bgr, demosaic::kRGGB, bits);
+                cv::cvtColor(bgr, tensor_reference, cv::COLOR_BGR2RGB);
+                cv::resize(tensor_reference, tensor_reference, kTensorSize);
+                tensor_reference.convertTo(tensor_reference, CV_32F);
+            });
+            printf("Average time: %lf ms.\n", time);
+            printf("------------------------------------------------\n");
+        }
+
+        {
+            printf("Testing RAW%d detector input directly from Bayer image:\n", bits);
+            auto time = Measure([&] { demosaic::BayerToTensor(raw, tensor, kTensorSize, demosaic::kRGGB, bits); });
+            printf("Average time: %lf ms.\n", time);
+            // Different interpolation, so only a rough similarity is expected.
+            cv::Mat difference;
+            cv::absdiff(tensor, tensor_reference, difference);
+            printf("Mean difference from BGR path: %lf.\n", cv::mean(difference.reshape(1))[0]);
+            printf("------------------------------------------------\n");
+        }
+    }
+
+    return 0;
+}
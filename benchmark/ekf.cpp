@@ -0,0 +1,147 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <vector>
+#include "predictor-armor/ekf.h"
+#include "predictor-armor/ekf_bank.h"
+#include "predictor-armor/predictor_armor.h"
+
+/// \brief Simulated measurements of a target doing uniform linear motion.
+struct Trajectory {
+    std::vector<double> delta_t;
+    std::vector<Eigen::Matrix<double, 3, 1>> y;
+    Eigen::Matrix<double, 5, 1> x_0;
+};
+
+Trajectory GenerateTrajectory(int frames) {
+    std::mt19937 generator(0);
+    std::uniform_real_distribution<double> delta_t(0.005, 0.015);
+    std::normal_distribution<double> noise(0, 0.02);
+    PredictFunction predict;
+    MeasureFunction measure;
+    Trajectory trajectory;
+    trajectory.x_0 << 1, 0.5, 0.2, -0.3, 5;
+    Eigen::Matrix<double, 5, 1> x = trajectory.x_0, x_next;
+    for (int i = 0; i < frames; ++i) {
+        predict.delta_t = delta_t(generator);
+        predict(x.data(), x_next.data());
+        x = x_next;
+        Eigen::Matrix<double, 5, 1> x_measured = x;
+        x_measured[0] += noise(generator);
+        x_measured[2] += noise(generator);
+        x_measured[4] += noise(generator);
+        Eigen::Matrix<double, 3, 1> y;
+        measure(x_measured.data(), y.data());
+        trajectory.delta_t.push_back(predict.delta_t);
+        trajectory.y.push_back(y);
+    }
+    return trajectory;
+}
+
+/// \return Average time of Predict and Update in nanoseconds.
+template<typename Filter, typename Scalar>
+double Run(const Trajectory &trajectory, int runs, double &checksum) {
+    PredictFunction predict;
+    MeasureFunction measure;
+    const auto start_time = std::chrono::steady_clock::now();
+    for (int run = 0; run < runs; ++run) {
+        Filter filter;
+        filter.Initialize(trajectory.x_0.cast<Scalar>());
+        for (size_t i = 0; i < trajectory.y.size(); ++i) {
+            predict.delta_t = trajectory.delta_t[i];
+            filter.Predict(predict);
+            filter.Update(measure, Eigen::Matrix<Scalar, 3, 1>(trajectory.y[i].cast<Scalar>()));
+        }
+        checksum += double(filter.x_estimate_[0]);
+    }
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start_time).count()
+           / (double(runs) * double(trajectory.y.size()));
+}
+
+constexpr unsigned int kFilters = 16;  ///< Number of armors tracked together.
+
+/// \return Average time of stepping kFilters separate analytic filters per frame in nanoseconds.
+template<typename Scalar>
+double RunFilters(const Trajectory &trajectory, int runs, double &checksum) {
+    PredictFunction predict;
+    MeasureFunction measure;
+    const auto start_time = std::chrono::steady_clock::now();
+    for (int run = 0; run < runs; ++run) {
+        std::vector<AnalyticExtendedKalmanFilter<Scalar, 5, 3>> filters(kFilters);
+        for (auto &filter: filters)
+            filter.Initialize(trajectory.x_0.cast<Scalar>());
+        for (size_t i = 0; i < trajectory.y.size(); ++i) {
+            predict.delta_t = trajectory.delta_t[i];
+            const Eigen::Matrix<Scalar, 3, 1> y = trajectory.y[i].cast<Scalar>();
+            for (auto &filter: filters) {
+                filter.Predict(predict);
+                filter.Update(measure, y);
+            }
+        }
+        checksum += double(filters.back().x_estimate_[0]);
+    }
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start_time).count()
+           / (double(runs) * double(trajectory.y.size()));
+}
+
+/// \return Average time of stepping kFilters filters in a bank per frame in nanoseconds.
+template<typename Scalar>
+double RunBank(const Trajectory &trajectory, int runs, double &checksum) {
+    auto bank = std::make_unique<EkfBank<Scalar, kFilters>>();
+    const auto start_time = std::chrono::steady_clock::now();
+    for (int run = 0; run < runs; ++run) {
+        bank->Clear();
+        for (unsigned int j = 0; j < kFilters; ++j)
+            bank->Add(trajectory.x_0.cast<Scalar>());
+        for (size_t i = 0; i < trajectory.y.size(); ++i) {
+            const Eigen::Matrix<Scalar, 3, 1> y = trajectory.y[i].cast<Scalar>();
+            for (unsigned int j = 0; j < kFilters; ++j)
+                bank->SetMeasurement(j, y);
+            bank->Step(Scalar(trajectory.delta_t[i]));
+        }
+        checksum += double(bank->State(kFilters - 1)[0]);
+    }
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start_time).count()
+           / (double(runs) * double(trajectory.y.size()));
+}
+
+int main(int argc, char *argv[]) {
+    const int runs = argc > 1 ? std::max(1, std::atoi(argv[1])) : 1000;
+    const int frames = argc > 2 ? std::max(1, std::atoi(argv[2])) : 1000;
+
+    printf("Benchmark for armor predictor EKF. Based on %d runs of %d frames.\n", runs, frames);
+    printf("Usage: %s [runs] [frames]\n", argv[0]);
+    printf("================================================\n");
+
+    const auto trajectory = GenerateTrajectory(frames);
+    double checksum = 0;
+    const double jet_time = Run<ExtendedKalmanFilter<5, 3>, double>(trajectory, runs, checksum);
+    const double double_time = Run<AnalyticExtendedKalmanFilter<double, 5, 3>, double>(trajectory, runs, checksum);
+    const double float_time = Run<AnalyticExtendedKalmanFilter<float, 5, 3>, float>(trajectory, runs, checksum);
+
+    printf("Predict and update with automatic differentiation: %lf ns\n", jet_time);
+    printf("------------------------------------------------\n");
+    printf("Predict and update with analytic jacobians (double): %lf ns, %.2lfx\n",
+           double_time, jet_time / double_time);
+    printf("Predict and update with analytic jacobians (float): %lf ns, %.2lfx\n",
+           float_time, jet_time / float_time);
+    printf("================================================\n");
+
+    const double filters_double_time = RunFilters<double>(trajectory, runs / 10 + 1, checksum);
+    const double bank_double_time = RunBank<double>(trajectory, runs / 10 + 1, checksum);
+    const double filters_float_time = RunFilters<float>(trajectory, runs / 10 + 1, checksum);
+    const double bank_float_time = RunBank<float>(trajectory, runs / 10 + 1, checksum);
+    printf("Step %u separate analytic filters (double): %lf ns per frame\n", kFilters, filters_double_time);
+    printf("Step %u filters in bank (double): %lf ns per frame, %.2lfx\n",
+           kFilters, bank_double_time, filters_double_time / bank_double_time);
+    printf("------------------------------------------------\n");
+    printf("Step %u separate analytic filters (float): %lf ns per frame\n", kFilters, filters_float_time);
+    printf("Step %u filters in bank (float): %lf ns per frame, %.2lfx\n",
+           kFilters, bank_float_time, filters_float_time / bank_float_time);
+    printf("================================================\n");
+    printf("Checksum: %lf\n", checksum);
+    return 0;
+}
@@ -0,0 +1,164 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+#include <glog/logging.h>
+#include "fsm-base/event.h"
+#include "fsm-base/machine_operation_event.h"
+#include "fsm-base/state.h"
+#include "fsm-base/transition.h"
+#include "fsm-base/transition_predicate.h"
+#include "fsm-base/machine.h"
+#include "fsm-base/machine_set.h"
+
+enum class ToggleEventType {
+    kToggle,
+};
+
+class ToggleEvent : public fsm::EventTemplate<ToggleEventType> {
+public:
+    using underlying_type = std::underlying_type<ToggleEventType>::type;
+
+    explicit ToggleEvent(const fsm::MachineBaseSharedPtr &machine)
+            : fsm::EventTemplate<ToggleEventType>(ToggleEventType::kToggle, machine) {}
+
+    std::ostream &ToStream(std::ostream &str) const override {
+        return str << "ToggleEvent | " << static_cast<underlying_type>(type_);
+    }
+
+    [[nodiscard]] std::string ToString() const override { return "ToggleEvent"; }
+};
+
+/// \brief Machine of two states toggled by every event, like armor machine transiting once per frame.
+class ToggleMachine : public fsm::StateMachine {
+public:
+    explicit ToggleMachine(const std::string &name) : StateMachine(name) {}
+
+    void Initialize() override {
+        off_ = fsm::State::MakeState(*this, "OFF");
+        on_ = fsm::State::MakeState(*this, "ON");
+        off_on_ = fsm::Transition::MakeTransition("OFF -> ON", off_, on_,
+                                                  std::make_shared<fsm::SimplePredicate<ToggleEvent>>
+                                                          (ToggleEventType::kToggle));
+        on_off_ = fsm::Transition::MakeTransition("ON -> OFF", on_, off_,
+                                                  std::make_shared<fsm::SimplePredicate<ToggleEvent>>
+                                                          (ToggleEventType::kToggle));
+        SetStartState(off_);
+        // Empty callbacks throw when called, so all of them are set.
+        auto on_enter = [this](fsm::MachineBase &, const fsm::StateSharedPtr &) {
+            is_transiting.store(false, std::memory_order_release);
+        };
+        auto on_exit = [](fsm::MachineBase &, const fsm::StateSharedPtr &) {};
+        auto on_transition = [](fsm::MachineBase &, const fsm::StateSharedPtr &, const fsm::ITransitionSharedPtr &,
+                                const fsm::EventSharedPtr &, const fsm::StateSharedPtr &) {};
+        off_->OnEnter = on_enter;
+        on_->OnEnter = on_enter;
+        off_->OnExit = on_exit;
+        on_->OnExit = on_exit;
+        off_on_->OnTransition = on_transition;
+        on_off_->OnTransition = on_transition;
+    }
+
+    fsm::StateSharedPtr off_;
+    fsm::StateSharedPtr on_;
+    fsm::TransitionSharedPtr off_on_;
+    fsm::TransitionSharedPtr on_off_;
+
+    std::atomic<bool> is_transiting{false};  ///< Flag polled by the previous busy-waiting predictor.
+};
+
+/// \brief Latency statistics of transitions in microseconds.
+struct Latency {
+    double average, median, max;
+};
+
+/**
+ * \brief Measure latency of one transition per frame.
+ * \param [in] frames Number of frames.
+ * \param [in] frame_interval Idle time between frames in microseconds, as other stages of a real frame.
+ * \param [in] transit Function transiting the machine once and returning after it finishes.
+ */
+template<typename Func>
+Latency Measure(int frames, int frame_interval, Func &&transit) {
+    std::vector<double> latency(frames);
+    for (int i = 0; i < frames; ++i) {
+        const auto start_time = std::chrono::steady_clock::now();
+        transit();
+        latency[i] = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start_time).count();
+        if (frame_interval > 0)
+            std::this_thread::sleep_for(std::chrono::microseconds(frame_interval));
+    }
+    Latency result{};
+    for (auto value: latency)
+        result.average += value / frames;
+    result.max = *std::max_element(latency.begin(), latency.end());
+    std::nth_element(latency.begin(), latency.begin() + frames / 2, latency.end());
+    result.median = latency[frames / 2];
+    return result;
+}
+
+int main(int argc, char *argv[]) {
+    google::InitGoogleLogging(argv[0]);
+    const int frames = argc > 1 ? std::max(1, std::atoi(argv[1])) : 10000;
+    const int frame_interval = argc > 2 ? std::max(0, std::atoi(argv[2])) : 100;
+
+    printf("Benchmark for per-frame transition latency of FSM. Based on %d frames, %d us apart.\n",
+           frames, frame_interval);
+    printf("Usage: %s [frames] [frame interval in us]\n", argv[0]);
+    printf("================================================\n");
+
+    // Background thread with busy-waiting on a flag set by OnEnter, as armor predictor did before.
+    Latency busy_wait_latency{};
+    {
+        auto machine_set = fsm::MachineSet::MakeMachineSet();
+        auto machine = fsm::MakeStateMachine<ToggleMachine>("Toggle Machine #1");
+        machine_set->StartBackground(500);
+        machine_set->Enqueue(std::make_shared<fsm::MachineOperationEvent>(fsm::MachineOperator::kAdd, machine));
+        busy_wait_latency = Measure(frames, frame_interval, [&]() {
+            machine->is_transiting.store(true, std::memory_order_relaxed);
+            machine_set->Enqueue(std::make_shared<ToggleEvent>(machine));
+            while (machine->is_transiting.load(std::memory_order_acquire))
+                std::this_thread::sleep_for(std::chrono::nanoseconds(1));
+        });
+        machine_set->StopBackground();
+    }
+
+    // Background thread with waiting on completion future.
+    Latency future_latency{};
+    {
+        auto machine_set = fsm::MachineSet::MakeMachineSet();
+        auto machine = fsm::MakeStateMachine<ToggleMachine>("Toggle Machine #2");
+        machine_set->StartBackground(500);
+        machine_set->Enqueue(std::make_shared<fsm::MachineOperationEvent>(fsm::MachineOperator::kAdd, machine));
+        future_latency = Measure(frames, frame_interval, [&]() {
+            CHECK(machine_set->EnqueueWithFuture(std::make_shared<ToggleEvent>(machine)).get());
+        });
+        machine_set->StopBackground();
+    }
+
+    // Inline dispatching on this thread, as armor predictor does now.
+    Latency dispatch_latency{};
+    {
+        auto machine_set = fsm::MachineSet::MakeMachineSet();
+        auto machine = fsm::MakeStateMachine<ToggleMachine>("Toggle Machine #3");
+        machine_set->Dispatch(std::make_shared<fsm::MachineOperationEvent>(fsm::MachineOperator::kAdd, machine));
+        dispatch_latency = Measure(frames, frame_interval, [&]() {
+            CHECK(machine_set->Dispatch(std::make_shared<ToggleEvent>(machine)));
+        });
+    }
+
+    printf("Background thread and busy-waiting: average %lf us, median %lf us, max %lf us\n",
+           busy_wait_latency.average, busy_wait_latency.median, busy_wait_latency.max);
+    printf("------------------------------------------------\n");
+    printf("Background thread and future: average %lf us, median %lf us, max %lf us, %.2lfx\n",
+           future_latency.average, future_latency.median, future_latency.max,
+           busy_wait_latency.average / future_latency.average);
+    printf("Inline dispatching: average %lf us, median %lf us, max %lf us, %.2lfx\n",
+           dispatch_latency.average, dispatch_latency.median, dispatch_latency.max,
+           busy_wait_latency.average / dispatch_latency.average);
+    printf("================================================\n");
+    return 0;
+}
@@ -0,0 +1,80 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <opencv2/imgproc.hpp>
+#include <opencv2/videoio.hpp>
+#include "image-processing/color_difference.h"
+
+const int kMaxFrames = 300;
+const int kDefaultThreshold = 65;  ///< SPLIT_GRAY_THRESH in rune config.
+
+template<typename Function>
+double Measure(const std::vector<cv::Mat> &frames, Function function) {
+    auto start_time = std::chrono::steady_clock::now();
+    for (const auto &frame: frames)
+        function(frame);
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_time).count()
+           / double(frames.size());
+}
+
+/// \brief Previous path of power rune detector: clone, split, subtract and threshold.
+void Reference(const cv::Mat &frame, cv::Mat &image, std::vector<cv::Mat> &channels, int threshold) {
+    image = frame.clone();
+    cv::split(image, channels);
+    cv::subtract(channels.at(2), channels.at(0), image);
+    cv::threshold(image, image, threshold, 255, cv::THRESH_BINARY);
+}
+
+int main(int argc, char *argv[]) {
+    const std::string video_file = argc > 1 ? argv[1] : "../assets/rune_red.mp4";
+    const int threshold = argc > 2 ? std::atoi(argv[2]) : kDefaultThreshold;
+
+    cv::VideoCapture video(video_file);
+    std::vector<cv::Mat> frames;
+    cv::Mat image;
+    while (int(frames.size()) < kMaxFrames && video.read(image))
+        frames.emplace_back(image.clone());
+    if (frames.empty()) {
+        printf("Failed to read video %s.\n", video_file.c_str());
+        return 1;
+    }
+
+    printf("Benchmark for power rune binarization. Based on %lu %dx%d frames of %s, threshold %d.\n",
+           (unsigned long) frames.size(), frames.front().cols, frames.front().rows, video_file.c_str(), threshold);
+    printf("Usage: %s [video file] [threshold]\n", argv[0]);
+    printf("================================================\n");
+
+    std::vector<cv::Mat> channels;
+    cv::Mat reference, mask;
+    {
+        printf("Testing four-pass path (clone, split, subtract, threshold):\n");
+        auto time = Measure(frames, [&](const cv::Mat &frame) { Reference(frame, reference, channels, threshold); });
+        printf("Average time: %lf ms per frame.\n", time);
+        printf("------------------------------------------------\n");
+    }
+
+    for (int num_bands: {1, 0}) {
+        if (num_bands)
+            printf("Testing single-pass color difference threshold in a single thread:\n");
+        else
+            printf("Testing single-pass color difference threshold with %d threads:\n", cv::getNumThreads());
+        auto time = Measure(frames, [&](const cv::Mat &frame) {
+            color_difference::Threshold(frame, mask, true, threshold, num_bands);
+        });
+        printf("Average time: %lf ms per frame.\n", time);
+
+        // Masks should be the same as the previous path.
+        int mismatches = 0;
+        for (const auto &frame: frames) {
+            Reference(frame, reference, channels, threshold);
+            color_difference::Threshold(frame, mask, true, threshold, num_bands);
+            mismatches += cv::countNonZero(reference != mask);
+        }
+        printf("Mismatched pixels: %d.\n", mismatches);
+        printf("------------------------------------------------\n");
+    }
+
+    return 0;
+}
@@ -0,0 +1,197 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <opencv2/imgproc.hpp>
+#include <opencv2/videoio.hpp>
+#include <glog/logging.h>
+#include "detector-rune-debug/detector_rune_debug.h"
+#include "image-processing/blob_labeler.h"
+#include "image-processing/color_difference.h"
+
+const int kMaxFrames = 300;
+constexpr float kMatchDistance = 2;  ///< Max distance of matched candidates in pixels.
+
+/// \brief Candidates of armor center P and center R of power rune in a frame.
+struct Candidates {
+    std::vector<cv::Point2f> armors;
+    std::vector<cv::Point2f> centers_r;
+};
+
+/// \brief Same binarization and morphological operation as power rune detector.
+void Preprocess(const cv::Mat &frame, cv::Mat &binary) {
+    color_difference::Threshold(frame, binary, true, RuneDetectorDebug::Instance().SplitGrayThresh());
+    cv::dilate(binary, binary, cv::getStructuringElement(cv::MORPH_RECT, {5, 5}, {2, 2}));
+    cv::morphologyEx(binary, binary, cv::MORPH_CLOSE, cv::getStructuringElement(cv::MORPH_RECT, {7, 7}, {3, 3}));
+}
+
+/// \return Ratio of short edge to long edge of a rotated rectangle.
+inline double EdgeRatio(const cv::RotatedRect &rect) {
+    const int width = int(rect.size.width), height = int(rect.size.height);
+    return double(std::min(width, height)) / double(std::max(width, height));
+}
+
+inline bool IsFan(const cv::RotatedRect &rect, double contour_area) {
+    const auto &config = RuneDetectorDebug::Instance();
+    const double ratio = EdgeRatio(rect);
+    return rect.size.area() >= config.MinBoundingBoxArea()
+           && ratio > config.MinBoundingBoxWHRatio() && ratio < config.MaxBoundingBoxWHRatio()
+           && contour_area > config.MinContourArea() && contour_area < config.MaxContourArea();
+}
+
+inline bool IsArmor(const cv::RotatedRect &rect) {
+    const auto &config = RuneDetectorDebug::Instance();
+    const double ratio = EdgeRatio(rect);
+    return rect.size.area() > config.MinArmorArea() && rect.size.area() < config.MaxArmorArea()
+           && ratio > config.MinArmorWHRatio() && ratio < config.MaxArmorWHRatio();
+}
+
+inline bool IsCenterR(const cv::RotatedRect &rect) {
+    const auto &config = RuneDetectorDebug::Instance();
+    return rect.size.area() > float(config.MinRBoundingBoxArea())
+           && rect.size.area() < float(config.MaxRBoundingBoxArea())
+           && std::abs(rect.size.width - rect.size.height) < float(config.MaxEncircleRRectWHDeviation());
+}
+
+/// \brief Previous path of power rune detector: contour tree, then geometry of every contour.
+void FindByContours(const cv::Mat &binary, std::vector<std::vector<cv::Point>> &contours,
+                    std::vector<cv::Vec4i> &hierarchies, Candidates &candidates) {
+    candidates.armors.clear();
+    candidates.centers_r.clear();
+    cv::findContours(binary, contours, hierarchies, cv::RETR_TREE, cv::CHAIN_APPROX_SIMPLE);
+    if (hierarchies.empty())
+        return;
+    for (int i = 0; i >= 0; i = hierarchies[i][0])
+        if (IsFan(cv::minAreaRect(contours[i]), cv::contourArea(contours[i])))
+            for (int child = hierarchies[i][2]; child >= 0; child = hierarchies[child][0]) {
+                const auto rect = cv::minAreaRect(contours[child]);
+                if (IsArmor(rect))
+                    candidates.armors.push_back(rect.center);
+            }
+    for (const auto &contour: contours) {
+        const auto rect = cv::minAreaRect(contour);
+        if (IsCenterR(rect))
+            candidates.centers_r.push_back(rect.center);
+    }
+}
+
+/// \brief Same bound as power rune detector, see RuneDetector.
+inline int MaxEncircleArea(const Blob &blob) {
+    const int margin = blob.hole ? 1 : -1;
+    return (blob.bounding_box.width + margin) * (blob.bounding_box.height + margin);
+}
+
+/// \brief Current path of power rune detector: blob statistics, then geometry of remaining blobs.
+void FindByBlobs(const cv::Mat &binary, const BlobLabeler &labeler, std::vector<Blob> &blobs,
+                 std::vector<cv::Point> &contour, Candidates &candidates) {
+    const auto &config = RuneDetectorDebug::Instance();
+    candidates.armors.clear();
+    candidates.centers_r.clear();
+    labeler(binary, blobs);
+    for (const auto &fan: blobs) {
+        if (fan.hole || fan.parent >= 0 || MaxEncircleArea(fan) < config.MinBoundingBoxArea()
+            || fan.filled_area <= config.MinContourArea())
+            continue;
+        labeler.Contour(fan, contour);
+        if (!IsFan(cv::minAreaRect(contour), cv::contourArea(contour)))
+            continue;
+        for (const int child: fan.children) {
+            const auto &armor = blobs[child];
+            if (MaxEncircleArea(armor) <= config.MinArmorArea() || armor.area >= config.MaxArmorArea())
+                continue;
+            labeler.Contour(armor, contour);
+            const auto rect = cv::minAreaRect(contour);
+            if (IsArmor(rect))
+                candidates.armors.push_back(rect.center);
+        }
+    }
+    for (const auto &blob: blobs) {
+        if (MaxEncircleArea(blob) <= config.MinRBoundingBoxArea())
+            continue;
+        labeler.Contour(blob, contour);
+        const auto rect = cv::minAreaRect(contour);
+        if (IsCenterR(rect))
+            candidates.centers_r.push_back(rect.center);
+    }
+}
+
+/// \return Number of points matched by points of the other set.
+uint64_t Match(const std::vector<cv::Point2f> &points, const std::vector<cv::Point2f> &references) {
+    uint64_t matched = 0;
+    for (const auto &reference: references)
+        for (const auto &point: points)
+            if (cv::norm(point - reference) <= kMatchDistance) {
+                ++matched;
+                break;
+            }
+    return matched;
+}
+
+int main(int argc, char *argv[]) {
+    google::InitGoogleLogging(argv[0]);
+    const std::string video_file = argc > 1 ? argv[1] : "../assets/rune_red.mp4";
+    const std::string config_file = argc > 2 ? argv[2] : "../config/infantry/rune-param.yaml";
+    RuneDetectorDebug::Instance().Initialize(config_file, false);
+
+    cv::VideoCapture video(video_file);
+    std::vector<cv::Mat> binaries;
+    cv::Mat image;
+    while (int(binaries.size()) < kMaxFrames && video.read(image)) {
+        binaries.emplace_back();
+        Preprocess(image, binaries.back());
+    }
+    if (binaries.empty()) {
+        printf("Failed to read video %s.\n", video_file.c_str());
+        return 1;
+    }
+
+    printf("Benchmark for power rune blob search. Based on %lu binarized %dx%d frames of %s.\n",
+           (unsigned long) binaries.size(), binaries.front().cols, binaries.front().rows, video_file.c_str());
+    printf("Usage: %s [video file] [rune config file]\n", argv[0]);
+    printf("================================================\n");
+
+    std::vector<Candidates> references(binaries.size()), candidates(binaries.size());
+    std::vector<std::vector<cv::Point>> contours;
+    std::vector<cv::Vec4i> hierarchies;
+    {
+        printf("Testing contour path (findContours with RETR_TREE, minAreaRect of every contour):\n");
+        const auto start_time = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < binaries.size(); ++i)
+            FindByContours(binaries[i], contours, hierarchies, references[i]);
+        printf("Average time: %lf ms per frame.\n", std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - start_time).count() / double(binaries.size()));
+        printf("------------------------------------------------\n");
+    }
+
+    BlobLabeler labeler;
+    std::vector<Blob> blobs;
+    std::vector<cv::Point> contour;
+    {
+        printf("Testing blob path (connected components, contours of remaining blobs only):\n");
+        const auto start_time = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < binaries.size(); ++i)
+            FindByBlobs(binaries[i], labeler, blobs, contour, candidates[i]);
+        printf("Average time: %lf ms per frame.\n", std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - start_time).count() / double(binaries.size()));
+
+        uint64_t num_armors = 0, matched_armors = 0, num_centers_r = 0, matched_centers_r = 0, extra = 0;
+        for (size_t i = 0; i < binaries.size(); ++i) {
+            num_armors += references[i].armors.size();
+            matched_armors += Match(candidates[i].armors, references[i].armors);
+            num_centers_r += references[i].centers_r.size();
+            matched_centers_r += Match(candidates[i].centers_r, references[i].centers_r);
+            extra += candidates[i].armors.size() + candidates[i].centers_r.size()
+                     - Match(references[i].armors, candidates[i].armors)
+                     - Match(references[i].centers_r, candidates[i].centers_r);
+        }
+        printf("Armor candidates matched: %lu / %lu.\n", (unsigned long) matched_armors, (unsigned long) num_armors);
+        printf("Center R candidates matched: %lu / %lu.\n", (unsigned long) matched_centers_r,
+               (unsigned long) num_centers_r);
+        printf("Candidates not in contour path: %lu.\n", (unsigned long) extra);
+        printf("------------------------------------------------\n");
+    }
+
+    return 0;
+}
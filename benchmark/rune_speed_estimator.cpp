@@ -0,0 +1,121 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <vector>
+#include "predictor-rune/rune_speed_estimator.h"
+
+constexpr int kFrames = 3000;           ///< Frames of each run, power rune is reset at the middle.
+constexpr double kFramePeriod = 0.01;   ///< Average frame period in seconds.
+constexpr double kDelay = 7.0 / 28.5;   ///< Prediction delay of power rune predictor in seconds.
+constexpr double kTolerance = 2;        ///< Max error of predicted rotation to be converged, in degrees.
+constexpr double kOutlierRatio = 0.02;  ///< Ratio of samples from fan switching.
+
+/// \brief Speed function of big power rune, with parameters chosen randomly in official range.
+struct SpeedFunction {
+    double amplitude, omega, phi;
+
+    [[nodiscard]] inline double Integral(double begin, double end) const {
+        return amplitude / omega * (std::cos(omega * begin + phi) - std::cos(omega * end + phi))
+               + (2.090 - amplitude) * (end - begin);
+    }
+};
+
+SpeedFunction RandomFunction(std::mt19937 &generator) {
+    return {std::uniform_real_distribution<double>(0.780, 1.045)(generator),
+            std::uniform_real_distribution<double>(1.884, 2.000)(generator),
+            std::uniform_real_distribution<double>(-M_PI, M_PI)(generator)};
+}
+
+/// \return Rotation in delay predicted by estimator in the same way as power rune predictor.
+double PredictedRotation(const RuneSpeedEstimator &estimator, double time) {
+    const auto &parameters = estimator.GetParameters();
+    const double begin = time - estimator.TimeOrigin(), end = begin + kDelay;
+    return parameters.amplitude / parameters.omega * (std::cos(parameters.omega * begin + parameters.phi)
+                                                      - std::cos(parameters.omega * end + parameters.phi))
+           + parameters.b * (end - begin);
+}
+
+int main(int argc, char *argv[]) {
+    const int runs = argc > 1 ? std::max(1, std::atoi(argv[1])) : 100;
+    const double noise = argc > 2 ? std::atof(argv[2]) : 0.3;
+
+    printf("Benchmark for incremental power rune speed estimator. Based on %d runs of %d frames,\n", runs, kFrames);
+    printf("with %.2lf rad/s speed noise and %.0lf%% outliers, and power rune reset at frame %d.\n",
+           noise, kOutlierRatio * 100, kFrames / 2);
+    printf("Usage: %s [runs] [speed noise in rad/s]\n", argv[0]);
+    printf("================================================\n");
+
+    std::mt19937 generator(0);
+    std::normal_distribution<double> noise_distribution(0, noise), period_distribution(kFramePeriod, 0.001);
+    std::uniform_real_distribution<double> uniform_distribution(0, 1);
+    auto estimator = std::make_unique<RuneSpeedEstimator>();
+
+    double total_time = 0, max_time = 0;
+    uint64_t updates = 0, converged_runs = 0, recovered_runs = 0;
+    double converge_frames = 0, recover_frames = 0, error_sum = 0;
+    uint64_t error_count = 0;
+    std::vector<double> errors(kFrames);
+    for (int run = 0; run < runs; ++run) {
+        estimator->Reset();
+        SpeedFunction function = RandomFunction(generator);
+        double time = 1.6e9 + uniform_distribution(generator) * 1e6;
+        for (int frame = 0; frame < kFrames; ++frame) {
+            if (frame == kFrames / 2) {
+                // Power rune is reset with new parameters, keep speed continuous in time.
+                function = RandomFunction(generator);
+            }
+            time += period_distribution(generator);
+            double speed = function.amplitude * std::sin(function.omega * time + function.phi)
+                           + 2.090 - function.amplitude + noise_distribution(generator);
+            if (uniform_distribution(generator) < kOutlierRatio)
+                speed = 20 * uniform_distribution(generator);
+
+            const auto start_time = std::chrono::steady_clock::now();
+            const bool valid = estimator->Update(time, speed);
+            const double update_time = std::chrono::duration<double, std::micro>(
+                    std::chrono::steady_clock::now() - start_time).count();
+            total_time += update_time;
+            max_time = std::max(max_time, update_time);
+            ++updates;
+
+            errors[frame] = valid ? std::abs(PredictedRotation(*estimator, time)
+                                             - function.Integral(time, time + kDelay)) * 180 / M_PI : INFINITY;
+        }
+
+        // Converged at the first frame since which all errors are in tolerance until power rune is reset.
+        auto converged_frame = [&](int begin, int end) {
+            int frame = end;
+            while (frame > begin && errors[frame - 1] < kTolerance)
+                --frame;
+            return frame < end ? frame - begin : -1;
+        };
+        const int first = converged_frame(0, kFrames / 2), second = converged_frame(kFrames / 2, kFrames);
+        if (first >= 0)
+            ++converged_runs, converge_frames += first;
+        if (second >= 0)
+            ++recovered_runs, recover_frames += second;
+        for (int frame = kFrames / 2 - 500; frame < kFrames / 2; ++frame)
+            error_sum += errors[frame], ++error_count;
+        for (int frame = kFrames - 500; frame < kFrames; ++frame)
+            error_sum += errors[frame], ++error_count;
+    }
+
+    printf("Average update time: %lf us, max update time: %lf us.\n", total_time / double(updates), max_time);
+    printf("------------------------------------------------\n");
+    printf("Converged from scratch in %lu / %lu runs, after %lf frames on average.\n",
+           (unsigned long) converged_runs, (unsigned long) runs,
+           converged_runs ? converge_frames / double(converged_runs) : 0.);
+    printf("Recovered from reset in %lu / %lu runs, after %lf frames on average.\n",
+           (unsigned long) recovered_runs, (unsigned long) runs,
+           recovered_runs ? recover_frames / double(recovered_runs) : 0.);
+    printf("Average error of predicted rotation in the last 500 frames of each phase: %lf degrees.\n",
+           error_sum / double(error_count));
+    printf("Previous predictor fits once after %d frames.\n", 1335);
+    printf("------------------------------------------------\n");
+
+    return 0;
+}
@@ -0,0 +1,70 @@
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <opencv2/videoio.hpp>
+#include <glog/logging.h>
+#include "detector-rune/detector_rune.h"
+
+/// \brief Whether the power rune is completely found in a frame.
+inline bool Found(const PowerRune &power_rune) {
+    return power_rune.CenterR() != cv::Point2f(0, 0) && power_rune.ArmorCenterP() != cv::Point2f(0, 0);
+}
+
+int main(int argc, char *argv[]) {
+    google::InitGoogleLogging(argv[0]);
+    const std::string video_file = argc > 1 ? argv[1] : "../assets/rune_red.mp4";
+
+    printf("Benchmark for power rune detector tracking in annulus around center R, against full frame detection.\n");
+    printf("Usage: %s [video file]\n", argv[0]);
+    printf("================================================\n");
+
+    cv::VideoCapture video(video_file);
+    cv::Mat image;
+    if (!video.read(image)) {
+        printf("Failed to read video %s.\n", video_file.c_str());
+        return 1;
+    }
+    Frame init_frame(image, 0);
+    RuneDetector full_frame_detector(Entity::Colors::kRed), tracking_detector(Entity::Colors::kRed);
+    full_frame_detector.Initialize("../config/infantry/rune-param.yaml", init_frame);
+    tracking_detector.Initialize("../config/infantry/rune-param.yaml", init_frame);
+
+    uint64_t num_frames = 0, num_found[2] = {0, 0}, num_both_found = 0;
+    double p_distance = 0;
+    do {
+        Frame frame(image, num_frames++);
+        debug::Painter::Instance().UpdateImage(image);
+        const auto reference = full_frame_detector.Run(frame);
+        const auto power_rune = tracking_detector.Run(frame);
+        // Same as RunePredictor::CalRadius(), without running the predictor.
+        tracking_detector.Track(std::hypot(power_rune.RtpVec().x, power_rune.RtpVec().y));
+
+        num_found[0] += Found(reference);
+        num_found[1] += Found(power_rune);
+        if (Found(reference) && Found(power_rune)) {
+            ++num_both_found;
+            p_distance += cv::norm(reference.ArmorCenterP() - power_rune.ArmorCenterP());
+        }
+    } while (video.read(image));
+
+    const auto reference_statistics = full_frame_detector.GetStatistics();
+    const auto statistics = tracking_detector.GetStatistics();
+    printf("Replayed %lu frames.\n", (unsigned long) num_frames);
+    printf("------------------------------------------------\n");
+    printf("Full frame detection: %lf ms per frame, found in %lu frames.\n",
+           reference_statistics.average_time, (unsigned long) num_found[0]);
+    printf("------------------------------------------------\n");
+    printf("Tracking detection: %lf ms per frame, found in %lu frames.\n",
+           statistics.average_time, (unsigned long) num_found[1]);
+    printf("Tracked in annulus: %lu frames, %lf ms per frame.\n",
+           (unsigned long) statistics.tracked_frames, statistics.average_tracking_time);
+    printf("Lost in annulus and detected in full frame: %lu frames.\n", (unsigned long) statistics.lost_frames);
+    printf("Speedup: %lf overall, %lf in tracked frames.\n",
+           statistics.average_time > 0 ? reference_statistics.average_time / statistics.average_time : 0.,
+           statistics.average_tracking_time > 0
+           ? reference_statistics.average_time / statistics.average_tracking_time : 0.);
+    printf("Average distance of armor center P from full frame detection: %lf pixels.\n",
+           num_both_found ? p_distance / double(num_both_found) : 0.);
+    printf("------------------------------------------------\n");
+    return 0;
+}
@@ -8,7 +8,7 @@ endif ()
 # Find Cuda
 # Custom library path.
 set(CUDA_PATH /usr/local/cuda)
-find_package(CUDA REQUIRED)
+find_package(CUDA QUIET)
 include_directories(${CUDA_INCLUDE_DIRS})
 file(GLOB CUDA_LIBS ${CUDA_PATH}/lib64/libcu*.so)
 
@@ -62,6 +62,9 @@ set(Nvidia_Tools_SOURCE
 find_package_handle_standard_args(
         Nvidia_Tools
         DEFAULT_MSG
+        TensorRT_INCLUDE_DIRS
+        TensorRT_LIBRARY_INFER
+        CUDA_INCLUDE_DIRS
         Nvidia_Tools_INCLUDE_DIRS
         Nvidia_Tools_LIBS
         Nvidia_Tools_SOURCE
@@ -1,5 +1,6 @@
 #include <iostream>
 #include <csignal>
+#include <opencv2/core.hpp>
 #include "cmdline-arg-parser/cmdline_arg_parser.h"
 #include "controller-base/controller_factory.h"
 
@@ -19,6 +20,10 @@ int main(int argc, char *argv[]) {
     // Parse command line flags.
     CmdlineArgParser::Instance().Parse(argc, argv);
 
+    // OpenCV threads are shared by the whole process, including OpenCV DNN backend of armor detector.
+    if (CmdlineArgParser::Instance().DetectorThreads() > 0)
+        cv::setNumThreads(CmdlineArgParser::Instance().DetectorThreads());
+
     // Create controller.
     Controller *controller = CREATE_CONTROLLER(CmdlineArgParser::Instance().ControllerType());
 
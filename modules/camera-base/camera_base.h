@@ -10,10 +10,15 @@
 
 #include "data-structure/frame.h"
 #include "data-structure/buffer.h"
+#include "data-structure/frame_pool.h"
+#include "lang-feature-extension/attr_reader.h"
 
 /// Buffer size for image provider and camera.
 #define CAMERA_BUFFER_SIZE 4
 
+/// Max time in milliseconds to wait for a frame.
+#define CAMERA_GET_FRAME_TIMEOUT 1000
+
 /**
  * \brief Camera base class.
  * \note You cannot directly construct objects.  \n
@@ -29,6 +34,9 @@ public:
 
     virtual ~Camera() = default;
 
+    /// \brief Pool of image buffers, check its counters for allocations and copies.
+    ATTR_READER_REF(frame_pool_, GetFramePool)
+
     /**
      * \brief Open a camera.
      * \param [in] serial_number Serial number of the camera you wanna open.
@@ -48,7 +56,7 @@ public:
     /**
      * \brief Get a frame with image and time stamp from internal image buffer.
      * \param [out] frame Acquired frame will be stored here.
-     * \return Whether buffer is not empty, or if you can successfully get an frame.
+     * \return Whether a frame is got before timeout, or if you can successfully get an frame.
      */
     virtual bool GetFrame(Frame &frame) = 0;
 
@@ -105,9 +113,20 @@ protected:
     bool stream_running_;           ///< Stream running flag.
     pthread_t daemon_thread_id_;    ///< Daemon thread id.
     bool stop_daemon_thread_flag_;  ///< Flag to stop daemon thread.
-    CircularBuffer<Frame, CAMERA_BUFFER_SIZE> buffer_;  ///< A ring buffer to store images.
+    FramePool frame_pool_;          ///< Image buffers of all frames, must be destroyed after them.
+    SPSCBuffer<Frame, CAMERA_BUFFER_SIZE> buffer_;  ///< A ring buffer to store images, keeping the latest ones.
+
+    /**
+     * \brief Wait for and get the oldest frame in buffer.
+     * \param [out] frame Output frame.
+     * \return Whether a frame is got before timeout.
+     */
+    inline bool WaitFrame(Frame &frame) {
+        return buffer_.WaitPop(frame, std::chrono::milliseconds(CAMERA_GET_FRAME_TIMEOUT));
+    }
 };
 
 #undef CAMERA_BUFFER_SIZE
+#undef CAMERA_GET_FRAME_TIMEOUT
 
 #endif  // CAMERA_BASE_H_
@@ -1,8 +1,8 @@
 #include <unistd.h>
 #include <opencv2/imgproc.hpp>
 #include <GxIAPI.h>
-#include <DxImageProc.h>
 #include "camera-base/camera_factory.h"
+#include "image-processing/demosaic.h"
 #include "camera_dh.h"
 
 uint16_t DHCamera::camera_count_ = 0;
@@ -174,10 +174,6 @@ bool DHCamera::StartStream() {
     // Save temporary config to cache folder.
     ExportConfigurationFile("../cache/" + serial_number_ + ".txt");
 
-    // Allocate memory for cache.
-    raw_8_to_rgb_24_cache_ = new unsigned char[payload_size_ * 3];
-    raw_16_to_8_cache_ = new unsigned char[payload_size_];
-
     // Open the stream.
     GX_STATUS status_code = GXStreamOn(device_);
     GX_START_STOP_STREAM_CHECK_STATUS_(status_code)
@@ -197,17 +193,10 @@ bool DHCamera::StopStream() {
     GX_STATUS status_code = GXStreamOff(device_);
     GX_START_STOP_STREAM_CHECK_STATUS_(status_code)
 
-    // Release memory for cache.
-    if (raw_16_to_8_cache_ != nullptr) {
-        delete[] raw_16_to_8_cache_;
-        raw_16_to_8_cache_ = nullptr;
-    }
-    if (raw_8_to_rgb_24_cache_ != nullptr) {
-        delete[] raw_8_to_rgb_24_cache_;
-        raw_8_to_rgb_24_cache_ = nullptr;
-    }
-
     LOG(INFO) << serial_number_ << "'s stream stopped.";
+    LOG(INFO) << serial_number_ << "'s frame pool: " << frame_pool_.NumBuffers() << " buffers, "
+              << frame_pool_.AllocationCount() << " allocations, " << frame_pool_.CopyCount() << " copies for "
+              << frame_pool_.AcquireCount() << " frames, " << buffer_.Dropped() << " frames dropped.";
     return true;
 }
 
@@ -251,81 +240,68 @@ void DHCamera::DefaultCaptureCallback(GX_FRAME_CALLBACK_PARAM *frame_callback) {
         return;
     }
 
-    // Convert to RGB format.
-    if (!self->Raw8Raw16ToRGB24(frame_callback))
+    Frame frame;
+    if (!self->RawToFrame(frame_callback, frame))
         return;
-
-    // Generate OpenCV style image matrix.
-    cv::Mat image = cv::Mat(frame_callback->nHeight,
-                            frame_callback->nWidth,
-                            CV_8UC3,
-                            self->raw_8_to_rgb_24_cache_);
-    cv::cvtColor(image, image, cv::COLOR_RGB2BGR);
-
-    self->buffer_.Push(Frame(image, frame_callback->nTimestamp));
+    self->buffer_.Push(std::move(frame));
 }
 
-bool DHCamera::Raw8Raw16ToRGB24(GX_FRAME_CALLBACK_PARAM *frame_callback) {
-    VxInt32 dx_status_code;
-
-    // Convert RAW8 or RAW16 image to RGB24 image.
+bool DHCamera::RawToFrame(GX_FRAME_CALLBACK_PARAM *frame_callback, Frame &frame) {
+    int bits;
     switch (frame_callback->nPixelFormat) {
         case GX_PIXEL_FORMAT_BAYER_GR8:
         case GX_PIXEL_FORMAT_BAYER_RG8:
         case GX_PIXEL_FORMAT_BAYER_GB8:
-        case GX_PIXEL_FORMAT_BAYER_BG8: {
-            // Convert to the RGB image.
-            dx_status_code = DxRaw8toRGB24((unsigned char *) frame_callback->pImgBuf,
-                                           raw_8_to_rgb_24_cache_,
-                                           frame_callback->nWidth,
-                                           frame_callback->nHeight,
-                                           RAW2RGB_NEIGHBOUR,
-                                           DX_PIXEL_COLOR_FILTER(color_filter_),
-                                           false);
-            if (dx_status_code != DX_OK) {
-                LOG(ERROR) << "DxRaw8toRGB24 failed with error " << std::to_string(dx_status_code) << ".";
-                return false;
-            }
+        case GX_PIXEL_FORMAT_BAYER_BG8:
+            bits = 8;
             break;
-        }
         case GX_PIXEL_FORMAT_BAYER_GR10:
         case GX_PIXEL_FORMAT_BAYER_RG10:
         case GX_PIXEL_FORMAT_BAYER_GB10:
         case GX_PIXEL_FORMAT_BAYER_BG10:
+            bits = 10;
+            break;
         case GX_PIXEL_FORMAT_BAYER_GR12:
         case GX_PIXEL_FORMAT_BAYER_RG12:
         case GX_PIXEL_FORMAT_BAYER_GB12:
-        case GX_PIXEL_FORMAT_BAYER_BG12: {
-            // Convert to the Raw8 image.
-            dx_status_code = DxRaw16toRaw8((unsigned char *) frame_callback->pImgBuf,
-                                           raw_16_to_8_cache_,
-                                           frame_callback->nWidth,
-                                           frame_callback->nHeight,
-                                           DX_BIT_2_9);
-            if (dx_status_code != DX_OK) {
-                LOG(ERROR) << "DxRaw8toRGB24 failed with error " << std::to_string(dx_status_code) << ".";
-                return false;
-            }
-
-            // Convert to the RGB24 image.
-            dx_status_code = DxRaw8toRGB24(raw_16_to_8_cache_,
-                                           raw_8_to_rgb_24_cache_,
-                                           frame_callback->nWidth,
-                                           frame_callback->nHeight,
-                                           RAW2RGB_NEIGHBOUR,
-                                           DX_PIXEL_COLOR_FILTER(color_filter_),
-                                           false);
-            if (dx_status_code != DX_OK) {
-                LOG(ERROR) << "DxRaw8toRGB24 failed with error " << std::to_string(dx_status_code) << ".";
-                return false;
-            }
+        case GX_PIXEL_FORMAT_BAYER_BG12:
+            bits = 12;
             break;
-        }
         default: {
             LOG(ERROR) << "Pixel format of this camera is not supported.";
             return false;
         }
     }
+
+    demosaic::BayerPattern pattern;
+    switch (color_filter_) {
+        case GX_COLOR_FILTER_BAYER_RG:
+            pattern = demosaic::kRGGB;
+            break;
+        case GX_COLOR_FILTER_BAYER_GR:
+            pattern = demosaic::kGRBG;
+            break;
+        case GX_COLOR_FILTER_BAYER_GB:
+            pattern = demosaic::kGBRG;
+            break;
+        case GX_COLOR_FILTER_BAYER_BG:
+            pattern = demosaic::kBGGR;
+            break;
+        default: {
+            LOG(ERROR) << "Color filter of this camera is not supported.";
+            return false;
+        }
+    }
+
+    // RAW10 and RAW12 pixels are stored in 16 bits.
+    // SDK will reuse its buffer after callback, so copy it into a pooled buffer.
+    const int type = bits == 8 ? CV_8UC1 : CV_16UC1;
+    cv::Mat raw_image = frame_pool_.Acquire(frame_callback->nHeight, frame_callback->nWidth, type);
+    cv::Mat(frame_callback->nHeight, frame_callback->nWidth, type,
+            const_cast<void *>(frame_callback->pImgBuf)).copyTo(raw_image);
+    frame_pool_.CountCopy();
+
+    frame = Frame(raw_image, pattern, bits, frame_callback->nTimestamp);
     return true;
 }
 
@@ -340,17 +316,8 @@ void *DHCamera::DaemonThreadFunction(void *obj) {
             LOG(INFO) << "Preparing for reconnection...";
 
             // Stop the stream, errors are blocked.
-            if (self->stream_running_) {
+            if (self->stream_running_)
                 GXStreamOff(self->device_);
-                if (self->raw_16_to_8_cache_ != nullptr) {
-                    delete[] self->raw_16_to_8_cache_;
-                    self->raw_16_to_8_cache_ = nullptr;
-                }
-                if (self->raw_8_to_rgb_24_cache_ != nullptr) {
-                    delete[] self->raw_8_to_rgb_24_cache_;
-                    self->raw_8_to_rgb_24_cache_ = nullptr;
-                }
-            }
 
             // Unregister any callbacks.
             self->UnregisterCaptureCallback();
@@ -375,21 +342,10 @@ void *DHCamera::DaemonThreadFunction(void *obj) {
 
             // Restart Stream.
             if (self->stream_running_) {
-                self->raw_8_to_rgb_24_cache_ = new unsigned char[self->payload_size_ * 3];
-                self->raw_16_to_8_cache_ = new unsigned char[self->payload_size_];
-
                 GX_STATUS status_code = GXStreamOn(self->device_);
                 if (status_code != GX_STATUS_SUCCESS) {
                     LOG(ERROR) << GetErrorInfo(status_code);
                     GXStreamOff(self->device_);
-                    if (self->raw_16_to_8_cache_ != nullptr) {
-                        delete[] self->raw_16_to_8_cache_;
-                        self->raw_16_to_8_cache_ = nullptr;
-                    }
-                    if (self->raw_8_to_rgb_24_cache_ != nullptr) {
-                        delete[] self->raw_8_to_rgb_24_cache_;
-                        self->raw_8_to_rgb_24_cache_ = nullptr;
-                    }
                     self->stream_running_ = false;
                 }
             }
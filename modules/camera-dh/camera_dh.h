@@ -46,14 +46,6 @@
  */
 #define GX_START_STOP_STREAM_CHECK_STATUS_(status_code)  \
     if ((status_code) != GX_STATUS_SUCCESS) {            \
-        if (raw_16_to_8_cache_ != nullptr) {             \
-            delete[] raw_16_to_8_cache_;                 \
-            raw_16_to_8_cache_ = nullptr;                \
-        }                                                \
-        if (raw_8_to_rgb_24_cache_ != nullptr) {         \
-            delete[] raw_8_to_rgb_24_cache_;             \
-            raw_8_to_rgb_24_cache_ = nullptr;            \
-        }                                                \
         LOG(ERROR) << GetErrorInfo(status_code);         \
         return false;                                    \
     }
@@ -67,9 +59,7 @@ class [[maybe_unused]] DHCamera final : public Camera {
 public:
     DHCamera() : device_(nullptr),
                  color_filter_(GX_COLOR_FILTER_NONE),
-                 payload_size_(0),
-                 raw_8_to_rgb_24_cache_(nullptr),
-                 raw_16_to_8_cache_(nullptr) {};
+                 payload_size_(0) {};
 
     ~DHCamera() final = default;
 
@@ -83,7 +73,7 @@ public:
 
     bool IsConnected() final;
 
-    inline bool GetFrame(Frame &frame) final { return buffer_.Pop(frame); }
+    inline bool GetFrame(Frame &frame) final { return WaitFrame(frame); }
 
     inline bool ExportConfigurationFile(const std::string &file_path) final {
         GX_STATUS status_code = GXExportConfigFile(device_, file_path.c_str());
@@ -272,11 +262,13 @@ private:
     }
 
     /**
-     * \brief Convert RAW 8/16 pixel formats to an RGB 24 one.
+     * \brief Copy a RAW 8/10/12 image into a pooled buffer, without converting it to BGR.
+     * \details BGR image will be converted lazily by Frame::Image() only when needed.
      * \param [in] frame_callback A frame buffer acquired directly from camera.
-     * \return Whether pixel format is normally converted.
+     * \param [out] frame Output raw frame.
+     * \return Whether pixel format is supported.
      */
-    bool Raw8Raw16ToRGB24(GX_FRAME_CALLBACK_PARAM *frame_callback);
+    bool RawToFrame(GX_FRAME_CALLBACK_PARAM *frame_callback, Frame &frame);
 
     /**
      * \brief Internal capture callback function.
@@ -295,8 +287,6 @@ private:
     GX_DEV_HANDLE device_;          ///< Device handle.
     int64_t color_filter_;          ///< Color filter type.
     int64_t payload_size_;          ///< Payload size.
-    unsigned char *raw_8_to_rgb_24_cache_;  ///< Cache for converting image from raw8 to rgb24.
-    unsigned char *raw_16_to_8_cache_;      ///< Cache for converting image from raw16 to raw8.
 
     [[maybe_unused]] static CameraRegistry<DHCamera> dh_camera_registry_;  ///< Own registry in camera factory.
 };
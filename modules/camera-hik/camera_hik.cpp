@@ -2,6 +2,7 @@
 #include <opencv2/imgproc.hpp>
 #include <MvCameraControl.h>
 #include "camera-base/camera_factory.h"
+#include "image-processing/demosaic.h"
 #include "camera_hik.h"
 
 /**
@@ -136,22 +137,72 @@ bool HikCamera::StartStream() {
 
 void HikCamera::ImageCallbackEx(unsigned char *image_data, MV_FRAME_OUT_INFO_EX *frame_info, void *obj) {
     auto self = (HikCamera *) obj;
-    cv::Mat image;
 
     if (frame_info->enPixelType == PixelType_Gvsp_RGB8_Packed) {
         auto time_stamp = (uint64_t) frame_info->nDevTimeStampHigh;
         time_stamp <<= 32;
         time_stamp += frame_info->nDevTimeStampLow;
-        image = cv::Mat(frame_info->nHeight, frame_info->nWidth, CV_8UC3, image_data);
+        // SDK will reuse its buffer after callback, so copy it into a pooled buffer.
+        cv::Mat image = self->frame_pool_.Acquire(frame_info->nHeight, frame_info->nWidth, CV_8UC3);
+        cv::Mat(frame_info->nHeight, frame_info->nWidth, CV_8UC3, image_data).copyTo(image);
+        self->frame_pool_.CountCopy();
         self->buffer_.Push(Frame(image, time_stamp));
-    } else if (frame_info->enPixelType == PixelType_Gvsp_BayerRG8) {
+    } else {
+        demosaic::BayerPattern pattern;
+        int bits;
+        switch (frame_info->enPixelType) {
+            case PixelType_Gvsp_BayerRG8:
+                pattern = demosaic::kRGGB, bits = 8;
+                break;
+            case PixelType_Gvsp_BayerGR8:
+                pattern = demosaic::kGRBG, bits = 8;
+                break;
+            case PixelType_Gvsp_BayerGB8:
+                pattern = demosaic::kGBRG, bits = 8;
+                break;
+            case PixelType_Gvsp_BayerBG8:
+                pattern = demosaic::kBGGR, bits = 8;
+                break;
+            case PixelType_Gvsp_BayerRG10:
+                pattern = demosaic::kRGGB, bits = 10;
+                break;
+            case PixelType_Gvsp_BayerGR10:
+                pattern = demosaic::kGRBG, bits = 10;
+                break;
+            case PixelType_Gvsp_BayerGB10:
+                pattern = demosaic::kGBRG, bits = 10;
+                break;
+            case PixelType_Gvsp_BayerBG10:
+                pattern = demosaic::kBGGR, bits = 10;
+                break;
+            case PixelType_Gvsp_BayerRG12:
+                pattern = demosaic::kRGGB, bits = 12;
+                break;
+            case PixelType_Gvsp_BayerGR12:
+                pattern = demosaic::kGRBG, bits = 12;
+                break;
+            case PixelType_Gvsp_BayerGB12:
+                pattern = demosaic::kGBRG, bits = 12;
+                break;
+            case PixelType_Gvsp_BayerBG12:
+                pattern = demosaic::kBGGR, bits = 12;
+                break;
+            default:
+                LOG(ERROR) << "Pixel format of this camera is not supported.";
+                return;
+        }
+
         auto time_stamp = (uint64_t) frame_info->nDevTimeStampHigh;
         time_stamp <<= 32;
         time_stamp += frame_info->nDevTimeStampLow;
-        image = cv::Mat(frame_info->nHeight, frame_info->nWidth, CV_8UC1, image_data);
-        cv::cvtColor(image, image, cv::COLOR_BayerRG2RGB);
-
-        self->buffer_.Push(Frame(image, time_stamp));
+        // RAW10 and RAW12 pixels are stored in 16 bits.
+        // Only copy raw image here, BGR image will be converted lazily by Frame::Image() when needed.
+        const int type = bits == 8 ? CV_8UC1 : CV_16UC1;
+        cv::Mat raw_image = self->frame_pool_.Acquire(frame_info->nHeight, frame_info->nWidth, type);
+        cv::Mat(frame_info->nHeight, frame_info->nWidth, type, image_data).copyTo(raw_image);
+        self->frame_pool_.CountCopy();
+
+        self->buffer_.Push(Frame(raw_image, pattern, bits, time_stamp));
     }
 }
 
@@ -169,6 +220,9 @@ bool HikCamera::StopStream() {
     }
 
     LOG(INFO) << serial_number_ << "'s stream stopped.";
+    LOG(INFO) << serial_number_ << "'s frame pool: " << frame_pool_.NumBuffers() << " buffers, "
+              << frame_pool_.AllocationCount() << " allocations, " << frame_pool_.CopyCount() << " copies for "
+              << frame_pool_.AcquireCount() << " frames, " << buffer_.Dropped() << " frames dropped.";
     return true;
 }
 
@@ -25,7 +25,7 @@ public:
 
     bool StartStream() final;
 
-    inline bool GetFrame(Frame &frame) final { return buffer_.Pop(frame); }
+    inline bool GetFrame(Frame &frame) final { return WaitFrame(frame); }
 
     bool StopStream() final;
 
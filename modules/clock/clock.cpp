@@ -0,0 +1,34 @@
+#include <mutex>
+#include <vector>
+#include "clock.h"
+
+namespace {
+    /// \brief Clock in use, with all clocks ever used kept alive for readers still holding references.
+    struct GlobalClock {
+        std::mutex mutex;
+        std::vector<std::shared_ptr<Clock>> clocks;
+        std::atomic<const Clock *> current;
+
+        GlobalClock() : clocks{std::make_shared<MonotonicClock>()}, current(clocks.front().get()) {}
+    };
+
+    GlobalClock &Instance() {
+        static GlobalClock global_clock;
+        return global_clock;
+    }
+}
+
+const Clock &Clock::Global() {
+    return *Instance().current.load(std::memory_order_acquire);
+}
+
+void Clock::SetGlobal(std::shared_ptr<Clock> clock) {
+    auto &global_clock = Instance();
+    std::lock_guard<std::mutex> lock(global_clock.mutex);
+    if (!clock) {
+        global_clock.current.store(global_clock.clocks.front().get(), std::memory_order_release);
+        return;
+    }
+    global_clock.clocks.emplace_back(std::move(clock));
+    global_clock.current.store(global_clock.clocks.back().get(), std::memory_order_release);
+}
@@ -0,0 +1,110 @@
+/**
+ * Clock source header.
+ * \author trantuan-20048607
+ * \date 2022.3.30
+ * \details Predictors, state machines and controllers read time from the global clock instead of system clocks,
+ *   so that replays of recorded videos follow time stamps of frames and run at any speed with the same results.
+ */
+
+#ifndef CLOCK_H_
+#define CLOCK_H_
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include "lang-feature-extension/disable_constructor.h"
+
+/**
+ * \brief Source of time in nanoseconds.
+ * \note Use Clock::Global() to read time, and Clock::SetGlobal() to replace the clock in use.
+ *   Latency statistics measure real cost and still use std::chrono::steady_clock.
+ */
+class Clock : NO_COPY, NO_MOVE {
+public:
+    Clock() = default;
+
+    virtual ~Clock() = default;
+
+    /// \return Current time in nanoseconds.
+    [[nodiscard]] virtual uint64_t Now() const = 0;
+
+    /// \return Current time in seconds.
+    [[nodiscard]] inline double NowSeconds() const { return double(Now()) * 1e-9; }
+
+    /**
+     * \return Whether time only follows input instead of running by itself.
+     * \note Work finishing on real time, e.g. in worker threads, should land at deterministic points of input
+     *   with such clocks, otherwise results still depend on playback speed.
+     */
+    [[nodiscard]] virtual bool Deterministic() const { return false; }
+
+    /**
+     * \return Clock in use, which is a MonotonicClock by default.
+     * \note Call it every time instead of keeping its reference, since it may be replaced.
+     */
+    [[nodiscard]] static const Clock &Global();
+
+    /**
+     * \brief Replace the clock in use.
+     * \param [in] clock New clock, nullptr to restore the default MonotonicClock.
+     * \attention Replace it before starting threads reading time, the old clock is kept alive until exiting.
+     */
+    static void SetGlobal(std::shared_ptr<Clock> clock);
+};
+
+/// \brief Monotonic clock of this machine, for running with cameras.
+class MonotonicClock final : public Clock {
+public:
+    [[nodiscard]] inline uint64_t Now() const final {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+};
+
+/**
+ * \brief Clock driven by time stamps of frames, for replaying videos.
+ * \details Time stays at the latest time stamp, older time stamps from out-of-order stages are ignored.
+ */
+class FrameClock final : public Clock {
+public:
+    FrameClock() : time_stamp_(0) {}
+
+    [[nodiscard]] inline uint64_t Now() const final { return time_stamp_.load(std::memory_order_acquire); }
+
+    [[nodiscard]] inline bool Deterministic() const final { return true; }
+
+    /**
+     * \brief Advance time to a frame.
+     * \param [in] time_stamp Time stamp of frame in nanoseconds.
+     */
+    inline void Update(uint64_t time_stamp) {
+        auto current = time_stamp_.load(std::memory_order_relaxed);
+        while (time_stamp > current
+               && !time_stamp_.compare_exchange_weak(current, time_stamp, std::memory_order_release,
+                                                     std::memory_order_relaxed));
+    }
+
+private:
+    std::atomic<uint64_t> time_stamp_;  ///< Latest time stamp.
+};
+
+/// \brief Clock set manually, for tests and benchmarks.
+class SimulatedClock final : public Clock {
+public:
+    explicit SimulatedClock(uint64_t time = 0) : time_(time) {}
+
+    [[nodiscard]] inline uint64_t Now() const final { return time_.load(std::memory_order_acquire); }
+
+    [[nodiscard]] inline bool Deterministic() const final { return true; }
+
+    /// \param [in] time New time in nanoseconds.
+    inline void Set(uint64_t time) { time_.store(time, std::memory_order_release); }
+
+    /// \param [in] duration Duration to advance in nanoseconds.
+    inline void Advance(uint64_t duration) { time_.fetch_add(duration, std::memory_order_acq_rel); }
+
+private:
+    std::atomic<uint64_t> time_;  ///< Current time.
+};
+
+#endif  // CLOCK_H_
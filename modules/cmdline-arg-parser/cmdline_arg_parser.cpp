@@ -14,6 +14,19 @@ DEFINE_bool(serial, false, "run with serial communication");
 DEFINE_bool(gimbal, false, "run with gimbal control");
 
 DEFINE_int32(mode_chooser, 0, "controller running mode chooser");
+DEFINE_bool(headless, false, "run without any window, for benchmark");
+DEFINE_string(detector_backend, "", "armor detector backend, tensorrt, opencv or opencv-int8, empty for auto");
+DEFINE_int32(detector_threads, 0, "OpenCV threads of armor detectors, 0 for all cores");
+DEFINE_double(detector_iou, 0.45, "IoU threshold of armor detector NMS, 0 to suppress any overlapped boxes");
+DEFINE_int32(detector_batch, 4, "max number of images in one inference of armor detector");
+DEFINE_string(detector_dump, "", "file to dump raw armor detector output, for decoder benchmark");
+DEFINE_bool(detector_roi, false, "detect armors in predicted ROI of locked target");
+DEFINE_int32(detector_roi_interval, 10, "max number of ROI frames between full frame scans");
+DEFINE_double(detector_roi_scale, 4, "ROI size relative to locked target");
+DEFINE_int32(detector_track_interval, 1, "max number of frames between armor detections, track boxes in between");
+DEFINE_int32(detector_async_slots, 0, "in-flight requests of asynchronous armor detection, 0 to detect synchronously");
+DEFINE_bool(detector_color_gate, false, "skip armor detection on frames without light-bar colors");
+DEFINE_bool(detector_light_bar, false, "detect armors by light bars on CPU instead of neural network");
 
 // TODO Temporary flag for debug, will be removed in the future.
 DEFINE_bool(rune, false, "run with rune, must under infantry controller");
@@ -41,9 +54,22 @@ void CmdlineArgParser::Parse(int argc, char **argv) {
     controller_type_ = FLAGS_type;
 
     mode_chooser_ = FLAGS_mode_chooser;
+    run_headless_ = FLAGS_headless;
     debug_show_image_ = FLAGS_debug_image;
     debug_use_trackbar_ = FLAGS_debug_trackbar;
     run_mode_rune_ = FLAGS_rune;
+    detector_backend_ = FLAGS_detector_backend;
+    detector_threads_ = FLAGS_detector_threads;
+    detector_iou_threshold_ = float(FLAGS_detector_iou);
+    detector_max_batch_size_ = FLAGS_detector_batch;
+    detector_dump_file_ = FLAGS_detector_dump;
+    detector_roi_ = FLAGS_detector_roi;
+    detector_roi_interval_ = FLAGS_detector_roi_interval;
+    detector_roi_scale_ = float(FLAGS_detector_roi_scale);
+    detector_track_interval_ = FLAGS_detector_track_interval;
+    detector_async_slots_ = FLAGS_detector_async_slots;
+    detector_color_gate_ = FLAGS_detector_color_gate;
+    detector_light_bar_ = FLAGS_detector_light_bar;
 
     // You must enable gimbal control to establish serial communication.
     assert(!run_with_serial_ || run_with_gimbal_);
@@ -55,5 +81,6 @@ void CmdlineArgParser::Parse(int argc, char **argv) {
     LOG(INFO) << "Running " << (run_with_serial_ ? "with" : "without") << " serial communication.";
     LOG(INFO) << "Running " << (run_with_gimbal_ ? "with" : "without") << " gimbal control.";
     LOG(INFO) << "Running " << (run_mode_rune_ ? "with" : "without") << " rune mode.";
+    LOG(INFO) << "Running " << (run_headless_ ? "without" : "with") << " windows.";
     LOG(INFO) << "Controller type: " << controller_type_;
 }
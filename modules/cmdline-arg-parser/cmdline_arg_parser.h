@@ -27,18 +27,55 @@ public:
 
     ATTR_READER(run_mode_rune_, RuneModeRune)
 
+    ATTR_READER(run_headless_, RunHeadless)
+
     ATTR_READER(debug_use_trackbar_, DebugUseTrackbar)
 
     ATTR_READER_REF(controller_type_, ControllerType)
 
+    ATTR_READER_REF(detector_backend_, DetectorBackend)
+
+    ATTR_READER(detector_threads_, DetectorThreads)
+
+    ATTR_READER(detector_iou_threshold_, DetectorIouThreshold)
+
+    ATTR_READER(detector_max_batch_size_, DetectorMaxBatchSize)
+
+    ATTR_READER_REF(detector_dump_file_, DetectorDumpFile)
+
+    ATTR_READER(detector_roi_, DetectorRoi)
+
+    ATTR_READER(detector_roi_interval_, DetectorRoiInterval)
+
+    ATTR_READER(detector_roi_scale_, DetectorRoiScale)
+
+    ATTR_READER(detector_track_interval_, DetectorTrackInterval)
+
+    ATTR_READER(detector_async_slots_, DetectorAsyncSlots)
+
+    ATTR_READER(detector_color_gate_, DetectorColorGate)
+
+    ATTR_READER(detector_light_bar_, DetectorLightBar)
+
     CmdlineArgParser() :
             run_with_camera_(false),
             run_with_gimbal_(false),
             run_with_serial_(false),
             run_mode_rune_(false),
             mode_chooser_(0),
+            run_headless_(false),
             debug_show_image_(false),
-            debug_use_trackbar_(true) {}
+            debug_use_trackbar_(true),
+            detector_threads_(0),
+            detector_iou_threshold_(0),
+            detector_max_batch_size_(0),
+            detector_roi_(false),
+            detector_roi_interval_(0),
+            detector_roi_scale_(0),
+            detector_track_interval_(0),
+            detector_async_slots_(0),
+            detector_color_gate_(false),
+            detector_light_bar_(false) {}
 
     inline static CmdlineArgParser &Instance() {
         static CmdlineArgParser _;
@@ -54,9 +91,23 @@ private:
     std::string controller_type_;  ///< Controller type, no default value.
 
     int mode_chooser_;         ///< TODO Controller mode chooser, will be implemented in the future.
+    bool run_headless_;        ///< Running without any window flag.
     bool debug_show_image_;
     bool debug_use_trackbar_;
     bool run_mode_rune_;       ///< secondly controller mode.
+
+    std::string detector_backend_;    ///< Armor detector backend type, empty for auto.
+    int detector_threads_;            ///< OpenCV threads of armor detectors, 0 for all cores.
+    float detector_iou_threshold_;    ///< IoU threshold of armor detector NMS.
+    int detector_max_batch_size_;     ///< Max number of images in one inference of armor detector.
+    std::string detector_dump_file_;  ///< File to dump armor detector output, empty to disable.
+    bool detector_roi_;               ///< Detect in predicted ROI of locked target.
+    int detector_roi_interval_;       ///< Max number of ROI frames between full frame scans.
+    float detector_roi_scale_;        ///< ROI size relative to locked target.
+    int detector_track_interval_;     ///< Max number of frames between detections, 1 to disable tracking.
+    int detector_async_slots_;        ///< In-flight requests of asynchronous armor detection, 0 to disable.
+    bool detector_color_gate_;        ///< Skip armor detection on frames without light-bar colors.
+    bool detector_light_bar_;         ///< Detect armors by light bars on CPU instead of neural network.
 };
 
 #endif  // CMDLINE_ARG_PARSER_H_
@@ -0,0 +1,174 @@
+#include "cmdline-arg-parser/cmdline_arg_parser.h"
+#include "controller_base.h"
+
+bool Controller::CaptureStage(FrameContext &context) {
+    if (exit_signal_ || !image_provider_->GetFrame(context.frame))
+        return false;
+
+    if (CmdlineArgParser::Instance().RunWithGimbal()) {
+        SerialReceivePacket serial_receive_packet{};
+        serial_->GetData(serial_receive_packet, std::chrono::milliseconds(5));
+        context.receive_packet = ReceivePacket(serial_receive_packet);
+    } else
+        context.receive_packet = ReceivePacket();
+    return true;
+}
+
+void Controller::InitializeDetectors(const std::string &config_dir) {
+    if (CmdlineArgParser::Instance().DetectorColorGate()
+        && !color_gate_.Initialize(config_dir + "/color-gate-param.yaml"))
+        LOG(WARNING) << "Color gate of armor detector is disabled.";
+
+    if (CmdlineArgParser::Instance().DetectorLightBar()
+        && !light_bar_detector_.Initialize(config_dir + "/light-bar-param.yaml",
+                                           CmdlineArgParser::Instance().DetectorThreads()))
+        LOG(WARNING) << "Light-bar detector is disabled, using armor detector.";
+
+    if (!armor_cascade_.Initialize(config_dir + "/cascade-param.yaml",
+                                   CmdlineArgParser::Instance().DetectorThreads()))
+        LOG(WARNING) << "Armor detector cascade is disabled.";
+
+    if (!armor_tiler_.Initialize(config_dir + "/tiling-param.yaml"))
+        LOG(WARNING) << "Tiled armor detection is disabled.";
+}
+
+bool Controller::DetectStage(FrameContext &context) {
+    const bool tracking = armor_tracker_.MaxInterval() > 1;
+    context.candidate = color_gate_(context.frame);
+    if (!context.candidate) {
+        context.boxes.clear();
+        if (tracking)
+            armor_tracker_.Update(context.frame, context.boxes);
+        return true;
+    }
+
+    auto start_time = std::chrono::steady_clock::now();
+    RoiScheduler::Modes mode;
+    if (tracking && armor_tracker_.Track(context.frame, context.boxes))
+        mode = RoiScheduler::kTracked;
+    else {
+        cv::Rect2f roi;
+        mode = roi_scheduler_.Schedule(roi);
+        if (light_bar_detector_.Initialized()) {
+            if (mode == RoiScheduler::kRoi)
+                light_bar_detector_(context.frame, roi, context.boxes);
+            else
+                light_bar_detector_(context.frame, context.boxes);
+        } else if (mode == RoiScheduler::kRoi)
+            armor_detector_(context.frame, roi, context.boxes);
+        else if (armor_cascade_.Enabled())
+            armor_cascade_(armor_detector_, context.frame, context.boxes);
+        else if (armor_tiler_.Enabled())
+            armor_tiler_(armor_detector_, context.frame, context.boxes);
+        else
+            armor_detector_(context.frame, context.boxes);
+        if (tracking)
+            armor_tracker_.Update(context.frame, context.boxes);
+    }
+    roi_scheduler_.Record(context.frame.time_stamp, mode,
+                          std::chrono::duration<double, std::milli>(
+                                  std::chrono::steady_clock::now() - start_time).count(),
+                          !context.boxes.empty());
+    return true;
+}
+
+bool Controller::SubmitStage(FrameContext &context) {
+    context.candidate = color_gate_(context.frame);
+    if (!context.candidate)
+        return true;
+
+    context.submit_time = std::chrono::steady_clock::now();
+    cv::Rect2f roi;
+    context.detect_mode = roi_scheduler_.Schedule(roi);
+    if (context.detect_mode == RoiScheduler::kRoi)
+        context.ticket = armor_detector_.Submit(context.frame, roi);
+    else
+        context.ticket = armor_detector_.Submit(context.frame);
+    return true;
+}
+
+bool Controller::CollectStage(FrameContext &context) {
+    if (!context.candidate) {
+        context.boxes.clear();
+        return true;
+    }
+
+    armor_detector_.Wait(context.ticket, context.boxes);
+    roi_scheduler_.Record(context.frame.time_stamp, context.detect_mode,
+                          std::chrono::duration<double, std::milli>(
+                                  std::chrono::steady_clock::now() - context.submit_time).count(),
+                          !context.boxes.empty());
+    return true;
+}
+
+void Controller::AddDetectStages() {
+    if (!armor_detector_ready_ && !light_bar_detector_.Initialized()) {
+        LOG(WARNING) << "No armor detector is initialized, armor detection is disabled.";
+        return;
+    }
+    if (!armor_detector_.AsyncEnabled() || light_bar_detector_.Initialized() || armor_cascade_.Enabled()
+        || armor_tiler_.Enabled()) {
+        LOG_IF(WARNING, armor_detector_.AsyncEnabled())
+                        << "Asynchronous detection is disabled with light-bar detector, cascade or tiling.";
+        pipeline_.AddStage("detect", [this](FrameContext &context) { return DetectStage(context); });
+        return;
+    }
+    LOG_IF(WARNING, armor_tracker_.MaxInterval() > 1)
+                    << "Armor tracker is disabled with asynchronous detection.";
+    pipeline_.AddStage("submit", [this](FrameContext &context) { return SubmitStage(context); });
+    pipeline_.AddStage("collect", [this](FrameContext &context) { return CollectStage(context); });
+}
+
+bool Controller::BattlefieldStage(FrameContext &context) {
+    context.armors.clear();
+    for (const auto &box: context.boxes)
+        context.armors.emplace_back(box,
+                                    image_provider_->IntrinsicMatrix(),
+                                    image_provider_->DistortionMatrix(),
+                                    context.receive_packet.quaternion);
+    context.battlefield = Battlefield(context.frame.time_stamp,
+                                      context.receive_packet.bullet_speed,
+                                      context.receive_packet.quaternion,
+                                      context.armors);
+    return true;
+}
+
+void Controller::RunPipeline() {
+    pipeline_.Run();
+    pipeline_.Report();
+    roi_scheduler_.Report();
+    if (color_gate_.Enabled()) {
+        const auto statistics = color_gate_.GetStatistics();
+        LOG(INFO) << "Armor color gate: checked " << statistics.frames << " frames"
+                  << ", skipped detection of " << statistics.rejected << " frames"
+                  << ", average time " << statistics.average_time << " ms.";
+    }
+    if (armor_cascade_.Enabled()) {
+        const auto statistics = armor_cascade_.GetStatistics();
+        LOG(INFO) << "Armor cascade: screened " << statistics.frames << " frames"
+                  << ", rejected " << statistics.decisions[ArmorCascade::kRejected]
+                  << ", accepted " << statistics.decisions[ArmorCascade::kAccepted]
+                  << ", detected in ROI " << statistics.decisions[ArmorCascade::kRoi]
+                  << ", detected in full frame " << statistics.decisions[ArmorCascade::kFullFrame]
+                  << ", average time " << statistics.average_time << " ms"
+                  << " (" << statistics.average_proposal_time << " ms of light-bar detector).";
+    }
+    if (armor_detector_.AsyncEnabled()) {
+        const auto statistics = armor_detector_.AsyncStatistics();
+        LOG(INFO) << "Asynchronous armor detection: " << statistics.requests << " requests"
+                  << ", " << statistics.failures << " failed"
+                  << ", average queue depth " << statistics.average_queue_depth
+                  << ", average latency " << statistics.average_latency << " ms"
+                  << ", max latency " << statistics.max_latency << " ms.";
+    } else if (armor_tracker_.MaxInterval() > 1) {
+        const auto statistics = armor_tracker_.GetStatistics();
+        LOG(INFO) << "Armor tracker: detected " << statistics.detected_frames << " frames"
+                  << ", tracked " << statistics.tracked_frames << " frames"
+                  << ", average drift " << statistics.average_drift << " px"
+                  << " in " << statistics.drift_samples << " samples"
+                  << ", final interval " << armor_tracker_.Interval() << ".";
+    }
+
+    if (CmdlineArgParser::Instance().RunWithGimbal())
+        serial_->StopCommunication();
+}
@@ -8,12 +8,40 @@
 #ifndef CONTROLLER_BASE_H_
 #define CONTROLLER_BASE_H_
 
+#include <unistd.h>
 #include "lang-feature-extension/disable_constructor.h"
+#include "clock/clock.h"
+#include "cmdline-arg-parser/cmdline_arg_parser.h"
 #include "data-structure/communication.h"
 #include "digital-twin/battlefield.h"
 #include "serial/serial.h"
 #include "image-provider-base/image_provider_base.h"
 #include "detector-armor/detector_armor.h"
+#include "detector-armor/detector_armor_cascade.h"
+#include "detector-armor/detector_armor_color_gate.h"
+#include "detector-armor/detector_armor_light_bar.h"
+#include "detector-armor/detector_armor_tiler.h"
+#include "detector-armor/detector_armor_tracker.h"
+#include "pipeline.h"
+#include "roi_scheduler.h"
+
+/**
+ * \brief Data of a single frame passing through controller pipeline stages.
+ * \attention Objects are reused by pipeline, see Pipeline for details.
+ */
+struct FrameContext {
+    Frame frame;
+    ReceivePacket receive_packet;
+    std::vector<bbox_t> boxes;
+    std::vector<Armor> armors;
+    Battlefield battlefield;
+    SendPacket send_packet{};
+    Eigen::Vector3d translation_vector_cam_predict;  ///< Predicted point in camera coordinate, for drawing.
+    bool candidate{true};                            ///< Whether color gate passes, no detection if not.
+    ArmorDetector::Ticket ticket{};                  ///< Ticket of asynchronous detection.
+    RoiScheduler::Modes detect_mode{};               ///< Detection mode of asynchronous detection.
+    std::chrono::steady_clock::time_point submit_time;  ///< Submitting time of asynchronous detection.
+};
 
 /**
  * \brief Controller base class.
@@ -30,10 +58,30 @@ public:
     Controller() :
             image_provider_(nullptr),
             serial_(nullptr),
-            armor_detector_(),
             send_packet_(),
-            receive_packet_() {
-        armor_detector_.Initialize("../assets/models/armor_detector_model.onnx");
+            receive_packet_(),
+            armor_detector_(),
+            armor_detector_ready_(false),
+            pipeline_(kPipelineDepth),
+            roi_scheduler_(CmdlineArgParser::Instance().DetectorRoi(),
+                           std::max(CmdlineArgParser::Instance().DetectorRoiInterval(), 0),
+                           CmdlineArgParser::Instance().DetectorRoiScale()),
+            armor_tracker_(std::max(CmdlineArgParser::Instance().DetectorTrackInterval(), 1)) {
+        // Replays follow time stamps of frames, so that they run at any speed with the same results.
+        if (!CmdlineArgParser::Instance().RunWithCamera()) {
+            frame_clock_ = std::make_shared<FrameClock>();
+            Clock::SetGlobal(frame_clock_);
+        }
+        // Failure is reported by AddDetectStages, as light-bar detector may still be initialized by subclasses.
+        armor_detector_ready_ = armor_detector_.Initialize("../assets/models/armor_detector_model.onnx",
+                                                           CmdlineArgParser::Instance().DetectorBackend());
+        armor_detector_.SetIouThreshold(CmdlineArgParser::Instance().DetectorIouThreshold());
+        armor_detector_.SetMaxBatchSize(CmdlineArgParser::Instance().DetectorMaxBatchSize());
+        armor_detector_.DumpOutput(CmdlineArgParser::Instance().DetectorDumpFile());
+        // Enough slots for all frames between submitting and collecting stages, so submitting never waits.
+        if (armor_detector_ready_ && CmdlineArgParser::Instance().DetectorAsyncSlots() > 0)
+            armor_detector_.EnableAsync(std::max(CmdlineArgParser::Instance().DetectorAsyncSlots(),
+                                                 int(kPipelineDepth) + 2));
     }
 
     virtual bool Initialize() = 0;
@@ -47,15 +95,105 @@ protected:
     SendPacket send_packet_;
     ReceivePacket receive_packet_;
     ArmorDetector armor_detector_;
+    bool armor_detector_ready_;  ///< Whether armor detector is initialized.
     std::vector<bbox_t> boxes_;  ///< Store boxes here to speed up.
     std::vector<Armor> armors_;  ///< Store armors here to speed up.
     Battlefield battlefield_;
+    Pipeline<FrameContext> pipeline_;  ///< Pipeline executor, stages are added by subclasses.
+    RoiScheduler roi_scheduler_;       ///< Detection mode scheduler, updated by predicting stages.
+    ArmorTracker armor_tracker_;       ///< Tracker of boxes between detections, only used in detection stage.
+    ColorGate color_gate_;             ///< Pre-filter of detection, enabled by subclasses with their config.
+    LightBarDetector light_bar_detector_;  ///< CPU-only detector replacing armor_detector_ when initialized.
+    ArmorTiler armor_tiler_;           ///< Tiled full frame detection, enabled by subclasses with their config.
+    ArmorCascade armor_cascade_;       ///< Light-bar screening before full frame detection, enabled by config.
+    std::shared_ptr<FrameClock> frame_clock_;  ///< Global clock when replaying videos, nullptr with cameras.
 
     static bool exit_signal_;  ///< Global normal exit signal.
 
+    /**
+     * \brief Source stage, get a frame and receive data from serial port.
+     * \param [out] context Frame context to fill.
+     * \return Whether a frame is got and program is not exiting.
+     */
+    bool CaptureStage(FrameContext &context);
+
+    /**
+     * \brief Initialize color gate, light-bar detector, cascade and tiling with configs of a robot.
+     * \details Each of them is disabled with a warning when its config fails to load.
+     *   Color gate and light-bar detector are only initialized when enabled by command line flags.
+     * \param [in] config_dir Config directory of robot, e.g. "../config/infantry".
+     */
+    void InitializeDetectors(const std::string &config_dir);
+
+    /**
+     * \brief Detect armor boxes in frame, or in predicted ROI when tracking.
+     * \details When detection interval is larger than 1, boxes are tracked from the last frame between detections.
+     *   Frames rejected by color gate output no box without detection.
+     *   Light-bar detector is used instead of armor detector when it is initialized.
+     *   Full frames are screened by cascade when it is enabled, or detected in tiles when tiling is enabled.
+     * \param [in,out] context Frame context.
+     * \return Always true.
+     */
+    bool DetectStage(FrameContext &context);
+
+    /**
+     * \brief Submit frame for asynchronous detection, in full frame or predicted ROI.
+     * \param [in,out] context Frame context.
+     * \return Always true.
+     */
+    bool SubmitStage(FrameContext &context);
+
+    /**
+     * \brief Collect boxes of asynchronous detection submitted by SubmitStage.
+     * \param [in,out] context Frame context.
+     * \return Always true.
+     */
+    bool CollectStage(FrameContext &context);
+
+    /**
+     * \brief Add detection stages to pipeline.
+     * \details Adds "submit" and "collect" stages when asynchronous detection is enabled without light-bar detector,
+     *   cascade and tiling, otherwise adds a single "detect" stage.
+     *   Tracking between detections is only supported by the latter.
+     *   No stage is added when neither armor detector nor light-bar detector is initialized, so all frames have
+     *   no box.
+     */
+    void AddDetectStages();
+
+    /**
+     * \brief Convert boxes to armors and build battlefield.
+     * \param [in,out] context Frame context.
+     * \return Always true.
+     */
+    bool BattlefieldStage(FrameContext &context);
+
+    /**
+     * \brief Advance global clock to a frame when replaying videos, call it before predicting this frame.
+     * \param [in] frame Frame to predict.
+     */
+    inline void UpdateClock(const Frame &frame) {
+        if (frame_clock_)
+            frame_clock_->Update(frame.time_stamp);
+    }
+
+    /**
+     * \brief Wait for camera to get ready, skipped when replaying videos.
+     */
+    static inline void WaitForCamera() {
+        if (CmdlineArgParser::Instance().RunWithCamera())
+            sleep(2);
+    }
+
+    /**
+     * \brief Run pipeline until exiting, then report statistics and stop serial communication.
+     * \attention Stages should be added to pipeline before calling this function.
+     */
+    void RunPipeline();
+
     /**
      * \brief Convert boxes to armors.
      * \attention Since std::vector is not threading safe, do not use it in different threads.
+     * \note Pipeline stages use BattlefieldStage instead.
      */
     inline void BboxToArmor() {
         armors_.clear();
@@ -65,6 +203,9 @@ protected:
                                  image_provider_->DistortionMatrix(),
                                  receive_packet_.quaternion);
     }
+
+private:
+    constexpr static unsigned int kPipelineDepth = 2;  ///< Capacity of each queue between pipeline stages.
 };
 
 #endif  // CONTROLLER_BASE_H_
@@ -0,0 +1,347 @@
+/**
+ * Multi-stage pipeline executor header.
+ * \author trantuan-20048607
+ * \date 2022.3.18
+ * \details Stages of a pipeline run in their own threads and hand data to each other through bounded queues,
+ *   so capture, inference, prediction and output of different frames can overlap.
+ */
+
+#ifndef PIPELINE_H_
+#define PIPELINE_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <glog/logging.h>
+#include "lang-feature-extension/attr_reader.h"
+#include "lang-feature-extension/disable_constructor.h"
+
+/**
+ * \brief Blocking FIFO queue with fixed capacity.
+ * \tparam T Type of elements in this queue.
+ */
+template<typename T>
+class BoundedQueue : NO_COPY, NO_MOVE {
+public:
+    explicit BoundedQueue(unsigned int capacity) : capacity_(capacity), closed_(false) {}
+
+    ATTR_READER(capacity_, Capacity)
+
+    /**
+     * \brief Push an element, wait while this queue is full.
+     * \param [in] obj Input element, will be moved.
+     * \return Whether element is pushed, false when queue is closed.
+     */
+    bool Push(T &&obj) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_full_.wait(lock, [this] { return closed_ || queue_.size() < capacity_; });
+        if (closed_)
+            return false;
+        queue_.push_back(std::move(obj));
+        lock.unlock();
+        not_empty_.notify_one();
+        return true;
+    }
+
+    /**
+     * \brief Pop an element, wait while this queue is empty.
+     * \param [out] obj Output element.
+     * \return Whether an element is popped, false when queue is closed.
+     */
+    bool Pop(T &obj) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_empty_.wait(lock, [this] { return closed_ || !queue_.empty(); });
+        if (closed_)
+            return false;
+        obj = std::move(queue_.front());
+        queue_.pop_front();
+        lock.unlock();
+        not_full_.notify_one();
+        return true;
+    }
+
+    /// \brief Close this queue and wake up all waiting threads.
+    void Close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            closed_ = true;
+        }
+        not_empty_.notify_all();
+        not_full_.notify_all();
+    }
+
+    [[nodiscard]] size_t Size() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return queue_.size();
+    }
+
+private:
+    const unsigned int capacity_;  ///< Max number of elements.
+    bool closed_;                  ///< Closed flag, all operations will fail after closing.
+    std::deque<T> queue_;          ///< Elements container.
+    mutable std::mutex mutex_;     ///< Mutex lock for all members above.
+    std::condition_variable not_empty_;
+    std::condition_variable not_full_;
+};
+
+/**
+ * \brief Multi-stage pipeline executor.
+ * \details Every stage is a function processing one data object:  \n
+ *   (First stage) Source, fill the data object. Return false to finish the stream.  \n
+ *   (Middle stages) Return false to drop current data object.  \n
+ *   (Last stage) Sink, runs in the thread calling Run(). Return false to stop the pipeline.  \n
+ *   Each stage owns one thread and the order of data objects is kept from source to sink.
+ *   Data objects are allocated once and recycled, so the number of data objects in flight is bounded
+ *   and a slow stage will block its upstream stages.
+ * \tparam T Type of data object.
+ * \attention Data objects are reused, stages must overwrite anything they read later.
+ */
+template<typename T>
+class Pipeline : NO_COPY, NO_MOVE {
+public:
+    typedef std::function<bool(T &)> StageFunction;
+
+    /// \brief Statistics of a single stage.
+    struct StageStatistics {
+        std::string name;            ///< Stage name.
+        uint64_t processed;          ///< Number of processed data objects.
+        uint64_t dropped;            ///< Number of data objects dropped by this stage.
+        double average_time;         ///< Average processing time in milliseconds.
+        double occupancy;            ///< Ratio of busy time to total running time.
+        double average_queue_depth;  ///< Average number of data objects waiting before this stage.
+    };
+
+    /**
+     * \param [in] depth Capacity of each queue between stages.
+     */
+    explicit Pipeline(unsigned int depth = 2) : depth_(depth), running_(false), stop_flag_(false) {}
+
+    ~Pipeline() {
+        Stop();
+        JoinThreads();
+    }
+
+    /**
+     * \brief Append a stage to the end of this pipeline.
+     * \param [in] name Stage name, used in statistics.
+     * \param [in] function Stage function.
+     */
+    void AddStage(const std::string &name, StageFunction function) {
+        stages_.emplace_back(std::make_unique<Stage>(name, std::move(function)));
+    }
+
+    /**
+     * \brief Run this pipeline and wait for it to finish.
+     * \details Returns when source finishes the stream, sink stops the pipeline or Stop() is called.
+     */
+    void Run() {
+        if (stages_.empty()) {
+            LOG(ERROR) << "No stage added to pipeline.";
+            return;
+        }
+
+        stop_flag_ = false;
+        const auto num_data = depth_ * stages_.size();
+        free_queue_ = std::make_unique<BoundedQueue<DataPtr>>(num_data);
+        for (size_t i = 0; i < num_data; ++i)
+            free_queue_->Push(std::make_unique<Data>());
+        for (size_t i = 1; i < stages_.size(); ++i)
+            stages_[i]->input = std::make_unique<BoundedQueue<DataPtr>>(depth_);
+
+        start_time_ = std::chrono::steady_clock::now();
+        running_ = true;
+        if (stages_.size() == 1)
+            SourceLoop();
+        else {
+            threads_.emplace_back(&Pipeline::SourceLoop, this);
+            for (size_t i = 1; i < stages_.size() - 1; ++i)
+                threads_.emplace_back(&Pipeline::StageLoop, this, i);
+            SinkLoop();
+        }
+
+        Stop();
+        JoinThreads();
+        stop_time_ = std::chrono::steady_clock::now();
+        running_ = false;
+    }
+
+    /// \brief Stop this pipeline, data objects in flight will be discarded.
+    void Stop() {
+        stop_flag_ = true;
+        if (free_queue_)
+            free_queue_->Close();
+        for (auto &stage: stages_)
+            if (stage->input)
+                stage->input->Close();
+    }
+
+    /// \return Statistics of all stages, in order.
+    [[nodiscard]] std::vector<StageStatistics> Statistics() const {
+        const auto total_time = double(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                (running_ ? std::chrono::steady_clock::now() : stop_time_) - start_time_).count());
+        std::vector<StageStatistics> statistics;
+        for (const auto &stage: stages_) {
+            const auto processed = stage->processed.load();
+            const auto busy_time = double(stage->busy_time.load());
+            statistics.push_back({stage->name,
+                                  processed,
+                                  stage->dropped.load(),
+                                  processed ? busy_time / processed * 1e-6 : 0,
+                                  total_time > 0 ? busy_time / total_time : 0,
+                                  processed ? double(stage->queue_depth.load()) / processed : 0});
+        }
+        return statistics;
+    }
+
+    /// \return Number of data objects arrived at sink per second.
+    [[nodiscard]] double Throughput() const {
+        if (stages_.empty())
+            return 0;
+        const auto total_time = double(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                (running_ ? std::chrono::steady_clock::now() : stop_time_) - start_time_).count());
+        return total_time > 0 ? double(stages_.back()->processed.load()) / total_time * 1e9 : 0;
+    }
+
+    /// \brief Print statistics of all stages to log.
+    void Report() const {
+        LOG(INFO) << "Pipeline throughput: " << Throughput() << " fps.";
+        for (const auto &stage: Statistics())
+            LOG(INFO) << "Stage " << stage.name
+                      << ": processed " << stage.processed
+                      << ", dropped " << stage.dropped
+                      << ", average time " << stage.average_time << " ms"
+                      << ", occupancy " << stage.occupancy * 100 << "%"
+                      << ", average queue depth " << stage.average_queue_depth << ".";
+    }
+
+private:
+    /// \brief Data object with its sequence number.
+    struct Data {
+        uint64_t sequence = 0;
+        T data;
+    };
+
+    typedef std::unique_ptr<Data> DataPtr;
+
+    struct Stage {
+        std::string name;
+        StageFunction function;
+        std::unique_ptr<BoundedQueue<DataPtr>> input;  ///< Input queue, nullptr for source.
+        std::atomic<uint64_t> processed;
+        std::atomic<uint64_t> dropped;
+        std::atomic<uint64_t> busy_time;               ///< Total processing time in nanoseconds.
+        std::atomic<uint64_t> queue_depth;             ///< Sum of input queue depth sampled at each pop.
+
+        Stage(std::string _name, StageFunction _function) :
+                name(std::move(_name)),
+                function(std::move(_function)),
+                input(nullptr),
+                processed(0),
+                dropped(0),
+                busy_time(0),
+                queue_depth(0) {}
+    };
+
+    /**
+     * \brief Call the function of a stage and record its statistics.
+     * \return Return value of stage function.
+     */
+    inline static bool Process(Stage &stage, T &data) {
+        auto start_time = std::chrono::steady_clock::now();
+        bool result = stage.function(data);
+        stage.busy_time += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start_time).count();
+        ++stage.processed;
+        if (stage.input)
+            stage.queue_depth += stage.input->Size();
+        return result;
+    }
+
+    /**
+     * \brief Hand a data object to the next stage, or recycle it when it leaves the last stage.
+     * \param [in] index Index of current stage.
+     * \param [in] data Data object, nullptr means the end of stream.
+     * \return Whether the pipeline is still running.
+     */
+    inline bool Forward(size_t index, DataPtr &&data) {
+        if (index + 1 < stages_.size())
+            return stages_[index + 1]->input->Push(std::move(data));
+        return !data || free_queue_->Push(std::move(data));
+    }
+
+    void SourceLoop() {
+        auto &stage = *stages_.front();
+        uint64_t sequence = 0;
+        DataPtr data;
+        while (!stop_flag_ && free_queue_->Pop(data)) {
+            data->sequence = sequence++;
+            if (!Process(stage, data->data)) {
+                Forward(0, nullptr);
+                break;
+            }
+            if (!Forward(0, std::move(data)))
+                break;
+        }
+    }
+
+    void StageLoop(size_t index) {
+        auto &stage = *stages_[index];
+        DataPtr data;
+        while (stage.input->Pop(data)) {
+            if (!data) {
+                Forward(index, nullptr);
+                break;
+            }
+            if (Process(stage, data->data)) {
+                if (!Forward(index, std::move(data)))
+                    break;
+            } else {
+                ++stage.dropped;
+                if (!free_queue_->Push(std::move(data)))
+                    break;
+            }
+        }
+    }
+
+    void SinkLoop() {
+        auto &stage = *stages_.back();
+        uint64_t last_sequence = 0;
+        bool first = true;
+        DataPtr data;
+        while (stage.input->Pop(data)) {
+            if (!data)
+                break;
+            DCHECK(first || data->sequence > last_sequence) << "Pipeline data arrived out of order.";
+            first = false;
+            last_sequence = data->sequence;
+            bool result = Process(stage, data->data);
+            if (!free_queue_->Push(std::move(data)) || !result)
+                break;
+        }
+    }
+
+    void JoinThreads() {
+        for (auto &thread: threads_)
+            if (thread.joinable())
+                thread.join();
+        threads_.clear();
+    }
+
+    const unsigned int depth_;                        ///< Capacity of each queue.
+    std::atomic<bool> running_;                       ///< Running flag, for statistics.
+    std::atomic<bool> stop_flag_;                     ///< Stop flag for all threads.
+    std::vector<std::unique_ptr<Stage>> stages_;      ///< All stages, in order.
+    std::unique_ptr<BoundedQueue<DataPtr>> free_queue_;  ///< Recycled data objects waiting for source.
+    std::vector<std::thread> threads_;                ///< Threads of all stages except sink.
+    std::chrono::steady_clock::time_point start_time_;
+    std::chrono::steady_clock::time_point stop_time_;
+};
+
+#endif  // PIPELINE_H_
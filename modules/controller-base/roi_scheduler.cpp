@@ -0,0 +1,59 @@
+#include <glog/logging.h>
+#include "roi_scheduler.h"
+
+void RoiScheduler::Update(uint64_t time_stamp, bool locked, const cv::Rect2f &roi) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // Predictions of frames before losing track are out of date.
+    if (time_stamp <= lost_time_stamp_)
+        return;
+    tracking_ = locked;
+    if (locked) {
+        const auto center_x = roi.x + roi.width / 2, center_y = roi.y + roi.height / 2;
+        const auto width = roi.width * roi_scale_, height = roi.height * roi_scale_;
+        roi_ = {center_x - width / 2, center_y - height / 2, width, height};
+    }
+}
+
+RoiScheduler::Modes RoiScheduler::Schedule(cv::Rect2f &roi) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!enabled_ || !tracking_ || roi_frames_ >= full_frame_interval_) {
+        roi_frames_ = 0;
+        return kFullFrame;
+    }
+    ++roi_frames_;
+    roi = roi_;
+    return kRoi;
+}
+
+void RoiScheduler::Record(uint64_t time_stamp, Modes mode, double time, bool hit) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto &data = statistics_[mode];
+    ++data.frames;
+    data.hits += hit;
+    data.total_time += time;
+
+    // Fall back to full frame scan immediately when target is missing in ROI.
+    if (mode == kRoi && !hit) {
+        tracking_ = false;
+        lost_time_stamp_ = time_stamp;
+    }
+}
+
+RoiScheduler::ModeStatistics RoiScheduler::Statistics(Modes mode) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto &data = statistics_[mode];
+    return {data.frames, data.hits, data.frames ? data.total_time / double(data.frames) : 0};
+}
+
+void RoiScheduler::Report() const {
+    const char *names[SIZE] = {"full frame", "ROI", "tracked"};
+    for (int mode = kFullFrame; mode < SIZE; ++mode) {
+        const auto statistics = Statistics(Modes(mode));
+        LOG(INFO) << "Armor detection in " << names[mode] << " mode: "
+                  << statistics.frames << " frames"
+                  << ", hit rate " << (statistics.frames ? 100. * double(statistics.hits)
+                                                           / double(statistics.frames) : 0) << "%"
+                  << ", average time " << statistics.average_time << " ms.";
+    }
+}
@@ -0,0 +1,105 @@
+/**
+ * Detection ROI scheduler header.
+ * \author trantuan-20048607
+ * \date 2022.3.29
+ * \details Choose between full frame and predicted ROI for armor detection, and collect statistics of all modes.
+ */
+
+#ifndef ROI_SCHEDULER_H_
+#define ROI_SCHEDULER_H_
+
+#include <mutex>
+#include <opencv2/core/types.hpp>
+#include "lang-feature-extension/attr_reader.h"
+#include "lang-feature-extension/disable_constructor.h"
+
+/**
+ * \brief Tracking mode scheduler of armor detector.
+ * \details Predictor stage updates the predicted ROI of locked target, and detection stage asks for the mode
+ *   of next frame. ROI mode is used while the track is alive, with a full frame scan every few frames
+ *   for re-acquisition of other targets. The track is lost when predictor unlocks or nothing is found in ROI.
+ * \note Functions are called in different pipeline stages, so all members are protected by a mutex.
+ */
+class RoiScheduler : NO_COPY, NO_MOVE {
+public:
+    /// Detection modes.
+    enum Modes {
+        kFullFrame = 0,
+        kRoi = 1,
+        kTracked = 2,  ///< Boxes are tracked from the last frame without detection, see ArmorTracker.
+        SIZE [[maybe_unused]] = 3
+    };
+
+    /// \brief Statistics of a detection mode.
+    struct ModeStatistics {
+        uint64_t frames;      ///< Number of frames processed in this mode.
+        uint64_t hits;        ///< Number of frames with any box found.
+        double average_time;  ///< Average detection time in milliseconds.
+    };
+
+    /**
+     * \param [in] enabled Enable ROI mode, otherwise always use full frame mode.
+     * \param [in] full_frame_interval Run a full frame scan after this number of ROI frames.
+     * \param [in] roi_scale ROI length and width coefficient relative to target.
+     */
+    RoiScheduler(bool enabled, unsigned int full_frame_interval, float roi_scale) :
+            enabled_(enabled),
+            full_frame_interval_(full_frame_interval),
+            roi_scale_(roi_scale),
+            tracking_(false),
+            lost_time_stamp_(0),
+            roi_frames_(0),
+            statistics_() {}
+
+    ATTR_READER(enabled_, Enabled)
+
+    /**
+     * \brief Update predicted ROI of locked target.
+     * \param [in] time_stamp Time stamp of frame used for prediction.
+     * \param [in] locked Whether a target is locked.
+     * \param [in] roi ROI of target size, will be scaled by roi_scale.
+     */
+    void Update(uint64_t time_stamp, bool locked, const cv::Rect2f &roi);
+
+    /**
+     * \brief Choose detection mode of next frame.
+     * \param [out] roi ROI to detect in ROI mode.
+     * \return Detection mode.
+     */
+    Modes Schedule(cv::Rect2f &roi);
+
+    /**
+     * \brief Record result of a detection.
+     * \param [in] time_stamp Time stamp of detected frame.
+     * \param [in] mode Detection mode.
+     * \param [in] time Detection time in milliseconds.
+     * \param [in] hit Whether any box is found.
+     */
+    void Record(uint64_t time_stamp, Modes mode, double time, bool hit);
+
+    /// \return Statistics of a mode.
+    [[nodiscard]] ModeStatistics Statistics(Modes mode) const;
+
+    /// \brief Print statistics of all modes to log.
+    void Report() const;
+
+private:
+    /// \brief Accumulated data of a mode.
+    struct ModeData {
+        uint64_t frames;
+        uint64_t hits;
+        double total_time;
+    };
+
+    const bool enabled_;                       ///< ROI mode is enabled.
+    const unsigned int full_frame_interval_;  ///< Max number of ROI frames between full frame scans.
+    const float roi_scale_;                   ///< ROI length and width coefficient relative to target.
+    bool tracking_;                           ///< Track is alive.
+    uint64_t lost_time_stamp_;                ///< Time stamp of the frame where track was lost.
+    unsigned int roi_frames_;                 ///< Number of ROI frames since the last full frame scan.
+    cv::Rect2f roi_;                          ///< Latest predicted ROI, scaled.
+    ModeData statistics_[SIZE];               ///< Statistics of all modes.
+    mutable std::mutex mutex_;                ///< Mutex lock for all members above.
+};
+
+#endif  // ROI_SCHEDULER_H_
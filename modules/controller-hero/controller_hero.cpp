@@ -38,27 +38,28 @@ bool HeroController::Initialize() {
 
     }
 
+    InitializeDetectors("../config/hero");
+
     LOG(INFO) << "Hero controller is ready.";
     return true;
 }
 
 void HeroController::Run() {
-    sleep(2);
-
-    while (!exit_signal_) {
-        if (!image_provider_->GetFrame(frame_))
-            break;
+    Eigen::Matrix3d camera_matrix;
+    cv::cv2eigen(image_provider_->IntrinsicMatrix(), camera_matrix);
 
-        if (CmdlineArgParser::Instance().RunWithGimbal()) {
-            SerialReceivePacket serial_receive_packet{};
-            serial_->GetData(serial_receive_packet, std::chrono::milliseconds(5));
-            receive_packet_ = ReceivePacket(serial_receive_packet);
-        }
+    WaitForCamera();
 
-        boxes_ = armor_detector_(frame_.image);
+    pipeline_.AddStage("capture", [this](FrameContext &context) { return CaptureStage(context); });
+    AddDetectStages();
+    pipeline_.AddStage("battlefield", [this](FrameContext &context) { return BattlefieldStage(context); });
+    pipeline_.AddStage("output", [&](FrameContext &context) {
+        if (CmdlineArgParser::Instance().RunHeadless())
+            return true;
 
-        auto img = frame_.image.clone();
-        for (const auto &box: boxes_) {
+        // Armor tracker keeps its own grey copy of frames, so output is the last stage reading this frame.
+        cv::Mat img = context.frame.Image();
+        for (const auto &box: context.boxes) {
             line(img, box.points[0], box.points[1], cv::Scalar(0, 255, 0), 2);
             line(img, box.points[1], box.points[2], cv::Scalar(0, 255, 0), 2);
             line(img, box.points[2], box.points[3], cv::Scalar(0, 255, 0), 2);
@@ -67,30 +68,16 @@ void HeroController::Run() {
                         cv::FONT_HERSHEY_SIMPLEX, 1,
                         cv::Scalar((box.color == 0) * 255, 0, (box.color == 1) * 255), 2);
         }
-        BboxToArmor();
-        battlefield_ = Battlefield(frame_.time_stamp,
-                                   receive_packet_.bullet_speed,
-                                   receive_packet_.quaternion,
-                                   armors_);
-        Eigen::Matrix3d camera_matrix;
         OutpostPredictor outpost_predictor;
-        cv::cv2eigen(image_provider_->IntrinsicMatrix(), camera_matrix);
+        debug::Painter::Instance().UpdateImage(context.frame.Image());
         auto point = camera_matrix * outpost_predictor.TranslationVectorCamPredict() / outpost_predictor.TranslationVectorCamPredict()(2, 0);
         cv::Point2d point_cv = {point[0], point[1]};
         debug::Painter::Instance().DrawPoint(point_cv, cv::Scalar(0, 0, 255), 1, 10);
         debug::Painter::Instance().ShowImage("ARMOR DETECT");
 
         cv::imshow("Hero", img);
-        if ((cv::waitKey(1) & 0xff) == 'q')
-            break;
-
-
-
-
-        boxes_.clear();
-        armors_.clear();
-    }
+        return (cv::waitKey(1) & 0xff) != 'q';
+    });
 
-    if (CmdlineArgParser::Instance().RunWithGimbal())
-        serial_->StopCommunication();
+    RunPipeline();
 }
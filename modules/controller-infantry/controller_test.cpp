@@ -47,73 +47,93 @@ bool InfantryController::Initialize() {
         LOG(INFO) << "Rune detector initialize successfully!";
     else
         LOG(ERROR) << "Rune detector initialize unsuccessfully!";
-    if (RunePredictor::Initialize("../config/infantry/rune-param.yaml"))
+    if (rune_predictor_.Initialize("../config/infantry/rune-predictor-param.yaml"))
         LOG(INFO) << "Rune predictor initialize successfully!";
     else
         LOG(ERROR) << "Rune predictor initialize unsuccessfully!";
 
+    InitializeDetectors("../config/infantry");
+
     LOG(INFO) << "Infantry controller is ready.";
     return true;
 }
 
 void InfantryController::Run() {
     ArmorPredictor armor_predictor(Entity::Colors::kBlue, true);
+    Eigen::Matrix3d camera_matrix;
+    cv::cv2eigen(image_provider_->IntrinsicMatrix(), camera_matrix);
 
-    sleep(2);
+    WaitForCamera();
 
-    while (!exit_signal_) {
-        if (!image_provider_->GetFrame(frame_))
-            break;
-        cv::waitKey(1);
-        debug::Painter::Instance().UpdateImage(frame_.image);
+    pipeline_.AddStage("capture", [this](FrameContext &context) { return CaptureStage(context); });
 
-        if (CmdlineArgParser::Instance().RunWithGimbal()) {
-            SerialReceivePacket serial_receive_packet{};
-            serial_->GetData(serial_receive_packet, std::chrono::milliseconds(5));
-            receive_packet_ = ReceivePacket(serial_receive_packet);
-        }
+    if (CmdlineArgParser::Instance().RuneModeRune()) {
+        // Rune detector and predictor share the painter, so they run in one stage.
+        pipeline_.AddStage("rune", [&](FrameContext &context) {
+            UpdateClock(context.frame);
+            debug::Painter::Instance().UpdateImage(context.frame.Image());
+            power_rune_ = rune_detector_.Run(context.frame);
+            context.send_packet = SendPacket(rune_predictor_.Predict(power_rune_));
+            rune_detector_.Track(rune_predictor_.CalRadius());
+            if (CmdlineArgParser::Instance().RunHeadless())
+                return true;
 
-        if (CmdlineArgParser::Instance().RuneModeRune()) {
-            power_rune_ = rune_detector_.Run(frame_);
-            send_packet_ = SendPacket(rune_predictor_.Predict(power_rune_));
             debug::Painter::Instance().DrawPoint(rune_predictor_.FinalTargetPoint(),
                                                  cv::Scalar(0, 255, 0), 3, 3);
             debug::Painter::Instance().ShowImage("Rune");
-        } else {
-            boxes_ = armor_detector_(frame_.image);
-            BboxToArmor();
-            battlefield_ = Battlefield(frame_.time_stamp, receive_packet_.bullet_speed, receive_packet_.quaternion,
-                                       armors_);
+            return (cv::waitKey(1) & 0xff) != 'q';
+        });
+    } else {
+        AddDetectStages();
+        pipeline_.AddStage("battlefield", [this](FrameContext &context) { return BattlefieldStage(context); });
+        pipeline_.AddStage("predict", [&](FrameContext &context) {
+            UpdateClock(context.frame);
             /// TODO mode switch
-            send_packet_ = SendPacket(armor_predictor.Run(battlefield_, ArmorPredictor::Modes::kAntiTop));
-            auto img = frame_.image.clone();
-            debug::Painter::Instance().UpdateImage(frame_.image);
-            for (const auto &box: boxes_) {
+            context.send_packet = SendPacket(armor_predictor.Run(context.battlefield,
+                                                                 ArmorPredictor::Modes::kAntiTop));
+            context.translation_vector_cam_predict = armor_predictor.TranslationVectorCamPredict();
+            cv::Rect2f roi;
+            bool locked = armor_predictor.PredictedROI(camera_matrix, roi);
+            roi_scheduler_.Update(context.frame.time_stamp, locked, roi);
+            return true;
+        });
+        pipeline_.AddStage("output", [&](FrameContext &context) {
+            if (CmdlineArgParser::Instance().RunHeadless())
+                return true;
+
+            debug::Painter::Instance().UpdateImage(context.frame.Image());
+            for (const auto &box: context.boxes) {
                 debug::Painter::Instance().DrawRotatedRectangle(box.points[0],
                                                                 box.points[1],
                                                                 box.points[2],
                                                                 box.points[3],
                                                                 cv::Scalar(0, 255, 0), 2);
                 debug::Painter::Instance().DrawText(std::to_string(box.id), box.points[0], 255, 2);
-                debug::Painter::Instance().DrawPoint(armors_.front().Center(), cv::Scalar(100, 255, 100));
+                debug::Painter::Instance().DrawPoint(context.armors.front().Center(), cv::Scalar(100, 255, 100));
             }
-            Eigen::Matrix3d camera_matrix;
-            cv::cv2eigen(image_provider_->IntrinsicMatrix(), camera_matrix);
-            auto point = camera_matrix * armor_predictor.TranslationVectorCamPredict() / armor_predictor.TranslationVectorCamPredict()(2, 0);
+            auto point = camera_matrix * context.translation_vector_cam_predict
+                         / context.translation_vector_cam_predict(2, 0);
             cv::Point2d point_cv = {point[0], point[1]};
             debug::Painter::Instance().DrawPoint(point_cv, cv::Scalar(0, 0, 255), 1, 10);
             debug::Painter::Instance().ShowImage("ARMOR DETECT");
-        }
+            return (cv::waitKey(1) & 0xff) != 'q';
+        });
+    }
 
-        if ((cv::waitKey(1) & 0xff) == 'q')
-            break;
+    RunPipeline();
 
-        boxes_.clear();
-        armors_.clear();
+    if (CmdlineArgParser::Instance().RuneModeRune()) {
+        const auto statistics = rune_detector_.GetStatistics();
+        LOG(INFO) << "Rune detector: " << statistics.frames << " frames"
+                  << ", tracked in annulus " << statistics.tracked_frames
+                  << ", lost in annulus " << statistics.lost_frames
+                  << ", average time " << statistics.average_time << " ms"
+                  << " (" << statistics.average_tracking_time << " ms tracked, "
+                  << statistics.average_full_time << " ms in full frame).";
+        const auto fit_statistics = rune_predictor_.GetFitStatistics();
+        LOG(INFO) << "Rune predictor: " << fit_statistics.fits << " background fits"
+                  << ", failed " << fit_statistics.failures
+                  << ", average latency " << fit_statistics.average_latency << " ms"
+                  << ", max latency " << fit_statistics.max_latency << " ms.";
     }
-
-    // exit.
-    if (CmdlineArgParser::Instance().RunWithGimbal())
-        serial_->StopCommunication();
 }
-
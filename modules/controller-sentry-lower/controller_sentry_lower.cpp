@@ -30,29 +30,40 @@ bool SentryLowerController::Initialize() {
             return false;
         }
     }
+
+    InitializeDetectors("../config/sentry");
+
     LOG(INFO) << "Lower sentry controller is ready.";
     return true;
 }
 
 void SentryLowerController::Run() {
     ArmorPredictor armor_predictor(Entity::Colors::kBlue, true);
+    Eigen::Matrix3d camera_matrix;
+    cv::cv2eigen(image_provider_->IntrinsicMatrix(), camera_matrix);
 
-    sleep(2);
-
-    while (!exit_signal_) {
-        if (!image_provider_->GetFrame(frame_))
-            break;
-
-        if (CmdlineArgParser::Instance().RunWithGimbal()) {
-            SerialReceivePacket serial_receive_packet{};
-            serial_->GetData(serial_receive_packet, std::chrono::milliseconds(5));
-            receive_packet_ = ReceivePacket(serial_receive_packet);
-        }
+    WaitForCamera();
 
-        boxes_ = armor_detector_(frame_.image);
+    pipeline_.AddStage("capture", [this](FrameContext &context) { return CaptureStage(context); });
+    AddDetectStages();
+    pipeline_.AddStage("battlefield", [this](FrameContext &context) { return BattlefieldStage(context); });
+    pipeline_.AddStage("predict", [&](FrameContext &context) {
+        UpdateClock(context.frame);
+        context.send_packet = SerialSendPacket(
+                armor_predictor.Run(context.battlefield, ArmorPredictor::Modes::kAutoAntitop));
+        context.translation_vector_cam_predict = armor_predictor.TranslationVectorCamPredict();
+        cv::Rect2f roi;
+        bool locked = armor_predictor.PredictedROI(camera_matrix, roi);
+        roi_scheduler_.Update(context.frame.time_stamp, locked, roi);
+        return true;
+    });
+    pipeline_.AddStage("output", [&](FrameContext &context) {
+        if (CmdlineArgParser::Instance().RunHeadless())
+            return true;
 
-        auto img = frame_.image.clone();
-        for (const auto &box: boxes_) {
+        // Armor tracker keeps its own grey copy of frames, so output is the last stage reading this frame.
+        cv::Mat img = context.frame.Image();
+        for (const auto &box: context.boxes) {
             line(img, box.points[0], box.points[1], cv::Scalar(0, 255, 0), 2);
             line(img, box.points[1], box.points[2], cv::Scalar(0, 255, 0), 2);
             line(img, box.points[2], box.points[3], cv::Scalar(0, 255, 0), 2);
@@ -61,28 +72,15 @@ void SentryLowerController::Run() {
                         cv::FONT_HERSHEY_SIMPLEX, 1,
                         cv::Scalar((box.color == 0) * 255, 0, (box.color == 1) * 255), 2);
         }
-
-        BboxToArmor();
-        battlefield_ = Battlefield(frame_.time_stamp, receive_packet_.bullet_speed, receive_packet_.quaternion,
-                                   armors_);
-
-        send_packet_ = SerialSendPacket(armor_predictor.Run(battlefield_, ArmorPredictor::Modes::kAutoAntitop));
-        Eigen::Matrix3d camera_matrix;
-        cv::cv2eigen(image_provider_->IntrinsicMatrix(), camera_matrix);
-        DrawPredictedPoint(img, camera_matrix, armor_predictor.TranslationVectorCamPredict());
+        DrawPredictedPoint(img, camera_matrix, context.translation_vector_cam_predict);
         cv::imshow("Sentry Lower", img);
 
-        if ((cv::waitKey(1) & 0xff) == 'q'){
+        if ((cv::waitKey(1) & 0xff) == 'q') {
             ArmorPredictorDebug::Instance().Save();
-            break;
+            return false;
         }
-        SerialSendPacket send_packet{1.f, 2.f, 3.f, false,4.f};
-        //serial_->SendData(send_packet, std::chrono::milliseconds(5));
-
-        boxes_.clear();
-        armors_.clear();
-    }
+        return true;
+    });
 
-    if (CmdlineArgParser::Instance().RunWithGimbal())
-        serial_->StopCommunication();
+    RunPipeline();
 }
@@ -47,7 +47,7 @@ bool TestController::Initialize() {
         LOG(INFO) << "Rune detector initialize successfully!";
     else
         LOG(ERROR) << "Rune detector initialize unsuccessfully!";
-    if (RunePredictor::Initialize("../config/test/rune-param.yaml"))
+    if (rune_predictor_.Initialize("../config/test/rune-predictor-param.yaml"))
         LOG(INFO) << "Rune predictor initialize successfully!";
     else
         LOG(ERROR) << "Rune predictor initialize unsuccessfully!";
@@ -63,13 +63,14 @@ void TestController::Run() {
 void TestController::Test() {
     ArmorPredictor armor_predictor(Entity::Colors::kBlue, true);
 
-    sleep(2);
+    WaitForCamera();
 
     while (!exit_signal_) {
         if (!image_provider_->GetFrame(frame_))
             break;
+        UpdateClock(frame_);
         cv::waitKey(1);
-        debug::Painter::Instance().UpdateImage(frame_.image);
+        debug::Painter::Instance().UpdateImage(frame_.Image());
 
         if (CmdlineArgParser::Instance().RunWithGimbal()) {
             SerialReceivePacket serial_receive_packet{};
@@ -80,18 +81,19 @@ void TestController::Test() {
         if (CmdlineArgParser::Instance().RuneModeRune()) {
             power_rune_ = rune_detector_.Run(frame_);
             send_packet_ = SendPacket(rune_predictor_.Predict(power_rune_));
+            rune_detector_.Track(rune_predictor_.CalRadius());
             debug::Painter::Instance().DrawPoint(rune_predictor_.FinalTargetPoint(),
                                                  cv::Scalar(0, 255, 0), 3, 3);
             debug::Painter::Instance().ShowImage("Rune");
         } else {
-            boxes_ = armor_detector_(frame_.image);
+            boxes_ = armor_detector_(frame_);
             BboxToArmor();
             battlefield_ = Battlefield(frame_.time_stamp, receive_packet_.bullet_speed, receive_packet_.quaternion,
                                        armors_);
             /// TODO mode switch
             send_packet_ = SendPacket(armor_predictor.Run(battlefield_, ArmorPredictor::Modes::kNormal));
-            auto img = frame_.image.clone();
-            debug::Painter::Instance().UpdateImage(frame_.image);
+            auto img = frame_.Image().clone();
+            debug::Painter::Instance().UpdateImage(frame_.Image());
             for (const auto &box: boxes_) {
                 debug::Painter::Instance().DrawRotatedRectangle(box.points[0],
                                                                 box.points[1],
@@ -1,87 +1,231 @@
 /**
- * Circular buffer model header.
+ * Lock-free ring buffer model header.
  * \author anonymity, trantuan-20048607
- * \date 2022.1.28
+ * \date 2022.3.20
  */
 
 #ifndef BUFFER_H_
 #define BUFFER_H_
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <mutex>
+#include <thread>
 #include "lang-feature-extension/disable_constructor.h"
 
+/// \brief Behavior when pushing an element into a full buffer.
+enum class BufferPolicy {
+    kReject,     ///< Refuse the new element.
+    kKeepLatest  ///< Drop the oldest element to make room for the new one.
+};
+
 /**
- * \brief Circular buffer with mutex.
- * \details Refer to https://en.wikipedia.org/wiki/Circular_buffer.
- * \tparam T Type of elements in this buffer.
- * \tparam size Max size of this buffer.
- * \attention Size must be 2^N.
+ * \brief Bounded lock-free ring buffer with one consumer.
+ * \details Every slot carries a sequence number telling whether it is ready to write or read,
+ *   refer to http://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue.  \n
+ *   With single producer and kReject policy, both Push and Pop are wait-free.
+ *   With kKeepLatest policy, producers pop the oldest element when buffer is full,
+ *   which competes with the consumer and makes operations lock-free.
+ * \tparam T Type of elements in this buffer, must be default constructible and movable.
+ * \tparam size Max number of elements.
+ * \tparam multi_producer Whether Push can be called from different threads at the same time.
+ * \tparam policy Behavior when buffer is full.
+ * \attention Size must be 2^N, and Pop / WaitPop must be called from only one thread.
  */
-template<typename T, unsigned int size>
-class CircularBuffer : NO_COPY, NO_MOVE {
-private:
-    T data_[size];                           ///< Data array.
-    unsigned int head_;                         ///< Head pointer.
-    unsigned int tail_;                         ///< Tail pointer.
-    std::mutex lock_[size];                     ///< Mutex lock for data.
-    std::mutex head_lock_;                      ///< Mutex lock for head pointer.
-    const unsigned int and_to_mod_ = size - 1;  ///< Use bitwise operation to accelerate modulus.
-
+template<typename T, unsigned int size, bool multi_producer, BufferPolicy policy>
+class RingBuffer : NO_COPY, NO_MOVE {
 public:
-    CircularBuffer<T, size>() : head_(0), tail_(0) {
-        static_assert(!(size & (size - 1)));
+    RingBuffer() : head_(0), tail_(0), dropped_(0), waiting_(0) {
+        static_assert(size && !(size & (size - 1)), "Size of ring buffer must be 2^N.");
+        for (unsigned int i = 0; i < size; ++i)
+            slots_[i].sequence.store(i, std::memory_order_relaxed);
     }
 
-    ~CircularBuffer() = default;
+    ~RingBuffer() = default;
 
     /**
-     * \return Size of this buffer, which is specified when it is constructed.
+     * \return Max number of elements, which is specified when it is constructed.
      */
-    [[maybe_unused]] [[nodiscard]] inline unsigned int Size() const { return size; }
+    [[maybe_unused]] [[nodiscard]] constexpr inline unsigned int Capacity() const { return size; }
+
+    /**
+     * \return Number of elements in this buffer, may be outdated when returned.
+     */
+    [[maybe_unused]] [[nodiscard]] inline unsigned int Size() const {
+        const auto head = head_.load(std::memory_order_acquire);
+        const auto tail = tail_.load(std::memory_order_acquire);
+        return tail > head ? unsigned(tail - head) : 0;
+    }
 
     /**
      * \brief Is this buffer empty?
-     * \return Whether buffer is empty.
+     * \return Whether buffer is empty, may be outdated when returned.
+     */
+    [[maybe_unused]] [[nodiscard]] inline bool Empty() const { return Size() == 0; }
+
+    /**
+     * \return Number of elements dropped or rejected because buffer was full.
      */
-    [[maybe_unused]] [[nodiscard]] inline bool Empty() const { return head_ == tail_; }
+    [[maybe_unused]] [[nodiscard]] inline uint64_t Dropped() const {
+        return dropped_.load(std::memory_order_relaxed);
+    }
 
     /**
      * \brief Push an element.
-     * \param [in] obj Input element.
+     * \param [in] obj Input element, will be moved.
+     * \return Whether element is pushed, always true with kKeepLatest policy.
      */
-    inline void Push(const T &obj) {
-        std::lock_guard<std::mutex> lock(lock_[tail_]);
-        data_[tail_] = obj;
-        ++tail_;
-        tail_ &= and_to_mod_;
-
-        if (head_ == tail_) {
-            std::lock_guard<std::mutex> head_lock(head_lock_);
-            ++head_;
-            head_ &= and_to_mod_;
+    inline bool Push(T &&obj) {
+        auto pos = tail_.load(std::memory_order_relaxed);
+        while (true) {
+            auto &slot = slots_[pos & kAndToMod];
+            const auto sequence = slot.sequence.load(std::memory_order_acquire);
+            const auto diff = int64_t(sequence) - int64_t(pos);
+            if (diff == 0) {
+                if (multi_producer) {
+                    if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                        break;
+                } else {
+                    tail_.store(pos + 1, std::memory_order_relaxed);
+                    break;
+                }
+            } else if (diff < 0) {
+                // Slot is still occupied.
+                if (policy == BufferPolicy::kReject) {
+                    dropped_.fetch_add(1, std::memory_order_relaxed);
+                    return false;
+                }
+                // Only drop an element when buffer is really full,
+                //   otherwise the consumer is moving this slot out and will release it soon.
+                if (head_.load(std::memory_order_acquire) + size <= pos) {
+                    T discarded;
+                    if (TryPop(discarded))
+                        dropped_.fetch_add(1, std::memory_order_relaxed);
+                } else
+                    std::this_thread::yield();
+                pos = tail_.load(std::memory_order_relaxed);
+            } else
+                pos = tail_.load(std::memory_order_relaxed);
         }
+
+        auto &slot = slots_[pos & kAndToMod];
+        slot.data = std::move(obj);
+        slot.sequence.store(pos + 1, std::memory_order_release);
+
+        // Wake up the consumer only when it is waiting.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiting_.load(std::memory_order_relaxed)) {
+            std::lock_guard<std::mutex> lock(wait_mutex_);
+            wait_condition_.notify_one();
+        }
+        return true;
     }
 
+    /**
+     * \brief Push a copy of an element.
+     * \param [in] obj Input element.
+     * \return Whether element is pushed, always true with kKeepLatest policy.
+     */
+    inline bool Push(const T &obj) { return Push(T(obj)); }
+
     /**
      * \brief Pop an element.
      * \param [out] obj Output element.
      * \return Whether buffer is not empty.
      */
-    inline bool Pop(T &obj) {
-        if (head_ == tail_)
-            return false;
-        std::lock_guard<std::mutex> lock(lock_[head_]);
-        obj = data_[head_];
-        std::lock_guard<std::mutex> head_lock(head_lock_);
-        ++head_;
-        head_ &= and_to_mod_;
-        return true;
+    inline bool Pop(T &obj) { return TryPop(obj); }
+
+    /**
+     * \brief Pop an element, wait until an element is pushed or timeout.
+     * \param [out] obj Output element.
+     * \param [in] timeout Max waiting time.
+     * \return Whether an element is popped.
+     */
+    template<typename Rep, typename Period>
+    bool WaitPop(T &obj, const std::chrono::duration<Rep, Period> &timeout) {
+        if (TryPop(obj))
+            return true;
+
+        const auto deadline = std::chrono::steady_clock::now() + timeout;
+        std::unique_lock<std::mutex> lock(wait_mutex_);
+        waiting_.fetch_add(1, std::memory_order_seq_cst);
+        bool result;
+        while (!(result = TryPop(obj))) {
+            if (wait_condition_.wait_until(lock, deadline) == std::cv_status::timeout) {
+                result = TryPop(obj);
+                break;
+            }
+        }
+        waiting_.fetch_sub(1, std::memory_order_relaxed);
+        return result;
     }
 
-    [[maybe_unused]] [[nodiscard]] const T &operator[](unsigned int id) {
-        while (tail_ + id < 0) id += size;
-        return data_[(tail_ + id) & and_to_mod_];
+private:
+    constexpr static unsigned int kCacheLineSize = 64;    ///< Avoid false sharing between indices.
+    constexpr static uint64_t kAndToMod = size - 1;       ///< Use bitwise operation to accelerate modulus.
+
+    /// \brief Whether more than one thread may pop, including producers dropping elements.
+    constexpr static bool kMultiConsumer = policy == BufferPolicy::kKeepLatest;
+
+    struct Slot {
+        std::atomic<uint64_t> sequence;  ///< Equals to position when writable, position + 1 when readable.
+        T data;
+    };
+
+    inline bool TryPop(T &obj) {
+        auto pos = head_.load(std::memory_order_relaxed);
+        while (true) {
+            auto &slot = slots_[pos & kAndToMod];
+            const auto sequence = slot.sequence.load(std::memory_order_acquire);
+            const auto diff = int64_t(sequence) - int64_t(pos + 1);
+            if (diff == 0) {
+                if (kMultiConsumer) {
+                    if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                        break;
+                } else {
+                    head_.store(pos + 1, std::memory_order_relaxed);
+                    break;
+                }
+            } else if (diff < 0)
+                return false;
+            else
+                pos = head_.load(std::memory_order_relaxed);
+        }
+
+        auto &slot = slots_[pos & kAndToMod];
+        obj = std::move(slot.data);
+        slot.sequence.store(pos + size, std::memory_order_release);
+        return true;
     }
+
+    alignas(kCacheLineSize) std::atomic<uint64_t> head_;     ///< Position to read.
+    alignas(kCacheLineSize) std::atomic<uint64_t> tail_;     ///< Position to write.
+    alignas(kCacheLineSize) std::atomic<uint64_t> dropped_;  ///< Dropped element counter.
+    std::atomic<int> waiting_;                               ///< Number of waiting consumers.
+    std::mutex wait_mutex_;                                  ///< Mutex lock for waiting only.
+    std::condition_variable wait_condition_;
+    alignas(kCacheLineSize) Slot slots_[size];               ///< Data array.
 };
 
+/**
+ * \brief Single-producer single-consumer ring buffer.
+ * \tparam T Type of elements in this buffer.
+ * \tparam size Max size of this buffer.
+ * \tparam policy Behavior when buffer is full, keep the latest elements by default.
+ * \attention Size must be 2^N.
+ */
+template<typename T, unsigned int size, BufferPolicy policy = BufferPolicy::kKeepLatest>
+using SPSCBuffer = RingBuffer<T, size, false, policy>;
+
+/**
+ * \brief Multi-producer single-consumer ring buffer.
+ * \tparam T Type of elements in this buffer.
+ * \tparam size Max size of this buffer.
+ * \tparam policy Behavior when buffer is full, keep the latest elements by default.
+ * \attention Size must be 2^N.
+ */
+template<typename T, unsigned int size, BufferPolicy policy = BufferPolicy::kKeepLatest>
+using MPSCBuffer = RingBuffer<T, size, true, policy>;
+
 #endif  // BUFFER_H_
@@ -0,0 +1,94 @@
+/**
+ * Lock-free double buffer model header.
+ * \author trantuan-20048607
+ * \date 2022.3.30
+ */
+
+#ifndef DOUBLE_BUFFER_H_
+#define DOUBLE_BUFFER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include "lang-feature-extension/disable_constructor.h"
+
+/**
+ * \brief Double buffer publishing values from one writer to any readers without locking.
+ * \details Version is odd while the writer fills the slot not being published, and even again when it is published,
+ *   as the writer of a sequence lock. Readers copy the published slot and check version afterwards, the copy is only
+ *   torn when the writer has started to fill the same slot again, i.e. after two publishes, then they copy again.
+ *   So Publish is wait-free and Read is lock-free.  \n
+ *   Slots are stored in atomic words, so that copying them while being written is well-defined.
+ * \tparam T Type of values, must be trivially copyable.
+ * \attention Publish must be called from only one thread.
+ */
+template<typename T>
+class DoubleBuffer : NO_COPY, NO_MOVE {
+public:
+    explicit DoubleBuffer(const T &initial_value = T()) : version_(0) {
+        static_assert(std::is_trivially_copyable<T>::value, "Values of double buffer must be trivially copyable.");
+        Store(slots_[0], initial_value);
+        Store(slots_[1], initial_value);
+    }
+
+    /**
+     * \brief Publish a new value.
+     * \param [in] value New value.
+     */
+    inline void Publish(const T &value) {
+        const auto version = version_.load(std::memory_order_relaxed);
+        version_.store(version + 1, std::memory_order_release);
+        // Readers seeing any word of this value also see the odd version, see Read.
+        std::atomic_thread_fence(std::memory_order_release);
+        Store(slots_[((version >> 1) + 1) & 1], value);
+        version_.store(version + 2, std::memory_order_release);
+    }
+
+    /**
+     * \brief Read the latest published value.
+     * \param [out] value Latest value, initial value before anything is published.
+     * \return Version of the value, which is the number of published values.
+     */
+    inline uint64_t Read(T &value) const {
+        while (true) {
+            const auto version = version_.load(std::memory_order_acquire);
+            const auto published = version >> 1;
+            Load(slots_[published & 1], value);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            // Slot of this value is written again from version 2 * published + 3 on.
+            if (version_.load(std::memory_order_relaxed) < 2 * published + 3)
+                return published;
+        }
+    }
+
+    /// \return Number of published values, may be outdated when returned.
+    [[nodiscard]] inline uint64_t Version() const { return version_.load(std::memory_order_acquire) >> 1; }
+
+private:
+    static constexpr size_t kWords = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    /// \brief Slot of a value in atomic words.
+    struct Slot {
+        std::atomic<uint64_t> words[kWords];
+    };
+
+    static inline void Store(Slot &slot, const T &value) {
+        uint64_t words[kWords] = {};
+        std::memcpy(words, &value, sizeof(T));
+        for (size_t i = 0; i < kWords; ++i)
+            slot.words[i].store(words[i], std::memory_order_relaxed);
+    }
+
+    static inline void Load(const Slot &slot, T &value) {
+        uint64_t words[kWords];
+        for (size_t i = 0; i < kWords; ++i)
+            words[i] = slot.words[i].load(std::memory_order_relaxed);
+        std::memcpy(&value, words, sizeof(T));
+    }
+
+    std::atomic<uint64_t> version_;  ///< Twice the number of published values, odd while a slot is being written.
+    Slot slots_[2];                  ///< Data slots, the latest value is in slot (version / 2) % 2.
+};
+
+#endif  // DOUBLE_BUFFER_H_
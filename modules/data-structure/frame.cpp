@@ -0,0 +1,11 @@
+#include "image-processing/demosaic.h"
+#include "frame.h"
+
+const cv::Mat &Frame::Image() {
+    if (image.empty() && !raw_image.empty()) {
+        image.allocator = raw_image.u ? raw_image.u->currAllocator : nullptr;
+        if (!demosaic::BayerToBGRParallel(raw_image, image, demosaic::BayerPattern(bayer_pattern), raw_bits))
+            image.release();
+    }
+    return image;
+}
@@ -11,20 +11,48 @@
 
 /**
  * \brief Single frame structure.
- * \details 2 ways of initializing method provided:  \n
+ * \details 3 ways of initializing method provided:  \n
  *   (Default) Directly use Frame() to initialize an empty and useless frame.  \n
- *   (Manual) Use Frame(_image, _time_stamp) to initialize a complete frame.
+ *   (Manual) Use Frame(_image, _time_stamp) to initialize a complete frame.  \n
+ *   (Raw) Use Frame(_raw_image, _bayer_pattern, _raw_bits, _time_stamp) to initialize a frame of Bayer image,
+ *   whose BGR image will be converted when Image() is called for the first time.
+ * \note Image is not copied, the frame holds a reference-counted handle of the image buffer,
+ *   which usually comes from a FramePool. Clone the image before drawing on it if it will be used elsewhere.
  */
 struct Frame {
-    cv::Mat image;        ///< OpenCV style image matrix.
+    cv::Mat image;        ///< OpenCV style image matrix, may be empty before calling Image() for raw frames.
+    cv::Mat raw_image;    ///< Bayer image from camera, empty when camera outputs BGR image.
+    int bayer_pattern;    ///< Color filter array order of raw image, see demosaic::BayerPattern.
+    int raw_bits;         ///< Valid bits of each raw pixel.
     uint64_t time_stamp;  ///< Time stamp in DEC nanoseconds.
 
-    Frame(cv::Mat &_image,
+    Frame(const cv::Mat &_image,
           uint64_t _time_stamp) :
-            image(_image.clone()),
+            image(_image),
+            bayer_pattern(0),
+            raw_bits(8),
             time_stamp(_time_stamp) {}
 
-    Frame() : time_stamp(0) {}
+    Frame(const cv::Mat &_raw_image,
+          int _bayer_pattern,
+          int _raw_bits,
+          uint64_t _time_stamp) :
+            raw_image(_raw_image),
+            bayer_pattern(_bayer_pattern),
+            raw_bits(_raw_bits),
+            time_stamp(_time_stamp) {}
+
+    Frame() : bayer_pattern(0), raw_bits(8), time_stamp(0) {}
+
+    /// \return Whether this frame carries a Bayer image.
+    [[nodiscard]] inline bool IsRaw() const { return !raw_image.empty(); }
+
+    /**
+     * \brief Get BGR image, convert it from raw image at the first call.
+     * \details Converted image uses the same allocator as raw image, so it comes from the same FramePool.
+     * \return BGR image, empty when conversion failed.
+     */
+    const cv::Mat &Image();
 };
 
 #endif  // FRAME_H_
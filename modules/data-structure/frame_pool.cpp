@@ -0,0 +1,86 @@
+#include "frame_pool.h"
+
+FramePool::~FramePool() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto block: free_blocks_)
+        delete block;
+    free_blocks_.clear();
+}
+
+cv::Mat FramePool::Acquire(int rows, int cols, int type) {
+    cv::Mat image;
+    image.allocator = this;
+    image.create(rows, cols, type);
+    return image;
+}
+
+cv::UMatData *FramePool::allocate(int dims, const int *sizes, int type, void *data, size_t *step,
+                                  cv::AccessFlag, cv::UMatUsageFlags) const {
+    // Compute steps the same way as OpenCV standard allocator.
+    size_t total = CV_ELEM_SIZE(type);
+    for (int i = dims - 1; i >= 0; --i) {
+        if (step) {
+            if (data && step[i] != CV_AUTOSTEP) {
+                CV_Assert(total <= step[i]);
+                total = step[i];
+            } else
+                step[i] = total;
+        }
+        total *= sizes[i];
+    }
+
+    // User data is never pooled, leave it to standard allocator.
+    if (data)
+        return cv::Mat::getStdAllocator()->allocate(dims, sizes, type, data, step,
+                                                    cv::ACCESS_RW, cv::USAGE_DEFAULT);
+
+    Block *block = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // Take the smallest fitting buffer, since raw and BGR images of different sizes share this pool.
+        auto best = free_blocks_.end();
+        for (auto it = free_blocks_.begin(); it != free_blocks_.end(); ++it)
+            if ((*it)->size >= total && (best == free_blocks_.end() || (*it)->size < (*best)->size))
+                best = it;
+        if (best != free_blocks_.end()) {
+            block = *best;
+            *best = free_blocks_.back();
+            free_blocks_.pop_back();
+        }
+        // Replace a too small buffer to keep the number of buffers bounded.
+        if (!block && !free_blocks_.empty()) {
+            delete free_blocks_.back();
+            free_blocks_.pop_back();
+            --num_buffers_;
+        }
+    }
+
+    if (block) {
+        // Reset header in place, without allocation.
+        block->header.~UMatData();
+        new(&block->header) cv::UMatData(this);
+    } else {
+        block = new Block(this, total);
+        ++allocation_count_;
+        ++num_buffers_;
+    }
+    ++acquire_count_;
+
+    auto header = &block->header;
+    header->data = header->origdata = block->data;
+    header->size = total;
+    header->userdata = block;
+    return header;
+}
+
+bool FramePool::allocate(cv::UMatData *data, cv::AccessFlag, cv::UMatUsageFlags) const {
+    return data != nullptr;
+}
+
+void FramePool::deallocate(cv::UMatData *data) const {
+    if (!data)
+        return;
+    CV_Assert(data->urefcount == 0 && data->refcount == 0);
+    std::lock_guard<std::mutex> lock(mutex_);
+    free_blocks_.push_back((Block *) data->userdata);
+}
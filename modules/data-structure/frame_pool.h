@@ -0,0 +1,92 @@
+/**
+ * Frame buffer pool header.
+ * \author trantuan-20048607
+ * \date 2022.3.22
+ */
+
+#ifndef FRAME_POOL_H_
+#define FRAME_POOL_H_
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <opencv2/core/core.hpp>
+#include "lang-feature-extension/disable_constructor.h"
+
+/**
+ * \brief Preallocated and reference-counted image buffers.
+ * \details This pool works as an OpenCV matrix allocator, so images acquired from it are
+ *   normal cv::Mat sharing buffers by reference counting.
+ *   When the last reference is released, the buffer returns to this pool instead of the heap.  \n
+ *   Deep copies (clone, copyTo into an empty matrix) use default allocator and never take pooled buffers.
+ * \attention This pool must be destroyed after all images acquired from it.
+ */
+class FramePool final : public cv::MatAllocator, NO_COPY, NO_MOVE {
+public:
+    FramePool() :
+            allocation_count_(0),
+            acquire_count_(0),
+            copy_count_(0),
+            num_buffers_(0) {
+        free_blocks_.reserve(kMaxExpectedBuffers);
+    }
+
+    ~FramePool() final;
+
+    /**
+     * \brief Acquire an image backed by a pooled buffer.
+     * \param [in] rows Image height.
+     * \param [in] cols Image width.
+     * \param [in] type OpenCV matrix type.
+     * \return An image with uninitialized content.
+     */
+    cv::Mat Acquire(int rows, int cols, int type);
+
+    /// \brief Record a full image write into a pooled buffer, call it in writers for statistics.
+    inline void CountCopy() { copy_count_.fetch_add(1, std::memory_order_relaxed); }
+
+    /// \return Times of allocating memory from heap, stops growing in steady state.
+    [[nodiscard]] inline uint64_t AllocationCount() const { return allocation_count_; }
+
+    /// \return Times of acquiring images.
+    [[nodiscard]] inline uint64_t AcquireCount() const { return acquire_count_; }
+
+    /// \return Times of full image writes into pooled buffers.
+    [[nodiscard]] inline uint64_t CopyCount() const { return copy_count_; }
+
+    /// \return Number of buffers owned by this pool, including those in use.
+    [[nodiscard]] inline unsigned int NumBuffers() const { return num_buffers_; }
+
+    cv::UMatData *allocate(int dims, const int *sizes, int type, void *data, size_t *step,
+                           cv::AccessFlag flags, cv::UMatUsageFlags usage_flags) const final;
+
+    bool allocate(cv::UMatData *data, cv::AccessFlag access_flags, cv::UMatUsageFlags usage_flags) const final;
+
+    void deallocate(cv::UMatData *data) const final;
+
+private:
+    constexpr static unsigned int kMaxExpectedBuffers = 32;  ///< Reserved size of free list.
+
+    /// \brief Pooled buffer with its own matrix data header, so that no allocation happens when reused.
+    struct Block {
+        uchar *data;
+        size_t size;
+        cv::UMatData header;
+
+        Block(const cv::MatAllocator *allocator, size_t _size) :
+                data((uchar *) cv::fastMalloc(_size)),
+                size(_size),
+                header(allocator) {}
+
+        ~Block() { cv::fastFree(data); }
+    };
+
+    mutable std::vector<Block *> free_blocks_;           ///< Buffers ready to use.
+    mutable std::mutex mutex_;                           ///< Mutex lock for free blocks.
+    mutable std::atomic<uint64_t> allocation_count_;     ///< Heap allocation counter.
+    mutable std::atomic<uint64_t> acquire_count_;        ///< Acquiring counter.
+    std::atomic<uint64_t> copy_count_;                   ///< Full image write counter.
+    mutable std::atomic<unsigned int> num_buffers_;      ///< Number of buffers.
+};
+
+#endif  // FRAME_POOL_H_
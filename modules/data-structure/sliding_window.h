@@ -0,0 +1,71 @@
+/**
+ * Fixed-capacity sliding window model header.
+ * \author trantuan-20048607
+ * \date 2022.3.30
+ */
+
+#ifndef SLIDING_WINDOW_H_
+#define SLIDING_WINDOW_H_
+
+#include <array>
+#include "lang-feature-extension/disable_constructor.h"
+
+/**
+ * \brief Sliding window keeping the latest elements in a fixed array.
+ * \details Pushing into a full window overwrites the oldest element, so memory use never grows.
+ * \tparam T Type of elements, must be default constructible and copyable.
+ * \tparam size Max number of elements.
+ * \attention This window is not thread-safe.
+ */
+template<typename T, unsigned int size>
+class SlidingWindow : NO_COPY, NO_MOVE {
+public:
+    SlidingWindow() : head_(0), size_(0) {
+        static_assert(size, "Size of sliding window must be positive.");
+    }
+
+    /// \return Max number of elements, which is specified when it is constructed.
+    [[nodiscard]] constexpr inline unsigned int Capacity() const { return size; }
+
+    /// \return Number of elements in this window.
+    [[nodiscard]] inline unsigned int Size() const { return size_; }
+
+    [[nodiscard]] inline bool Empty() const { return size_ == 0; }
+
+    [[nodiscard]] inline bool Full() const { return size_ == size; }
+
+    /**
+     * \brief Push an element, dropping the oldest one when window is full.
+     * \param [in] obj Input element.
+     */
+    inline void Push(const T &obj) {
+        if (size_ < size) {
+            elements_[(head_ + size_++) % size] = obj;
+        } else {
+            elements_[head_] = obj;
+            head_ = (head_ + 1) % size;
+        }
+    }
+
+    /**
+     * \param [in] index Index counted from the oldest element, must be less than Size().
+     * \return Reference to the element.
+     */
+    inline const T &operator[](unsigned int index) const { return elements_[(head_ + index) % size]; }
+
+    /// \return Reference to the oldest element, window must not be empty.
+    inline const T &Front() const { return elements_[head_]; }
+
+    /// \return Reference to the latest element, window must not be empty.
+    inline const T &Back() const { return elements_[(head_ + size_ - 1) % size]; }
+
+    /// \brief Drop all elements.
+    inline void Clear() { head_ = size_ = 0; }
+
+private:
+    std::array<T, size> elements_;  ///< Element storage.
+    unsigned int head_;             ///< Index of the oldest element.
+    unsigned int size_;             ///< Number of elements.
+};
+
+#endif  // SLIDING_WINDOW_H_
@@ -1,233 +1,278 @@
-#include <filesystem>
-#include <fstream>
+#include <algorithm>
+#include <chrono>
 #include <opencv2/imgproc.hpp>
-#include <cuda.h>
-#include <cuda_runtime_api.h>
-#include <NvOnnxParser.h>
-#include <logger.h>
 #include <glog/logging.h>
+#include "image-processing/demosaic.h"
+#include "detector_armor_backend_factory.h"
 #include "detector_armor.h"
 
-#define TRT_ASSERT(expr)                                              \
-    if(!(expr)) {                                                     \
-        LOG(ERROR) << "TensorRT assertion failed: " << #expr << ".";  \
-        exit(-1);                                                     \
-    }
-
-static inline size_t get_dims_size(const nvinfer1::Dims &dims) {
-    size_t sz = 1;
-    for (int i = 0; i < dims.nbDims; ++i) sz *= dims.d[i];
-    return sz;
-}
+bool ArmorDetector::Initialize(const std::string &onnx_file, const std::string &backend_type) {
+    std::string type = backend_type;
+    if (type.empty())
+        for (const auto &candidate: {"tensorrt", "opencv"})
+            if (ArmorDetectorBackendFactory::Instance().HasBackend(candidate)) {
+                type = candidate;
+                break;
+            }
 
-template<class F, class T, class ...Ts>
-T reduce(F &&func, T x, Ts... xs) {
-    if constexpr (sizeof...(Ts) > 0) {
-        return func(x, reduce(std::forward<F>(func), xs...));
-    } else {
-        return x;
+    backend_.reset(CREATE_ARMOR_DETECTOR_BACKEND(type));
+    if (!backend_) {
+        LOG(ERROR) << "Failed to create armor detector backend.";
+        return false;
+    }
+    if (!backend_->Initialize(onnx_file)) {
+        LOG(ERROR) << "Failed to initialize armor detector with " << type << " backend.";
+        backend_.reset();
+        return false;
     }
+    LOG(INFO) << "Armor detector is running with " << type << " backend.";
+    return true;
 }
 
-template<class T, class ...Ts>
-T reduce_max(T x, Ts... xs) {
-    return reduce([](auto &&a, auto &&b) { return std::max(a, b); }, x, xs...);
+bool ArmorDetector::DumpOutput(const std::string &file_path) {
+    if (dump_file_.is_open())
+        dump_file_.close();
+    if (file_path.empty())
+        return true;
+    dump_file_.open(file_path, std::ios::binary | std::ios::app);
+    if (!dump_file_) {
+        LOG(ERROR) << "Failed to open armor detector dump file " << file_path << ".";
+        return false;
+    }
+    return true;
 }
 
-template<class T, class ...Ts>
-T reduce_min(T x, Ts... xs) {
-    return reduce([](auto &&a, auto &&b) { return std::min(a, b); }, x, xs...);
+void ArmorDetector::operator()(const cv::Mat &image, std::vector<bbox_t> &boxes) const {
+    float fx = (float) image.cols / kInputWidth, fy = (float) image.rows / kInputHeight;
+    Preprocess(image, input_buffer_);
+    Infer(input_buffer_, fx, fy, boxes);
 }
 
-static inline bool is_overlap(const float pts1[8], const float pts2[8]) {
-    cv::Rect2f bbox1, bbox2;
+void ArmorDetector::operator()(const std::vector<cv::Mat> &images, std::vector<std::vector<bbox_t>> &boxes) const {
+    boxes.resize(images.size());
+    if (!backend_) {
+        LOG(ERROR) << "Armor detector is not initialized.";
+        for (auto &image_boxes: boxes)
+            image_boxes.clear();
+        return;
+    }
 
-    bbox1.x = reduce_min(pts1[0], pts1[2], pts1[4], pts1[6]);
-    bbox1.y = reduce_min(pts1[1], pts1[3], pts1[5], pts1[7]);
-    bbox1.width = reduce_max(pts1[0], pts1[2], pts1[4], pts1[6]) - bbox1.x;
-    bbox1.height = reduce_max(pts1[1], pts1[3], pts1[5], pts1[7]) - bbox1.y;
+    // Split images into balanced batches, e.g. 9 images with max batch size 4 are split into 3, 3 and 3.
+    const auto max_batch_size = size_t(MaxBatchSize());
+    const auto num_batches = (images.size() + max_batch_size - 1) / max_batch_size;
+    batch_input_buffer_.create(int(max_batch_size) * kInputHeight, kInputWidth, CV_32FC3);
+    batch_output_buffer_.resize(max_batch_size * kTopkNum * kBoxSize);
+
+    size_t begin = 0;
+    for (size_t batch = 0; batch < num_batches; ++batch) {
+        const auto end = images.size() * (batch + 1) / num_batches;
+        const auto batch_size = int(end - begin);
+
+        // Pre-process. [pack images into continuous rows of one tensor]
+        for (int i = 0; i < batch_size; ++i) {
+            cv::Mat x = batch_input_buffer_.rowRange(i * kInputHeight, (i + 1) * kInputHeight);
+            Preprocess(images[begin + i], x);
+        }
 
-    bbox2.x = reduce_min(pts2[0], pts2[2], pts2[4], pts2[6]);
-    bbox2.y = reduce_min(pts2[1], pts2[3], pts2[5], pts2[7]);
-    bbox2.width = reduce_max(pts2[0], pts2[2], pts2[4], pts2[6]) - bbox2.x;
-    bbox2.height = reduce_max(pts2[1], pts2[3], pts2[5], pts2[7]) - bbox2.y;
-    return (bbox1 & bbox2).area() > 0;
-}
+        // Predict model.
+        if (!backend_->InferBatch(batch_input_buffer_.rowRange(0, batch_size * kInputHeight), batch_size,
+                                  batch_output_buffer_.data())) {
+            for (int i = 0; i < batch_size; ++i)
+                boxes[begin + i].clear();
+            begin = end;
+            continue;
+        }
 
-static inline int argmax(const float *ptr, int len) {
-    int arg_max = 0;
-    for (int i = 1; i < len; ++i)
-        if (ptr[i] > ptr[arg_max])
-            arg_max = i;
-    return arg_max;
+        // Post-process. [split outputs & decode & nms]
+        for (int i = 0; i < batch_size; ++i) {
+            const auto *output = batch_output_buffer_.data() + size_t(i) * kTopkNum * kBoxSize;
+            if (dump_file_.is_open())
+                dump_file_.write((const char *) output, (std::streamsize) (kTopkNum * kBoxSize * sizeof(float)));
+            const auto &image = images[begin + i];
+            decoder_.Decode(output, (float) image.cols / kInputWidth, (float) image.rows / kInputHeight,
+                            boxes[begin + i]);
+        }
+        begin = end;
+    }
 }
 
-inline constexpr float inv_sigmoid(float x) {
-    return -std::log(1 / x - 1);
-}
+void ArmorDetector::operator()(const Frame &frame, std::vector<bbox_t> &boxes) const {
+    if (!frame.IsRaw()) {
+        (*this)(frame.image, boxes);
+        return;
+    }
 
-inline constexpr float sigmoid(float x) {
-    return 1 / (1 + std::exp(-x));
+    float fx, fy;
+    if (!Prepare(frame, {0, 0, frame.raw_image.cols, frame.raw_image.rows}, input_buffer_, fx, fy)) {
+        boxes.clear();
+        return;
+    }
+    Infer(input_buffer_, fx, fy, boxes);
 }
 
-void ArmorDetector::Initialize(const std::string &onnx_file) {
-    std::filesystem::path onnx_file_path(onnx_file);
-    auto cache_file_path = onnx_file_path;
-    cache_file_path.replace_extension("cache");
-
-    if (std::filesystem::exists(cache_file_path)) {
-        BuildEngineFromCache(cache_file_path.c_str());
-    } else {
-        BuildEngineFromONNX(onnx_file_path.c_str());
-        CacheEngine(cache_file_path.c_str());
+cv::Rect ArmorDetector::operator()(const Frame &frame, const cv::Rect2f &roi, std::vector<bbox_t> &boxes) const {
+    const auto frame_size = frame.IsRaw() ? frame.raw_image.size() : frame.image.size();
+    const auto rect = FitRoi(frame_size, roi);
+    if (rect.size() == frame_size) {
+        (*this)(frame, boxes);
+        return rect;
     }
 
-    TRT_ASSERT((context_ = engine_->createExecutionContext()) != nullptr)
-    TRT_ASSERT((input_index_ = engine_->getBindingIndex("input")) == 0)
-    TRT_ASSERT((output_index_ = engine_->getBindingIndex("output-topk")) == 1)
-
-    auto input_dims = engine_->getBindingDimensions(input_index_);
-    auto output_dims = engine_->getBindingDimensions(output_index_);
-    input_size_ = get_dims_size(input_dims);
-    output_size_ = get_dims_size(output_dims);
-
-    TRT_ASSERT(cudaMalloc(&device_buffer_[input_index_], input_size_ * sizeof(float)) == 0)
-    TRT_ASSERT(cudaMalloc(&device_buffer_[output_index_], output_size_ * sizeof(float)) == 0)
-    TRT_ASSERT(cudaStreamCreate(&stream_) == 0)
-
-    output_buffer_ = new float[output_size_];
-
-    TRT_ASSERT(output_buffer_ != nullptr)
+    float fx, fy;
+    if (!Prepare(frame, rect, input_buffer_, fx, fy)) {
+        boxes.clear();
+        return rect;
+    }
+    Infer(input_buffer_, fx, fy, boxes);
+    for (auto &box: boxes)
+        for (auto &point: box.points)
+            point.x += (float) rect.x, point.y += (float) rect.y;
+    return rect;
 }
 
-ArmorDetector::~ArmorDetector() {
-    delete[] output_buffer_;
-
-    cudaStreamDestroy(stream_);
-    cudaFree(device_buffer_[output_index_]);
-    cudaFree(device_buffer_[input_index_]);
-
-    engine_->destroy();
+bool ArmorDetector::EnableAsync(unsigned int num_slots) {
+    async_.reset();
+    if (!num_slots)
+        return true;
+    if (!backend_) {
+        LOG(ERROR) << "Armor detector is not initialized.";
+        return false;
+    }
+    async_ = std::make_unique<AsyncInference>(
+            num_slots, kTopkNum * kBoxSize,
+            [this](const cv::Mat &x, float *output) { return backend_->Infer(x, output); });
+    async_requests_.resize(async_->NumSlots());
+    return true;
 }
 
-void ArmorDetector::BuildEngineFromONNX(const std::string &onnx_file) {
-    LOG(INFO) << "Engine will be built from ONNX.";
-    auto builder = nvinfer1::createInferBuilder(sample::gLogger);
-    TRT_ASSERT(builder != nullptr)
-
-    const auto explicitBatch = 1U <<
-                                  static_cast<uint32_t>(nvinfer1::NetworkDefinitionCreationFlag::kEXPLICIT_BATCH);
-    auto network = builder->createNetworkV2(explicitBatch);
-    TRT_ASSERT(network != nullptr)
-
-    auto parser = nvonnxparser::createParser(*network, sample::gLogger);
-    TRT_ASSERT(parser != nullptr)
-
-    parser->parseFromFile(onnx_file.c_str(),
-                          static_cast<int>(nvinfer1::ILogger::Severity::kINFO));
-
-    auto yolov5_output = network->getOutput(0);
-
-    auto slice_layer = network->addSlice(*yolov5_output,
-                                         nvinfer1::Dims3{0, 0, 8},
-                                         nvinfer1::Dims3{1, 15120, 1},
-                                         nvinfer1::Dims3{1, 1, 1});
-
-    auto yolov5_conf = slice_layer->getOutput(0);
-
-    auto shuffle_layer = network->addShuffle(*yolov5_conf);
-    shuffle_layer->setReshapeDimensions(nvinfer1::Dims2{1, 15120});
-
-    yolov5_conf = shuffle_layer->getOutput(0);
-
-    auto topk_layer = network->addTopK(*yolov5_conf,
-                                       nvinfer1::TopKOperation::kMAX,
-                                       kTopkNum,
-                                       1 << 1);
-
-    auto topk_idx = topk_layer->getOutput(1);
-
-    auto gather_layer = network->addGather(*yolov5_output, *topk_idx, 1);
-    gather_layer->setNbElementWiseDims(1);
-
-    auto yolov5_output_topk = gather_layer->getOutput(0);
-    yolov5_output_topk->setName("output-topk");
-
-    network->getInput(0)->setName("input");
-    network->markOutput(*yolov5_output_topk);
-    network->unmarkOutput(*yolov5_output);
-
-    auto config = builder->createBuilderConfig();
+ArmorDetector::Ticket ArmorDetector::Submit(const Frame &frame) {
+    const auto frame_size = frame.IsRaw() ? frame.raw_image.size() : frame.image.size();
+    return Submit(frame, {0, 0, frame_size.width, frame_size.height});
+}
 
-    if (builder->platformHasFastFp16()) {
-        LOG(INFO) << "Platform supports fp16, fp16 is enabled.";
-        config->setFlag(nvinfer1::BuilderFlag::kFP16);
-    } else {
-        LOG(INFO) << "Platform does not support fp16, enable fp32 instead.";
+ArmorDetector::Ticket ArmorDetector::Submit(const Frame &frame, const cv::Rect2f &roi) {
+    if (!async_) {
+        LOG(ERROR) << "Asynchronous inference of armor detector is not enabled.";
+        return 0;
     }
 
-    size_t free, total;
-    cuMemGetInfo(&free, &total);
-
-    LOG(INFO) << "GPU memory total: " << (total >> 20) << "MB, free: " << (free >> 20) << "MB.";
-    LOG(INFO) << "Max workspace size will use all of free GPU memory.";
-
-    config->setMaxWorkspaceSize(free >> 1);
+    const auto frame_size = frame.IsRaw() ? frame.raw_image.size() : frame.image.size();
+    const auto rect = FitRoi(frame_size, roi);
+    AsyncRequest request{1.f, 1.f, rect.tl()};
+    const auto ticket = async_->Submit([&](cv::Mat &x) {
+        return Prepare(frame, rect, x, request.fx, request.fy);
+    });
 
-    TRT_ASSERT((engine_ = builder->buildEngineWithConfig(*network, *config)) != nullptr)
+    // Slot of this ticket is not reused until it is released, so its request info is safe to write here.
+    async_requests_[ticket % async_->NumSlots()] = request;
+    return ticket;
+}
 
-    config->destroy();
-    parser->destroy();
-    network->destroy();
-    builder->destroy();
+bool ArmorDetector::Poll(Ticket ticket, std::vector<bbox_t> &boxes) {
+    if (!async_) {
+        boxes.clear();
+        return true;
+    }
+    const float *output;
+    const auto status = async_->Poll(ticket, output);
+    if (status == AsyncInference::kPending)
+        return false;
+    Collect(ticket, status, output, boxes);
+    return true;
 }
 
-void ArmorDetector::BuildEngineFromCache(const std::string &cache_file) {
-    LOG(INFO) << "Engine will be built from cache.";
-    std::ifstream ifs(cache_file, std::ios::binary);
-    ifs.seekg(0, std::ios::end);
-    size_t sz = ifs.tellg();
-    ifs.seekg(0, std::ios::beg);
-    auto buffer = std::make_unique<char[]>(sz);
-    ifs.read(buffer.get(), (std::streamsize) sz);
-    auto runtime = nvinfer1::createInferRuntime(sample::gLogger);
+void ArmorDetector::Wait(Ticket ticket, std::vector<bbox_t> &boxes) {
+    if (!async_) {
+        boxes.clear();
+        return;
+    }
+    const float *output;
+    const auto status = async_->Wait(ticket, output);
+    Collect(ticket, status, output, boxes);
+}
 
-    TRT_ASSERT(runtime != nullptr)
-    TRT_ASSERT((engine_ = runtime->deserializeCudaEngine(buffer.get(), sz)) != nullptr)
+void ArmorDetector::Collect(Ticket ticket, AsyncInference::Status status, const float *output,
+                            std::vector<bbox_t> &boxes) {
+    boxes.clear();
+    if (status == AsyncInference::kDone) {
+        const auto &request = async_requests_[ticket % async_->NumSlots()];
+        if (dump_file_.is_open())
+            dump_file_.write((const char *) output, (std::streamsize) (kTopkNum * kBoxSize * sizeof(float)));
+
+        // Post-process. [decode & nms & offset]
+        decoder_.Decode(output, request.fx, request.fy, boxes);
+        for (auto &box: boxes)
+            for (auto &point: box.points)
+                point.x += (float) request.offset.x, point.y += (float) request.offset.y;
+    }
+    async_->Release(ticket);
+}
 
-    runtime->destroy();
+cv::Rect ArmorDetector::FitRoi(const cv::Size &frame_size, const cv::Rect2f &roi) {
+    // Expand to aspect ratio of model input, and limit upscale ratio.
+    auto width = std::max({roi.width,
+                           roi.height * kInputWidth / kInputHeight,
+                           kInputWidth / kMaxRoiUpscale});
+    auto height = width * kInputHeight / kInputWidth;
+    const int w = std::min(int(width) & ~1, frame_size.width & ~1);
+    const int h = std::min(int(height) & ~1, frame_size.height & ~1);
+    if (w == (frame_size.width & ~1) && h == (frame_size.height & ~1))
+        return {0, 0, frame_size.width, frame_size.height};
+
+    // Keep center of ROI, and move it into frame.
+    const int x = std::clamp(int(roi.x + (roi.width - float(w)) / 2), 0, frame_size.width - w) & ~1;
+    const int y = std::clamp(int(roi.y + (roi.height - float(h)) / 2), 0, frame_size.height - h) & ~1;
+    return {x, y, w, h};
 }
 
-void ArmorDetector::CacheEngine(const std::string &cache_file) {
-    auto engine_buffer = engine_->serialize();
-    TRT_ASSERT(engine_buffer != nullptr)
+bool ArmorDetector::Prepare(const Frame &frame, const cv::Rect &rect, cv::Mat &x, float &fx, float &fy) const {
+    fx = (float) rect.width / kInputWidth, fy = (float) rect.height / kInputHeight;
+    if (!frame.IsRaw()) {
+        Preprocess(frame.image(rect), x);
+        return true;
+    }
 
-    std::ofstream ofs(cache_file, std::ios::binary);
-    ofs.write(static_cast<const char *>(engine_buffer->data()), (std::streamsize) engine_buffer->size());
-    engine_buffer->destroy();
+    // Pre-process. [demosaic & resize & rgb & float in one pass]
+    // Used when region is large enough to be downscaled by Bayer cells.
+    if (rect.width / 2 >= kInputWidth && rect.height / 2 >= kInputHeight)
+        return demosaic::BayerToTensor(frame.raw_image(rect), x, {kInputWidth, kInputHeight},
+                                       demosaic::BayerPattern(frame.bayer_pattern), frame.raw_bits);
+
+    // Demosaic at full resolution to keep details of small region. Even offsets keep the Bayer pattern.
+    if (!demosaic::BayerToBGR(frame.raw_image(rect), roi_buffer_,
+                              demosaic::BayerPattern(frame.bayer_pattern), frame.raw_bits))
+        return false;
+    Preprocess(roi_buffer_, x);
+    return true;
 }
 
-std::vector<bbox_t> ArmorDetector::operator()(const cv::Mat &image) const {
-    // Pre-process. [bgr2rgb & resize]
-    cv::Mat x;
-    float fx = (float) image.cols / 640.f, fy = (float) image.rows / 384.f;
-    cv::cvtColor(image, x, cv::COLOR_BGR2RGB);
-
-    if (image.cols != 640 || image.rows != 384)
-        cv::resize(x, x, {640, 384});
+void ArmorDetector::Preprocess(const cv::Mat &image, cv::Mat &x) const {
+    // Pre-process. [resize & bgr2rgb & float]
+    // Resizing first converts fewer pixels, with the same result since channels are resized independently.
+    const cv::Mat *resized = &image;
+    if (image.cols != kInputWidth || image.rows != kInputHeight) {
+        cv::resize(image, resize_buffer_, {kInputWidth, kInputHeight});
+        resized = &resize_buffer_;
+    }
+    cv::cvtColor(*resized, resize_buffer_, cv::COLOR_BGR2RGB);
+    resize_buffer_.convertTo(x, CV_32F);
+}
 
-    x.convertTo(x, CV_32F);
+void ArmorDetector::Infer(const cv::Mat &x, float fx, float fy, std::vector<bbox_t> &boxes) const {
+    boxes.clear();
 
     // Predict model.
-    std::chrono::system_clock::time_point start = std::chrono::system_clock::now();
+    if (!backend_) {
+        LOG(ERROR) << "Armor detector is not initialized.";
+        return;
+    }
 
-    cudaMemcpyAsync(device_buffer_[input_index_], x.data, input_size_ * sizeof(float), cudaMemcpyHostToDevice, stream_);
-    context_->enqueue(1, device_buffer_, stream_, nullptr);
-    cudaMemcpyAsync(output_buffer_, device_buffer_[output_index_], output_size_ * sizeof(float), cudaMemcpyDeviceToHost,
-                    stream_);
-    cudaStreamSynchronize(stream_);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
 
-    std::chrono::system_clock::time_point end = std::chrono::system_clock::now();
+    if (!backend_->Infer(x, output_buffer_.data()))
+        return;
+
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
     auto dur = end - start;
     auto time = std::chrono::duration_cast<std::chrono::microseconds>(dur);
 
@@ -235,42 +280,10 @@ std::vector<bbox_t> ArmorDetector::operator()(const cv::Mat &image) const {
     LOG(INFO) << "Armor detector inference time : [" << (double) time.count() / 1000.0 << " ms]";
 #endif
 
-    // Post-process. [nms]
-    std::vector<bbox_t> result;
-
-    result.reserve(kTopkNum);
-    std::vector<uint8_t> removed(kTopkNum);
-
-    for (int i = 0; i < kTopkNum; ++i) {
-        auto *box_buffer = output_buffer_ + i * 20;  // 20 -> 23
-
-        if (box_buffer[8] < inv_sigmoid(kKeepThreshold))
-            break;
-        else if (removed[i])
-            continue;
-
-        result.emplace_back();
-        auto &box = result.back();
-
-        memcpy(&box.points, box_buffer, 8 * sizeof(float));
-
-        for (auto &point: box.points)
-            point.x *= fx, point.y *= fy;
-
-        box.confidence = sigmoid(box_buffer[8]);
-        box.color = argmax(box_buffer + 9, 4);
-        box.id = argmax(box_buffer + 13, 7);
-
-        for (int j = i + 1; j < kTopkNum; ++j) {
-            auto *box2_buffer = output_buffer_ + j * 20;
-            if (box2_buffer[8] < inv_sigmoid(kKeepThreshold))
-                break;
-            else if (removed[j])
-                continue;
-            if (is_overlap(box_buffer, box2_buffer))
-                removed[j] = true;
-        }
-    }
+    if (dump_file_.is_open())
+        dump_file_.write((const char *) output_buffer_.data(),
+                         (std::streamsize) (output_buffer_.size() * sizeof(float)));
 
-    return result;
+    // Post-process. [decode & nms]
+    decoder_.Decode(output_buffer_.data(), fx, fy, boxes);
 }
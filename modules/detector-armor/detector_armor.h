@@ -7,57 +7,243 @@
 #ifndef DETECTOR_ARMOR_H_
 #define DETECTOR_ARMOR_H_
 
+#include <algorithm>
+#include <fstream>
+#include <memory>
 #include <opencv2/core.hpp>
-#include <NvInfer.h>
 #include "data-structure/bbox_t.h"
+#include "data-structure/frame.h"
 #include "lang-feature-extension/disable_constructor.h"
+#include "detector_armor_async.h"
+#include "detector_armor_backend.h"
+#include "detector_armor_decoder.h"
 
-/// \brief Armor detector based on TensorRT.
+/**
+ * \brief Armor detector with pluggable inference backends.
+ * \details Pre-processing, decoding and NMS are done here, only model inference depends on backend.  \n
+ *   Besides synchronous prediction, frames can be submitted and collected later after EnableAsync(),
+ *   so pre-processing of the next frame overlaps inference of the previous ones.
+ * \attention Synchronous and asynchronous predictions share the backend, do not run them at the same time.
+ */
 class ArmorDetector : NO_COPY, NO_MOVE {
-    static constexpr int kTopkNum = 128;
-    static constexpr float kKeepThreshold = 0.1f;
+    static constexpr int kTopkNum = ArmorDetectorBackend::kTopkNum;
+    static constexpr int kBoxSize = ArmorDetectorBackend::kBoxSize;
+    static constexpr int kInputWidth = ArmorDetectorBackend::kInputWidth;
+    static constexpr int kInputHeight = ArmorDetectorBackend::kInputHeight;
+    static constexpr float kMaxRoiUpscale = 2.f;  ///< Max upscale ratio from ROI to model input.
 
 public:
-    ArmorDetector() : engine_(),
-                      context_(),
-                      device_buffer_(),
-                      output_buffer_(),
-                      stream_(),
-                      input_index_(),
-                      output_index_(),
-                      input_size_(),
-                      output_size_() {}
+    static constexpr int kDefaultMaxBatchSize = 4;  ///< Default max number of images in one inference.
+
+    typedef AsyncInference::Ticket Ticket;
+
+    ArmorDetector() :
+            backend_(nullptr),
+            max_batch_size_(kDefaultMaxBatchSize),
+            output_buffer_(kTopkNum * kBoxSize),
+            decoder_(),
+            async_(nullptr) {}
 
-    ~ArmorDetector();
+    ~ArmorDetector() = default;
 
     /**
      * \brief Load and initialize model.
      * \param [in] onnx_file ONNX file path.
+     * \param [in] backend_type Backend type name, empty to use the first available one of "tensorrt" and "opencv".
+     * \return Whether model is loaded.
      */
-    void Initialize(const std::string &onnx_file);
+    bool Initialize(const std::string &onnx_file, const std::string &backend_type = "");
+
+    /**
+     * \brief Set IoU threshold of NMS.
+     * \param [in] iou_threshold Max IoU between output boxes, 0 to suppress any overlapped boxes.
+     */
+    inline void SetIouThreshold(float iou_threshold) { decoder_.SetIouThreshold(iou_threshold); }
+
+    /**
+     * \brief Set max number of images in one inference of batched prediction.
+     * \param [in] max_batch_size Max batch size, limited by backend.
+     */
+    inline void SetMaxBatchSize(int max_batch_size) {
+        max_batch_size_ = std::clamp(max_batch_size, 1, ArmorDetectorBackend::kMaxBatchSize);
+    }
+
+    /// \return Max batch size actually used, 1 before initialization or when backend does not support batching.
+    [[nodiscard]] inline int MaxBatchSize() const {
+        return backend_ ? std::min(max_batch_size_, backend_->MaxBatchSize()) : 1;
+    }
+
+    /**
+     * \brief Append raw "output-topk" tensors of all following frames to a file, for benchmarks of decoder.
+     * \param [in] file_path Output file path, empty to stop dumping.
+     * \return Whether file is opened.
+     */
+    bool DumpOutput(const std::string &file_path);
 
     /**
      * \brief Predict detection model.
      * \param [in] image Input image.
+     * \param [out] boxes 4-point structures, cleared before writing. Reuse it between frames to avoid allocation.
+     */
+    void operator()(const cv::Mat &image, std::vector<bbox_t> &boxes) const;
+
+    /**
+     * \brief Predict detection model with a frame.
+     * \details Raw frames are converted to model input directly, without producing BGR images.
+     * \param [in] frame Input frame.
+     * \param [out] boxes 4-point structures, cleared before writing. Reuse it between frames to avoid allocation.
+     */
+    void operator()(const Frame &frame, std::vector<bbox_t> &boxes) const;
+
+    /**
+     * \brief Predict detection model on multiple images, such as frames of different cameras, tiles or ROIs.
+     * \details Images are split into as few batches as possible with balanced sizes,
+     *   and each batch is packed into one tensor and predicted in one inference.
+     * \param [in] images Input images.
+     * \param [out] boxes 4-point structures of each image, resized to the number of images.
+     */
+    void operator()(const std::vector<cv::Mat> &images, std::vector<std::vector<bbox_t>> &boxes) const;
+
+    /**
+     * \brief Predict detection model in a region of a frame.
+     * \details ROI is expanded to the aspect ratio of model input and moved into frame,
+     *   then converted to model input at native or upscaled resolution, so small targets keep their pixels.
+     *   The whole frame is used when ROI covers it.
+     * \param [in] frame Input frame.
+     * \param [in] roi Region of interest in frame.
+     * \param [out] boxes 4-point structures in frame coordinate, cleared before writing.
+     * \return Region actually used.
+     */
+    cv::Rect operator()(const Frame &frame, const cv::Rect2f &roi, std::vector<bbox_t> &boxes) const;
+
+    /**
+     * \brief Fit an ROI to model input.
+     * \param [in] frame_size Size of frame.
+     * \param [in] roi Region of interest in frame.
+     * \return Region with even coordinates inside frame, at least 1/kMaxRoiUpscale of model input size.
+     */
+    static cv::Rect FitRoi(const cv::Size &frame_size, const cv::Rect2f &roi);
+
+    /**
+     * \brief Enable asynchronous prediction.
+     * \param [in] num_slots Number of in-flight requests, 0 to disable.
+     * \return Whether asynchronous prediction is enabled or disabled as required.
+     * \attention Call it after initialization, and when no request is in flight.
+     */
+    bool EnableAsync(unsigned int num_slots);
+
+    /// \return Whether asynchronous prediction is enabled.
+    [[nodiscard]] inline bool AsyncEnabled() const { return async_ != nullptr; }
+
+    /**
+     * \brief Submit a frame for asynchronous prediction.
+     * \details Frame is pre-processed in caller thread, and inference runs in background.
+     *   Waits when all slots are in use, until the oldest request is collected.
+     * \param [in] frame Input frame, only read before returning.
+     * \return Ticket to collect boxes.
+     */
+    Ticket Submit(const Frame &frame);
+
+    /**
+     * \brief Submit a region of a frame for asynchronous prediction.
+     * \param [in] frame Input frame, only read before returning.
+     * \param [in] roi Region of interest in frame, fitted in the same way as synchronous prediction.
+     * \return Ticket to collect boxes.
+     */
+    Ticket Submit(const Frame &frame, const cv::Rect2f &roi);
+
+    /**
+     * \brief Collect boxes of a submitted request without waiting.
+     * \param [in] ticket Ticket of request, released after collected.
+     * \param [out] boxes 4-point structures in frame coordinate, empty when request failed.
+     * \return Whether request is finished and collected.
+     */
+    bool Poll(Ticket ticket, std::vector<bbox_t> &boxes);
+
+    /**
+     * \brief Wait for a submitted request and collect its boxes.
+     * \param [in] ticket Ticket of request, released after collected.
+     * \param [out] boxes 4-point structures in frame coordinate, empty when request failed.
+     */
+    void Wait(Ticket ticket, std::vector<bbox_t> &boxes);
+
+    /// \return Statistics of asynchronous requests, all zero when disabled.
+    [[nodiscard]] inline AsyncInference::Statistics AsyncStatistics() const {
+        return async_ ? async_->GetStatistics() : AsyncInference::Statistics{};
+    }
+
+    /**
+     * \brief Predict detection model.
+     * \param [in] image Input image.
+     * \return 4-point structures in a vector.
+     */
+    inline std::vector<bbox_t> operator()(const cv::Mat &image) const {
+        std::vector<bbox_t> boxes;
+        (*this)(image, boxes);
+        return boxes;
+    }
+
+    /**
+     * \brief Predict detection model with a frame.
+     * \param [in] frame Input frame.
      * \return 4-point structures in a vector.
      */
-    std::vector<bbox_t> operator()(const cv::Mat &image) const;
+    inline std::vector<bbox_t> operator()(const Frame &frame) const {
+        std::vector<bbox_t> boxes;
+        (*this)(frame, boxes);
+        return boxes;
+    }
 
 private:
-    void BuildEngineFromONNX(const std::string &);
+    /// \brief Information to decode an asynchronous request.
+    struct AsyncRequest {
+        float fx;          ///< Horizontal scale from model input to region.
+        float fy;          ///< Vertical scale from model input to region.
+        cv::Point offset;  ///< Offset of region in frame.
+    };
 
-    void BuildEngineFromCache(const std::string &);
+    /**
+     * \brief Convert a region of frame to model input.
+     * \param [in] frame Input frame.
+     * \param [in] rect Region in frame, with even coordinates for raw frames.
+     * \param [out] x Float RGB image of model input size.
+     * \param [out] fx Horizontal scale from model input to region.
+     * \param [out] fy Vertical scale from model input to region.
+     * \return Whether input is converted.
+     */
+    bool Prepare(const Frame &frame, const cv::Rect &rect, cv::Mat &x, float &fx, float &fy) const;
 
-    void CacheEngine(const std::string &);
+    /// \brief Decode output of a finished asynchronous request and release it.
+    void Collect(Ticket ticket, AsyncInference::Status status, const float *output, std::vector<bbox_t> &boxes);
 
-    nvinfer1::ICudaEngine *engine_;         ///< CUDA engine handle.
-    nvinfer1::IExecutionContext *context_;  ///< CUDA execution context handle.
+    /**
+     * \brief Run model and decode its output.
+     * \param [in] input Model input, float RGB image in HWC layout.
+     * \param [in] fx Horizontal scale from model input to source image.
+     * \param [in] fy Vertical scale from model input to source image.
+     * \param [out] boxes 4-point structures.
+     */
+    void Infer(const cv::Mat &input, float fx, float fy, std::vector<bbox_t> &boxes) const;
+
+    /**
+     * \brief Convert a BGR image to model input.
+     * \param [in] image Input BGR image.
+     * \param [out] x Float RGB image of model input size, written in place when it is allocated.
+     */
+    void Preprocess(const cv::Mat &image, cv::Mat &x) const;
 
-    mutable void *device_buffer_[2];
-    float *output_buffer_;
-    cudaStream_t stream_;
-    int input_index_, output_index_;
-    size_t input_size_, output_size_;
+    std::unique_ptr<ArmorDetectorBackend> backend_;  ///< Inference backend.
+    int max_batch_size_;                             ///< Max number of images in one inference.
+    mutable std::vector<float> output_buffer_;       ///< Backend output in "output-topk" layout.
+    mutable cv::Mat input_buffer_;                   ///< Model input converted from raw frames, reused between calls.
+    mutable cv::Mat roi_buffer_;                     ///< BGR image of ROI demosaiced from raw frames.
+    mutable cv::Mat resize_buffer_;                  ///< Resized BGR image in pre-processing.
+    mutable cv::Mat batch_input_buffer_;             ///< Model inputs of a batch, stacked by rows.
+    mutable std::vector<float> batch_output_buffer_;  ///< Backend outputs of a batch.
+    mutable ArmorDecoder decoder_;                   ///< Output decoder with NMS.
+    mutable std::ofstream dump_file_;                ///< Dump file of backend output, not opened by default.
+    std::unique_ptr<AsyncInference> async_;          ///< Asynchronous inference slots, null when disabled.
+    std::vector<AsyncRequest> async_requests_;       ///< Decoding information of each slot.
 };
 
 #endif  // DETECTOR_ARMOR_H_
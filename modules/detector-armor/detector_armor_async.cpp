@@ -0,0 +1,149 @@
+#include <algorithm>
+#include "detector_armor_async.h"
+
+AsyncInference::AsyncInference(unsigned int num_slots, size_t output_size, InferFunction infer) :
+        num_slots_(std::max(num_slots, 1u)),
+        infer_(std::move(infer)),
+        slots_(num_slots_),
+        next_ticket_(0),
+        next_run_ticket_(0),
+        stop_flag_(false),
+        requests_(0),
+        failures_(0),
+        total_queue_depth_(0),
+        total_latency_(0),
+        max_latency_(0) {
+    for (auto &slot: slots_)
+        slot.output.resize(output_size);
+    worker_ = std::thread(&AsyncInference::WorkerLoop, this);
+}
+
+AsyncInference::~AsyncInference() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_flag_ = true;
+    }
+    changed_.notify_all();
+    if (worker_.joinable())
+        worker_.join();
+}
+
+AsyncInference::Ticket AsyncInference::Submit(const PrepareFunction &prepare) {
+    const auto submit_time = std::chrono::steady_clock::now();
+    std::unique_lock<std::mutex> lock(mutex_);
+    const auto ticket = next_ticket_++;
+    auto &slot = slots_[ticket % num_slots_];
+    changed_.wait(lock, [&] { return stop_flag_ || slot.state == Slot::kFree; });
+    slot.ticket = ticket;
+    slot.submit_time = submit_time;
+    if (stop_flag_) {
+        slot.state = Slot::kFailed;
+        return ticket;
+    }
+    slot.state = Slot::kPreparing;
+    total_queue_depth_ += std::count_if(slots_.begin(), slots_.end(),
+                                        [](const Slot &s) { return s.state != Slot::kFree; });
+
+    // Prepare input without lock, so the worker keeps running other slots.
+    lock.unlock();
+    const bool prepared = prepare(slot.input);
+    lock.lock();
+    if (prepared)
+        slot.state = Slot::kQueued;
+    else
+        Finish(slot, false);
+    lock.unlock();
+    changed_.notify_all();
+    return ticket;
+}
+
+AsyncInference::Status AsyncInference::Poll(Ticket ticket, const float *&output) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return SlotStatus(slots_[ticket % num_slots_], ticket, output);
+}
+
+AsyncInference::Status AsyncInference::Wait(Ticket ticket, const float *&output) const {
+    std::unique_lock<std::mutex> lock(mutex_);
+    const auto &slot = slots_[ticket % num_slots_];
+    Status status;
+    changed_.wait(lock, [&] { return (status = SlotStatus(slot, ticket, output)) != kPending; });
+    return status;
+}
+
+void AsyncInference::Release(Ticket ticket) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto &slot = slots_[ticket % num_slots_];
+        if (ticket >= next_ticket_ || slot.ticket != ticket
+            || (slot.state != Slot::kDone && slot.state != Slot::kFailed))
+            return;
+        slot.state = Slot::kFree;
+    }
+    changed_.notify_all();
+}
+
+AsyncInference::Statistics AsyncInference::GetStatistics() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return {requests_,
+            failures_,
+            next_ticket_ ? double(total_queue_depth_) / double(next_ticket_) : 0,
+            requests_ ? total_latency_ / double(requests_) : 0,
+            max_latency_};
+}
+
+AsyncInference::Status AsyncInference::SlotStatus(const Slot &slot, Ticket ticket, const float *&output) const {
+    if (ticket >= next_ticket_ || slot.ticket != ticket)
+        return slot.ticket < ticket && ticket < next_ticket_ ? kPending : kInvalid;
+    switch (slot.state) {
+        case Slot::kPreparing:
+        case Slot::kQueued:
+            return kPending;
+        case Slot::kDone:
+            output = slot.output.data();
+            return kDone;
+        case Slot::kFailed:
+            return kFailed;
+        default:
+            return kInvalid;
+    }
+}
+
+void AsyncInference::WorkerLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        // A ticket is resolved when it is queued, failed in preparing, or even released and its slot reused.
+        changed_.wait(lock, [this] {
+            if (stop_flag_)
+                return true;
+            if (next_run_ticket_ >= next_ticket_)
+                return false;
+            const auto &slot = slots_[next_run_ticket_ % num_slots_];
+            return slot.ticket > next_run_ticket_
+                   || (slot.ticket == next_run_ticket_ && slot.state != Slot::kPreparing);
+        });
+        if (stop_flag_)
+            return;
+
+        auto &slot = slots_[next_run_ticket_ % num_slots_];
+        const bool queued = slot.ticket == next_run_ticket_ && slot.state == Slot::kQueued;
+        ++next_run_ticket_;
+        if (!queued)
+            continue;
+
+        lock.unlock();
+        const bool succeeded = infer_(slot.input, slot.output.data());
+        lock.lock();
+        Finish(slot, succeeded);
+        changed_.notify_all();
+    }
+}
+
+void AsyncInference::Finish(Slot &slot, bool succeeded) {
+    slot.state = succeeded ? Slot::kDone : Slot::kFailed;
+    const auto latency = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - slot.submit_time).count();
+    ++requests_;
+    failures_ += !succeeded;
+    total_latency_ += latency;
+    max_latency_ = std::max(max_latency_, latency);
+}
@@ -0,0 +1,144 @@
+/**
+ * Asynchronous inference slots header.
+ * \author trantuan-20048607
+ * \date 2022.3.30
+ * \details Submit / poll / wait interface of inference with several in-flight requests,
+ *   independent of inference backends.
+ */
+
+#ifndef DETECTOR_ARMOR_ASYNC_H_
+#define DETECTOR_ARMOR_ASYNC_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <opencv2/core/core.hpp>
+#include "lang-feature-extension/attr_reader.h"
+#include "lang-feature-extension/disable_constructor.h"
+
+/**
+ * \brief Asynchronous inference with in-flight slots.
+ * \details Each slot owns its input and output buffers. A request takes the slot of its ticket,
+ *   whose input is prepared in caller thread, then inference runs in a worker thread in order of tickets.
+ *   So preparing request N + 1 overlaps inference of request N.  \n
+ *   Slots are used in turn, ticket t always takes slot t % NumSlots(), and a slot is free again after
+ *   its result is released.
+ * \attention Submit waits while the slot of new ticket is in use, so a thread must release old requests
+ *   before submitting more than NumSlots() requests.
+ */
+class AsyncInference : NO_COPY, NO_MOVE {
+public:
+    typedef uint64_t Ticket;
+
+    /// \brief Inference function, returns whether inference succeeded.
+    typedef std::function<bool(const cv::Mat &input, float *output)> InferFunction;
+
+    /// \brief Input preparing function, returns whether input is ready.
+    typedef std::function<bool(cv::Mat &input)> PrepareFunction;
+
+    /// Status of a request.
+    enum Status {
+        kPending = 0,  ///< Not finished.
+        kDone = 1,     ///< Finished successfully.
+        kFailed = 2,   ///< Preparing or inference failed.
+        kInvalid = 3   ///< Ticket is released or not submitted.
+    };
+
+    /// \brief Statistics of requests.
+    struct Statistics {
+        uint64_t requests;           ///< Number of finished requests.
+        uint64_t failures;           ///< Number of failed requests.
+        double average_queue_depth;  ///< Average number of requests in flight when submitting, including itself.
+        double average_latency;      ///< Average time from submitting to finishing in milliseconds.
+        double max_latency;          ///< Max time from submitting to finishing in milliseconds.
+    };
+
+    /**
+     * \param [in] num_slots Number of in-flight slots, at least 1.
+     * \param [in] output_size Number of output floats of a request.
+     * \param [in] infer Inference function, called in worker thread.
+     */
+    AsyncInference(unsigned int num_slots, size_t output_size, InferFunction infer);
+
+    ~AsyncInference();
+
+    ATTR_READER(num_slots_, NumSlots)
+
+    /**
+     * \brief Submit a request.
+     * \param [in] prepare Function to write input buffer, called in caller thread.
+     * \return Ticket of this request.
+     */
+    Ticket Submit(const PrepareFunction &prepare);
+
+    /**
+     * \brief Check status of a request without waiting.
+     * \param [in] ticket Ticket of request.
+     * \param [out] output Output buffer when request is done, valid until released.
+     * \return Status of request.
+     */
+    Status Poll(Ticket ticket, const float *&output) const;
+
+    /**
+     * \brief Wait for a request to finish.
+     * \param [in] ticket Ticket of request.
+     * \param [out] output Output buffer when request is done, valid until released.
+     * \return Status of request, never kPending.
+     */
+    Status Wait(Ticket ticket, const float *&output) const;
+
+    /// \brief Release a finished request and free its slot.
+    void Release(Ticket ticket);
+
+    /// \return Statistics of all requests.
+    [[nodiscard]] Statistics GetStatistics() const;
+
+private:
+    /// \brief Inference slot with its own buffers.
+    struct Slot {
+        enum States {
+            kFree = 0,
+            kPreparing = 1,
+            kQueued = 2,
+            kDone = 3,
+            kFailed = 4
+        };
+
+        States state = kFree;
+        Ticket ticket = 0;
+        cv::Mat input;
+        std::vector<float> output;
+        std::chrono::steady_clock::time_point submit_time;
+    };
+
+    /// \brief Get status of a slot with lock held.
+    Status SlotStatus(const Slot &slot, Ticket ticket, const float *&output) const;
+
+    /// \brief Run queued requests in order of tickets.
+    void WorkerLoop();
+
+    /// \brief Record statistics of a finished request with lock held.
+    void Finish(Slot &slot, bool succeeded);
+
+    const unsigned int num_slots_;  ///< Number of slots.
+    const InferFunction infer_;     ///< Inference function.
+    std::vector<Slot> slots_;       ///< All slots.
+    Ticket next_ticket_;            ///< Ticket of the next submitted request.
+    Ticket next_run_ticket_;        ///< Ticket of the next request to run.
+    bool stop_flag_;                ///< Stop worker thread.
+
+    uint64_t requests_;          ///< Number of finished requests.
+    uint64_t failures_;          ///< Number of failed requests.
+    uint64_t total_queue_depth_;  ///< Sum of queue depth sampled at each submitting.
+    double total_latency_;       ///< Sum of latency in milliseconds.
+    double max_latency_;         ///< Max latency in milliseconds.
+
+    mutable std::mutex mutex_;               ///< Mutex lock for all members above.
+    mutable std::condition_variable changed_;  ///< Notified when any slot changes.
+    std::thread worker_;                     ///< Worker thread running inference.
+};
+
+#endif  // DETECTOR_ARMOR_ASYNC_H_
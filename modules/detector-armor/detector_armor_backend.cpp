@@ -0,0 +1,27 @@
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <vector>
+#include "detector_armor_backend.h"
+
+void ArmorDetectorBackend::SelectTopK(const float *output, float *output_topk) {
+    thread_local std::vector<int> indices(kNumBoxes);
+    std::iota(indices.begin(), indices.end(), 0);
+
+    auto greater = [output](int a, int b) {
+        return output[a * kBoxSize + kConfidenceIndex] > output[b * kBoxSize + kConfidenceIndex];
+    };
+    std::nth_element(indices.begin(), indices.begin() + kTopkNum - 1, indices.end(), greater);
+    std::sort(indices.begin(), indices.begin() + kTopkNum, greater);
+
+    for (int i = 0; i < kTopkNum; ++i)
+        std::memcpy(output_topk + i * kBoxSize, output + indices[i] * kBoxSize, kBoxSize * sizeof(float));
+}
+
+bool ArmorDetectorBackend::InferBatch(const cv::Mat &input, int batch_size, float *output_topk) {
+    for (int i = 0; i < batch_size; ++i)
+        if (!Infer(input.rowRange(i * kInputHeight, (i + 1) * kInputHeight),
+                   output_topk + size_t(i) * kTopkNum * kBoxSize))
+            return false;
+    return true;
+}
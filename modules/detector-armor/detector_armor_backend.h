@@ -0,0 +1,76 @@
+/**
+ * Armor detector inference backend base class header.
+ * \author trantuan-20048607
+ * \date 2022.3.27
+ * \details Include this file only to declare or use pointers of armor detector backend.
+ */
+
+#ifndef DETECTOR_ARMOR_BACKEND_H_
+#define DETECTOR_ARMOR_BACKEND_H_
+
+#include <string>
+#include <opencv2/core/core.hpp>
+#include "lang-feature-extension/disable_constructor.h"
+
+/**
+ * \brief Armor detector inference backend base class.
+ * \details A backend only runs the model and outputs the same "output-topk" layout,
+ *   decoding and NMS are done by ArmorDetector, so all backends return identical boxes.
+ * \note You cannot directly construct objects.  \n
+ *   Instead, find backend types in subclass documents,
+ *   include detector_armor_backend_factory.h and use CREATE_ARMOR_DETECTOR_BACKEND macro.
+ */
+class ArmorDetectorBackend : NO_COPY, NO_MOVE {
+public:
+    static constexpr int kInputWidth = 640;     ///< Width of model input.
+    static constexpr int kInputHeight = 384;    ///< Height of model input.
+    static constexpr int kNumBoxes = 15120;     ///< Number of boxes in raw model output.
+    static constexpr int kBoxSize = 20;         ///< Floats of a box, 8 points, 1 confidence, 4 colors and 7 ids.
+    static constexpr int kConfidenceIndex = 8;  ///< Index of confidence in a box.
+    static constexpr int kTopkNum = 128;        ///< Number of boxes in "output-topk" layout.
+    static constexpr int kMaxBatchSize = 16;    ///< Max number of images in a batch of any backend.
+
+    ArmorDetectorBackend() = default;
+
+    virtual ~ArmorDetectorBackend() = default;
+
+    /**
+     * \brief Load and initialize model.
+     * \param [in] onnx_file ONNX file path.
+     * \return Whether model is loaded.
+     */
+    virtual bool Initialize(const std::string &onnx_file) = 0;
+
+    /**
+     * \brief Run model.
+     * \param [in] input Continuous float RGB image of kInputHeight x kInputWidth in HWC layout.
+     * \param [out] output_topk Top kTopkNum boxes of kBoxSize floats, in descending order of confidence.
+     * \return Whether inference succeeded.
+     */
+    virtual bool Infer(const cv::Mat &input, float *output_topk) = 0;
+
+    /// \return Max number of images in one inference, 1 when batching is not supported.
+    [[nodiscard]] virtual int MaxBatchSize() const { return 1; }
+
+    /**
+     * \brief Run model on a batch of images.
+     * \details Default implementation runs Infer image by image.
+     * \param [in] input Continuous float RGB images stacked by rows, (batch_size * kInputHeight) x kInputWidth,
+     *   which is the same memory layout as an NHWC tensor.
+     * \param [in] batch_size Number of images, not larger than MaxBatchSize().
+     * \param [out] output_topk Top-k boxes of all images, batch_size * kTopkNum * kBoxSize floats.
+     * \return Whether inference succeeded.
+     */
+    virtual bool InferBatch(const cv::Mat &input, int batch_size, float *output_topk);
+
+protected:
+    /**
+     * \brief Select top kTopkNum boxes by confidence on CPU.
+     * \details This is the same as slice, top-k and gather layers appended to TensorRT network.
+     * \param [in] output Raw model output of kNumBoxes boxes.
+     * \param [out] output_topk Output of kTopkNum boxes.
+     */
+    static void SelectTopK(const float *output, float *output_topk);
+};
+
+#endif  // DETECTOR_ARMOR_BACKEND_H_
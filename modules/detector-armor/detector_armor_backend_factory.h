@@ -0,0 +1,121 @@
+/**
+ * Armor detector backend factory header.
+ * \author trantuan-20048607
+ * \date 2022.3.27
+ * \details Include this file to create armor detector backend objects.
+ */
+
+#ifndef DETECTOR_ARMOR_BACKEND_FACTORY_H_
+#define DETECTOR_ARMOR_BACKEND_FACTORY_H_
+
+#include <unordered_map>
+#include <glog/logging.h>
+#include "detector_armor_backend.h"
+
+/// \brief A macro to create an armor detector backend of specified type name.
+#define CREATE_ARMOR_DETECTOR_BACKEND(backend_type_name)  \
+    ArmorDetectorBackendFactory::Instance().CreateBackend(backend_type_name)
+
+/**
+ * \brief Base class of armor detector backend registry.
+ * \warning You should use its subclass ArmorDetectorBackendRegistry instead of this base class.
+ */
+class ArmorDetectorBackendRegistryBase : NO_COPY, NO_MOVE {
+public:
+    virtual ArmorDetectorBackend *CreateBackend() = 0;
+
+protected:
+    ArmorDetectorBackendRegistryBase() = default;
+
+    virtual ~ArmorDetectorBackendRegistryBase() = default;
+};
+
+/**
+ * \brief Singleton armor detector backend factory.
+ * \details
+ *   For Singleton pattern, refer to https://en.wikipedia.org/wiki/Singleton_pattern.  \n
+ *   For Factory pattern, refer to https://en.wikipedia.org/wiki/Factory_method_pattern.
+ */
+class ArmorDetectorBackendFactory : NO_COPY, NO_MOVE {
+public:
+    /**
+     * \brief Get the only instance of armor detector backend factory.
+     * \return An armor detector backend factory object.
+     */
+    inline static ArmorDetectorBackendFactory &Instance() {
+        static ArmorDetectorBackendFactory _;
+        return _;
+    }
+
+    /**
+     * \brief Register an armor detector backend type.
+     * \param [in] backend_type_name Type name of backend.
+     * \param [in] registry A registry object of backend.
+     * \warning You may call this function only when you're programming for a new type of backend.
+     */
+    inline void RegisterBackend(const std::string &backend_type_name,
+                                ArmorDetectorBackendRegistryBase *registry) {
+        backend_registry_[backend_type_name] = registry;
+    }
+
+    /**
+     * \brief Check whether a backend type is compiled and registered.
+     * \param [in] backend_type_name Type name of backend.
+     * \return Whether this type can be created.
+     */
+    [[nodiscard]] inline bool HasBackend(const std::string &backend_type_name) const {
+        return backend_registry_.find(backend_type_name) != backend_registry_.end();
+    }
+
+    /**
+     * \brief Create an armor detector backend whose type is registered to factory.
+     * \param [in] backend_type_name Type name of backend.
+     * \return A pointer to created backend.
+     * \note You may use macro CREATE_ARMOR_DETECTOR_BACKEND(backend_type_name) instead of call this function.
+     */
+    inline ArmorDetectorBackend *CreateBackend(const std::string &backend_type_name) {
+        if (HasBackend(backend_type_name)) {
+            DLOG(INFO) << "Created " << backend_type_name << " armor detector backend.";
+            return backend_registry_[backend_type_name]->CreateBackend();
+        } else {
+            LOG(ERROR) << "Armor detector backend type '" << backend_type_name << "' not found.";
+            return nullptr;
+        }
+    }
+
+private:
+    ArmorDetectorBackendFactory() = default;
+
+    ~ArmorDetectorBackendFactory() = default;
+
+    std::unordered_map<std::string, ArmorDetectorBackendRegistryBase *> backend_registry_;  ///< Backend registry map.
+};
+
+/**
+ * \brief Templated armor detector backend registry class.
+ * \tparam BackendType Backend type inherited from base class ArmorDetectorBackend.
+ * \attention Once object is constructed, this type of backend will immediately
+ *     be registered to backend factory.  \n
+ *   This means the constructed object is useless and should not appear in any other place.  \n
+ *   (Thus, template class though this is, it's better to be treated as a function.)
+ */
+template<class BackendType>
+class ArmorDetectorBackendRegistry final : public ArmorDetectorBackendRegistryBase {
+public:
+    /**
+     * \brief Constructor of armor detector backend registry.
+     * \param [in] backend_type_name Type name of backend.
+     */
+    explicit ArmorDetectorBackendRegistry<BackendType>(const std::string &backend_type_name) {
+        ArmorDetectorBackendFactory::Instance().RegisterBackend(backend_type_name, this);
+    }
+
+    /**
+     * \brief Create a backend of this type.
+     * \return A backend pointer.
+     * \warning NEVER directly call this function. Instead, it should be called by backend factory.
+     */
+    inline ArmorDetectorBackend *CreateBackend() final { return new BackendType(); }
+};
+
+#endif  // DETECTOR_ARMOR_BACKEND_FACTORY_H_
@@ -0,0 +1,127 @@
+#include <opencv2/dnn.hpp>
+#include "detector_armor_backend_factory.h"
+#include "detector_armor_backend_opencv.h"
+#include "detector_armor_calibration.h"
+
+/// Net::quantize is added in OpenCV 4.5.5.
+#define OPENCV_DNN_QUANTIZE (CV_VERSION_MAJOR > 4 || (CV_VERSION_MAJOR == 4 && (CV_VERSION_MINOR > 5 || \
+                                     (CV_VERSION_MINOR == 5 && CV_VERSION_REVISION >= 5))))
+
+/**
+ * \warning Backend registry will be initialized before the program entering the main function!
+ *   This means any error occurring here will not be caught unless you're using debugger.
+ *   (Thus, do not use this variable in any other place and you should not modify it.)
+ */
+[[maybe_unused]] ArmorDetectorBackendRegistry<OpenCVBackend> OpenCVBackend::registry_ =
+        ArmorDetectorBackendRegistry<OpenCVBackend>("opencv");
+
+[[maybe_unused]] ArmorDetectorBackendRegistry<OpenCVInt8Backend> OpenCVInt8Backend::registry_ =
+        ArmorDetectorBackendRegistry<OpenCVInt8Backend>("opencv-int8");
+
+bool OpenCVBackend::Initialize(const std::string &onnx_file) {
+    try { net_ = cv::dnn::readNetFromONNX(onnx_file); }
+    catch (const cv::Exception &error) {
+        LOG(ERROR) << "Failed to load ONNX model " << onnx_file << ": " << error.what();
+        return false;
+    }
+    if (net_.empty()) {
+        LOG(ERROR) << "Failed to load ONNX model " << onnx_file << ".";
+        return false;
+    }
+    net_.setPreferableBackend(cv::dnn::DNN_BACKEND_OPENCV);
+    net_.setPreferableTarget(cv::dnn::DNN_TARGET_CPU);
+
+    // Keep only raw model output, the same as the first output used by TensorRT backend.
+    output_names_ = net_.getUnconnectedOutLayersNames();
+    if (output_names_.empty()) {
+        LOG(ERROR) << "No output found in ONNX model " << onnx_file << ".";
+        return false;
+    }
+    output_names_.resize(1);
+
+    LOG(INFO) << "OpenCV DNN backend will run on CPU with " << cv::getNumThreads() << " threads.";
+    return true;
+}
+
+bool OpenCVBackend::Infer(const cv::Mat &input, float *output_topk) {
+    return InferBatch(input, 1, output_topk);
+}
+
+bool OpenCVBackend::InferBatch(const cv::Mat &input, int batch_size, float *output_topk) {
+    if (!input.isContinuous() || input.type() != CV_32FC3 ||
+        input.rows != kInputHeight * batch_size || input.cols != kInputWidth) {
+        LOG(ERROR) << "Invalid armor detector input.";
+        return false;
+    }
+    if (batch_size > 1 && !batch_supported_)
+        return ArmorDetectorBackend::InferBatch(input, batch_size, output_topk);
+
+    // Model takes HWC input the same as TensorRT backend, so wrap input as an NHWC blob without copying.
+    const int shape[] = {batch_size, kInputHeight, kInputWidth, 3};
+    net_.setInput(cv::Mat(4, shape, CV_32F, input.data));
+    try { net_.forward(outputs_, output_names_); }
+    catch (const cv::Exception &error) {
+        LOG_IF(ERROR, batch_size == 1) << "Armor detector inference failed: " << error.what();
+        outputs_.clear();
+    }
+
+    if (outputs_.empty() || outputs_.front().total() != size_t(batch_size) * kNumBoxes * kBoxSize
+        || !outputs_.front().isContinuous()) {
+        if (batch_size > 1) {
+            LOG(WARNING) << "Batched inference is not supported by this model, images will run one by one.";
+            batch_supported_ = false;
+            return ArmorDetectorBackend::InferBatch(input, batch_size, output_topk);
+        }
+        LOG_IF(ERROR, !outputs_.empty()) << "Unexpected armor detector output size "
+                                         << outputs_.front().total() << ".";
+        return false;
+    }
+    const auto &output = outputs_.front();
+    for (int i = 0; i < batch_size; ++i)
+        SelectTopK(output.ptr<float>() + size_t(i) * kNumBoxes * kBoxSize,
+                   output_topk + size_t(i) * kTopkNum * kBoxSize);
+    return true;
+}
+
+bool OpenCVInt8Backend::Initialize(const std::string &onnx_file) {
+#if OPENCV_DNN_QUANTIZE
+    if (!OpenCVBackend::Initialize(onnx_file))
+        return false;
+
+    const auto calibration_file = calibration::CalibrationFile(onnx_file);
+    std::vector<cv::Mat> samples;
+    if (!calibration::Load(calibration_file, samples)) {
+        LOG(ERROR) << "Failed to load calibration data of " << onnx_file << ", run calibration tool first.";
+        return false;
+    }
+
+    // Calibration blobs are NHWC float, the same as inference input.
+    const int shape[] = {1, kInputHeight, kInputWidth, 3};
+    std::vector<cv::Mat> calibration_data(samples.size());
+    for (size_t i = 0; i < samples.size(); ++i) {
+        cv::Mat x;
+        samples[i].convertTo(x, CV_32F);
+        calibration_data[i] = x.reshape(1, 4, shape);
+    }
+
+    // Keep float input and output, so only layers between them run in INT8.
+    try { net_ = net_.quantize(calibration_data, CV_32F, CV_32F); }
+    catch (const cv::Exception &error) {
+        LOG(ERROR) << "Failed to quantize ONNX model " << onnx_file << ": " << error.what();
+        return false;
+    }
+    net_.setPreferableBackend(cv::dnn::DNN_BACKEND_OPENCV);
+    net_.setPreferableTarget(cv::dnn::DNN_TARGET_CPU);
+    output_names_ = net_.getUnconnectedOutLayersNames();
+    if (output_names_.empty()) {
+        LOG(ERROR) << "No output found in quantized model of " << onnx_file << ".";
+        return false;
+    }
+    output_names_.resize(1);
+    LOG(INFO) << "Quantized armor detector model to INT8 with " << samples.size() << " calibration samples.";
+    return true;
+#else
+    LOG(ERROR) << "INT8 quantization requires OpenCV 4.5.5 or later, but OpenCV " << CV_VERSION << " is used.";
+    return false;
+#endif
+}
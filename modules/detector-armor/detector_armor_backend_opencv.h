@@ -0,0 +1,70 @@
+/**
+ * OpenCV DNN armor detector backend header.
+ * \author trantuan-20048607
+ * \date 2022.3.27
+ * \warning NEVER include this file except in ./detector_armor_backend_opencv.cpp.
+ */
+
+#ifndef DETECTOR_ARMOR_BACKEND_OPENCV_H_
+#define DETECTOR_ARMOR_BACKEND_OPENCV_H_
+
+// Include nothing to avoid this file being wrongly included.
+
+/**
+ * \brief Armor detector backend running on CPU with OpenCV DNN module.
+ * \details Layers are parallelized by OpenCV threads (intra-op threading),
+ *   and top-k boxes are selected on CPU after inference.
+ *   OpenCV threads are shared by the whole process, so their number is set in main function instead of here.  \n
+ *   Batches run in one forward pass when the model has a dynamic batch dimension.
+ *   Otherwise the first batch fails and this backend falls back to running images one by one.
+ * \warning NEVER directly use this class to create backend!  \n
+ *   Instead, turn to ArmorDetectorBackendFactory class and use CREATE_ARMOR_DETECTOR_BACKEND("opencv").
+ */
+class [[maybe_unused]] OpenCVBackend : public ArmorDetectorBackend {
+public:
+    OpenCVBackend() : batch_supported_(true) {}
+
+    ~OpenCVBackend() override = default;
+
+    bool Initialize(const std::string &onnx_file) override;
+
+    bool Infer(const cv::Mat &input, float *output_topk) final;
+
+    [[nodiscard]] int MaxBatchSize() const final { return batch_supported_ ? kMaxBatchSize : 1; }
+
+    bool InferBatch(const cv::Mat &input, int batch_size, float *output_topk) final;
+
+protected:
+    cv::dnn::Net net_;                       ///< OpenCV DNN network.
+    std::vector<std::string> output_names_;  ///< Name of raw output layer.
+    std::vector<cv::Mat> outputs_;           ///< Output blobs, reused between calls.
+    bool batch_supported_;                   ///< Model accepts batch size larger than 1, cleared when it fails.
+
+private:
+    /// Own registry for OpenCV backend.
+    [[maybe_unused]] static ArmorDetectorBackendRegistry<OpenCVBackend> registry_;
+};
+
+/**
+ * \brief Armor detector backend running an INT8 quantized model on CPU with OpenCV DNN module.
+ * \details The fp32 ONNX model is quantized when loading, with activation ranges calibrated on frames
+ *   sampled by the calibration tool and saved beside the model, see detector_armor_calibration.h.
+ *   Inputs and outputs stay in float, so pre-processing and decoding are the same as fp32 backends.
+ * \attention Requires OpenCV 4.5.5 or later, initialization fails with earlier versions.
+ * \warning NEVER directly use this class to create backend!  \n
+ *   Instead, turn to ArmorDetectorBackendFactory class and use CREATE_ARMOR_DETECTOR_BACKEND("opencv-int8").
+ */
+class [[maybe_unused]] OpenCVInt8Backend final : public OpenCVBackend {
+public:
+    OpenCVInt8Backend() = default;
+
+    ~OpenCVInt8Backend() final = default;
+
+    bool Initialize(const std::string &onnx_file) final;
+
+private:
+    /// Own registry for OpenCV INT8 backend.
+    [[maybe_unused]] static ArmorDetectorBackendRegistry<OpenCVInt8Backend> registry_;
+};
+
+#endif  // DETECTOR_ARMOR_BACKEND_OPENCV_H_
@@ -0,0 +1,175 @@
+#include <filesystem>
+#include <fstream>
+#include <cuda.h>
+#include <cuda_runtime_api.h>
+#include <NvInfer.h>
+#include <NvOnnxParser.h>
+#include <logger.h>
+#include "detector_armor_backend_factory.h"
+#include "detector_armor_backend_tensorrt.h"
+
+#define TRT_ASSERT(expr)                                              \
+    if(!(expr)) {                                                     \
+        LOG(ERROR) << "TensorRT assertion failed: " << #expr << ".";  \
+        exit(-1);                                                     \
+    }
+
+static inline size_t get_dims_size(const nvinfer1::Dims &dims) {
+    size_t sz = 1;
+    for (int i = 0; i < dims.nbDims; ++i) sz *= dims.d[i];
+    return sz;
+}
+
+/**
+ * \warning Backend registry will be initialized before the program entering the main function!
+ *   This means any error occurring here will not be caught unless you're using debugger.
+ *   (Thus, do not use this variable in any other place and you should not modify it.)
+ */
+[[maybe_unused]] ArmorDetectorBackendRegistry<TensorRTBackend> TensorRTBackend::registry_ =
+        ArmorDetectorBackendRegistry<TensorRTBackend>("tensorrt");
+
+bool TensorRTBackend::Initialize(const std::string &onnx_file) {
+    std::filesystem::path onnx_file_path(onnx_file);
+    auto cache_file_path = onnx_file_path;
+    cache_file_path.replace_extension("cache");
+
+    if (std::filesystem::exists(cache_file_path)) {
+        BuildEngineFromCache(cache_file_path.c_str());
+    } else {
+        BuildEngineFromONNX(onnx_file_path.c_str());
+        CacheEngine(cache_file_path.c_str());
+    }
+
+    TRT_ASSERT((context_ = engine_->createExecutionContext()) != nullptr)
+    TRT_ASSERT((input_index_ = engine_->getBindingIndex("input")) == 0)
+    TRT_ASSERT((output_index_ = engine_->getBindingIndex("output-topk")) == 1)
+
+    auto input_dims = engine_->getBindingDimensions(input_index_);
+    auto output_dims = engine_->getBindingDimensions(output_index_);
+    input_size_ = get_dims_size(input_dims);
+    output_size_ = get_dims_size(output_dims);
+    TRT_ASSERT(input_size_ == kInputWidth * kInputHeight * 3)
+    TRT_ASSERT(output_size_ == kTopkNum * kBoxSize)
+
+    TRT_ASSERT(cudaMalloc(&device_buffer_[input_index_], input_size_ * sizeof(float)) == 0)
+    TRT_ASSERT(cudaMalloc(&device_buffer_[output_index_], output_size_ * sizeof(float)) == 0)
+    TRT_ASSERT(cudaStreamCreate(&stream_) == 0)
+    return true;
+}
+
+TensorRTBackend::~TensorRTBackend() {
+    if (!engine_)
+        return;
+
+    cudaStreamDestroy(stream_);
+    cudaFree(device_buffer_[output_index_]);
+    cudaFree(device_buffer_[input_index_]);
+
+    engine_->destroy();
+}
+
+void TensorRTBackend::BuildEngineFromONNX(const std::string &onnx_file) {
+    LOG(INFO) << "Engine will be built from ONNX.";
+    auto builder = nvinfer1::createInferBuilder(sample::gLogger);
+    TRT_ASSERT(builder != nullptr)
+
+    const auto explicitBatch = 1U <<
+                                  static_cast<uint32_t>(nvinfer1::NetworkDefinitionCreationFlag::kEXPLICIT_BATCH);
+    auto network = builder->createNetworkV2(explicitBatch);
+    TRT_ASSERT(network != nullptr)
+
+    auto parser = nvonnxparser::createParser(*network, sample::gLogger);
+    TRT_ASSERT(parser != nullptr)
+
+    parser->parseFromFile(onnx_file.c_str(),
+                          static_cast<int>(nvinfer1::ILogger::Severity::kINFO));
+
+    auto yolov5_output = network->getOutput(0);
+
+    auto slice_layer = network->addSlice(*yolov5_output,
+                                         nvinfer1::Dims3{0, 0, kConfidenceIndex},
+                                         nvinfer1::Dims3{1, kNumBoxes, 1},
+                                         nvinfer1::Dims3{1, 1, 1});
+
+    auto yolov5_conf = slice_layer->getOutput(0);
+
+    auto shuffle_layer = network->addShuffle(*yolov5_conf);
+    shuffle_layer->setReshapeDimensions(nvinfer1::Dims2{1, kNumBoxes});
+
+    yolov5_conf = shuffle_layer->getOutput(0);
+
+    auto topk_layer = network->addTopK(*yolov5_conf,
+                                       nvinfer1::TopKOperation::kMAX,
+                                       kTopkNum,
+                                       1 << 1);
+
+    auto topk_idx = topk_layer->getOutput(1);
+
+    auto gather_layer = network->addGather(*yolov5_output, *topk_idx, 1);
+    gather_layer->setNbElementWiseDims(1);
+
+    auto yolov5_output_topk = gather_layer->getOutput(0);
+    yolov5_output_topk->setName("output-topk");
+
+    network->getInput(0)->setName("input");
+    network->markOutput(*yolov5_output_topk);
+    network->unmarkOutput(*yolov5_output);
+
+    auto config = builder->createBuilderConfig();
+
+    if (builder->platformHasFastFp16()) {
+        LOG(INFO) << "Platform supports fp16, fp16 is enabled.";
+        config->setFlag(nvinfer1::BuilderFlag::kFP16);
+    } else {
+        LOG(INFO) << "Platform does not support fp16, enable fp32 instead.";
+    }
+
+    size_t free, total;
+    cuMemGetInfo(&free, &total);
+
+    LOG(INFO) << "GPU memory total: " << (total >> 20) << "MB, free: " << (free >> 20) << "MB.";
+    LOG(INFO) << "Max workspace size will use all of free GPU memory.";
+
+    config->setMaxWorkspaceSize(free >> 1);
+
+    TRT_ASSERT((engine_ = builder->buildEngineWithConfig(*network, *config)) != nullptr)
+
+    config->destroy();
+    parser->destroy();
+    network->destroy();
+    builder->destroy();
+}
+
+void TensorRTBackend::BuildEngineFromCache(const std::string &cache_file) {
+    LOG(INFO) << "Engine will be built from cache.";
+    std::ifstream ifs(cache_file, std::ios::binary);
+    ifs.seekg(0, std::ios::end);
+    size_t sz = ifs.tellg();
+    ifs.seekg(0, std::ios::beg);
+    auto buffer = std::make_unique<char[]>(sz);
+    ifs.read(buffer.get(), (std::streamsize) sz);
+    auto runtime = nvinfer1::createInferRuntime(sample::gLogger);
+
+    TRT_ASSERT(runtime != nullptr)
+    TRT_ASSERT((engine_ = runtime->deserializeCudaEngine(buffer.get(), sz)) != nullptr)
+
+    runtime->destroy();
+}
+
+void TensorRTBackend::CacheEngine(const std::string &cache_file) {
+    auto engine_buffer = engine_->serialize();
+    TRT_ASSERT(engine_buffer != nullptr)
+
+    std::ofstream ofs(cache_file, std::ios::binary);
+    ofs.write(static_cast<const char *>(engine_buffer->data()), (std::streamsize) engine_buffer->size());
+    engine_buffer->destroy();
+}
+
+bool TensorRTBackend::Infer(const cv::Mat &input, float *output_topk) {
+    cudaMemcpyAsync(device_buffer_[input_index_], input.data, input_size_ * sizeof(float), cudaMemcpyHostToDevice,
+                    stream_);
+    context_->enqueue(1, device_buffer_, stream_, nullptr);
+    cudaMemcpyAsync(output_topk, device_buffer_[output_index_], output_size_ * sizeof(float), cudaMemcpyDeviceToHost,
+                    stream_);
+    return cudaStreamSynchronize(stream_) == cudaSuccess;
+}
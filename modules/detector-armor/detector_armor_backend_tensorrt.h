@@ -0,0 +1,56 @@
+/**
+ * TensorRT armor detector backend header.
+ * \author anonymity, screw-44, trantuan-20048607
+ * \date 2022.3.27
+ * \warning NEVER include this file except in ./detector_armor_backend_tensorrt.cpp.
+ */
+
+#ifndef DETECTOR_ARMOR_BACKEND_TENSORRT_H_
+#define DETECTOR_ARMOR_BACKEND_TENSORRT_H_
+
+// Include nothing to avoid this file being wrongly included.
+
+/**
+ * \brief Armor detector backend based on TensorRT.
+ * \details Top-k boxes are selected on GPU by layers appended to the network.
+ *   Engine is built with explicit batch 1, so batches run image by image.
+ * \warning NEVER directly use this class to create backend!  \n
+ *   Instead, turn to ArmorDetectorBackendFactory class and use CREATE_ARMOR_DETECTOR_BACKEND("tensorrt").
+ */
+class [[maybe_unused]] TensorRTBackend final : public ArmorDetectorBackend {
+public:
+    TensorRTBackend() : engine_(),
+                        context_(),
+                        device_buffer_(),
+                        stream_(),
+                        input_index_(),
+                        output_index_(),
+                        input_size_(),
+                        output_size_() {}
+
+    ~TensorRTBackend() final;
+
+    bool Initialize(const std::string &onnx_file) final;
+
+    bool Infer(const cv::Mat &input, float *output_topk) final;
+
+private:
+    void BuildEngineFromONNX(const std::string &);
+
+    void BuildEngineFromCache(const std::string &);
+
+    void CacheEngine(const std::string &);
+
+    nvinfer1::ICudaEngine *engine_;         ///< CUDA engine handle.
+    nvinfer1::IExecutionContext *context_;  ///< CUDA execution context handle.
+
+    void *device_buffer_[2];
+    cudaStream_t stream_;
+    int input_index_, output_index_;
+    size_t input_size_, output_size_;
+
+    /// Own registry for TensorRT backend.
+    [[maybe_unused]] static ArmorDetectorBackendRegistry<TensorRTBackend> registry_;
+};
+
+#endif  // DETECTOR_ARMOR_BACKEND_TENSORRT_H_
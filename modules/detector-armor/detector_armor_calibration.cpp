@@ -0,0 +1,76 @@
+#include <fstream>
+#include <opencv2/imgproc.hpp>
+#include <glog/logging.h>
+#include "detector_armor_backend.h"
+#include "detector_armor_calibration.h"
+
+constexpr int kSampleWidth = ArmorDetectorBackend::kInputWidth;
+constexpr int kSampleHeight = ArmorDetectorBackend::kInputHeight;
+constexpr size_t kSampleSize = size_t(kSampleWidth) * kSampleHeight * 3;  ///< Bytes of a sample.
+
+std::string calibration::CalibrationFile(const std::string &onnx_file) {
+    // Same as std::filesystem::path::replace_extension, without linking stdc++fs in tests and benchmarks.
+    const auto extension = onnx_file.find_last_of('.');
+    const auto file_name = onnx_file.find_last_of('/');
+    if (extension == std::string::npos || (file_name != std::string::npos && extension < file_name)
+        || extension == file_name + 1)
+        return onnx_file + ".calib";
+    return onnx_file.substr(0, extension) + ".calib";
+}
+
+void calibration::ToSample(const cv::Mat &image, cv::Mat &sample) {
+    cv::Mat resized;
+    if (image.cols != kSampleWidth || image.rows != kSampleHeight)
+        cv::resize(image, resized, {kSampleWidth, kSampleHeight});
+    else
+        resized = image;
+    cv::cvtColor(resized, sample, cv::COLOR_BGR2RGB);
+}
+
+bool calibration::Save(const std::string &file_path, const std::vector<cv::Mat> &samples) {
+    std::ofstream file(file_path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        LOG(ERROR) << "Failed to open calibration file " << file_path << ".";
+        return false;
+    }
+    for (const auto &sample: samples) {
+        if (sample.type() != CV_8UC3 || sample.cols != kSampleWidth || sample.rows != kSampleHeight) {
+            LOG(ERROR) << "Invalid calibration sample.";
+            return false;
+        }
+        const cv::Mat continuous = sample.isContinuous() ? sample : sample.clone();
+        file.write((const char *) continuous.data, (std::streamsize) kSampleSize);
+    }
+    if (!file) {
+        LOG(ERROR) << "Failed to write calibration file " << file_path << ".";
+        return false;
+    }
+    return true;
+}
+
+bool calibration::Load(const std::string &file_path, std::vector<cv::Mat> &samples) {
+    samples.clear();
+    std::ifstream file(file_path, std::ios::binary | std::ios::ate);
+    if (!file) {
+        LOG(ERROR) << "Failed to open calibration file " << file_path << ".";
+        return false;
+    }
+    const auto file_size = size_t(file.tellg());
+    if (!file_size || file_size % kSampleSize) {
+        LOG(ERROR) << "Invalid size of calibration file " << file_path << ".";
+        return false;
+    }
+
+    file.seekg(0);
+    samples.resize(file_size / kSampleSize);
+    for (auto &sample: samples) {
+        sample.create(kSampleHeight, kSampleWidth, CV_8UC3);
+        file.read((char *) sample.data, (std::streamsize) kSampleSize);
+    }
+    if (!file) {
+        LOG(ERROR) << "Failed to read calibration file " << file_path << ".";
+        samples.clear();
+        return false;
+    }
+    return true;
+}
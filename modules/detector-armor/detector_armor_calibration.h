@@ -0,0 +1,54 @@
+/**
+ * Armor detector calibration data header.
+ * \author trantuan-20048607
+ * \date 2022.3.30
+ * \details Frames sampled from recorded videos, used to calibrate activation ranges of quantized models.
+ */
+
+#ifndef DETECTOR_ARMOR_CALIBRATION_H_
+#define DETECTOR_ARMOR_CALIBRATION_H_
+
+#include <string>
+#include <vector>
+#include <opencv2/core.hpp>
+
+/**
+ * \brief Calibration data of armor detector.
+ * \details A calibration file stores samples of model input size one by one, each as 8-bit RGB pixels in HWC layout
+ *   without any header, so the number of samples is file size divided by sample size.
+ *   It is saved beside ONNX model with extension "calib", the same as TensorRT engine cache.
+ */
+namespace calibration {
+    /**
+     * \brief Get calibration file path of a model.
+     * \param [in] onnx_file ONNX file path.
+     * \return Path with extension replaced by "calib".
+     */
+    std::string CalibrationFile(const std::string &onnx_file);
+
+    /**
+     * \brief Convert a BGR image to a calibration sample.
+     * \details Same as pre-processing of ArmorDetector before converting to float.
+     * \param [in] image Input BGR image.
+     * \param [out] sample 8-bit RGB image of model input size.
+     */
+    void ToSample(const cv::Mat &image, cv::Mat &sample);
+
+    /**
+     * \brief Save calibration samples.
+     * \param [in] file_path Calibration file path, overwritten.
+     * \param [in] samples 8-bit RGB images of model input size.
+     * \return Whether all samples are saved.
+     */
+    bool Save(const std::string &file_path, const std::vector<cv::Mat> &samples);
+
+    /**
+     * \brief Load calibration samples.
+     * \param [in] file_path Calibration file path.
+     * \param [out] samples 8-bit RGB images of model input size.
+     * \return Whether file is loaded with at least one sample.
+     */
+    bool Load(const std::string &file_path, std::vector<cv::Mat> &samples);
+}
+
+#endif  // DETECTOR_ARMOR_CALIBRATION_H_
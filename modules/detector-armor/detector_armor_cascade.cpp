@@ -0,0 +1,131 @@
+#include <algorithm>
+#include <chrono>
+#include <glog/logging.h>
+#include "detector_armor_cascade.h"
+
+bool ArmorCascade::Initialize(const std::string &config_file, int num_stripes) {
+    cv::FileStorage config;
+
+    // Open config file.
+    try {
+        config.open(config_file, cv::FileStorage::READ);
+    } catch (const std::exception &) {
+        LOG(ERROR) << "Failed to open armor cascade config file " << config_file << ".";
+        return false;
+    }
+    if (!config.isOpened()) {
+        LOG(ERROR) << "Failed to open armor cascade config file " << config_file << ".";
+        return false;
+    }
+
+    // Read config data.
+    int enabled = 0, skip_empty = 1;
+    std::string light_bar_config_file;
+    Policy policy;
+    try {
+        config["ENABLED"] >> enabled;
+        config["SKIP_EMPTY"] >> skip_empty;
+        config["ACCEPT_CONFIDENCE"] >> policy.accept_confidence;
+        config["ROI_SCALE"] >> policy.roi_scale;
+        config["MAX_ROI_RATIO"] >> policy.max_roi_ratio;
+        config["LIGHT_BAR_CONFIG"] >> light_bar_config_file;
+    } catch (const std::exception &) {
+        LOG(ERROR) << "Failed to load config of armor cascade.";
+        return false;
+    }
+    config.release();
+    policy.skip_empty = skip_empty != 0;
+
+    enabled_ = false;
+    policy_ = policy;
+    if (!enabled)
+        return true;
+    if (!light_bar_detector_.Initialize(light_bar_config_file, num_stripes)) {
+        LOG(ERROR) << "Failed to initialize light-bar detector of armor cascade.";
+        return false;
+    }
+    enabled_ = true;
+    return true;
+}
+
+bool ArmorCascade::Initialize(const Policy &policy, const LightBarDetector::Parameters &parameters,
+                              int num_stripes) {
+    enabled_ = false;
+    policy_ = policy;
+    if (!light_bar_detector_.Initialize(parameters, num_stripes))
+        return false;
+    enabled_ = true;
+    return true;
+}
+
+ArmorCascade::Decisions ArmorCascade::operator()(const ArmorDetector &detector, const Frame &frame,
+                                                 std::vector<bbox_t> &boxes) {
+    const auto start_time = std::chrono::steady_clock::now();
+    const auto frame_size = frame.IsRaw() ? frame.raw_image.size() : frame.image.size();
+    if (!enabled_) {
+        detector(frame, boxes);
+        return kFullFrame;
+    }
+
+    // The first stage.
+    light_bar_detector_(frame, boxes);
+    const auto proposal_end_time = std::chrono::steady_clock::now();
+
+    Decisions decision;
+    cv::Rect2f roi;
+    if (light_bar_detector_.LightBars().empty() && policy_.skip_empty)
+        decision = kRejected;
+    else if (!boxes.empty()
+             && std::all_of(boxes.begin(), boxes.end(),
+                            [this](const bbox_t &box) { return box.confidence >= policy_.accept_confidence; }))
+        decision = kAccepted;
+    else if (boxes.empty())
+        decision = kFullFrame;
+    else {
+        // Bounding box of all proposals, expanded around its center.
+        float min_x = boxes.front().points[0].x, max_x = min_x, min_y = boxes.front().points[0].y, max_y = min_y;
+        for (const auto &box: boxes)
+            for (const auto &point: box.points) {
+                min_x = std::min(min_x, point.x), max_x = std::max(max_x, point.x);
+                min_y = std::min(min_y, point.y), max_y = std::max(max_y, point.y);
+            }
+        const float width = (max_x - min_x) * policy_.roi_scale, height = (max_y - min_y) * policy_.roi_scale;
+        roi = {(min_x + max_x - width) / 2, (min_y + max_y - height) / 2, width, height};
+        const auto rect = ArmorDetector::FitRoi(frame_size, roi);
+        const bool small_roi = float(rect.area()) <= policy_.max_roi_ratio * float(frame_size.area());
+        decision = rect.size() != frame_size && small_roi ? kRoi : kFullFrame;
+    }
+
+    // The second stage.
+    if (decision == kRejected)
+        boxes.clear();
+    else if (decision == kRoi)
+        detector(frame, roi, boxes);
+    else if (decision == kFullFrame)
+        detector(frame, boxes);
+
+    const auto end_time = std::chrono::steady_clock::now();
+    ++statistics_.frames;
+    ++statistics_.decisions[decision];
+    statistics_.average_proposal_time += std::chrono::duration<double, std::milli>(
+            proposal_end_time - start_time).count();
+    statistics_.average_detection_time += std::chrono::duration<double, std::milli>(
+            end_time - proposal_end_time).count();
+    statistics_.average_time += std::chrono::duration<double, std::milli>(end_time - start_time).count();
+    return decision;
+}
+
+ArmorCascade::Statistics ArmorCascade::GetStatistics() const {
+    auto statistics = statistics_;
+    if (statistics.frames) {
+        statistics.average_proposal_time /= double(statistics.frames);
+        statistics.average_detection_time /= double(statistics.frames);
+        statistics.average_time /= double(statistics.frames);
+    }
+    return statistics;
+}
+
+const char *ArmorCascade::DecisionName(Decisions decision) {
+    static const char *kNames[SIZE] = {"rejected", "accepted", "roi", "full frame"};
+    return decision >= 0 && decision < SIZE ? kNames[decision] : "unknown";
+}
@@ -0,0 +1,104 @@
+/**
+ * Two-stage armor detector cascade header.
+ * \author trantuan-20048607
+ * \date 2022.3.30
+ * \details Screen frames by light-bar proposals on CPU, and run the neural network only when it is needed.
+ */
+
+#ifndef DETECTOR_ARMOR_CASCADE_H_
+#define DETECTOR_ARMOR_CASCADE_H_
+
+#include <string>
+#include <vector>
+#include <opencv2/core.hpp>
+#include "data-structure/bbox_t.h"
+#include "data-structure/frame.h"
+#include "lang-feature-extension/attr_reader.h"
+#include "lang-feature-extension/disable_constructor.h"
+#include "detector_armor.h"
+#include "detector_armor_light_bar.h"
+
+/**
+ * \brief Cascade of light-bar detector and armor detector.
+ * \details Each frame is screened by light-bar detector first, then one of these decisions is made:  \n
+ *   (1) Rejected: no light bar is found and skip_empty is set, output no box.  \n
+ *   (2) Accepted: all proposals are at least accept_confidence, output proposals directly.  \n
+ *   (3) ROI: armor detector runs in the region around all proposals, expanded by roi_scale,
+ *   when it is no larger than max_roi_ratio of frame.  \n
+ *   (4) Full frame: armor detector runs in the whole frame, for unpaired light bars or spread proposals.
+ * \attention Statistics are not thread safe, use it in a single pipeline stage.
+ */
+class ArmorCascade : NO_COPY, NO_MOVE {
+public:
+    /// Decisions of the first stage.
+    enum Decisions {
+        kRejected = 0,
+        kAccepted = 1,
+        kRoi = 2,
+        kFullFrame = 3,
+        SIZE [[maybe_unused]] = 4
+    };
+
+    /// \brief Cascade policy.
+    struct Policy {
+        bool skip_empty = true;       ///< Output no box without running armor detector when no light bar is found.
+        float accept_confidence = 2;  ///< Min confidence of proposals to skip armor detector, above 1 to never skip.
+        float roi_scale = 3;          ///< ROI size relative to bounding box of proposals.
+        float max_roi_ratio = 0.5;    ///< Max ROI area relative to frame, larger ones run in full frame.
+    };
+
+    /// \brief Statistics of cascade.
+    struct Statistics {
+        uint64_t frames;                ///< Number of screened frames.
+        uint64_t decisions[SIZE];       ///< Number of frames of each decision.
+        double average_proposal_time;   ///< Average time of light-bar detector in milliseconds.
+        double average_detection_time;  ///< Average time of armor detector in milliseconds, over all frames.
+        double average_time;            ///< Average total time in milliseconds.
+    };
+
+    ArmorCascade() : enabled_(false), policy_(), statistics_() {}
+
+    /**
+     * \brief Load policy and light-bar detector from config file.
+     * \param [in] config_file Config file path.
+     * \param [in] num_stripes Number of image stripes of light-bar detector, 0 to use OpenCV threads.
+     * \return Whether config is loaded. Cascade is enabled only when "ENABLED" is not 0.
+     */
+    bool Initialize(const std::string &config_file, int num_stripes = 0);
+
+    /**
+     * \brief Set policy and light-bar detector parameters directly and enable cascade, for benchmarks.
+     * \param [in] policy Cascade policy.
+     * \param [in] parameters Parameters of light-bar detector.
+     * \param [in] num_stripes Number of image stripes of light-bar detector, 0 to use OpenCV threads.
+     * \return Whether light-bar detector is ready.
+     */
+    bool Initialize(const Policy &policy, const LightBarDetector::Parameters &parameters, int num_stripes = 0);
+
+    ATTR_READER(enabled_, Enabled)
+
+    ATTR_READER_REF(policy_, GetPolicy)
+
+    /**
+     * \brief Detect armors in a frame with cascade.
+     * \param [in] detector Armor detector of the second stage.
+     * \param [in] frame Input frame.
+     * \param [out] boxes 4-point structures in frame coordinate, cleared before writing.
+     * \return Decision of the first stage.
+     */
+    Decisions operator()(const ArmorDetector &detector, const Frame &frame, std::vector<bbox_t> &boxes);
+
+    /// \return Statistics of screened frames.
+    [[nodiscard]] Statistics GetStatistics() const;
+
+    /// \return Name of a decision, for reports.
+    static const char *DecisionName(Decisions decision);
+
+private:
+    bool enabled_;                         ///< Whether cascade is enabled.
+    Policy policy_;                        ///< Cascade policy.
+    LightBarDetector light_bar_detector_;  ///< Detector of the first stage.
+    Statistics statistics_;                ///< Statistics, with total times in average fields.
+};
+
+#endif  // DETECTOR_ARMOR_CASCADE_H_
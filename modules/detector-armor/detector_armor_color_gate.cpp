@@ -0,0 +1,189 @@
+#include <algorithm>
+#include <chrono>
+#include <opencv2/core.hpp>
+#include <glog/logging.h>
+#include "math-tools/hardware_acceleration.h"
+#include "detector_armor_color_gate.h"
+
+namespace {
+    /// \brief Count light-bar pixels of a color pair with 8-bit scalar values.
+    inline void CountPixel(int blue, int red, int difference, int brightness, uint64_t counts[2]) {
+        counts[0] += blue > brightness && blue - red > difference;
+        counts[1] += red > brightness && red - blue > difference;
+    }
+
+#if defined(USE_SSE2)
+
+    /// \brief Mask of bytes of x > threshold, in unsigned 8 bits.
+    inline __m128i GreaterX16(__m128i x, __m128i threshold) {
+        return _mm_xor_si128(_mm_cmpeq_epi8(_mm_subs_epu8(x, threshold), _mm_setzero_si128()),
+                             _mm_set1_epi8(-1));
+    }
+
+    /// \brief Add light-bar pixels of 16 color pairs, only lanes with 1 in lane_mask are counted.
+    inline void CountX16(__m128i blue, __m128i red, __m128i difference, __m128i brightness, __m128i lane_mask,
+                         __m128i &blue_sum, __m128i &red_sum) {
+        const __m128i blue_pass = _mm_and_si128(GreaterX16(_mm_subs_epu8(blue, red), difference),
+                                                GreaterX16(blue, brightness));
+        const __m128i red_pass = _mm_and_si128(GreaterX16(_mm_subs_epu8(red, blue), difference),
+                                               GreaterX16(red, brightness));
+        blue_sum = _mm_add_epi64(blue_sum, _mm_sad_epu8(_mm_and_si128(blue_pass, lane_mask), _mm_setzero_si128()));
+        red_sum = _mm_add_epi64(red_sum, _mm_sad_epu8(_mm_and_si128(red_pass, lane_mask), _mm_setzero_si128()));
+    }
+
+    inline uint64_t HorizontalSum(__m128i sum) {
+        uint64_t lanes[2];
+        _mm_storeu_si128((__m128i *) lanes, sum);
+        return lanes[0] + lanes[1];
+    }
+
+#endif
+
+    /// \brief Count light-bar pixels in a BGR row.
+    void CountBGRRow(const uint8_t *row, int width, int difference, int brightness, uint64_t counts[2]) {
+        const int n = 3 * width;
+        int i = 0;
+#if defined(USE_SSE2)
+        // Blue at the first byte of each pixel and red 2 bytes later, so 2 overlapped loads align them.
+        // Pixels start at different lanes in 3 chunks of a 48-byte group.
+        uint8_t pixel_starts[48] = {};
+        for (int j = 0; j < 48; j += 3)
+            pixel_starts[j] = 1;
+        const __m128i lane_masks[3] = {_mm_loadu_si128((const __m128i *) pixel_starts),
+                                       _mm_loadu_si128((const __m128i *) (pixel_starts + 16)),
+                                       _mm_loadu_si128((const __m128i *) (pixel_starts + 32))};
+        const __m128i difference_x16 = _mm_set1_epi8(char(difference));
+        const __m128i brightness_x16 = _mm_set1_epi8(char(brightness));
+        __m128i blue_sum = _mm_setzero_si128(), red_sum = _mm_setzero_si128();
+        for (; i + 50 <= n; i += 48)
+            for (int j = 0; j < 3; ++j)
+                CountX16(_mm_loadu_si128((const __m128i *) (row + i + 16 * j)),
+                         _mm_loadu_si128((const __m128i *) (row + i + 16 * j + 2)),
+                         difference_x16, brightness_x16, lane_masks[j], blue_sum, red_sum);
+        counts[0] += HorizontalSum(blue_sum);
+        counts[1] += HorizontalSum(red_sum);
+#endif
+        for (; i < n; i += 3)
+            CountPixel(row[i], row[i + 2], difference, brightness, counts);
+    }
+
+    /// \brief Count light-bar cells of Bayer rows, with red and blue pixels of each cell in even columns.
+    template<typename T>
+    void CountBayerRows(const T *red_row, const T *blue_row, int num_cells, int shift,
+                        int difference, int brightness, uint64_t counts[2]) {
+        int k = 0;
+#if defined(USE_SSE2)
+        if constexpr (sizeof(T) == 1) {
+            const __m128i lane_mask = _mm_set1_epi16(1);  // Lanes of even bytes.
+            const __m128i difference_x16 = _mm_set1_epi8(char(difference));
+            const __m128i brightness_x16 = _mm_set1_epi8(char(brightness));
+            __m128i blue_sum = _mm_setzero_si128(), red_sum = _mm_setzero_si128();
+            for (; k + 8 < num_cells; k += 8)
+                CountX16(_mm_loadu_si128((const __m128i *) (blue_row + 2 * k)),
+                         _mm_loadu_si128((const __m128i *) (red_row + 2 * k)),
+                         difference_x16, brightness_x16, lane_mask, blue_sum, red_sum);
+            counts[0] += HorizontalSum(blue_sum);
+            counts[1] += HorizontalSum(red_sum);
+        }
+#endif
+        for (; k < num_cells; ++k)
+            CountPixel(std::min(blue_row[2 * k] >> shift, 255), std::min(red_row[2 * k] >> shift, 255),
+                       difference, brightness, counts);
+    }
+}
+
+bool ColorGate::Initialize(const std::string &config_file) {
+    cv::FileStorage config;
+
+    // Open config file.
+    try {
+        config.open(config_file, cv::FileStorage::READ);
+    } catch (const std::exception &) {
+        LOG(ERROR) << "Failed to open color gate config file " << config_file << ".";
+        return false;
+    }
+    if (!config.isOpened()) {
+        LOG(ERROR) << "Failed to open color gate config file " << config_file << ".";
+        return false;
+    }
+
+    // Read config data.
+    Thresholds thresholds;
+    try {
+        config["COLOR"] >> thresholds.color;
+        config["DIFFERENCE_THRESH"] >> thresholds.difference_threshold;
+        config["BRIGHTNESS_THRESH"] >> thresholds.brightness_threshold;
+        config["MIN_PIXELS"] >> thresholds.min_pixels;
+        config["ROW_STEP"] >> thresholds.row_step;
+    } catch (const std::exception &) {
+        LOG(ERROR) << "Failed to load config of color gate.";
+        return false;
+    }
+    config.release();
+
+    Initialize(thresholds);
+    return true;
+}
+
+void ColorGate::Initialize(const Thresholds &thresholds) {
+    thresholds_ = thresholds;
+    thresholds_.difference_threshold = std::clamp(thresholds_.difference_threshold, 0, 255);
+    thresholds_.brightness_threshold = std::clamp(thresholds_.brightness_threshold, 0, 255);
+    thresholds_.row_step = std::max(thresholds_.row_step, 1);
+    enabled_ = true;
+}
+
+void ColorGate::Count(const Frame &frame, uint64_t counts[2]) const {
+    counts[0] = counts[1] = 0;
+    const int difference = thresholds_.difference_threshold, brightness = thresholds_.brightness_threshold;
+
+    if (!frame.IsRaw()) {
+        if (frame.image.type() != CV_8UC3)
+            return;
+        for (int y = 0; y < frame.image.rows; y += thresholds_.row_step)
+            CountBGRRow(frame.image.ptr<uint8_t>(y), frame.image.cols, difference, brightness, counts);
+        return;
+    }
+
+    // (row, col) of red pixel in a 2x2 cell in order of demosaic::BayerPattern, blue pixel is at the opposite corner.
+    static const int kRedPositions[4][2] = {{0, 0}, {0, 1}, {1, 0}, {1, 1}};
+    const auto &raw = frame.raw_image;
+    const auto *red = kRedPositions[frame.bayer_pattern & 3], *blue = kRedPositions[3 - (frame.bayer_pattern & 3)];
+    const int shift = std::max(frame.raw_bits - 8, 0), num_cells = raw.cols / 2;
+    const int row_step = (thresholds_.row_step + 1) & ~1;
+    for (int y = 0; y + 1 < raw.rows; y += row_step) {
+        if (raw.type() == CV_8UC1)
+            CountBayerRows(raw.ptr<uint8_t>(y + red[0]) + red[1], raw.ptr<uint8_t>(y + blue[0]) + blue[1],
+                           num_cells, 0, difference, brightness, counts);
+        else if (raw.type() == CV_16UC1)
+            CountBayerRows(raw.ptr<uint16_t>(y + red[0]) + red[1], raw.ptr<uint16_t>(y + blue[0]) + blue[1],
+                           num_cells, shift, difference, brightness, counts);
+    }
+    counts[0] *= 2, counts[1] *= 2;
+}
+
+bool ColorGate::operator()(const Frame &frame) {
+    if (!enabled_)
+        return true;
+
+    const auto start_time = std::chrono::steady_clock::now();
+    uint64_t counts[2];
+    Count(frame, counts);
+    const auto min_pixels = uint64_t(std::max(thresholds_.min_pixels, 0));
+    const bool passed = thresholds_.color == 0 || thresholds_.color == 1
+                        ? counts[thresholds_.color] >= min_pixels
+                        : counts[0] >= min_pixels || counts[1] >= min_pixels;
+
+    ++statistics_.frames;
+    statistics_.rejected += !passed;
+    statistics_.average_time += std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start_time).count();
+    return passed;
+}
+
+ColorGate::Statistics ColorGate::GetStatistics() const {
+    auto statistics = statistics_;
+    if (statistics.frames)
+        statistics.average_time /= double(statistics.frames);
+    return statistics;
+}
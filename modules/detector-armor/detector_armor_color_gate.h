@@ -0,0 +1,88 @@
+/**
+ * Armor color gate header.
+ * \author trantuan-20048607
+ * \date 2022.3.30
+ * \details Cheap pre-filter of armor detector, finding light-bar colored pixels in sampled rows of a frame,
+ *   so that frames without any enemy light bar skip inference.
+ */
+
+#ifndef DETECTOR_ARMOR_COLOR_GATE_H_
+#define DETECTOR_ARMOR_COLOR_GATE_H_
+
+#include <string>
+#include "data-structure/frame.h"
+#include "lang-feature-extension/attr_reader.h"
+#include "lang-feature-extension/disable_constructor.h"
+
+/**
+ * \brief Color presence gate of armor detector.
+ * \details A pixel is counted as a light-bar pixel of a color when its channel of this color is brighter than
+ *   brightness threshold, and exceeds the opposite channel by difference threshold.
+ *   Only one of every row_step rows is checked, with SSE2 (or NEON on arm).
+ *   Raw frames are checked by 2x2 Bayer cells without demosaicing, each cell counts as 2 pixels.  \n
+ *   A frame passes when light-bar pixels of the gated color are no fewer than min_pixels.
+ * \attention Statistics are not thread safe, use it in a single pipeline stage.
+ */
+class ColorGate : NO_COPY, NO_MOVE {
+public:
+    static constexpr int kAnyColor = -1;  ///< Gate on both blue and red light bars.
+
+    /// \brief Thresholds of color gate.
+    struct Thresholds {
+        int color = kAnyColor;           ///< Gated color in bbox_t order, 0 for blue and 1 for red, or kAnyColor.
+        int difference_threshold = 60;   ///< Min difference between light-bar channel and opposite channel.
+        int brightness_threshold = 120;  ///< Min value of light-bar channel.
+        int min_pixels = 4;              ///< Min number of light-bar pixels in sampled rows.
+        int row_step = 4;                ///< Check one of every row_step rows.
+    };
+
+    /// \brief Statistics of checked frames.
+    struct Statistics {
+        uint64_t frames;      ///< Number of checked frames.
+        uint64_t rejected;    ///< Number of frames without enough light-bar pixels.
+        double average_time;  ///< Average checking time in milliseconds.
+    };
+
+    ColorGate() : enabled_(false), thresholds_(), statistics_() {}
+
+    /**
+     * \brief Load thresholds from config file and enable this gate.
+     * \param [in] config_file Config file path.
+     * \return Whether config is loaded.
+     */
+    bool Initialize(const std::string &config_file);
+
+    /**
+     * \brief Set thresholds directly and enable this gate, for benchmarks.
+     * \param [in] thresholds Thresholds of gate.
+     */
+    void Initialize(const Thresholds &thresholds);
+
+    ATTR_READER(enabled_, Enabled)
+
+    ATTR_READER_REF(thresholds_, GetThresholds)
+
+    /**
+     * \brief Count light-bar pixels in sampled rows of a frame.
+     * \param [in] frame Input frame, BGR or raw.
+     * \param [out] counts Number of blue and red light-bar pixels.
+     */
+    void Count(const Frame &frame, uint64_t counts[2]) const;
+
+    /**
+     * \brief Check whether a frame may contain light bars of gated color.
+     * \param [in] frame Input frame.
+     * \return Whether armor detection should run on this frame, always true when gate is disabled.
+     */
+    bool operator()(const Frame &frame);
+
+    /// \return Statistics of checked frames.
+    [[nodiscard]] Statistics GetStatistics() const;
+
+private:
+    bool enabled_;            ///< Whether this gate is enabled.
+    Thresholds thresholds_;   ///< Thresholds of gate.
+    Statistics statistics_;   ///< Statistics, with total time in average_time.
+};
+
+#endif  // DETECTOR_ARMOR_COLOR_GATE_H_
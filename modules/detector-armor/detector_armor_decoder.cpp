@@ -0,0 +1,270 @@
+#include <algorithm>
+#include <cmath>
+#include "math-tools/hardware_acceleration.h"
+#include "detector_armor_decoder.h"
+
+namespace {
+    constexpr int kConfidenceIndex = 8;  ///< Index of confidence in a box.
+    constexpr int kColorIndex = 9;       ///< Index of the first color score in a box.
+    constexpr int kNumColors = 4;
+    constexpr int kIdIndex = 13;         ///< Index of the first id score in a box.
+    constexpr int kNumIds = 7;
+
+    /// \brief Max vertices of intersection of 2 quadrilaterals, with some space for numerical errors.
+    constexpr int kMaxPolygonSize = 16;
+
+    inline float Cross(const cv::Point2f &o, const cv::Point2f &a, const cv::Point2f &b) {
+        return (a.x - o.x) * (b.y - o.y) - (a.y - o.y) * (b.x - o.x);
+    }
+
+    /// \return Signed area of a polygon, positive when vertices are counterclockwise in y-up coordinate.
+    inline float SignedArea(const cv::Point2f *polygon, int size) {
+        float area = 0;
+        for (int i = 0, j = size - 1; i < size; j = i++)
+            area += polygon[j].x * polygon[i].y - polygon[i].x * polygon[j].y;
+        return 0.5f * area;
+    }
+
+    /**
+     * \brief Calculate intersection area of 2 convex quadrilaterals with Sutherland-Hodgman clipping.
+     * \param [in] a Subject quadrilateral.
+     * \param [in] b Clip quadrilateral.
+     * \return Intersection area.
+     */
+    float QuadIntersectionArea(const cv::Point2f a[4], const cv::Point2f b[4]) {
+        const float orientation = SignedArea(b, 4);
+        if (orientation == 0)
+            return 0;
+        const float sign = orientation > 0 ? 1.f : -1.f;
+
+        cv::Point2f buffers[2][kMaxPolygonSize];
+        cv::Point2f *polygon = buffers[0], *clipped = buffers[1];
+        std::copy(a, a + 4, polygon);
+        int size = 4;
+
+        float sides[kMaxPolygonSize];
+        for (int edge = 0; edge < 4 && size > 0; ++edge) {
+            const auto &p = b[edge], &q = b[(edge + 1) & 3];
+            for (int i = 0; i < size; ++i)
+                sides[i] = sign * Cross(p, q, polygon[i]);
+
+            // Walk edges from the last vertex, keep inside vertices and add crossing points.
+            int clipped_size = 0;
+            for (int i = 0, last = size - 1; i < size && clipped_size + 2 <= kMaxPolygonSize; last = i++) {
+                const bool inside = sides[i] >= 0, last_inside = sides[last] >= 0;
+                if (inside != last_inside) {
+                    const float t = sides[last] / (sides[last] - sides[i]);
+                    clipped[clipped_size++] = polygon[last] + t * (polygon[i] - polygon[last]);
+                }
+                if (inside)
+                    clipped[clipped_size++] = polygon[i];
+            }
+            std::swap(polygon, clipped);
+            size = clipped_size;
+        }
+        return size < 3 ? 0 : std::fabs(SignedArea(polygon, size));
+    }
+
+    inline float Sigmoid(float x) { return 1 / (1 + std::exp(-x)); }
+
+    inline int ArgMax(const float *ptr, int len) {
+        int arg_max = 0;
+        for (int i = 1; i < len; ++i)
+            if (ptr[i] > ptr[arg_max])
+                arg_max = i;
+        return arg_max;
+    }
+
+#if defined(USE_SSE2)
+
+    /// \brief Argmax of len fields, 4 boxes at a time. The first one wins in ties, the same as ArgMax.
+    inline __m128i ArgMaxX4(const __m128 *fields, int len) {
+        __m128 max_value = fields[0];
+        __m128i arg_max = _mm_setzero_si128();
+        for (int i = 1; i < len; ++i) {
+            const __m128 greater = _mm_cmpgt_ps(fields[i], max_value);
+            const __m128i greater_i = _mm_castps_si128(greater);
+            max_value = _mm_or_ps(_mm_and_ps(greater, fields[i]), _mm_andnot_ps(greater, max_value));
+            arg_max = _mm_or_si128(_mm_and_si128(greater_i, _mm_set1_epi32(i)),
+                                   _mm_andnot_si128(greater_i, arg_max));
+        }
+        return arg_max;
+    }
+
+#endif
+}
+
+ArmorDecoder::ArmorDecoder(float keep_threshold, float iou_threshold) :
+        keep_threshold_(keep_threshold),
+        raw_keep_threshold_(-std::log(1 / keep_threshold - 1)),
+        iou_threshold_(iou_threshold),
+        x_(),
+        y_(),
+        confidence_(),
+        min_x_(),
+        max_x_(),
+        min_y_(),
+        max_y_(),
+        area_(),
+        color_(),
+        id_(),
+        removed_() {
+    static_assert(kTopkNum % 4 == 0, "Number of boxes must be a multiple of 4.");
+}
+
+int ArmorDecoder::DecodeScalar(const float *output_topk, float fx, float fy, int begin, int end) {
+    for (int i = begin; i < end; ++i) {
+        const float *box = output_topk + i * kBoxSize;
+        if (!(box[kConfidenceIndex] >= raw_keep_threshold_))
+            return i - begin;
+
+        cv::Point2f points[4];
+        for (int k = 0; k < 4; ++k) {
+            x_[k][i] = points[k].x = box[2 * k] * fx;
+            y_[k][i] = points[k].y = box[2 * k + 1] * fy;
+        }
+        min_x_[i] = std::min({x_[0][i], x_[1][i], x_[2][i], x_[3][i]});
+        max_x_[i] = std::max({x_[0][i], x_[1][i], x_[2][i], x_[3][i]});
+        min_y_[i] = std::min({y_[0][i], y_[1][i], y_[2][i], y_[3][i]});
+        max_y_[i] = std::max({y_[0][i], y_[1][i], y_[2][i], y_[3][i]});
+        area_[i] = std::fabs(SignedArea(points, 4));
+        confidence_[i] = Sigmoid(box[kConfidenceIndex]);
+        color_[i] = ArgMax(box + kColorIndex, kNumColors);
+        id_[i] = ArgMax(box + kIdIndex, kNumIds);
+    }
+    return end - begin;
+}
+
+int ArmorDecoder::DecodeX4(const float *output_topk, float fx, float fy, int begin) {
+#if defined(USE_SSE2)
+    // Transpose 4 boxes into 20 fields of 4 lanes.
+    const float *box = output_topk + begin * kBoxSize;
+    __m128 fields[kBoxSize];
+    for (int group = 0; group < kBoxSize / 4; ++group) {
+        __m128 row_0 = _mm_loadu_ps(box + group * 4);
+        __m128 row_1 = _mm_loadu_ps(box + kBoxSize + group * 4);
+        __m128 row_2 = _mm_loadu_ps(box + 2 * kBoxSize + group * 4);
+        __m128 row_3 = _mm_loadu_ps(box + 3 * kBoxSize + group * 4);
+        _MM_TRANSPOSE4_PS(row_0, row_1, row_2, row_3);
+        fields[group * 4] = row_0;
+        fields[group * 4 + 1] = row_1;
+        fields[group * 4 + 2] = row_2;
+        fields[group * 4 + 3] = row_3;
+    }
+
+    // Boxes are sorted, so kept ones are always before others.
+    const int mask = _mm_movemask_ps(_mm_cmpge_ps(fields[kConfidenceIndex], _mm_set1_ps(raw_keep_threshold_)));
+    int num_kept = 0;
+    while (num_kept < 4 && (mask >> num_kept & 1))
+        ++num_kept;
+    if (!num_kept)
+        return 0;
+
+    const __m128 scale_x = _mm_set1_ps(fx), scale_y = _mm_set1_ps(fy);
+    __m128 x[4], y[4];
+    for (int k = 0; k < 4; ++k) {
+        x[k] = _mm_mul_ps(fields[2 * k], scale_x);
+        y[k] = _mm_mul_ps(fields[2 * k + 1], scale_y);
+        _mm_store_ps(x_[k] + begin, x[k]);
+        _mm_store_ps(y_[k] + begin, y[k]);
+    }
+    _mm_store_ps(min_x_ + begin, _mm_min_ps(_mm_min_ps(x[0], x[1]), _mm_min_ps(x[2], x[3])));
+    _mm_store_ps(max_x_ + begin, _mm_max_ps(_mm_max_ps(x[0], x[1]), _mm_max_ps(x[2], x[3])));
+    _mm_store_ps(min_y_ + begin, _mm_min_ps(_mm_min_ps(y[0], y[1]), _mm_min_ps(y[2], y[3])));
+    _mm_store_ps(max_y_ + begin, _mm_max_ps(_mm_max_ps(y[0], y[1]), _mm_max_ps(y[2], y[3])));
+
+    // Shoelace formula.
+    __m128 area = _mm_setzero_ps();
+    for (int k = 0; k < 4; ++k)
+        area = _mm_add_ps(area, _mm_sub_ps(_mm_mul_ps(x[k], y[(k + 1) & 3]), _mm_mul_ps(x[(k + 1) & 3], y[k])));
+    area = _mm_andnot_ps(_mm_set1_ps(-0.f), _mm_mul_ps(area, _mm_set1_ps(0.5f)));
+    _mm_store_ps(area_ + begin, area);
+
+    const __m128 one = _mm_set1_ps(1.f);
+    _mm_store_ps(confidence_ + begin,
+                 _mm_div_ps(one, _mm_add_ps(one, exp_ps(_mm_sub_ps(_mm_setzero_ps(), fields[kConfidenceIndex])))));
+    _mm_store_si128((__m128i *) (color_ + begin), ArgMaxX4(fields + kColorIndex, kNumColors));
+    _mm_store_si128((__m128i *) (id_ + begin), ArgMaxX4(fields + kIdIndex, kNumIds));
+    return num_kept;
+#else
+    return DecodeScalar(output_topk, fx, fy, begin, begin + 4);
+#endif
+}
+
+bool ArmorDecoder::Suppress(int i, int j) const {
+    // IoU can not exceed threshold when the intersection of bounding boxes is small enough.
+    if (iou_threshold_ > 0) {
+        const float bound = std::min({(std::min(max_x_[i], max_x_[j]) - std::max(min_x_[i], min_x_[j]))
+                                      * (std::min(max_y_[i], max_y_[j]) - std::max(min_y_[i], min_y_[j])),
+                                      area_[i], area_[j]});
+        if (bound <= iou_threshold_ * (area_[i] + area_[j] - bound))
+            return false;
+    }
+
+    const cv::Point2f a[4] = {{x_[0][i], y_[0][i]}, {x_[1][i], y_[1][i]},
+                              {x_[2][i], y_[2][i]}, {x_[3][i], y_[3][i]}};
+    const cv::Point2f b[4] = {{x_[0][j], y_[0][j]}, {x_[1][j], y_[1][j]},
+                              {x_[2][j], y_[2][j]}, {x_[3][j], y_[3][j]}};
+    const float intersection = QuadIntersectionArea(a, b);
+    if (iou_threshold_ <= 0)
+        return intersection > 0;
+    const float union_area = area_[i] + area_[j] - intersection;
+    return union_area > 0 && intersection > iou_threshold_ * union_area;
+}
+
+void ArmorDecoder::Decode(const float *output_topk, float fx, float fy, std::vector<bbox_t> &boxes) {
+    boxes.clear();
+
+    int num_boxes = 0;
+    while (num_boxes < kTopkNum) {
+        const int num_kept = DecodeX4(output_topk, fx, fy, num_boxes);
+        num_boxes += num_kept;
+        if (num_kept < 4)
+            break;
+    }
+
+    std::fill(removed_, removed_ + num_boxes, false);
+    for (int i = 0; i < num_boxes; ++i) {
+        if (removed_[i])
+            continue;
+
+        boxes.emplace_back();
+        auto &box = boxes.back();
+        for (int k = 0; k < 4; ++k)
+            box.points[k] = {x_[k][i], y_[k][i]};
+        box.confidence = confidence_[i];
+        box.color = color_[i];
+        box.id = id_[i];
+
+        // Reject boxes whose bounding boxes do not overlap before calculating IoU.
+        int j = i + 1;
+#if defined(USE_SSE2)
+        const __m128 min_x = _mm_set1_ps(min_x_[i]), max_x = _mm_set1_ps(max_x_[i]);
+        const __m128 min_y = _mm_set1_ps(min_y_[i]), max_y = _mm_set1_ps(max_y_[i]);
+        for (; j + 4 <= num_boxes; j += 4) {
+            const __m128 overlap = _mm_and_ps(
+                    _mm_and_ps(_mm_cmplt_ps(_mm_loadu_ps(min_x_ + j), max_x),
+                               _mm_cmpgt_ps(_mm_loadu_ps(max_x_ + j), min_x)),
+                    _mm_and_ps(_mm_cmplt_ps(_mm_loadu_ps(min_y_ + j), max_y),
+                               _mm_cmpgt_ps(_mm_loadu_ps(max_y_ + j), min_y)));
+            for (int mask = _mm_movemask_ps(overlap); mask; mask &= mask - 1) {
+                const int lane = j + __builtin_ctz(mask);
+                if (!removed_[lane] && Suppress(i, lane))
+                    removed_[lane] = true;
+            }
+        }
+#endif
+        for (; j < num_boxes; ++j)
+            if (!removed_[j]
+                && min_x_[j] < max_x_[i] && max_x_[j] > min_x_[i]
+                && min_y_[j] < max_y_[i] && max_y_[j] > min_y_[i]
+                && Suppress(i, j))
+                removed_[j] = true;
+    }
+}
+
+float ArmorDecoder::QuadIoU(const cv::Point2f a[4], const cv::Point2f b[4]) {
+    const float intersection = QuadIntersectionArea(a, b);
+    const float union_area = std::fabs(SignedArea(a, 4)) + std::fabs(SignedArea(b, 4)) - intersection;
+    return union_area > 0 ? intersection / union_area : 0;
+}
@@ -0,0 +1,89 @@
+/**
+ * Armor detector output decoder header.
+ * \author trantuan-20048607
+ * \date 2022.3.28
+ * \details Decode "output-topk" layout of armor detector backends and remove duplicated boxes.
+ */
+
+#ifndef DETECTOR_ARMOR_DECODER_H_
+#define DETECTOR_ARMOR_DECODER_H_
+
+#include <vector>
+#include "data-structure/bbox_t.h"
+#include "lang-feature-extension/attr_reader.h"
+#include "lang-feature-extension/disable_constructor.h"
+
+/**
+ * \brief Structure-of-arrays decoder with quadrilateral IoU NMS.
+ * \details Boxes are transposed into arrays of fields, then thresholded, scaled, activated by sigmoid
+ *   and classified by argmax 4 boxes at a time with SSE2 (or NEON on arm).  \n
+ *   NMS suppresses a box when its IoU with a kept box is larger than threshold,
+ *   where IoU is computed on quadrilaterals and axis-aligned bounding boxes are used for early rejection.
+ * \attention Input boxes must be in descending order of confidence, which is how top-k layers output them.
+ */
+class ArmorDecoder : NO_COPY, NO_MOVE {
+public:
+    static constexpr int kTopkNum = 128;                  ///< Number of input boxes.
+    static constexpr int kBoxSize = 20;                   ///< Floats of a box.
+    static constexpr float kDefaultKeepThreshold = 0.1f;  ///< Min confidence after sigmoid.
+    static constexpr float kDefaultIouThreshold = 0.45f;  ///< Max IoU with kept boxes.
+
+    /**
+     * \param [in] keep_threshold Min confidence of boxes, after sigmoid.
+     * \param [in] iou_threshold Max IoU between kept boxes, 0 to suppress any overlapped boxes.
+     */
+    explicit ArmorDecoder(float keep_threshold = kDefaultKeepThreshold,
+                          float iou_threshold = kDefaultIouThreshold);
+
+    ATTR_READER(keep_threshold_, KeepThreshold)
+
+    ATTR_READER(iou_threshold_, IouThreshold)
+
+    inline void SetIouThreshold(float iou_threshold) { iou_threshold_ = iou_threshold; }
+
+    /**
+     * \brief Decode boxes and remove duplicated ones.
+     * \param [in] output_topk kTopkNum boxes of kBoxSize floats, in descending order of confidence.
+     * \param [in] fx Horizontal scale from model input to source image.
+     * \param [in] fy Vertical scale from model input to source image.
+     * \param [out] boxes Output boxes, cleared before writing. Its capacity is reused between calls.
+     */
+    void Decode(const float *output_topk, float fx, float fy, std::vector<bbox_t> &boxes);
+
+    /**
+     * \brief Calculate IoU of 2 convex quadrilaterals.
+     * \param [in] a Vertices of the first quadrilateral, in clockwise or counterclockwise order.
+     * \param [in] b Vertices of the second quadrilateral.
+     * \return Intersection over union.
+     */
+    static float QuadIoU(const cv::Point2f a[4], const cv::Point2f b[4]);
+
+private:
+    /// \brief Decode boxes in [begin, end) without SIMD, return number of boxes above threshold.
+    int DecodeScalar(const float *output_topk, float fx, float fy, int begin, int end);
+
+    /// \brief Decode 4 boxes from begin with SIMD, return number of boxes above threshold.
+    int DecodeX4(const float *output_topk, float fx, float fy, int begin);
+
+    /// \brief Whether to suppress box j by box i.
+    bool Suppress(int i, int j) const;
+
+    float keep_threshold_;      ///< Min confidence after sigmoid.
+    float raw_keep_threshold_;  ///< Min confidence before sigmoid.
+    float iou_threshold_;       ///< Max IoU between kept boxes.
+
+    // Decoded fields, in structure-of-arrays layout.
+    alignas(16) float x_[4][kTopkNum];
+    alignas(16) float y_[4][kTopkNum];
+    alignas(16) float confidence_[kTopkNum];
+    alignas(16) float min_x_[kTopkNum];
+    alignas(16) float max_x_[kTopkNum];
+    alignas(16) float min_y_[kTopkNum];
+    alignas(16) float max_y_[kTopkNum];
+    alignas(16) float area_[kTopkNum];
+    alignas(16) int color_[kTopkNum];
+    alignas(16) int id_[kTopkNum];
+    bool removed_[kTopkNum];
+};
+
+#endif  // DETECTOR_ARMOR_DECODER_H_
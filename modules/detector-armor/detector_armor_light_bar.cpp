@@ -0,0 +1,316 @@
+#include <algorithm>
+#include <cmath>
+#include <opencv2/imgproc.hpp>
+#include <glog/logging.h>
+#include "image-processing/demosaic.h"
+#include "detector_armor_light_bar.h"
+
+/// Min distance ratio of large armors, whose numbers are wider and which are solved with large armor size.
+constexpr float kLargeArmorDistanceRatio = 3.2f;
+
+/// Rows of light-bar end points in number patch before cropping.
+constexpr float kNumberTopRow = 8.f, kNumberBottomRow = 20.f;
+
+bool LightBarDetector::Initialize(const std::string &config_file, int num_stripes) {
+    cv::FileStorage config;
+
+    // Open config file.
+    try {
+        config.open(config_file, cv::FileStorage::READ);
+    } catch (const std::exception &) {
+        LOG(ERROR) << "Failed to open light-bar detector config file " << config_file << ".";
+        return false;
+    }
+    if (!config.isOpened()) {
+        LOG(ERROR) << "Failed to open light-bar detector config file " << config_file << ".";
+        return false;
+    }
+
+    // Read config data.
+    Parameters parameters;
+    try {
+        config["COLOR"] >> parameters.color;
+        config["DIFFERENCE_THRESH"] >> parameters.difference_threshold;
+        config["BRIGHTNESS_THRESH"] >> parameters.brightness_threshold;
+        config["MIN_BAR_AREA"] >> parameters.min_bar_area;
+        config["MIN_BAR_RATIO"] >> parameters.min_bar_ratio;
+        config["MAX_BAR_RATIO"] >> parameters.max_bar_ratio;
+        config["MAX_BAR_ANGLE"] >> parameters.max_bar_angle;
+        config["MAX_ANGLE_DIFFERENCE"] >> parameters.max_angle_difference;
+        config["MIN_LENGTH_RATIO"] >> parameters.min_length_ratio;
+        config["MIN_DISTANCE_RATIO"] >> parameters.min_distance_ratio;
+        config["MAX_DISTANCE_RATIO"] >> parameters.max_distance_ratio;
+        config["MAX_OFFSET_RATIO"] >> parameters.max_offset_ratio;
+        config["MIN_NUMBER_CONFIDENCE"] >> parameters.min_number_confidence;
+        config["NUMBER_MODEL"] >> parameters.number_model;
+        config["DEFAULT_ID"] >> parameters.default_id;
+        config["DEFAULT_LARGE_ID"] >> parameters.default_large_id;
+    } catch (const std::exception &) {
+        LOG(ERROR) << "Failed to load config of light-bar detector.";
+        return false;
+    }
+    config.release();
+
+    return Initialize(parameters, num_stripes);
+}
+
+bool LightBarDetector::Initialize(const Parameters &parameters, int num_stripes) {
+    initialized_ = false;
+    parameters_ = parameters;
+    num_stripes_ = std::max(num_stripes, 0);
+
+    number_classifier_ = cv::dnn::Net();
+    if (!parameters_.number_model.empty()) {
+        try {
+            number_classifier_ = cv::dnn::readNetFromONNX(parameters_.number_model);
+        } catch (const cv::Exception &) {
+            LOG(ERROR) << "Failed to load number classifier " << parameters_.number_model << ".";
+            return false;
+        }
+        number_classifier_.setPreferableBackend(cv::dnn::DNN_BACKEND_OPENCV);
+        number_classifier_.setPreferableTarget(cv::dnn::DNN_TARGET_CPU);
+    } else
+        LOG(WARNING) << "No number classifier for light-bar detector, armors will be " << parameters_.default_id
+                     << " or " << parameters_.default_large_id << " when large.";
+
+    initialized_ = true;
+    return true;
+}
+
+void LightBarDetector::operator()(const cv::Mat &image, std::vector<bbox_t> &boxes) const {
+    boxes.clear();
+    bars_.clear();
+    if (!initialized_) {
+        LOG(ERROR) << "Light-bar detector is not initialized.";
+        return;
+    }
+    if (image.empty() || image.type() != CV_8UC3)
+        return;
+
+    const int colors[2] = {0, 1};
+    const int *colors_begin = parameters_.color == kAnyColor ? colors : colors + std::clamp(parameters_.color, 0, 1);
+    const int *colors_end = parameters_.color == kAnyColor ? colors + 2 : colors_begin + 1;
+    for (auto color = colors_begin; color != colors_end; ++color) {
+        masks_[*color].create(image.size(), CV_8UC1);
+        dilated_[*color].create(image.size(), CV_8UC1);
+    }
+
+    // Threshold and dilate in stripes. Dilating reads rows of neighboring stripes, so it starts after thresholding.
+    int num_stripes = num_stripes_ ? num_stripes_ : std::max(cv::getNumThreads(), 1);
+    num_stripes = std::min(num_stripes, image.rows);
+    cv::parallel_for_(cv::Range(0, num_stripes), [&](const cv::Range &range) {
+        for (int stripe = range.start; stripe < range.end; ++stripe)
+            for (auto color = colors_begin; color != colors_end; ++color)
+                ThresholdRows(image, *color,
+                              image.rows * stripe / num_stripes, image.rows * (stripe + 1) / num_stripes);
+    }, num_stripes);
+    const cv::Mat kernel = cv::getStructuringElement(cv::MORPH_RECT, {3, 3});
+    cv::parallel_for_(cv::Range(0, num_stripes), [&](const cv::Range &range) {
+        for (int stripe = range.start; stripe < range.end; ++stripe) {
+            const int row_begin = image.rows * stripe / num_stripes, row_end = image.rows * (stripe + 1) / num_stripes;
+            for (auto color = colors_begin; color != colors_end; ++color) {
+                cv::Mat dilated = dilated_[*color].rowRange(row_begin, row_end);
+                cv::dilate(masks_[*color].rowRange(row_begin, row_end), dilated, kernel);
+            }
+        }
+    }, num_stripes);
+
+    for (auto color = colors_begin; color != colors_end; ++color)
+        FindLightBars(*color, bars_);
+    PairLightBars(bars_, parameters_, boxes);
+
+    boxes.erase(std::remove_if(boxes.begin(), boxes.end(),
+                               [&](bbox_t &box) { return !ClassifyNumber(image, box); }),
+                boxes.end());
+    std::stable_sort(boxes.begin(), boxes.end(),
+                     [](const bbox_t &a, const bbox_t &b) { return a.confidence > b.confidence; });
+}
+
+void LightBarDetector::operator()(const Frame &frame, std::vector<bbox_t> &boxes) const {
+    if (!frame.IsRaw()) {
+        (*this)(frame.image, boxes);
+        return;
+    }
+    if (!demosaic::BayerToBGRParallel(frame.raw_image, bgr_buffer_,
+                                      demosaic::BayerPattern(frame.bayer_pattern), frame.raw_bits,
+                                      num_stripes_)) {
+        boxes.clear();
+        bars_.clear();
+        return;
+    }
+    (*this)(bgr_buffer_, boxes);
+}
+
+cv::Rect LightBarDetector::operator()(const Frame &frame, const cv::Rect2f &roi, std::vector<bbox_t> &boxes) const {
+    const auto frame_size = frame.IsRaw() ? frame.raw_image.size() : frame.image.size();
+
+    // Even offsets keep the Bayer pattern.
+    auto rect = cv::Rect(roi) & cv::Rect({0, 0}, frame_size);
+    rect = {rect.x & ~1, rect.y & ~1, rect.width & ~1, rect.height & ~1};
+    if (rect.size() == frame_size) {
+        (*this)(frame, boxes);
+        return rect;
+    }
+    if (rect.empty()) {
+        boxes.clear();
+        bars_.clear();
+        return rect;
+    }
+
+    if (!frame.IsRaw())
+        (*this)(frame.image(rect), boxes);
+    else if (demosaic::BayerToBGR(frame.raw_image(rect), bgr_buffer_,
+                                  demosaic::BayerPattern(frame.bayer_pattern), frame.raw_bits))
+        (*this)(bgr_buffer_, boxes);
+    else {
+        boxes.clear();
+        bars_.clear();
+    }
+
+    for (auto &box: boxes)
+        for (auto &point: box.points)
+            point.x += (float) rect.x, point.y += (float) rect.y;
+    return rect;
+}
+
+void LightBarDetector::PairLightBars(const std::vector<LightBar> &bars, const Parameters &parameters,
+                                     std::vector<bbox_t> &boxes) {
+    boxes.clear();
+
+    /// Candidate pair with its geometry error in [0, 1].
+    struct Candidate {
+        size_t left, right;
+        float error;
+    };
+    std::vector<Candidate> candidates;
+    for (size_t i = 0; i < bars.size(); ++i)
+        for (size_t j = 0; j < bars.size(); ++j) {
+            const auto &left = bars[i], &right = bars[j];
+            if (i == j || left.color != right.color || left.center.x >= right.center.x)
+                continue;
+
+            const float angle_difference = std::abs(left.angle - right.angle);
+            const float length_ratio = std::min(left.length, right.length) / std::max(left.length, right.length);
+            const float average_length = (left.length + right.length) / 2;
+            const float distance_ratio = float(cv::norm(right.center - left.center)) / average_length;
+            const float offset_ratio = std::abs(right.center.y - left.center.y) / average_length;
+            if (angle_difference > parameters.max_angle_difference
+                || length_ratio < parameters.min_length_ratio
+                || distance_ratio < parameters.min_distance_ratio
+                || distance_ratio > parameters.max_distance_ratio
+                || offset_ratio > parameters.max_offset_ratio)
+                continue;
+
+            // Another light bar inside means a wrong pair across armors.
+            const std::vector<cv::Point2f> quad = {left.top, left.bottom, right.bottom, right.top};
+            bool contains_bar = false;
+            for (size_t k = 0; k < bars.size() && !contains_bar; ++k)
+                contains_bar = k != i && k != j && bars[k].color == left.color
+                               && cv::pointPolygonTest(quad, bars[k].center, false) >= 0;
+            if (contains_bar)
+                continue;
+
+            const float error = (angle_difference / std::max(parameters.max_angle_difference, 1e-3f)
+                                 + (1 - length_ratio) / std::max(1 - parameters.min_length_ratio, 1e-3f)
+                                 + offset_ratio / std::max(parameters.max_offset_ratio, 1e-3f)) / 3;
+            candidates.push_back({i, j, error});
+        }
+
+    // Each light bar is used by its best pair only.
+    std::stable_sort(candidates.begin(), candidates.end(),
+                     [](const Candidate &a, const Candidate &b) { return a.error < b.error; });
+    std::vector<bool> used(bars.size(), false);
+    for (const auto &candidate: candidates) {
+        if (used[candidate.left] || used[candidate.right])
+            continue;
+        used[candidate.left] = used[candidate.right] = true;
+        const auto &left = bars[candidate.left], &right = bars[candidate.right];
+        // Without number, distance between light bars is the only hint of large armors.
+        const float distance_ratio = float(cv::norm(right.center - left.center)) / ((left.length + right.length) / 2);
+        boxes.push_back({{left.top, left.bottom, right.bottom, right.top},
+                         1 - candidate.error / 2,
+                         left.color,
+                         distance_ratio > kLargeArmorDistanceRatio ? parameters.default_large_id
+                                                                   : parameters.default_id});
+    }
+}
+
+void LightBarDetector::ThresholdRows(const cv::Mat &image, int color, int row_begin, int row_end) const {
+    // Same as subtracting the opposite channel and binarizing, in one pass without splitting channels.
+    const int own_channel = color == 1 ? 2 : 0, other_channel = 2 - own_channel;
+    const int difference = parameters_.difference_threshold, brightness = parameters_.brightness_threshold;
+    for (int y = row_begin; y < row_end; ++y) {
+        const auto *pixel = image.ptr<uint8_t>(y);
+        auto *mask = masks_[color].ptr<uint8_t>(y);
+        for (int x = 0; x < image.cols; ++x, pixel += 3) {
+            const int own = pixel[own_channel], other = pixel[other_channel];
+            mask[x] = own > brightness && own - other > difference ? 255 : 0;
+        }
+    }
+}
+
+void LightBarDetector::FindLightBars(int color, std::vector<LightBar> &bars) const {
+    cv::findContours(dilated_[color], contours_, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
+    for (const auto &contour: contours_) {
+        if (cv::contourArea(contour) < parameters_.min_bar_area)
+            continue;
+
+        // End points are centers of the short edges, which are the top-most and bottom-most ones of a standing bar.
+        const auto rect = cv::minAreaRect(contour);
+        cv::Point2f points[4];
+        rect.points(points);
+        std::sort(points, points + 4, [](const cv::Point2f &a, const cv::Point2f &b) { return a.y < b.y; });
+        LightBar bar;
+        bar.top = (points[0] + points[1]) / 2;
+        bar.bottom = (points[2] + points[3]) / 2;
+        bar.center = rect.center;
+        bar.length = float(cv::norm(bar.bottom - bar.top));
+        bar.angle = float(std::atan2(bar.top.x - bar.bottom.x, bar.bottom.y - bar.top.y) * 180 / CV_PI);
+        bar.color = color;
+        if (bar.length <= 0)
+            continue;
+
+        const float ratio = bar.length * bar.length / rect.size.area();
+        if (ratio < parameters_.min_bar_ratio || ratio > parameters_.max_bar_ratio
+            || std::abs(bar.angle) > parameters_.max_bar_angle)
+            continue;
+        bars.push_back(bar);
+    }
+}
+
+bool LightBarDetector::ClassifyNumber(const cv::Mat &image, bbox_t &box) const {
+    // Default ids are set when pairing.
+    if (number_classifier_.empty())
+        return true;
+
+    // Warp light-bar end points to fixed rows, so number has the same size in patch.
+    const float left_length = float(cv::norm(box.points[1] - box.points[0]));
+    const float right_length = float(cv::norm(box.points[2] - box.points[3]));
+    const float distance = float(cv::norm((box.points[2] + box.points[3]) / 2 - (box.points[0] + box.points[1]) / 2));
+    const int width = distance / ((left_length + right_length) / 2) > kLargeArmorDistanceRatio ? 54 : 32;
+    const cv::Point2f target[4] = {{0, kNumberTopRow},
+                                   {0, kNumberBottomRow},
+                                   {float(width - 1), kNumberBottomRow},
+                                   {float(width - 1), kNumberTopRow}};
+    cv::warpPerspective(image, number_patch_, cv::getPerspectiveTransform(box.points, target),
+                        {width, kNumberHeight});
+    number_patch_ = number_patch_.colRange((width - kNumberWidth) / 2, (width + kNumberWidth) / 2);
+    cv::cvtColor(number_patch_, number_patch_, cv::COLOR_BGR2GRAY);
+    cv::threshold(number_patch_, number_patch_, 0, 255, cv::THRESH_BINARY | cv::THRESH_OTSU);
+
+    cv::dnn::blobFromImage(number_patch_, number_blob_, 1. / 255);
+    number_classifier_.setInput(number_blob_);
+    cv::Mat scores = number_classifier_.forward().reshape(1, 1);
+
+    // Softmax.
+    double max_score;
+    cv::Point max_location;
+    cv::minMaxLoc(scores, nullptr, &max_score, nullptr, &max_location);
+    cv::exp(scores - max_score, scores);
+    const float probability = 1.f / float(cv::sum(scores)[0]);
+    if (max_location.x == kNegativeClass || probability < parameters_.min_number_confidence)
+        return false;
+    box.id = max_location.x;
+    box.confidence *= probability;
+    return true;
+}
@@ -0,0 +1,160 @@
+/**
+ * Light-bar armor detector header.
+ * \author trantuan-20048607
+ * \date 2022.3.30
+ * \details Traditional armor detector finding and pairing light bars, without neural network inference,
+ *   as a CPU-only alternative of ArmorDetector.
+ */
+
+#ifndef DETECTOR_ARMOR_LIGHT_BAR_H_
+#define DETECTOR_ARMOR_LIGHT_BAR_H_
+
+#include <string>
+#include <vector>
+#include <opencv2/core.hpp>
+#include <opencv2/dnn.hpp>
+#include "data-structure/bbox_t.h"
+#include "data-structure/frame.h"
+#include "lang-feature-extension/attr_reader.h"
+#include "lang-feature-extension/disable_constructor.h"
+
+/**
+ * \brief Armor detector by light bars.
+ * \details Detection runs in these steps:  \n
+ *   (1) Light-bar colored pixels are thresholded by channel difference and brightness, then dilated,
+ *   in horizontal stripes at the same time.  \n
+ *   (2) Light bars are extracted from external contours by their length-width ratio and tilt angle.  \n
+ *   (3) Light bars of the same color are paired by angle difference, length ratio and distance,
+ *   and pairs with another light bar inside are rejected. Each light bar is used by the best pair only.  \n
+ *   (4) Number between light bars is warped to a binary patch and classified by a small network on CPU,
+ *   whose output also rejects pairs without numbers. Without this network, armors get a default id,
+ *   or a default large id when light bars are far apart, so that they are solved as large armors.  \n
+ *   Output boxes are the same as ArmorDetector: 4 end points of light bars in order of
+ *   top left, bottom left, bottom right and top right.
+ * \attention Buffers are reused between calls, do not call it in different threads at the same time.
+ */
+class LightBarDetector : NO_COPY, NO_MOVE {
+public:
+    static constexpr int kAnyColor = -1;      ///< Detect both blue and red armors.
+    static constexpr int kNumberWidth = 20;   ///< Width of number patch.
+    static constexpr int kNumberHeight = 28;  ///< Height of number patch.
+    static constexpr int kNegativeClass = 7;  ///< Class of patches without number, after ids 0 to 6.
+
+    /// \brief Parameters of detector.
+    struct Parameters {
+        int color = kAnyColor;               ///< Detected color in bbox_t order, 0 for blue and 1 for red, or kAnyColor.
+        int difference_threshold = 80;       ///< Min difference between light-bar channel and opposite channel.
+        int brightness_threshold = 150;      ///< Min value of light-bar channel.
+        int min_bar_area = 8;                ///< Min contour area of a light bar in pixels.
+        float min_bar_ratio = 1.5f;          ///< Min length-width ratio of a light bar.
+        float max_bar_ratio = 15.f;          ///< Max length-width ratio of a light bar.
+        float max_bar_angle = 40.f;          ///< Max angle between light bar and vertical direction in degrees.
+        float max_angle_difference = 10.f;   ///< Max angle difference of paired light bars in degrees.
+        float min_length_ratio = 0.6f;       ///< Min ratio of shorter to longer light bar in a pair.
+        float min_distance_ratio = 0.8f;     ///< Min distance between paired light bars over their average length.
+        float max_distance_ratio = 5.f;      ///< Max distance between paired light bars over their average length.
+        float max_offset_ratio = 0.5f;       ///< Max vertical offset of paired light bars over their average length.
+        float min_number_confidence = 0.6f;  ///< Min probability of number classifier.
+        std::string number_model;            ///< ONNX file of number classifier, empty to use default id.
+        int default_id = 3;                  ///< Id of small armors without number classifier.
+        int default_large_id = 1;            ///< Id of large armors without number classifier, solved as large.
+    };
+
+    /// \brief Light bar extracted from a contour.
+    struct LightBar {
+        cv::Point2f top;     ///< Top end point.
+        cv::Point2f bottom;  ///< Bottom end point.
+        cv::Point2f center;  ///< Center point.
+        float length;        ///< Distance between end points.
+        float angle;         ///< Signed angle from vertical direction in degrees.
+        int color;           ///< Color in bbox_t order.
+    };
+
+    LightBarDetector() : initialized_(false), parameters_(), num_stripes_(0) {}
+
+    /**
+     * \brief Load parameters from config file.
+     * \param [in] config_file Config file path.
+     * \param [in] num_stripes Number of image stripes processed at the same time, 0 to use OpenCV threads.
+     * \return Whether detector is ready.
+     */
+    bool Initialize(const std::string &config_file, int num_stripes = 0);
+
+    /**
+     * \brief Set parameters directly, for benchmarks.
+     * \param [in] parameters Parameters of detector.
+     * \param [in] num_stripes Number of image stripes processed at the same time, 0 to use OpenCV threads.
+     * \return Whether detector is ready, false when number classifier fails to load.
+     */
+    bool Initialize(const Parameters &parameters, int num_stripes = 0);
+
+    ATTR_READER(initialized_, Initialized)
+
+    ATTR_READER_REF(parameters_, GetParameters)
+
+    /**
+     * \brief Detect armors in a BGR image.
+     * \param [in] image Input BGR image.
+     * \param [out] boxes 4-point structures, cleared before writing.
+     */
+    void operator()(const cv::Mat &image, std::vector<bbox_t> &boxes) const;
+
+    /**
+     * \brief Detect armors in a frame, raw frames are demosaiced first.
+     * \param [in] frame Input frame.
+     * \param [out] boxes 4-point structures, cleared before writing.
+     */
+    void operator()(const Frame &frame, std::vector<bbox_t> &boxes) const;
+
+    /**
+     * \brief Detect armors in a region of a frame.
+     * \param [in] frame Input frame.
+     * \param [in] roi Region of interest, moved into frame.
+     * \param [out] boxes 4-point structures in frame coordinate, cleared before writing.
+     * \return Region actually used.
+     */
+    cv::Rect operator()(const Frame &frame, const cv::Rect2f &roi, std::vector<bbox_t> &boxes) const;
+
+    /**
+     * \brief Pair light bars to armors.
+     * \param [in] bars Light bars.
+     * \param [in] parameters Parameters of detector.
+     * \param [out] boxes Armors with default id or default large id, in descending order of confidence.
+     */
+    static void PairLightBars(const std::vector<LightBar> &bars, const Parameters &parameters,
+                              std::vector<bbox_t> &boxes);
+
+    /// \return Light bars found in the last detection including unpaired ones, in coordinate of detected image.
+    [[nodiscard]] inline const std::vector<LightBar> &LightBars() const { return bars_; }
+
+private:
+    /// \brief Threshold light-bar colored pixels of a color in rows [row_begin, row_end).
+    void ThresholdRows(const cv::Mat &image, int color, int row_begin, int row_end) const;
+
+    /// \brief Extract light bars of a color from dilated mask.
+    void FindLightBars(int color, std::vector<LightBar> &bars) const;
+
+    /**
+     * \brief Classify number of an armor.
+     * \param [in] image Input BGR image.
+     * \param [in,out] box Armor box, whose id and confidence are updated.
+     * \return Whether armor has a number.
+     */
+    bool ClassifyNumber(const cv::Mat &image, bbox_t &box) const;
+
+    bool initialized_;                        ///< Whether detector is initialized.
+    Parameters parameters_;                   ///< Parameters of detector.
+    int num_stripes_;                         ///< Number of image stripes, 0 to use OpenCV threads.
+    mutable cv::dnn::Net number_classifier_;  ///< Number classifier, empty when not loaded.
+
+    // Buffers reused between calls.
+    mutable cv::Mat bgr_buffer_;
+    mutable cv::Mat masks_[2];     ///< Thresholded masks of blue and red.
+    mutable cv::Mat dilated_[2];   ///< Dilated masks of blue and red.
+    mutable cv::Mat number_patch_;
+    mutable cv::Mat number_blob_;
+    mutable std::vector<std::vector<cv::Point>> contours_;
+    mutable std::vector<LightBar> bars_;
+};
+
+#endif  // DETECTOR_ARMOR_LIGHT_BAR_H_
@@ -0,0 +1,144 @@
+#include <algorithm>
+#include <glog/logging.h>
+#include "detector_armor_backend.h"
+#include "detector_armor_decoder.h"
+#include "detector_armor_tiler.h"
+
+/// Max distance from a tile edge in model input pixels, for boxes cut by this edge.
+constexpr float kSeamMargin = 4.f;
+
+bool ArmorTiler::Initialize(const std::string &config_file) {
+    cv::FileStorage config;
+
+    // Open config file.
+    try {
+        config.open(config_file, cv::FileStorage::READ);
+    } catch (const std::exception &) {
+        LOG(ERROR) << "Failed to open armor tiling config file " << config_file << ".";
+        return false;
+    }
+    if (!config.isOpened()) {
+        LOG(ERROR) << "Failed to open armor tiling config file " << config_file << ".";
+        return false;
+    }
+
+    // Read config data.
+    int enabled = 0, full_frame = 1;
+    Layout layout;
+    try {
+        config["ENABLED"] >> enabled;
+        config["TILE_SCALE"] >> layout.tile_scale;
+        config["OVERLAP"] >> layout.overlap;
+        config["FULL_FRAME"] >> full_frame;
+        config["IOU_THRESH"] >> layout.iou_threshold;
+    } catch (const std::exception &) {
+        LOG(ERROR) << "Failed to load config of armor tiling.";
+        return false;
+    }
+    config.release();
+    layout.full_frame = full_frame != 0;
+
+    Initialize(layout);
+    enabled_ = enabled != 0;
+    return true;
+}
+
+void ArmorTiler::Initialize(const Layout &layout) {
+    layout_ = layout;
+    layout_.tile_scale = std::max(layout_.tile_scale, 0.1f);
+    layout_.overlap = std::max(layout_.overlap, 0);
+    enabled_ = true;
+}
+
+void ArmorTiler::Split(const cv::Size &frame_size, const Layout &layout, std::vector<cv::Rect> &tiles) {
+    tiles.clear();
+    const int tile_width = std::min(int(ArmorDetectorBackend::kInputWidth * layout.tile_scale) & ~1,
+                                    frame_size.width);
+    const int tile_height = std::min(int(ArmorDetectorBackend::kInputHeight * layout.tile_scale) & ~1,
+                                     frame_size.height);
+    if (tile_width <= 0 || tile_height <= 0)
+        return;
+
+    // Fewest tiles covering frame with required overlap, n * tile_length - (n - 1) * overlap >= frame_length.
+    auto positions = [&layout](int frame_length, int tile_length) {
+        if (frame_length <= tile_length)
+            return std::vector<int>{0};
+        const int overlap = std::min(layout.overlap, tile_length / 2);
+        const int n = std::max((frame_length - overlap + tile_length - overlap - 1) / (tile_length - overlap), 2);
+        std::vector<int> result(n);
+        for (int i = 0; i < n; ++i)
+            result[i] = int(int64_t(frame_length - tile_length) * i / (n - 1));
+        return result;
+    };
+    const auto xs = positions(frame_size.width, tile_width), ys = positions(frame_size.height, tile_height);
+    for (auto y: ys)
+        for (auto x: xs)
+            tiles.emplace_back(x, y, tile_width, tile_height);
+}
+
+void ArmorTiler::operator()(const ArmorDetector &detector, const cv::Mat &image, std::vector<bbox_t> &boxes) const {
+    boxes.clear();
+    Split(image.size(), layout_, tiles_);
+    if (tiles_.empty())
+        return;
+
+    images_.clear();
+    for (const auto &tile: tiles_)
+        images_.emplace_back(image(tile));
+    const bool full_frame = layout_.full_frame && tiles_.size() > 1;
+    if (full_frame)
+        images_.emplace_back(image);
+    detector(images_, tile_boxes_);
+
+    for (size_t i = 0; i < tiles_.size(); ++i)
+        for (auto box: tile_boxes_[i]) {
+            if (CutBySeam(box, tiles_[i], image.size()))
+                continue;
+            for (auto &point: box.points)
+                point.x += (float) tiles_[i].x, point.y += (float) tiles_[i].y;
+            boxes.push_back(box);
+        }
+    if (full_frame)
+        boxes.insert(boxes.end(), tile_boxes_.back().begin(), tile_boxes_.back().end());
+    Merge(boxes);
+}
+
+void ArmorTiler::operator()(const ArmorDetector &detector, Frame &frame, std::vector<bbox_t> &boxes) const {
+    const auto &image = frame.Image();
+    if (image.empty()) {
+        boxes.clear();
+        return;
+    }
+    (*this)(detector, image, boxes);
+}
+
+bool ArmorTiler::CutBySeam(const bbox_t &box, const cv::Rect &tile, const cv::Size &frame_size) const {
+    float min_x = box.points[0].x, max_x = min_x, min_y = box.points[0].y, max_y = min_y;
+    for (const auto &point: box.points) {
+        min_x = std::min(min_x, point.x), max_x = std::max(max_x, point.x);
+        min_y = std::min(min_y, point.y), max_y = std::max(max_y, point.y);
+    }
+
+    // A box of more than half overlap may be cut too much to be complete in the neighbor tile, keep it for NMS.
+    const float margin = kSeamMargin * float(tile.width) / ArmorDetectorBackend::kInputWidth;
+    const float max_length = float(layout_.overlap) / 2;
+    const bool horizontal_cut = (tile.x > 0 && min_x < margin)
+                                || (tile.x + tile.width < frame_size.width && max_x > float(tile.width) - margin);
+    const bool vertical_cut = (tile.y > 0 && min_y < margin)
+                              || (tile.y + tile.height < frame_size.height && max_y > float(tile.height) - margin);
+    return (horizontal_cut && max_x - min_x < max_length) || (vertical_cut && max_y - min_y < max_length);
+}
+
+void ArmorTiler::Merge(std::vector<bbox_t> &boxes) const {
+    std::stable_sort(boxes.begin(), boxes.end(),
+                     [](const bbox_t &a, const bbox_t &b) { return a.confidence > b.confidence; });
+    size_t num_kept = 0;
+    for (size_t i = 0; i < boxes.size(); ++i) {
+        bool suppressed = false;
+        for (size_t j = 0; j < num_kept && !suppressed; ++j)
+            suppressed = ArmorDecoder::QuadIoU(boxes[j].points, boxes[i].points) > layout_.iou_threshold;
+        if (!suppressed)
+            boxes[num_kept++] = boxes[i];
+    }
+    boxes.resize(num_kept);
+}
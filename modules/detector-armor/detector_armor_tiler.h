@@ -0,0 +1,104 @@
+/**
+ * Tiled armor detection header.
+ * \author trantuan-20048607
+ * \date 2022.3.30
+ * \details Detect armors in overlapping tiles of a high resolution frame, so that far targets keep their pixels.
+ */
+
+#ifndef DETECTOR_ARMOR_TILER_H_
+#define DETECTOR_ARMOR_TILER_H_
+
+#include <string>
+#include <vector>
+#include <opencv2/core.hpp>
+#include "data-structure/bbox_t.h"
+#include "data-structure/frame.h"
+#include "lang-feature-extension/attr_reader.h"
+#include "lang-feature-extension/disable_constructor.h"
+#include "detector_armor.h"
+
+/**
+ * \brief Tiled detection of armor detector.
+ * \details A frame is split into a grid of overlapping tiles with the aspect ratio of model input,
+ *   each covering tile_scale times model input size, so tile_scale 1 detects at native resolution.
+ *   Tiles, and optionally the whole frame for near armors larger than overlap, are predicted by batched detection.  \n
+ *   Boxes are moved to frame coordinate and merged. Boxes cut by an inner tile edge are dropped when they are
+ *   smaller than half of overlap, since the neighbor tile contains them completely.
+ *   Then duplicates across tile seams are removed by quadrilateral IoU NMS.
+ * \attention Buffers are reused between calls, do not call it in different threads at the same time.
+ */
+class ArmorTiler : NO_COPY, NO_MOVE {
+public:
+    /// \brief Tiling layout.
+    struct Layout {
+        float tile_scale = 1;       ///< Tile size relative to model input size, 1 for native resolution.
+        int overlap = 64;           ///< Min overlap of neighbor tiles in frame pixels.
+        bool full_frame = true;     ///< Also detect in the whole frame.
+        float iou_threshold = 0.3;  ///< Max IoU between merged boxes.
+    };
+
+    ArmorTiler() : enabled_(false), layout_() {}
+
+    /**
+     * \brief Load layout from config file.
+     * \param [in] config_file Config file path.
+     * \return Whether config is loaded. Tiling is enabled only when "ENABLED" is not 0.
+     */
+    bool Initialize(const std::string &config_file);
+
+    /**
+     * \brief Set layout directly and enable tiling, for benchmarks.
+     * \param [in] layout Tiling layout.
+     */
+    void Initialize(const Layout &layout);
+
+    ATTR_READER(enabled_, Enabled)
+
+    ATTR_READER_REF(layout_, GetLayout)
+
+    /**
+     * \brief Split a frame into tiles.
+     * \param [in] frame_size Size of frame.
+     * \param [in] layout Tiling layout.
+     * \param [out] tiles Regions of tiles in frame, in row-major order, a single tile for small frames.
+     */
+    static void Split(const cv::Size &frame_size, const Layout &layout, std::vector<cv::Rect> &tiles);
+
+    /**
+     * \brief Detect armors in tiles of a BGR image.
+     * \param [in] detector Armor detector.
+     * \param [in] image Input BGR image.
+     * \param [out] boxes 4-point structures in image coordinate, cleared before writing.
+     */
+    void operator()(const ArmorDetector &detector, const cv::Mat &image, std::vector<bbox_t> &boxes) const;
+
+    /**
+     * \brief Detect armors in tiles of a frame.
+     * \param [in] detector Armor detector.
+     * \param [in] frame Input frame, raw frames are demosaiced by Frame::Image().
+     * \param [out] boxes 4-point structures in frame coordinate, cleared before writing.
+     */
+    void operator()(const ArmorDetector &detector, Frame &frame, std::vector<bbox_t> &boxes) const;
+
+private:
+    /**
+     * \brief Whether a box in a tile is cut by an inner tile edge and contained by a neighbor tile.
+     * \param [in] box Box in tile coordinate.
+     * \param [in] tile Region of tile in frame.
+     * \param [in] frame_size Size of frame.
+     */
+    [[nodiscard]] bool CutBySeam(const bbox_t &box, const cv::Rect &tile, const cv::Size &frame_size) const;
+
+    /// \brief Remove duplicated boxes in descending order of confidence.
+    void Merge(std::vector<bbox_t> &boxes) const;
+
+    bool enabled_;   ///< Whether tiling is enabled.
+    Layout layout_;  ///< Tiling layout.
+
+    // Buffers reused between calls.
+    mutable std::vector<cv::Rect> tiles_;
+    mutable std::vector<cv::Mat> images_;
+    mutable std::vector<std::vector<bbox_t>> tile_boxes_;
+};
+
+#endif  // DETECTOR_ARMOR_TILER_H_
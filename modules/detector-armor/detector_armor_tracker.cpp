@@ -0,0 +1,163 @@
+#include <cfloat>
+#include <cmath>
+#include <opencv2/imgproc.hpp>
+#include <opencv2/video/tracking.hpp>
+#include "image-processing/demosaic.h"
+#include "detector_armor_tracker.h"
+
+/// Size of optical flow search window.
+constexpr int kWindowSize = 15;
+
+/// Levels of optical flow pyramid.
+constexpr int kPyramidLevels = 2;
+
+bool ArmorTracker::Track(const Frame &frame, std::vector<bbox_t> &boxes) {
+    if (boxes_.empty() || frames_since_detection_ + 1 >= interval_)
+        return false;
+
+    std::vector<bbox_t> tracked;
+    if (!TrackCorners(frame, tracked)) {
+        interval_ = std::max(interval_ / 2, 1u);
+        return false;
+    }
+    for (auto &box: tracked) {
+        box.confidence *= kConfidenceDecay;
+        if (box.confidence < kMinConfidence)
+            return false;
+    }
+
+    ++frames_since_detection_;
+    ++statistics_.tracked_frames;
+    boxes_ = tracked;
+    boxes = std::move(tracked);
+    KeepPrevious(frame);
+    return true;
+}
+
+void ArmorTracker::Update(const Frame &frame, const std::vector<bbox_t> &boxes) {
+    // Compare tracking with detection to measure track quality.
+    std::vector<bbox_t> tracked;
+    if (!boxes_.empty()) {
+        int matched = 0;
+        float drift = 0;
+        const bool succeeded = TrackCorners(frame, tracked);
+        if (succeeded)
+            drift = Drift(tracked, boxes, matched);
+        if (matched > 0) {
+            ++statistics_.drift_samples;
+            statistics_.average_drift += drift;
+        }
+        if (!succeeded || matched < int(tracked.size()) || drift > kBadDrift)
+            interval_ = std::max(interval_ / 2, 1u);
+        else if (drift < kGoodDrift)
+            interval_ = std::min(interval_ + 1, max_interval_);
+    } else if (!boxes.empty())
+        interval_ = std::min(interval_ + 1, max_interval_);
+
+    ++statistics_.detected_frames;
+    frames_since_detection_ = 0;
+    boxes_ = boxes;
+    KeepPrevious(frame);
+}
+
+ArmorTracker::Statistics ArmorTracker::GetStatistics() const {
+    auto statistics = statistics_;
+    if (statistics.drift_samples)
+        statistics.average_drift /= double(statistics.drift_samples);
+    return statistics;
+}
+
+float ArmorTracker::Drift(const std::vector<bbox_t> &tracked, const std::vector<bbox_t> &detected, int &matched) {
+    matched = 0;
+    float total_drift = 0;
+    for (const auto &box: tracked) {
+        auto min_drift = FLT_MAX;
+        for (const auto &candidate: detected) {
+            if (candidate.color != box.color || candidate.id != box.id)
+                continue;
+            float drift = 0;
+            for (int i = 0; i < 4; ++i)
+                drift += std::hypot(candidate.points[i].x - box.points[i].x, candidate.points[i].y - box.points[i].y);
+            min_drift = std::min(min_drift, drift / 4);
+        }
+        if (min_drift < FLT_MAX) {
+            ++matched;
+            total_drift += min_drift;
+        }
+    }
+    return matched ? total_drift / float(matched) : 0;
+}
+
+bool ArmorTracker::TrackCorners(const Frame &frame, std::vector<bbox_t> &boxes) {
+    const auto frame_size = frame.IsRaw() ? frame.raw_image.size() : frame.image.size();
+    if (frame_size != previous_size_ || frame_size.empty() || previous_grey_.empty())
+        return false;
+
+    const int x = previous_rect_.x, y = previous_rect_.y;
+    GreyPatch(frame, previous_rect_, current_grey_);
+    if (current_grey_.empty())
+        return false;
+
+    auto &previous = corners_[0], &current = corners_[1], &backward = corners_[2];
+    previous.clear();
+    for (const auto &box: boxes_)
+        for (const auto &point: box.points)
+            previous.emplace_back(point.x - float(x), point.y - float(y));
+
+    // Forward-backward check rejects corners drifting on weak texture.
+    const cv::Size window(kWindowSize, kWindowSize);
+    cv::calcOpticalFlowPyrLK(previous_grey_, current_grey_, previous, current, status_[0], error_,
+                             window, kPyramidLevels);
+    cv::calcOpticalFlowPyrLK(current_grey_, previous_grey_, current, backward, status_[1], error_,
+                             window, kPyramidLevels);
+    for (size_t i = 0; i < previous.size(); ++i)
+        if (!status_[0][i] || !status_[1][i]
+            || std::hypot(backward[i].x - previous[i].x, backward[i].y - previous[i].y) > kMaxForwardBackwardError)
+            return false;
+
+    boxes = boxes_;
+    for (size_t i = 0; i < boxes.size(); ++i)
+        for (int j = 0; j < 4; ++j)
+            boxes[i].points[j] = {current[4 * i + j].x + float(x), current[4 * i + j].y + float(y)};
+    return true;
+}
+
+void ArmorTracker::KeepPrevious(const Frame &frame) {
+    previous_size_ = frame.IsRaw() ? frame.raw_image.size() : frame.image.size();
+    if (boxes_.empty() || previous_size_.empty()) {
+        previous_grey_.release();
+        return;
+    }
+
+    // Patch covering all boxes and their neighborhoods, with even offset to keep Bayer pattern.
+    float min_x = FLT_MAX, min_y = FLT_MAX, max_x = -FLT_MAX, max_y = -FLT_MAX;
+    for (const auto &box: boxes_) {
+        float box_min_x = FLT_MAX, box_min_y = FLT_MAX, box_max_x = -FLT_MAX, box_max_y = -FLT_MAX;
+        for (const auto &point: box.points) {
+            box_min_x = std::min(box_min_x, point.x), box_max_x = std::max(box_max_x, point.x);
+            box_min_y = std::min(box_min_y, point.y), box_max_y = std::max(box_max_y, point.y);
+        }
+        const auto margin = std::max(box_max_x - box_min_x, box_max_y - box_min_y) + kWindowSize;
+        min_x = std::min(min_x, box_min_x - margin), max_x = std::max(max_x, box_max_x + margin);
+        min_y = std::min(min_y, box_min_y - margin), max_y = std::max(max_y, box_max_y + margin);
+    }
+    const int x = std::clamp(int(min_x), 0, previous_size_.width - 2) & ~1;
+    const int y = std::clamp(int(min_y), 0, previous_size_.height - 2) & ~1;
+    previous_rect_ = cv::Rect(x, y,
+                              (std::clamp(int(max_x) + 1, x + 2, previous_size_.width) - x) & ~1,
+                              (std::clamp(int(max_y) + 1, y + 2, previous_size_.height) - y) & ~1);
+    GreyPatch(frame, previous_rect_, previous_grey_);
+}
+
+void ArmorTracker::GreyPatch(const Frame &frame, const cv::Rect &rect, cv::Mat &grey) {
+    if (!frame.IsRaw()) {
+        cv::cvtColor(frame.image(rect), grey, cv::COLOR_BGR2GRAY);
+        return;
+    }
+    if (!demosaic::BayerToBGR(frame.raw_image(rect), bgr_buffer_,
+                              demosaic::BayerPattern(frame.bayer_pattern), frame.raw_bits)) {
+        grey.release();
+        return;
+    }
+    cv::cvtColor(bgr_buffer_, grey, cv::COLOR_BGR2GRAY);
+}
@@ -0,0 +1,122 @@
+/**
+ * Armor corner tracker header.
+ * \author trantuan-20048607
+ * \date 2022.3.29
+ * \details Propagate corners of detected armors between detections with pyramidal Lucas-Kanade optical flow.
+ */
+
+#ifndef DETECTOR_ARMOR_TRACKER_H_
+#define DETECTOR_ARMOR_TRACKER_H_
+
+#include <algorithm>
+#include <vector>
+#include <opencv2/core.hpp>
+#include "data-structure/bbox_t.h"
+#include "data-structure/frame.h"
+#include "lang-feature-extension/attr_reader.h"
+#include "lang-feature-extension/disable_constructor.h"
+
+/**
+ * \brief Keypoint tracker for detect-every-N mode of armor detector.
+ * \details After a detection, the 4 corners of each box are tracked frame by frame until the detection interval
+ *   is reached, any corner fails the forward-backward check or any box confidence decays below threshold.  \n
+ *   Detection interval adapts to track quality: at each detection, boxes are also tracked to the detected frame,
+ *   and the corner drift against detection increases the interval by one when it is small and halves it
+ *   when it is large. Any failure of tracking also halves it.
+ *   Only patches around boxes are converted to grey images, raw frames are demosaiced in these patches only.
+ *   Grey patch of the last frame is kept as a private copy, so that frames can be reused or drawn on by other stages.
+ * \attention Not thread safe, use it in a single pipeline stage.
+ */
+class ArmorTracker : NO_COPY, NO_MOVE {
+public:
+    static constexpr float kMaxForwardBackwardError = 1.f;  ///< Max forward-backward error of a corner in pixels.
+    static constexpr float kGoodDrift = 1.5f;               ///< Drift to increase interval in pixels.
+    static constexpr float kBadDrift = 4.f;                 ///< Drift to decrease interval in pixels.
+    static constexpr float kConfidenceDecay = 0.95f;        ///< Confidence decay of a tracked frame.
+    static constexpr float kMinConfidence = 0.4f;           ///< Min confidence of tracked boxes.
+
+    /// \brief Statistics of tracker.
+    struct Statistics {
+        uint64_t detected_frames;  ///< Number of frames with detection.
+        uint64_t tracked_frames;   ///< Number of frames with tracking only.
+        uint64_t drift_samples;    ///< Number of detections compared with tracking.
+        double average_drift;      ///< Average corner drift against detection in pixels.
+    };
+
+    /**
+     * \param [in] max_interval Max number of frames between detections, 1 to detect every frame.
+     */
+    explicit ArmorTracker(unsigned int max_interval) :
+            max_interval_(std::max(max_interval, 1u)),
+            interval_(1),
+            frames_since_detection_(0),
+            statistics_() {}
+
+    ATTR_READER(max_interval_, MaxInterval)
+
+    ATTR_READER(interval_, Interval)
+
+    /**
+     * \brief Track boxes of the last frame to this frame.
+     * \param [in] frame Current frame.
+     * \param [out] boxes Tracked boxes, only written when tracking succeeds.
+     * \return Whether boxes are tracked, false means detection is required for this frame.
+     */
+    bool Track(const Frame &frame, std::vector<bbox_t> &boxes);
+
+    /**
+     * \brief Restart tracks with detected boxes, and adapt detection interval.
+     * \param [in] frame Current frame.
+     * \param [in] boxes Detected boxes.
+     */
+    void Update(const Frame &frame, const std::vector<bbox_t> &boxes);
+
+    /// \return Statistics of this tracker.
+    [[nodiscard]] Statistics GetStatistics() const;
+
+    /**
+     * \brief Calculate average corner distance between tracked and detected boxes.
+     * \details Each tracked box is matched with the nearest detected box with the same color and id.
+     * \param [in] tracked Tracked boxes.
+     * \param [in] detected Detected boxes.
+     * \param [out] matched Number of matched boxes.
+     * \return Average corner distance of matched boxes, 0 when nothing is matched.
+     */
+    static float Drift(const std::vector<bbox_t> &tracked, const std::vector<bbox_t> &detected, int &matched);
+
+private:
+    /**
+     * \brief Track corners of current boxes from the previous frame to a frame.
+     * \param [in] frame Target frame.
+     * \param [out] boxes Tracked boxes.
+     * \return Whether all corners pass forward-backward check.
+     */
+    bool TrackCorners(const Frame &frame, std::vector<bbox_t> &boxes);
+
+    /**
+     * \brief Keep grey patch around current boxes of a frame for tracking to the next frame.
+     * \param [in] frame Frame of current boxes.
+     */
+    void KeepPrevious(const Frame &frame);
+
+    /// \brief Convert a patch of frame to grey image.
+    void GreyPatch(const Frame &frame, const cv::Rect &rect, cv::Mat &grey);
+
+    const unsigned int max_interval_;      ///< Max number of frames between detections.
+    unsigned int interval_;                ///< Current number of frames between detections.
+    unsigned int frames_since_detection_;  ///< Number of tracked frames since the last detection.
+    cv::Size previous_size_;               ///< Size of the last frame.
+    cv::Rect previous_rect_;               ///< Patch of the last frame in previous_grey_.
+    std::vector<bbox_t> boxes_;            ///< Boxes in the last frame.
+    Statistics statistics_;                ///< Statistics, with total drift in average_drift.
+
+    // Buffers reused between frames.
+    cv::Mat bgr_buffer_;
+    cv::Mat previous_grey_;  ///< Grey patch of the last frame, copied instead of referring to the frame.
+    cv::Mat current_grey_;
+    std::vector<cv::Point2f> corners_[3];  ///< Previous, tracked and backward tracked corners.
+    std::vector<uint8_t> status_[2];
+    std::vector<float> error_;
+};
+
+#endif  // DETECTOR_ARMOR_TRACKER_H_
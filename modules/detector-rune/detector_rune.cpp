@@ -1,5 +1,8 @@
 #include "detector-rune-debug/detector_rune_debug.h"
+#include <algorithm>
+#include <chrono>
 #include <opencv2/imgproc.hpp>
+#include "image-processing/color_difference.h"
 #include "detector_rune.h"
 
 [[maybe_unused]] RuneDetector::RuneDetector(Entity::Colors color, bool debug) :
@@ -14,11 +17,27 @@
         energy_center_r_(cv::Point2f(0, 0)),
         armor_center_p_(cv::Point2f(0, 0)),
         fan_center_g_(cv::Point2f(0, 0)),
-        send_yaw_pitch_delay_(cv::Point3f(0, 0, 0)) {}
+        send_yaw_pitch_delay_(cv::Point3f(0, 0, 0)),
+        radius_(0),
+        statistics_() {}
+
+/**
+ * \brief Upper bound of area of min area rectangle of blob contour, from its bounding box.
+ * \details Contours of foreground blobs pass through centers of their edge pixels,
+ *   and contours of holes pass through centers of foreground pixels around them.
+ */
+inline int MaxEncircleArea(const Blob &blob) {
+    const int margin = blob.hole ? 1 : -1;
+    return (blob.bounding_box.width + margin) * (blob.bounding_box.height + margin);
+}
+
+/// Outer radius of tracked annulus relative to radius of armor center P, covering armors and motion between frames.
+constexpr double kAnnulusScale = 1.25;
 
 bool RuneDetector::Initialize(const std::string &config_path, const Frame &frame, bool debug_use_trackbar) {
     // Initial center will be center of the image.
     energy_center_r_ = fan_center_g_ = armor_center_p_ = cv::Point2f(0, 0);
+    radius_ = 0;
 
     RuneDetectorDebug::Instance().Initialize("../config/infantry/rune-param.yaml", debug_use_trackbar);
 
@@ -26,21 +45,45 @@ bool RuneDetector::Initialize(const std::string &config_path, const Frame &frame
 }
 
 PowerRune RuneDetector::Run(Frame &frame) {
-    image_ = frame.image.clone();
-
-    // Split image's channels.
-    if (3 == image_.channels())
-        ImageSplit(image_);
-
-    // Binarize image.
-    cv::threshold(image_, image_, RuneDetectorDebug::Instance().SplitGrayThresh(), 255, cv::THRESH_BINARY);
+    const cv::Mat &image = frame.Image();
+    const auto start_time = std::chrono::steady_clock::now();
+
+    // Track in the bounding box of annulus when rotation direction is decided and center R is found in last frame.
+    const cv::Rect full_frame({0, 0}, image.size());
+    frame_size_ = image.size();
+    roi_ = full_frame;
+    if (0 != clockwise_ && radius_ > 0 && energy_center_r_ != cv::Point2f(0, 0)) {
+        const auto outer_radius = float(radius_ * kAnnulusScale);
+        roi_ = cv::Rect(cv::Point(energy_center_r_ - cv::Point2f(outer_radius, outer_radius)),
+                        cv::Point(energy_center_r_ + cv::Point2f(outer_radius, outer_radius))) & full_frame;
+        if (roi_.empty())
+            roi_ = full_frame;
+    }
+    const bool tracking = roi_ != full_frame;
+    bool lost = false;
 
-    ImageMorphologyEx(image_);
+    ImagePreprocess(image);
 
     if (0 == clockwise_)
         FindRotateDirection();
-    else
+    else if (!FindArmorCenterP(image_) && tracking) {
+        // Lost in annulus, detect again in full frame.
+        lost = true;
+        roi_ = full_frame;
+        ImagePreprocess(image);
         FindArmorCenterP(image_);
+    }
+
+    const auto time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_time).count();
+    ++statistics_.frames;
+    statistics_.average_time += time;
+    if (lost)
+        ++statistics_.lost_frames;
+    else if (tracking) {
+        ++statistics_.tracked_frames;
+        statistics_.average_tracking_time += time;
+    } else
+        statistics_.average_full_time += time;
 
     debug::Painter::Instance().DrawPoint(armor_center_p_, cv::Scalar(0, 255, 255));
     debug::Painter::Instance().DrawPoint(energy_center_r_, cv::Scalar(255, 0, 255));
@@ -56,14 +99,41 @@ PowerRune RuneDetector::Run(Frame &frame) {
             send_yaw_pitch_delay_};
 }
 
-void RuneDetector::ImageSplit(cv::Mat &image) {
-    cv::split(image, image_channels_);
-    if (Entity::Colors::kRed == color_)
-        cv::subtract(image_channels_.at(2), image_channels_.at(0), image);     // Target is red energy
-    else if (Entity::Colors::kBlue == color_)
-        cv::subtract(image_channels_.at(0), image_channels_.at(2), image);     // Target is blue energy
+void RuneDetector::Track(double radius) {
+    radius_ = std::max(radius, 0.);
+}
+
+RuneDetector::Statistics RuneDetector::GetStatistics() const {
+    auto statistics = statistics_;
+    const auto full_frames = statistics.frames - statistics.tracked_frames - statistics.lost_frames;
+    if (statistics.frames)
+        statistics.average_time /= double(statistics.frames);
+    if (statistics.tracked_frames)
+        statistics.average_tracking_time /= double(statistics.tracked_frames);
+    if (full_frames)
+        statistics.average_full_time /= double(full_frames);
+    return statistics;
+}
+
+void RuneDetector::ImagePreprocess(const cv::Mat &image) {
+    const cv::Mat roi_image = image(roi_);
+    if (3 == roi_image.channels())
+        ImageBinarize(roi_image);
     else
+        cv::threshold(roi_image, image_, RuneDetectorDebug::Instance().SplitGrayThresh(), 255, cv::THRESH_BINARY);
+
+    ImageMorphologyEx(image_);
+}
+
+void RuneDetector::ImageBinarize(const cv::Mat &image) {
+    if (Entity::Colors::kRed == color_ || Entity::Colors::kBlue == color_)
+        color_difference::Threshold(image, image_, Entity::Colors::kRed == color_,
+                                    RuneDetectorDebug::Instance().SplitGrayThresh());
+    else {
         LOG(ERROR) << "Input wrong color " << color_ << " of power rune.";
+        image_.create(image.size(), CV_8UC1);
+        image_.setTo(0);
+    }
 }
 
 void RuneDetector::ImageMorphologyEx(cv::Mat &image) {
@@ -83,9 +153,12 @@ bool RuneDetector::FindCenterR(cv::Mat &image) {
     std::vector<cv::Point2f> possible_center_r;
     found_energy_center_r = false;
 
-    // Find possible center points by contour's area.
-    for (auto &fan_contour: fan_contours_) {
-        cv::RotatedRect encircle_r_rect = cv::minAreaRect(fan_contour);
+    // Find possible center points by contour's area, tracing contours only for large enough blobs.
+    for (const auto &blob: blobs_) {
+        if (MaxEncircleArea(blob) <= RuneDetectorDebug::Instance().MinRBoundingBoxArea())
+            continue;
+        blob_labeler_.Contour(blob, contour_);
+        cv::RotatedRect encircle_r_rect = cv::minAreaRect(contour_);
         double encircle_rect_area = encircle_r_rect.size.area();
         if (encircle_rect_area > float(RuneDetectorDebug::Instance().MinRBoundingBoxArea())
             && encircle_rect_area < float(RuneDetectorDebug::Instance().MaxRBoundingBoxArea())
@@ -112,10 +185,10 @@ bool RuneDetector::FindCenterR(cv::Mat &image) {
         else
             direction_vec = -vec;
 
-        if (debug_) {
-            cv::line(image, fan_rect_points_[0], fan_rect_points_[1],
-                     cv::Scalar_<double>(255, 0, 0), 3);
-        }
+        // Points are in frame coordinates while image is a ROI when tracking, so draw on the frame.
+        if (debug_)
+            debug::Painter::Instance().DrawLine(fan_rect_points_[0], fan_rect_points_[1],
+                                                cv::Scalar_<double>(255, 0, 0), 3);
     } else {
         cv::Point2f vec = fan_rect_points_[1] - fan_rect_points_[2];
         if (possible_ptr_vec.dot(vec) > 0)
@@ -123,10 +196,9 @@ bool RuneDetector::FindCenterR(cv::Mat &image) {
         else
             direction_vec = -vec;
 
-        if (debug_) {
-            cv::line(image, fan_rect_points_[2], fan_rect_points_[1],
-                     cv::Scalar_<double>(255, 0, 0), 3);
-        }
+        if (debug_)
+            debug::Painter::Instance().DrawLine(fan_rect_points_[2], fan_rect_points_[1],
+                                                cv::Scalar_<double>(255, 0, 0), 3);
     }
 
     cv::Point2f new_fan_encircle_rect_center = fan_encircle_rect_.center + (direction_vec * .75);
@@ -170,25 +242,26 @@ bool RuneDetector::FindCenterR(cv::Mat &image) {
 }
 
 bool RuneDetector::FindArmorCenterP(cv::Mat &image) {
-    // Find the blade contour in the image and establish the contour hierarchy.
-    cv::findContours(image, fan_contours_,
-                     fan_hierarchies_,
-                     cv::RETR_TREE,
-                     cv::CHAIN_APPROX_SIMPLE);
-
-    if (debug_) {
-        debug::Painter::Instance().DrawContours(fan_contours_, cv::Scalar(255, 255, 0));
-        cv::imshow("image", image);
-        cv::waitKey(1);
-    }
+    // Label blobs in the image and establish their enclosing relations.
+    // Blobs are offset to frame coordinate when image is a ROI.
+    blob_labeler_(image, blobs_, roi_.tl());
+    fan_contours_.clear();
 
-    found_energy_center_r = false;
+    found_energy_center_r = found_armor_center_p = found_fan_center_g = false;
+
+    if (!blobs_.empty()) {
+        // Traverse top-level blobs, most of them are rejected by statistics before tracing contours.
+        for (const auto &fan: blobs_) {
+            if (fan.hole || fan.parent >= 0)
+                continue;
+            if (MaxEncircleArea(fan) < RuneDetectorDebug::Instance().MinBoundingBoxArea()
+                || fan.filled_area <= RuneDetectorDebug::Instance().MinContourArea())
+                continue;
 
-    if (!fan_hierarchies_.empty()) {
-        // Traverse the contour according to the horizontal relationship.
-        for (int i = 0; i >= 0; i = fan_hierarchies_[i][0]) {
             // Find minimum enclosing rectangle for each selection.
-            fan_encircle_rect_ = cv::minAreaRect(fan_contours_[i]);
+            blob_labeler_.Contour(fan, contour_);
+            fan_contours_.push_back(contour_);
+            fan_encircle_rect_ = cv::minAreaRect(contour_);
 
             // Record enclosing rectangular area.
             const double &bounding_box_area = fan_encircle_rect_.size.area();
@@ -208,17 +281,22 @@ bool RuneDetector::FindArmorCenterP(cv::Mat &image) {
                   big_encircle_rect_wh_ratio < RuneDetectorDebug::Instance().MaxBoundingBoxWHRatio()))
                 continue;
 
-            double contour_area = cv::contourArea(fan_contours_[i]);  ///< Contour area.
+            double contour_area = cv::contourArea(contour_);  ///< Contour area.
 
             // Continue if contour area satisfies limits.
             if (contour_area > RuneDetectorDebug::Instance().MinContourArea() &&
                 contour_area < RuneDetectorDebug::Instance().MaxContourArea()) {
-                // Traverse the sub contour, in case not falling into small cavities.
-                for (int next_son = fan_hierarchies_[i][2]; next_son >= 0; next_son = fan_hierarchies_[next_son][0]) {
-                    armor_encircle_rect_ = cv::minAreaRect(fan_contours_[next_son]);
+                // Traverse the holes, in case not falling into small cavities.
+                for (const int child: fan.children) {
+                    const auto &armor = blobs_[child];
+                    if (MaxEncircleArea(armor) <= RuneDetectorDebug::Instance().MinArmorArea()
+                        || armor.area >= RuneDetectorDebug::Instance().MaxArmorArea())
+                        continue;
+
+                    blob_labeler_.Contour(armor, contour_);
+                    armor_encircle_rect_ = cv::minAreaRect(contour_);
                     double armor_rect_area = armor_encircle_rect_.size.area();
 
-
                     auto armor_encircle_rect_height = int(armor_encircle_rect_.size.height);
                     auto armor_encircle_rect_width = int(armor_encircle_rect_.size.width);
 
@@ -251,6 +329,16 @@ bool RuneDetector::FindArmorCenterP(cv::Mat &image) {
             }
         }
 
+        if (debug_) {
+            debug::Painter::Instance().DrawContours(fan_contours_, cv::Scalar(255, 255, 0));
+            // Show binarized ROI at its place in frame, the rest is black when tracking.
+            debug_image_.create(frame_size_, image.type());
+            debug_image_.setTo(0);
+            image.copyTo(debug_image_(roi_));
+            cv::imshow("image", debug_image_);
+            cv::waitKey(1);
+        }
+
         if (!found_armor_center_p)
             LOG(ERROR) << "No P point found! ";
         // Do not change this order.
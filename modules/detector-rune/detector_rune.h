@@ -11,9 +11,20 @@
 #include "data-structure/frame.h"
 #include "digital-twin/facilities/power_rune.h"
 #include "debug-tools/painter.h"
+#include "image-processing/blob_labeler.h"
 
 class RuneDetector : NO_COPY, NO_MOVE {
 public:
+    /// \brief Statistics of tracking mode.
+    struct Statistics {
+        uint64_t frames;               ///< Number of detected frames.
+        uint64_t tracked_frames;       ///< Number of frames found in annular ROI.
+        uint64_t lost_frames;          ///< Number of frames lost in annular ROI and detected again in full frame.
+        double average_time;           ///< Average detection time in milliseconds.
+        double average_tracking_time;  ///< Average detection time of frames found in annular ROI.
+        double average_full_time;      ///< Average detection time of frames only detected in full frame.
+    };
+
     [[maybe_unused]] explicit RuneDetector(Entity::Colors color = Entity::Colors::kBlue, bool debug = false);
 
     ~RuneDetector() = default;
@@ -33,9 +44,27 @@ public:
      */
     bool Initialize(const std::string &config_path, const Frame &frame, bool debug_use_trackbar = false);
 
+    /**
+     * \brief Set radius of annulus to track power rune from next frame.
+     * \details Armor P and fan G always lie on a known radius around center R, so when rotation direction is decided
+     *   and center R is found in last frame, only the bounding box of the annulus around R is detected.
+     *   Full frame is detected again in the same frame when the rune is lost in it.
+     * \param [in] radius Radius from center R to armor center P in pixels, usually RunePredictor::CalRadius(),
+     *   0 to always detect in full frame.
+     */
+    void Track(double radius);
+
+    ATTR_READER_REF(roi_, Roi)
+
+    /// \return Statistics of tracking mode.
+    [[nodiscard]] Statistics GetStatistics() const;
+
 private:
-    /// Split RGB channels of the frame
-    void ImageSplit(cv::Mat &image);
+    /// Binarize and apply morphological operation to the ROI of the frame
+    void ImagePreprocess(const cv::Mat &image);
+
+    /// Binarize difference of target color and the opposite color of a BGR frame
+    void ImageBinarize(const cv::Mat &image);
 
     /// Frame morphological operation
     static void ImageMorphologyEx(cv::Mat &image);
@@ -57,11 +86,17 @@ private:
     bool found_fan_center_g;     ///< Whether fan center G is found.
     bool debug_;                 ///< Debug flag.
 
-    cv::Mat image_;              ///< Initial input image.
+    cv::Mat image_;              ///< Binarized ROI of input image, buffer is reused between frames.
+    cv::Rect roi_;               ///< ROI of current frame, the whole frame when not tracking.
+    cv::Size frame_size_;        ///< Size of current frame.
+    cv::Mat debug_image_;        ///< Binarized image in frame coordinates, only for debug.
+    double radius_;              ///< Radius from center R to armor center P for tracking, 0 when not tracking.
+    Statistics statistics_;      ///< Statistics, with total times in average fields.
     cv::Point2f fan_rect_points_[4];
-    std::vector<cv::Mat> image_channels_;
-    std::vector<std::vector<cv::Point>> fan_contours_;
-    std::vector<cv::Vec4i> fan_hierarchies_;
+    BlobLabeler blob_labeler_;
+    std::vector<Blob> blobs_;
+    std::vector<cv::Point> contour_;
+    std::vector<std::vector<cv::Point>> fan_contours_;  ///< Contours of blobs examined as fans, for debug.
     cv::RotatedRect fan_encircle_rect_;
     cv::RotatedRect armor_encircle_rect_;
     const cv::Point2f offset_center_r_;
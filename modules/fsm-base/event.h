@@ -7,6 +7,7 @@
 #ifndef EVENT_H_
 #define EVENT_H_
 
+#include <future>
 #include "fsm_base_types.h"
 
 namespace fsm {
@@ -49,6 +50,8 @@ namespace fsm {
     protected:
         MachineSetWeakPtr machine_set_;
         MachineBaseWeakPtrVec target_machines_;
+        /// Fulfilled with whether this event is handled, only for events enqueued by MachineSet::EnqueueWithFuture.
+        std::shared_ptr<std::promise<bool>> completion_;
     };
 
     /**
@@ -29,6 +29,9 @@ namespace fsm {
 
         T Next(unsigned int timeout);
 
+        /// \brief Take the first message without waiting, even a timeout of 0 waits on timers of system.
+        T TryNext();
+
         void Clear();
 
         bool MessageAvailable() const;
@@ -86,7 +89,8 @@ namespace fsm {
     template<class T>
     T EventQueue<T>::Next(unsigned int timeout) {
         T first_message;
-        auto now = std::chrono::system_clock::now();
+        // Waiting is real, only the polling period of background thread depends on it.
+        auto now = std::chrono::steady_clock::now();
         std::unique_lock<std::mutex> lock(mutex_);
         bool signaled = condition_.wait_until(lock,
                                               now + std::chrono::milliseconds(timeout),
@@ -99,6 +103,17 @@ namespace fsm {
         return first_message;
     }
 
+    template<class T>
+    T EventQueue<T>::TryNext() {
+        T first_message;
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!queue_.empty()) {
+            first_message = std::move(queue_.front());
+            queue_.pop_front();
+        }
+        return first_message;
+    }
+
     template<class T>
     bool EventQueue<T>::MessageAvailable() const {
         std::lock_guard<std::mutex> lock(mutex_);
@@ -4,10 +4,11 @@
 #include "transition.h"
 #include "machine.h"
 #include "machine_set.h"
+#include "clock/clock.h"
 
+/// \return Time of global clock in milliseconds, so that timeouts follow frames in replays.
 uint64_t GetTime() {
-    return std::chrono::duration_cast<std::chrono::milliseconds>(
-            std::chrono::system_clock::now().time_since_epoch()).count();
+    return Clock::Global().Now() / 1000000;
 }
 
 namespace fsm {
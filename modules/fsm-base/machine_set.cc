@@ -22,6 +22,22 @@ namespace fsm {
         }
     }
 
+    [[maybe_unused]] std::future<bool> MachineSet::EnqueueWithFuture(EventSharedPtr event) {
+        event->completion_ = std::make_shared<std::promise<bool>>();
+        auto future = event->completion_->get_future();
+        Enqueue(std::move(event));
+        return future;
+    }
+
+    [[maybe_unused]] bool MachineSet::Dispatch(EventSharedPtr event) {
+        event->machine_set_ = shared_from_this();
+        std::lock_guard<std::recursive_mutex> lock(process_mutex_);
+        // Never block here, background thread may take the last event after it is found available.
+        while (auto queued_event = event_queue_.TryNext())
+            InternalProcess(queued_event);
+        return InternalProcess(event);
+    }
+
     [[maybe_unused]] void MachineSet::RegisterHandler(MachineSetHandlerSharedPtr handler) {
         event_handler_ = std::move(handler);
     }
@@ -64,8 +80,9 @@ namespace fsm {
     }
 
     [[maybe_unused]] void MachineSet::Process() {
-        while (event_queue_.MessageAvailable())
-            Process(event_queue_.Next());
+        std::lock_guard<std::recursive_mutex> lock(process_mutex_);
+        while (auto event = event_queue_.TryNext())
+            InternalProcess(event);
         InternalProcessTimeoutEvent();
     }
 
@@ -99,6 +116,12 @@ namespace fsm {
     }
 
     void MachineSet::Process(const EventSharedPtr &event) {
+        std::lock_guard<std::recursive_mutex> lock(process_mutex_);
+        InternalProcess(event);
+    }
+
+    bool MachineSet::InternalProcess(const EventSharedPtr &event) {
+        bool handled = false;
         try {
             auto operate_machine_event = std::dynamic_pointer_cast<MachineOperationEvent>(event);
             if (operate_machine_event) {
@@ -107,28 +130,35 @@ namespace fsm {
                 } else if (MachineOperator::kRemove == operate_machine_event->type()) {
                     RemoveMachine(operate_machine_event->machine());
                 }
+                handled = true;
+            } else {
+                DLOG(INFO) << "Handling event: " << event->ToString() << ".";
 
-                return;
-            }
-
-            LOG(INFO) << "Handling event: " << event->ToString() << ".";
-
-            bool handled = event->target_machines_.empty() ?
-                           ProcessNoTargetMachineEvent(event) : ProcessTargetMachineEvent(event);
+                handled = event->target_machines_.empty() ?
+                          ProcessNoTargetMachineEvent(event) : ProcessTargetMachineEvent(event);
 
-            if (!handled) {
-                LOG(ERROR) << "Unhandled event: " << event->ToString() << ".";
+                if (!handled) {
+                    LOG(ERROR) << "Unhandled event: " << event->ToString() << ".";
+                }
             }
         } catch (std::exception &e) {
             LOG(ERROR) << __FUNCTION__ << " | caught exception: " << e.what() << ".";
-            OnProcessError();
+            if (OnProcessError)
+                OnProcessError();
         } catch (...) {
             LOG(ERROR) << __FUNCTION__ << " | caught unknown exception.";
-            OnProcessError();
+            if (OnProcessError)
+                OnProcessError();
+        }
+        if (event->completion_) {
+            event->completion_->set_value(handled);
+            event->completion_.reset();
         }
+        return handled;
     }
 
     void MachineSet::ProcessTimeoutMachine(const MachineBaseSharedPtr &machine) {
+        std::lock_guard<std::recursive_mutex> lock(process_mutex_);
         auto found = machine_set_.find(machine);
         if (found != machine_set_.end()) {
             auto state_machine = std::dynamic_pointer_cast<StateMachine>(*found);
@@ -162,8 +192,9 @@ namespace fsm {
             background_thread_ = std::make_unique<std::thread>([&, sleep_time]() {
                 while (!background_thread_stop_flag_.load()) {
                     EventSharedPtr event = event_queue_.Next(sleep_time);
+                    std::lock_guard<std::recursive_mutex> lock(process_mutex_);
                     if (event) {
-                        Process(event);
+                        InternalProcess(event);
                     }
                     InternalProcessTimeoutEvent();
                 }
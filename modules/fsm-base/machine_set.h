@@ -5,6 +5,8 @@
 #include <thread>
 #include <functional>
 #include <atomic>
+#include <future>
+#include <mutex>
 #include "event_queue.h"
 #include "machine.h"
 
@@ -27,6 +29,23 @@ namespace fsm {
 
         [[maybe_unused]] void Enqueue(EventSharedPtr event);
 
+        /**
+         * \brief Enqueue an event and get notified when it is processed.
+         * \param [in] event Event to process in background thread or by Process().
+         * \return Future of whether event is handled by any machine.
+         * \note Future gets std::future_error when event is dropped without processing, e.g. when set is destroyed.
+         */
+        [[maybe_unused]] [[nodiscard]] std::future<bool> EnqueueWithFuture(EventSharedPtr event);
+
+        /**
+         * \brief Process an event on the caller's thread, for machines whose transitions are latency-critical.
+         * \details Events waiting in queue are processed first to keep their order. Processing is serialized with
+         *   background thread, so that machines never run in two threads at the same time.
+         * \param [in] event Event to process.
+         * \return Whether event is handled by any machine, i.e. all transitions caused by it have finished.
+         */
+        [[maybe_unused]] bool Dispatch(EventSharedPtr event);
+
         [[maybe_unused]] void StartBackground(unsigned int sleep_time);
 
         void StopBackground();
@@ -62,6 +81,9 @@ namespace fsm {
 
         void InternalProcessTimeoutEvent();
 
+        /// \brief Process an event and fulfill its completion, with process_mutex_ locked.
+        bool InternalProcess(const EventSharedPtr &event);
+
         typedef std::vector<MachineBaseSharedPtr> MachinePtrList;
         typedef std::set<MachineBaseSharedPtr> MachinePtrSet;
 
@@ -74,6 +96,9 @@ namespace fsm {
 
         [[maybe_unused]] std::thread::id owner_thread_id_;
 
+        /// Serialize processing in background thread and callers' threads, recursive for dispatching in callbacks.
+        std::recursive_mutex process_mutex_;
+
         std::atomic<bool> background_thread_stop_flag_;
         std::unique_ptr<std::thread> background_thread_;
     };
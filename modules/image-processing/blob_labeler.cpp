@@ -0,0 +1,132 @@
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <opencv2/imgproc.hpp>
+#include <glog/logging.h>
+#include "blob_labeler.h"
+
+namespace {
+    /// \brief Make a blob from statistics of a label.
+    Blob MakeBlob(int label, bool hole, const cv::Mat &stats, const cv::Mat &centroids, const double *moments,
+                  const cv::Point &offset) {
+        const int *stat = stats.ptr<int>(label);
+        const double *centroid = centroids.ptr<double>(label);
+        Blob blob;
+        blob.label = label;
+        blob.hole = hole;
+        blob.area = blob.filled_area = stat[cv::CC_STAT_AREA];
+        blob.bounding_box = {stat[cv::CC_STAT_LEFT] + offset.x, stat[cv::CC_STAT_TOP] + offset.y,
+                             stat[cv::CC_STAT_WIDTH], stat[cv::CC_STAT_HEIGHT]};
+        blob.centroid = {float(centroid[0]) + float(offset.x), float(centroid[1]) + float(offset.y)};
+        blob.mu20 = float(moments[0] / blob.area - centroid[0] * centroid[0]);
+        blob.mu11 = float(moments[1] / blob.area - centroid[0] * centroid[1]);
+        blob.mu02 = float(moments[2] / blob.area - centroid[1] * centroid[1]);
+        blob.parent = -1;
+        return blob;
+    }
+
+    /// \brief Find a row of the left-most column of a label, whose left neighbor is in the enclosing component.
+    int LeftMostRow(const cv::Mat &labels, int label, const cv::Rect &bounding_box) {
+        for (int y = bounding_box.y; y < bounding_box.y + bounding_box.height; ++y)
+            if (labels.at<int>(y, bounding_box.x) == label)
+                return y;
+        return bounding_box.y;
+    }
+}
+
+cv::RotatedRect Blob::EquivalentRect() const {
+    // A w x h rectangle has variances of w^2 / 12 and h^2 / 12 along its edges.
+    const float common = (mu20 + mu02) / 2;
+    const float difference = std::sqrt((mu20 - mu02) * (mu20 - mu02) / 4 + mu11 * mu11);
+    const float angle = 0.5f * std::atan2(2 * mu11, mu20 - mu02) * float(180 / CV_PI);
+    return {centroid, {std::sqrt(12 * std::max(common + difference, 0.f)),
+                       std::sqrt(12 * std::max(common - difference, 0.f))}, angle};
+}
+
+bool BlobLabeler::operator()(const cv::Mat &binary, std::vector<Blob> &blobs, const cv::Point &offset) const {
+    blobs.clear();
+    if (binary.empty() || binary.type() != CV_8UC1) {
+        LOG(ERROR) << "Unsupported image type " << binary.type() << " to label blobs.";
+        return false;
+    }
+    offset_ = offset;
+
+    const int num_labels = cv::connectedComponentsWithStats(binary, labels_, stats_, centroids_, 8, CV_32S);
+    cv::compare(binary, 0, inverse_, cv::CMP_EQ);
+    const int num_hole_labels = cv::connectedComponentsWithStats(inverse_, hole_labels_, hole_stats_,
+                                                                 hole_centroids_, 4, CV_32S);
+
+    // Raw second moments of all labels in one pass, every pixel is either foreground or background.
+    moments_.assign(3 * (num_labels + num_hole_labels), 0);
+    double *moments = moments_.data(), *hole_moments = moments + 3 * num_labels;
+    for (int y = 0; y < binary.rows; ++y) {
+        const int *label_row = labels_.ptr<int>(y), *hole_row = hole_labels_.ptr<int>(y);
+        for (int x = 0; x < binary.cols; ++x) {
+            double *m = label_row[x] ? moments + 3 * label_row[x] : hole_moments + 3 * hole_row[x];
+            m[0] += double(x * x), m[1] += double(x * y), m[2] += double(y * y);
+        }
+    }
+
+    for (int label = 1; label < num_labels; ++label)
+        blobs.emplace_back(MakeBlob(label, false, stats_, centroids_, moments + 3 * label, offset));
+    hole_indices_.assign(num_hole_labels, -1);
+    for (int label = 1; label < num_hole_labels; ++label) {
+        const int *stat = hole_stats_.ptr<int>(label);
+        if (stat[cv::CC_STAT_LEFT] == 0 || stat[cv::CC_STAT_TOP] == 0
+            || stat[cv::CC_STAT_LEFT] + stat[cv::CC_STAT_WIDTH] == binary.cols
+            || stat[cv::CC_STAT_TOP] + stat[cv::CC_STAT_HEIGHT] == binary.rows)
+            continue;
+        hole_indices_[label] = int(blobs.size());
+        blobs.emplace_back(MakeBlob(label, true, hole_stats_, hole_centroids_, hole_moments + 3 * label, offset));
+    }
+
+    // Left neighbor of the left-most pixel of a component is in the other kind of component enclosing it,
+    // otherwise they are connected.
+    for (size_t i = 0; i < blobs.size(); ++i) {
+        auto &blob = blobs[i];
+        const auto &labels = blob.hole ? hole_labels_ : labels_;
+        const cv::Rect bounding_box = blob.bounding_box - offset;
+        if (bounding_box.x == 0)
+            continue;
+        const int y = LeftMostRow(labels, blob.label, bounding_box);
+        if (blob.hole)
+            blob.parent = labels_.at<int>(y, bounding_box.x - 1) - 1;
+        else
+            blob.parent = hole_indices_[hole_labels_.at<int>(y, bounding_box.x - 1)];
+        if (blob.parent >= 0)
+            blobs[blob.parent].children.push_back(int(i));
+    }
+
+    // Enclosed blobs have smaller bounding boxes, so they are filled before their parents.
+    order_.resize(blobs.size());
+    std::iota(order_.begin(), order_.end(), 0);
+    std::sort(order_.begin(), order_.end(), [&](int a, int b) {
+        return blobs[a].bounding_box.area() < blobs[b].bounding_box.area();
+    });
+    for (const int i: order_)
+        if (blobs[i].parent >= 0)
+            blobs[blobs[i].parent].filled_area += blobs[i].filled_area;
+    return true;
+}
+
+void BlobLabeler::Contour(const Blob &blob, std::vector<cv::Point> &contour) const {
+    contour.clear();
+    if (!blob.hole) {
+        const cv::Rect rect = blob.bounding_box - offset_;
+        cv::compare(labels_(rect), blob.label, mask_, cv::CMP_EQ);
+        cv::findContours(mask_, contours_, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE, rect.tl() + offset_);
+    } else {
+        // Holes never touch image border, so the foreground pixels around them are in image.
+        const cv::Rect rect(blob.bounding_box.x - offset_.x - 1, blob.bounding_box.y - offset_.y - 1,
+                            blob.bounding_box.width + 2, blob.bounding_box.height + 2);
+        cv::compare(hole_labels_(rect), blob.label, mask_, cv::CMP_EQ);
+        cv::dilate(mask_, mask_, cv::Mat());
+        cv::findContours(mask_, contours_, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE, rect.tl() + offset_);
+    }
+    if (contours_.empty())
+        return;
+    contour.swap(*std::max_element(contours_.begin(), contours_.end(),
+                                   [](const std::vector<cv::Point> &a, const std::vector<cv::Point> &b) {
+                                       return a.size() < b.size();
+                                   }));
+}
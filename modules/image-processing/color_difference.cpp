@@ -0,0 +1,82 @@
+#include <algorithm>
+#include <cstring>
+#include <glog/logging.h>
+#include "math-tools/hardware_acceleration.h"
+#include "color_difference.h"
+
+namespace {
+#if defined(USE_SSE2)
+
+    /// \brief Split 16 interleaved pixels into blue and red lanes, with unpacking only (no SSSE3 shuffle).
+    inline void LoadBlueRedX16(const uint8_t *p, __m128i &blue, __m128i &red) {
+        __m128i a = _mm_loadu_si128((const __m128i *) p);
+        __m128i b = _mm_loadu_si128((const __m128i *) (p + 16));
+        __m128i c = _mm_loadu_si128((const __m128i *) (p + 32));
+
+        // Each round interleaves the 3 vectors by bytes, and 4 rounds sort 48 bytes by channel.
+        // Green lanes of the last round are not needed.
+        for (int round = 0; round < 3; ++round) {
+            const __m128i x = _mm_unpacklo_epi8(a, _mm_unpackhi_epi64(b, b));
+            const __m128i y = _mm_unpacklo_epi8(_mm_unpackhi_epi64(a, a), c);
+            const __m128i z = _mm_unpacklo_epi8(b, _mm_unpackhi_epi64(c, c));
+            a = x, b = y, c = z;
+        }
+        blue = _mm_unpacklo_epi8(a, _mm_unpackhi_epi64(b, b));
+        red = _mm_unpacklo_epi8(b, _mm_unpackhi_epi64(c, c));
+    }
+
+#endif
+}
+
+bool color_difference::Threshold(const cv::Mat &bgr, cv::Mat &mask, bool red, int threshold, int num_bands) {
+    if (bgr.empty() || bgr.type() != CV_8UC3) {
+        LOG(ERROR) << "Unsupported image type " << bgr.type() << " to threshold color difference.";
+        return false;
+    }
+    mask.create(bgr.size(), CV_8UC1);
+    if (num_bands <= 0)
+        num_bands = std::max(cv::getNumThreads(), 1);
+    num_bands = std::min(num_bands, bgr.rows);
+
+    cv::parallel_for_(cv::Range(0, num_bands), [&](const cv::Range &range) {
+        for (int band = range.start; band < range.end; ++band)
+            ThresholdRows(bgr, mask, red, threshold,
+                          bgr.rows * band / num_bands,
+                          bgr.rows * (band + 1) / num_bands);
+    }, num_bands);
+    return true;
+}
+
+void color_difference::ThresholdRows(const cv::Mat &bgr, cv::Mat &mask, bool red, int threshold,
+                                     int row_begin, int row_end) {
+    // Differences are in [0, 255], so other thresholds give constant masks.
+    if (threshold < 0 || threshold >= 255) {
+        for (int y = row_begin; y < row_end; ++y)
+            std::memset(mask.ptr<uint8_t>(y), threshold < 0 ? 255 : 0, bgr.cols);
+        return;
+    }
+
+    const int own_channel = red ? 2 : 0, other_channel = 2 - own_channel;
+    for (int y = row_begin; y < row_end; ++y) {
+        const auto *pixel = bgr.ptr<uint8_t>(y);
+        auto *output = mask.ptr<uint8_t>(y);
+        int x = 0;
+#if defined(USE_SSE2)
+        const __m128i threshold_x16 = _mm_set1_epi8(char(threshold));
+        const __m128i ones = _mm_set1_epi8(-1);
+        for (; x + 16 <= bgr.cols; x += 16) {
+            __m128i blue, red_x16;
+            LoadBlueRedX16(pixel + 3 * x, blue, red_x16);
+            const __m128i difference = red ? _mm_subs_epu8(red_x16, blue) : _mm_subs_epu8(blue, red_x16);
+            // difference > threshold <=> saturated (difference - threshold) != 0.
+            const __m128i result = _mm_xor_si128(
+                    _mm_cmpeq_epi8(_mm_subs_epu8(difference, threshold_x16), _mm_setzero_si128()), ones);
+            _mm_storeu_si128((__m128i *) (output + x), result);
+        }
+#endif
+        for (; x < bgr.cols; ++x) {
+            const int difference = pixel[3 * x + own_channel] - pixel[3 * x + other_channel];
+            output[x] = difference > threshold ? 255 : 0;
+        }
+    }
+}
@@ -0,0 +1,35 @@
+/**
+ * Color difference threshold functions header.
+ * \author trantuan-20048607
+ * \date 2022.3.30
+ * \details Binarize BGR24 images by difference of red and blue channels in a single pass,
+ *   accelerated by SSE2 (or NEON on arm), without splitting channels into temporary images.
+ */
+
+#ifndef COLOR_DIFFERENCE_H_
+#define COLOR_DIFFERENCE_H_
+
+#include <opencv2/core/core.hpp>
+
+namespace color_difference {
+    /**
+     * \brief Binarize a BGR image by color difference.
+     * \details Same as cv::split, cv::subtract and cv::threshold(THRESH_BINARY) in sequence,
+     *   that is, a pixel is 255 when saturated (own - other) > threshold and 0 otherwise.
+     * \param [in] bgr Source CV_8UC3 image.
+     * \param [out] mask Output CV_8UC1 image. Existing buffer will be used when its size and type match.
+     * \param [in] red Own channel is red when true (red - blue), and blue when false (blue - red).
+     * \param [in] threshold Binarization threshold.
+     * \param [in] num_bands Number of row bands processed at the same time, 0 to use the number of OpenCV threads.
+     * \return Whether image is binarized.
+     */
+    bool Threshold(const cv::Mat &bgr, cv::Mat &mask, bool red, int threshold, int num_bands = 0);
+
+    /**
+     * \brief Binarize rows in [row_begin, row_end) of a BGR image.
+     * \details Output image must be allocated. No parameter is checked in this function.
+     */
+    void ThresholdRows(const cv::Mat &bgr, cv::Mat &mask, bool red, int threshold, int row_begin, int row_end);
+}
+
+#endif  // COLOR_DIFFERENCE_H_
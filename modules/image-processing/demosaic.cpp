@@ -0,0 +1,304 @@
+#include <vector>
+#include <glog/logging.h>
+#include "math-tools/hardware_acceleration.h"
+#include "demosaic.h"
+
+namespace {
+    /// \brief Reflect index out of border without changing its Bayer parity.
+    inline int Reflect(int i, int n) {
+        return i < 0 ? -i : (i >= n ? 2 * n - 2 - i : i);
+    }
+
+    /// \brief Divide by 2^n with rounding and saturate to 8 bits.
+    inline uint8_t Scale(int value, int n) {
+        if (n)
+            value = (value + (1 << (n - 1))) >> n;
+        return value > 255 ? 255 : uint8_t(value);
+    }
+
+    /**
+     * \brief Interpolate a single pixel.
+     * \details In a row, "row color" is the non-green color in this row, and "other color" is the other one.
+     */
+    template<typename T>
+    inline void InterpolatePixel(const T *up, const T *cur, const T *down,
+                                 int x, int width, bool color_pixel, int shift,
+                                 uint8_t &row_color, uint8_t &green, uint8_t &other_color) {
+        const int left = Reflect(x - 1, width), right = Reflect(x + 1, width);
+        const int horizontal = cur[left] + cur[right];
+        const int vertical = up[x] + down[x];
+        if (color_pixel) {
+            const int diagonal = up[left] + up[right] + down[left] + down[right];
+            row_color = Scale(cur[x], shift);
+            green = Scale(horizontal + vertical, shift + 2);
+            other_color = Scale(diagonal, shift + 2);
+        } else {
+            row_color = Scale(horizontal, shift + 1);
+            green = Scale(cur[x], shift);
+            other_color = Scale(vertical, shift + 1);
+        }
+    }
+
+#if defined(USE_SSE2)
+
+    /// \brief Load 8 pixels and extend them to 16 bits.
+    inline __m128i Load8(const uint8_t *p) {
+        return _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *) p), _mm_setzero_si128());
+    }
+
+    inline __m128i Load8(const uint16_t *p) {
+        return _mm_loadu_si128((const __m128i *) p);
+    }
+
+    /// \brief Divide 16 bit values by 2^n with rounding.
+    inline __m128i ScaleX8(__m128i value, int n) {
+        if (!n)
+            return value;
+        return _mm_srl_epi16(_mm_add_epi16(value, _mm_set1_epi16(short(1 << (n - 1)))), _mm_cvtsi32_si128(n));
+    }
+
+    inline __m128i Select(__m128i mask, __m128i a, __m128i b) {
+        return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+    }
+
+    /// \brief Compact 4 pixels in BGR0 format to 12 bytes of BGR format, the last 4 bytes are garbage.
+    inline __m128i CompactBGR0(__m128i pixels) {
+        const __m128i mask_0 = _mm_set_epi32(0, 0, 0, -1);
+        const __m128i mask_1 = _mm_set_epi32(0, 0, -1, 0);
+        const __m128i mask_2 = _mm_set_epi32(0, -1, 0, 0);
+        const __m128i mask_3 = _mm_set_epi32(-1, 0, 0, 0);
+        return _mm_or_si128(_mm_or_si128(_mm_and_si128(pixels, mask_0),
+                                         _mm_srli_si128(_mm_and_si128(pixels, mask_1), 1)),
+                            _mm_or_si128(_mm_srli_si128(_mm_and_si128(pixels, mask_2), 2),
+                                         _mm_srli_si128(_mm_and_si128(pixels, mask_3), 3)));
+    }
+
+#endif
+
+    template<typename T>
+    void ConvertRows(const cv::Mat &raw, cv::Mat &bgr, demosaic::BayerPattern pattern, int bits,
+                     int row_begin, int row_end) {
+        const int width = raw.cols, height = raw.rows, shift = bits - 8;
+        const int red_row = int(pattern) >> 1, red_col = int(pattern) & 1;
+
+        for (int y = row_begin; y < row_end; ++y) {
+            const T *up = raw.ptr<T>(Reflect(y - 1, height));
+            const T *cur = raw.ptr<T>(y);
+            const T *down = raw.ptr<T>(Reflect(y + 1, height));
+            auto *out = bgr.ptr<uint8_t>(y);
+
+            const bool red_in_row = (y & 1) == red_row;
+            const int color_col = red_in_row ? red_col : 1 - red_col;  // Column parity of non-green pixels.
+            const int row_color_channel = red_in_row ? 2 : 0, other_color_channel = 2 - row_color_channel;
+
+            auto scalar_pixel = [&](int x) {
+                uint8_t row_color, green, other_color;
+                InterpolatePixel(up, cur, down, x, width, (x & 1) == color_col, shift,
+                                 row_color, green, other_color);
+                out[3 * x + row_color_channel] = row_color;
+                out[3 * x + 1] = green;
+                out[3 * x + other_color_channel] = other_color;
+            };
+
+            int x = 0;
+#if defined(USE_SSE2)
+            // Start at an even column, so that lane parity equals column parity.
+            for (; x < 2 && x < width; ++x)
+                scalar_pixel(x);
+
+            const __m128i color_mask = color_col ? _mm_set_epi16(-1, 0, -1, 0, -1, 0, -1, 0)
+                                                 : _mm_set_epi16(0, -1, 0, -1, 0, -1, 0, -1);
+            // Loads read [x - 1, x + 9) and stores write 4 bytes after the 8 pixels.
+            for (; x + 10 <= width; x += 8) {
+                const __m128i up_left = Load8(up + x - 1), up_center = Load8(up + x), up_right = Load8(up + x + 1);
+                const __m128i left = Load8(cur + x - 1), center = Load8(cur + x), right = Load8(cur + x + 1);
+                const __m128i down_left = Load8(down + x - 1), down_center = Load8(down + x),
+                        down_right = Load8(down + x + 1);
+
+                const __m128i horizontal = _mm_add_epi16(left, right);
+                const __m128i vertical = _mm_add_epi16(up_center, down_center);
+                const __m128i diagonal = _mm_add_epi16(_mm_add_epi16(up_left, up_right),
+                                                       _mm_add_epi16(down_left, down_right));
+
+                const __m128i row_color = Select(color_mask,
+                                                 ScaleX8(center, shift),
+                                                 ScaleX8(horizontal, shift + 1));
+                const __m128i green = Select(color_mask,
+                                             ScaleX8(_mm_add_epi16(horizontal, vertical), shift + 2),
+                                             ScaleX8(center, shift));
+                const __m128i other_color = Select(color_mask,
+                                                   ScaleX8(diagonal, shift + 2),
+                                                   ScaleX8(vertical, shift + 1));
+
+                const __m128i blue = _mm_packus_epi16(red_in_row ? other_color : row_color, _mm_setzero_si128());
+                const __m128i red = _mm_packus_epi16(red_in_row ? row_color : other_color, _mm_setzero_si128());
+                const __m128i blue_green = _mm_unpacklo_epi8(blue, _mm_packus_epi16(green, _mm_setzero_si128()));
+                const __m128i red_zero = _mm_unpacklo_epi8(red, _mm_setzero_si128());
+
+                _mm_storeu_si128((__m128i *) (out + 3 * x),
+                                 CompactBGR0(_mm_unpacklo_epi16(blue_green, red_zero)));
+                _mm_storeu_si128((__m128i *) (out + 3 * x + 12),
+                                 CompactBGR0(_mm_unpackhi_epi16(blue_green, red_zero)));
+            }
+#endif
+            for (; x < width; ++x)
+                scalar_pixel(x);
+        }
+    }
+
+    bool CheckAndAllocate(const cv::Mat &raw, cv::Mat &bgr, int bits) {
+        if (raw.empty() || raw.rows < 2 || raw.cols < 2) {
+            LOG(ERROR) << "Bayer image is too small to demosaic.";
+            return false;
+        }
+        if (!((raw.type() == CV_8UC1 && bits == 8) ||
+              (raw.type() == CV_16UC1 && (bits == 10 || bits == 12)))) {
+            LOG(ERROR) << "Unsupported Bayer image type " << raw.type() << " with " << bits << " bits.";
+            return false;
+        }
+        bgr.create(raw.rows, raw.cols, CV_8UC3);
+        return true;
+    }
+
+    /// \brief Bilinear sampling position of an output pixel in source cells, the same as cv::resize.
+    struct SamplePosition {
+        int first;     ///< Index of the first cell.
+        int second;    ///< Index of the second cell.
+        float weight;  ///< Weight of the second cell.
+    };
+
+    /// \brief Sample positions of an axis, kept for the next conversion of the same sizes.
+    struct SamplePositionCache {
+        int output_size = 0;                   ///< Output size of cached positions.
+        int num_cells = 0;                     ///< Number of source cells of cached positions.
+        std::vector<SamplePosition> positions;
+    };
+
+    const std::vector<SamplePosition> &ComputeSamplePositions(SamplePositionCache &cache,
+                                                              int output_size, int num_cells) {
+        if (cache.output_size == output_size && cache.num_cells == num_cells)
+            return cache.positions;
+        cache.output_size = output_size;
+        cache.num_cells = num_cells;
+        cache.positions.resize(output_size);
+        const float scale = float(num_cells) / float(output_size);
+        for (int i = 0; i < output_size; ++i) {
+            const float position = std::max((float(i) + 0.5f) * scale - 0.5f, 0.f);
+            auto &sample = cache.positions[i];
+            sample.first = std::min(int(position), num_cells - 1);
+            sample.second = std::min(sample.first + 1, num_cells - 1);
+            sample.weight = sample.first == sample.second ? 0.f : position - float(sample.first);
+        }
+        return cache.positions;
+    }
+
+    template<typename T>
+    void ConvertTensorRows(const cv::Mat &raw, cv::Mat &tensor, demosaic::BayerPattern pattern,
+                           float factor, bool rgb,
+                           const std::vector<SamplePosition> &columns, const std::vector<SamplePosition> &rows,
+                           int row_begin, int row_end) {
+        const int num_cells = raw.cols >> 1, width = tensor.cols;
+        const int red_row = int(pattern) >> 1, red_col = int(pattern) & 1;
+        const int red_channel = rgb ? 0 : 2, blue_channel = 2 - red_channel;
+        // Row of cells is reused by each worker thread, and only grows with larger images.
+        thread_local std::vector<float> cells;
+        cells.resize(3 * num_cells);
+
+        for (int y = row_begin; y < row_end; ++y) {
+            // Vertical pass, blend 2 rows of cells into one row of RGB cells.
+            const auto &row = rows[y];
+            const int cell_rows[2] = {row.first, row.second};
+            const float weights[2] = {(1.f - row.weight) * factor, row.weight * factor};
+            std::fill(cells.begin(), cells.end(), 0.f);
+            for (int k = 0; k < (row.weight > 0 ? 2 : 1); ++k) {
+                const T *red_line = raw.ptr<T>(2 * cell_rows[k] + red_row);
+                const T *blue_line = raw.ptr<T>(2 * cell_rows[k] + 1 - red_row);
+                const float weight = weights[k], half_weight = 0.5f * weight;
+                float *cell = cells.data();
+                for (int i = 0; i < num_cells; ++i, cell += 3, red_line += 2, blue_line += 2) {
+                    cell[0] += weight * float(red_line[red_col]);
+                    cell[1] += half_weight * float(int(red_line[1 - red_col]) + int(blue_line[red_col]));
+                    cell[2] += weight * float(blue_line[1 - red_col]);
+                }
+            }
+
+            // Horizontal pass, write in output channel order.
+            auto *out = tensor.ptr<float>(y);
+            for (int x = 0; x < width; ++x, out += 3) {
+                const auto &column = columns[x];
+                const float *a = cells.data() + 3 * column.first, *b = cells.data() + 3 * column.second;
+                out[red_channel] = a[0] + column.weight * (b[0] - a[0]);
+                out[1] = a[1] + column.weight * (b[1] - a[1]);
+                out[blue_channel] = a[2] + column.weight * (b[2] - a[2]);
+            }
+        }
+    }
+}
+
+void demosaic::BayerToBGRRows(const cv::Mat &raw, cv::Mat &bgr, BayerPattern pattern, int bits,
+                              int row_begin, int row_end) {
+    if (raw.depth() == CV_8U)
+        ConvertRows<uint8_t>(raw, bgr, pattern, bits, row_begin, row_end);
+    else
+        ConvertRows<uint16_t>(raw, bgr, pattern, bits, row_begin, row_end);
+}
+
+bool demosaic::BayerToBGR(const cv::Mat &raw, cv::Mat &bgr, BayerPattern pattern, int bits) {
+    if (!CheckAndAllocate(raw, bgr, bits))
+        return false;
+    BayerToBGRRows(raw, bgr, pattern, bits, 0, raw.rows);
+    return true;
+}
+
+bool demosaic::BayerToBGRParallel(const cv::Mat &raw, cv::Mat &bgr, BayerPattern pattern, int bits,
+                                  int num_bands) {
+    if (!CheckAndAllocate(raw, bgr, bits))
+        return false;
+    if (num_bands <= 0)
+        num_bands = std::max(cv::getNumThreads(), 1);
+    num_bands = std::min(num_bands, raw.rows);
+
+    // Every band reads one row outside itself, but only writes its own rows.
+    cv::parallel_for_(cv::Range(0, num_bands), [&](const cv::Range &range) {
+        for (int band = range.start; band < range.end; ++band)
+            BayerToBGRRows(raw, bgr, pattern, bits,
+                           raw.rows * band / num_bands,
+                           raw.rows * (band + 1) / num_bands);
+    }, num_bands);
+    return true;
+}
+
+bool demosaic::BayerToTensor(const cv::Mat &raw, cv::Mat &tensor, const cv::Size &size,
+                             BayerPattern pattern, int bits, bool rgb, float scale,
+                             int num_bands) {
+    if (raw.empty() || raw.rows < 2 || raw.cols < 2 || size.width <= 0 || size.height <= 0) {
+        LOG(ERROR) << "Invalid size to convert Bayer image to tensor.";
+        return false;
+    }
+    if (!((raw.type() == CV_8UC1 && bits == 8) ||
+          (raw.type() == CV_16UC1 && (bits == 10 || bits == 12)))) {
+        LOG(ERROR) << "Unsupported Bayer image type " << raw.type() << " with " << bits << " bits.";
+        return false;
+    }
+    tensor.create(size.height, size.width, CV_32FC3);
+
+    // Positions are cached for each calling thread, as sizes seldom change between frames.
+    thread_local SamplePositionCache column_cache, row_cache;
+    const auto &columns = ComputeSamplePositions(column_cache, size.width, raw.cols >> 1);
+    const auto &rows = ComputeSamplePositions(row_cache, size.height, raw.rows >> 1);
+    const float factor = scale / float(1 << (bits - 8));
+
+    if (num_bands <= 0)
+        num_bands = std::max(cv::getNumThreads(), 1);
+    num_bands = std::min(num_bands, size.height);
+    cv::parallel_for_(cv::Range(0, num_bands), [&](const cv::Range &range) {
+        for (int band = range.start; band < range.end; ++band) {
+            const int row_begin = size.height * band / num_bands, row_end = size.height * (band + 1) / num_bands;
+            if (raw.depth() == CV_8U)
+                ConvertTensorRows<uint8_t>(raw, tensor, pattern, factor, rgb, columns, rows, row_begin, row_end);
+            else
+                ConvertTensorRows<uint16_t>(raw, tensor, pattern, factor, rgb, columns, rows, row_begin, row_end);
+        }
+    }, num_bands);
+    return true;
+}
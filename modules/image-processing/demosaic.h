@@ -0,0 +1,76 @@
+/**
+ * Bayer demosaic functions header.
+ * \author trantuan-20048607
+ * \date 2022.3.25
+ * \details Convert RAW8 / RAW10 / RAW12 Bayer images to BGR24 images in a single pass,
+ *   using bilinear interpolation accelerated by SSE2 (or NEON on arm).  \n
+ *   Bayer images can also be converted directly to downscaled float images as neural network inputs,
+ *   without producing full resolution BGR images.
+ */
+
+#ifndef DEMOSAIC_H_
+#define DEMOSAIC_H_
+
+#include <opencv2/core/core.hpp>
+
+namespace demosaic {
+    /// \brief Color filter array order, named by the first two pixels of the first two rows.
+    enum BayerPattern {
+        kRGGB = 0,
+        kGRBG = 1,
+        kGBRG = 2,
+        kBGGR = 3
+    };
+
+    /**
+     * \brief Convert a Bayer image to BGR image.
+     * \param [in] raw Source Bayer image, CV_8UC1 for RAW8, or CV_16UC1 with low bits valid for RAW10 and RAW12.
+     * \param [out] bgr Output CV_8UC3 image. Existing buffer will be used when its size and type match.
+     * \param [in] pattern Color filter array order of source image.
+     * \param [in] bits Valid bits of each raw pixel, 8, 10 or 12.
+     * \return Whether image is converted.
+     */
+    bool BayerToBGR(const cv::Mat &raw, cv::Mat &bgr, BayerPattern pattern, int bits = 8);
+
+    /**
+     * \brief Multi-threaded version of BayerToBGR, converting bands of rows at the same time.
+     * \param [in] raw Source Bayer image, see BayerToBGR.
+     * \param [out] bgr Output CV_8UC3 image.
+     * \param [in] pattern Color filter array order of source image.
+     * \param [in] bits Valid bits of each raw pixel.
+     * \param [in] num_bands Number of row bands, 0 to use the number of OpenCV threads.
+     * \return Whether image is converted.
+     */
+    bool BayerToBGRParallel(const cv::Mat &raw, cv::Mat &bgr, BayerPattern pattern, int bits = 8,
+                            int num_bands = 0);
+
+    /**
+     * \brief Convert rows in [row_begin, row_end) of a Bayer image.
+     * \details Output image must be allocated. No parameter is checked in this function.
+     */
+    void BayerToBGRRows(const cv::Mat &raw, cv::Mat &bgr, BayerPattern pattern, int bits,
+                        int row_begin, int row_end);
+
+    /**
+     * \brief Convert a Bayer image directly to a downscaled float image, such as input tensor of detector.
+     * \details Every 2x2 Bayer cell is treated as one pixel (green is the average of 2 green pixels),
+     *   and cells are resized to output size with bilinear interpolation.
+     *   Demosaic, resize, channel reordering and type conversion are all done in one pass over source rows,
+     *   which is the same as cv::resize(INTER_LINEAR) on a half resolution demosaiced image.
+     * \param [in] raw Source Bayer image, see BayerToBGR.
+     * \param [out] tensor Output CV_32FC3 image in HWC layout.
+     *   Existing buffer will be used when its size and type match, so it can wrap a user buffer.
+     * \param [in] size Output size, should not be larger than half of source size.
+     * \param [in] pattern Color filter array order of source image.
+     * \param [in] bits Valid bits of each raw pixel.
+     * \param [in] rgb Channel order of output, RGB when true and BGR when false.
+     * \param [in] scale Output value of an 8-bit pixel value of 1.
+     * \param [in] num_bands Number of row bands processed at the same time, 0 to use the number of OpenCV threads.
+     * \return Whether image is converted.
+     */
+    bool BayerToTensor(const cv::Mat &raw, cv::Mat &tensor, const cv::Size &size,
+                       BayerPattern pattern, int bits = 8, bool rgb = true, float scale = 1.f,
+                       int num_bands = 0);
+}
+
+#endif  // DEMOSAIC_H_
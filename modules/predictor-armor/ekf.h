@@ -16,6 +16,8 @@
 
 /**
  * \brief Extended kalman filter template.
+ * \note Jacobians are computed by automatic differentiation, it is kept as reference of
+ *   AnalyticExtendedKalmanFilter used by armor predictor.
  * \tparam N_x Data length of x.
  * \tparam N_y Data length of y.
  */
@@ -46,7 +48,6 @@ public:
 
     template<typename Func>
     VectorX Predict(Func &&func) {
-        auto &track=ArmorPredictorDebug::Instance();
         AlterPredictcovMeasurecov(ArmorPredictorDebug::Instance().PredictedXZYNoise(),
                                   ArmorPredictorDebug::Instance().PredictedXZYSpeedNoise(),
                                   ArmorPredictorDebug::Instance().MeasureXYNoise(),
@@ -63,7 +64,6 @@ public:
             predict_jacobi_.block(i, 0, 1, N_x) =
                     x_predict_auto_jet[i].v.transpose();
         }
-        ArmorPredictorDebug a;
         status_cov_ = predict_jacobi_ * status_cov_ * predict_jacobi_.transpose() + predict_cov_;
         return x_predict_;
     }
@@ -0,0 +1,152 @@
+/**
+ * Extended Kalman Filter with analytic jacobians templated class header.
+ * \author trantuan-20048607
+ * \date 2022.3.30
+ * \note This file is only for internal use of implementation.
+ *   To use predictor in other modules, include the corresponding headers.
+ */
+
+#ifndef EKF_ANALYTIC_H_
+#define EKF_ANALYTIC_H_
+
+#include <cmath>
+#include <type_traits>
+#include <Eigen/Dense>
+#include "predictor-armor-debug/predictor_armor_debug.h"
+
+/**
+ * \brief Extended kalman filter template with closed-form jacobians.
+ * \details Unlike ExtendedKalmanFilter differentiating models by ceres::Jet, models compute their own jacobians:
+ *   \code
+ *   void operator()(const VectorX &x_0, VectorX &x, MatrixXX &jacobian) const;  // Predicting function.
+ *   void operator()(const VectorX &x, VectorY &y, MatrixYX &jacobian) const;    // Measuring function.
+ *   \endcode
+ *   Innovation covariance is solved by Cholesky decomposition instead of inverted, and noise matrices are only
+ *   rebuilt when parameters in ArmorPredictorDebug change.
+ * \tparam T Scalar type, float or double.
+ * \tparam N_x Data length of x.
+ * \tparam N_y Data length of y.
+ * \note Noise parameters are laid out for X: x, v_x, y, v_y, z and Y: yaw, pitch, distance, as ExtendedKalmanFilter.
+ */
+template<typename T, unsigned int N_x, unsigned int N_y>
+class AnalyticExtendedKalmanFilter {
+public:
+    static_assert(std::is_floating_point_v<T>, "Scalar type of kalman filter should be float or double.");
+
+    typedef Eigen::Matrix<T, N_x, N_x> MatrixXX;
+    typedef Eigen::Matrix<T, N_y, N_x> MatrixYX;
+    typedef Eigen::Matrix<T, N_x, N_y> MatrixXY;
+    typedef Eigen::Matrix<T, N_y, N_y> MatrixYY;
+    typedef Eigen::Matrix<T, N_x, 1> VectorX;
+    typedef Eigen::Matrix<T, N_y, 1> VectorY;
+
+    AnalyticExtendedKalmanFilter()
+            : x_estimate_(VectorX::Zero()),
+              x_predict_(VectorX::Zero()),
+              status_cov_(MatrixXX::Identity()),
+              noise_parameters_{} {
+        AlterPredictcovMeasurecov(0.01, 100, 1, 800);
+    }
+
+    inline void Initialize(const VectorX &x = VectorX::Zero()) { x_estimate_ = x; }
+
+    template<typename Func>
+    VectorX Predict(Func &&func) {
+        const auto &debug = ArmorPredictorDebug::Instance();
+        AlterPredictcovMeasurecov(debug.PredictedXZYNoise(),
+                                  debug.PredictedXZYSpeedNoise(),
+                                  debug.MeasureXYNoise(),
+                                  debug.MeasureZNoise());
+        func(x_estimate_, x_predict_, predict_jacobi_);
+        // Coefficient-based products are faster than blocked ones for matrices this small.
+        const MatrixXX predict_status_cov = predict_jacobi_.lazyProduct(status_cov_);
+        status_cov_ = predict_status_cov.lazyProduct(predict_jacobi_.transpose()) + predict_cov_;
+        return x_predict_;
+    }
+
+    template<typename Func>
+    VectorX Update(Func &&func, const VectorY &y) {
+        func(x_predict_, y_predict_, measure_jacobi_);
+
+        // K = P * H^T * S^-1, where P and S are symmetric, so K^T = S^-1 * (H * P) is solved instead.
+        const MatrixYX measure_status_cov = measure_jacobi_.lazyProduct(status_cov_);
+        const MatrixYY innovation_cov = measure_status_cov.lazyProduct(measure_jacobi_.transpose()) + measure_cov_;
+        kalman_gain_ = CholeskySolve(innovation_cov, measure_status_cov).transpose();
+        x_estimate_ = x_predict_ + kalman_gain_.lazyProduct(y - y_predict_);
+        status_cov_ -= kalman_gain_.lazyProduct(measure_status_cov);
+
+        return x_estimate_;
+    }
+
+    /// \brief Set noise parameters, noise matrices are rebuilt only when they change.
+    void AlterPredictcovMeasurecov(double p_xyz_noise, double p_xy_speed_noise, double m_xy_noise, double m_z_noise) {
+        const NoiseParameters noise_parameters{p_xyz_noise, p_xy_speed_noise, m_xy_noise, m_z_noise};
+        if (noise_parameters == noise_parameters_)
+            return;
+        noise_parameters_ = noise_parameters;
+        predict_cov_.setZero();
+        predict_cov_.diagonal() << T(p_xyz_noise), T(p_xy_speed_noise), T(p_xyz_noise), T(p_xy_speed_noise),
+                T(p_xyz_noise);
+        measure_cov_.setZero();
+        measure_cov_.diagonal() << T(m_xy_noise), T(m_xy_noise), T(m_z_noise);
+    }
+
+    VectorX x_estimate_;       ///< Estimated status var. [Xe]
+    VectorX x_predict_;        ///< Predicted status var. [Xp]
+    MatrixXX predict_jacobi_;  ///< Prediction jacobi matrix. [F]
+    MatrixYX measure_jacobi_;  ///< Measurement jacobi matrix. [H]
+    MatrixXX status_cov_;      ///< Status covariance matrix. [P]
+    MatrixXX predict_cov_;     ///< Prediction covariance matrix. [Q]
+    MatrixYY measure_cov_;     ///< Measurement covariance matrix. [R]
+    MatrixXY kalman_gain_;     ///< Kalman gain. [K]
+    VectorY y_predict_;        ///< Predicted measuring var. [Yp]
+
+private:
+    /**
+     * \brief Solve a * x = b by Cholesky decomposition of a.
+     * \details Loops of fixed length are unrolled by compilers, which is faster than Eigen::LLT and Eigen::LDLT
+     *   for matrices this small. Innovation covariance is positive definite as long as measure_cov_ is.
+     * \param [in] a Symmetric positive definite matrix, only its lower triangle is used.
+     * \param [in] b Right hand side.
+     * \return Solution x.
+     */
+    static MatrixYX CholeskySolve(MatrixYY a, MatrixYX b) {
+        // Decompose a = L * L^T, L is stored in lower triangle of a.
+        for (unsigned int j = 0; j < N_y; ++j) {
+            for (unsigned int k = 0; k < j; ++k)
+                a(j, j) -= a(j, k) * a(j, k);
+            a(j, j) = std::sqrt(a(j, j));
+            for (unsigned int i = j + 1; i < N_y; ++i) {
+                for (unsigned int k = 0; k < j; ++k)
+                    a(i, j) -= a(i, k) * a(j, k);
+                a(i, j) /= a(j, j);
+            }
+        }
+        // Solve L * z = b, then L^T * x = z, in place.
+        for (unsigned int i = 0; i < N_y; ++i) {
+            for (unsigned int k = 0; k < i; ++k)
+                b.row(i) -= a(i, k) * b.row(k);
+            b.row(i) /= a(i, i);
+        }
+        for (unsigned int i = N_y; i-- > 0;) {
+            for (unsigned int k = i + 1; k < N_y; ++k)
+                b.row(i) -= a(k, i) * b.row(k);
+            b.row(i) /= a(i, i);
+        }
+        return b;
+    }
+
+    /// \brief Noise parameters of the cached noise matrices.
+    struct NoiseParameters {
+        double p_xyz_noise, p_xy_speed_noise, m_xy_noise, m_z_noise;
+
+        inline bool operator==(const NoiseParameters &rhs) const {
+            return p_xyz_noise == rhs.p_xyz_noise && p_xy_speed_noise == rhs.p_xy_speed_noise
+                   && m_xy_noise == rhs.m_xy_noise && m_z_noise == rhs.m_z_noise;
+        }
+    };
+
+    NoiseParameters noise_parameters_;  ///< Parameters of predict_cov_ and measure_cov_.
+};
+
+#endif  // EKF_ANALYTIC_H_
@@ -0,0 +1,243 @@
+/**
+ * Bank of armor Extended Kalman Filters in structure-of-arrays layout header.
+ * \author trantuan-20048607
+ * \date 2022.3.30
+ * \note This file is only for internal use of implementation.
+ *   To use predictor in other modules, include the corresponding headers.
+ */
+
+#ifndef EKF_BANK_H_
+#define EKF_BANK_H_
+
+#include <cmath>
+#include <type_traits>
+#include <Eigen/Dense>
+#include "lang-feature-extension/attr_reader.h"
+#include "lang-feature-extension/disable_constructor.h"
+#include "predictor-armor-debug/predictor_armor_debug.h"
+
+/**
+ * \brief Measurement model of armor filters, converting position to spherical coordinate with its jacobian.
+ * \details Shared by MeasureFunction and EkfBank, so that both filters use the same model.
+ *   Only columns of positions are output, columns of velocities in jacobian are always zero.
+ * \tparam T Scalar type.
+ * \param [in] px,py,pz Position x, y, z.
+ * \param [out] y Yaw, pitch and distance.
+ * \param [out] h Jacobian of y with respect to x, y, z.
+ */
+template<typename T>
+inline void MeasureSpherical(T px, T py, T pz, T y[3], T h[3][3]) {
+    const T horizontal_square = px * px + pz * pz, square = horizontal_square + py * py;
+    const T horizontal = std::sqrt(horizontal_square), distance = std::sqrt(square);
+    y[0] = std::atan2(px, pz);
+    y[1] = std::atan2(py, horizontal);
+    y[2] = distance;
+
+    const T pitch_factor = -py / (horizontal * square);
+    h[0][0] = pz / horizontal_square, h[0][1] = 0, h[0][2] = -px / horizontal_square;
+    h[1][0] = pitch_factor * px, h[1][1] = horizontal / square, h[1][2] = pitch_factor * pz;
+    h[2][0] = px / distance, h[2][1] = py / distance, h[2][2] = pz / distance;
+}
+
+/**
+ * \brief Bank of extended kalman filters of armors, stepped together in one pass.
+ * \details Model is the same as AnalyticExtendedKalmanFilter with PredictFunction and MeasureFunction,
+ *   i.e. X: x, v_x, y, v_y, z in uniform linear motion and Y: yaw, pitch, distance.
+ *   Each element of states and covariances is stored in its own array over filters, so that predicting is a few
+ *   loops over filters vectorized by compilers, and updating is one straight-line pass over contiguous arrays.
+ *   Filters without measurement are masked instead of branched.
+ * \tparam T Scalar type, float or double.
+ * \tparam kCapacity Max number of filters.
+ */
+template<typename T, unsigned int kCapacity>
+class EkfBank : NO_COPY, NO_MOVE {
+public:
+    static_assert(std::is_floating_point_v<T>, "Scalar type of kalman filter should be float or double.");
+
+    static constexpr unsigned int kNx = 5;  ///< Data length of x.
+    static constexpr unsigned int kNy = 3;  ///< Data length of y.
+
+    typedef Eigen::Matrix<T, kNx, kNx> MatrixXX;
+    typedef Eigen::Matrix<T, kNx, 1> VectorX;
+    typedef Eigen::Matrix<T, kNy, 1> VectorY;
+
+    ATTR_READER(size_, Size)
+
+    EkfBank() : size_(0), x_{}, p_{}, y_{}, measured_{} {}
+
+    ~EkfBank() = default;
+
+    /// \brief Remove all filters.
+    inline void Clear() { size_ = 0; }
+
+    /**
+     * \brief Add a filter with identity covariance, as a new AnalyticExtendedKalmanFilter.
+     * \param [in] x Initial status.
+     * \return Index of new filter, -1 when bank is full.
+     */
+    int Add(const VectorX &x) {
+        if (size_ == kCapacity)
+            return -1;
+        const unsigned int i = size_++;
+        for (unsigned int r = 0; r < kNx; ++r) {
+            x_[r][i] = x[r];
+            for (unsigned int c = 0; c < kNx; ++c)
+                p_[r][c][i] = r == c ? T(1) : T(0);
+        }
+        measured_[i] = 0;
+        return int(i);
+    }
+
+    /**
+     * \brief Remove a filter.
+     * \param [in] i Index of filter, the last filter is moved to this index.
+     */
+    void Remove(unsigned int i) {
+        const unsigned int last = --size_;
+        if (i == last)
+            return;
+        for (unsigned int r = 0; r < kNx; ++r) {
+            x_[r][i] = x_[r][last];
+            for (unsigned int c = 0; c < kNx; ++c)
+                p_[r][c][i] = p_[r][c][last];
+        }
+        for (unsigned int r = 0; r < kNy; ++r)
+            y_[r][i] = y_[r][last];
+        measured_[i] = measured_[last];
+    }
+
+    /**
+     * \brief Set measurement of a filter for the next step.
+     * \param [in] i Index of filter.
+     * \param [in] y Measured yaw, pitch and distance.
+     */
+    inline void SetMeasurement(unsigned int i, const VectorY &y) {
+        for (unsigned int r = 0; r < kNy; ++r)
+            y_[r][i] = y[r];
+        measured_[i] = 1;
+    }
+
+    /**
+     * \brief Predict all filters, then update those with measurements set since the last step.
+     * \param [in] delta_t Time since the last step in seconds.
+     */
+    void Step(T delta_t) {
+        const auto &debug = ArmorPredictorDebug::Instance();
+        const T p_xyz_noise = T(debug.PredictedXZYNoise()), p_xy_speed_noise = T(debug.PredictedXZYSpeedNoise()),
+                m_xy_noise = T(debug.MeasureXYNoise()), m_z_noise = T(debug.MeasureZNoise());
+        const T predict_noise[kNx] = {p_xyz_noise, p_xy_speed_noise, p_xyz_noise, p_xy_speed_noise, p_xyz_noise};
+        const T measure_noise[kNy] = {m_xy_noise, m_xy_noise, m_z_noise};
+        const unsigned int size = size_;
+
+        // Predict: x = F * x, P = F * P * F^T + Q, where F only adds delta_t times speed to position.
+        for (unsigned int i = 0; i < size; ++i) {
+            x_[0][i] += delta_t * x_[1][i];
+            x_[2][i] += delta_t * x_[3][i];
+        }
+        for (unsigned int c = 0; c < kNx; ++c)
+            for (unsigned int i = 0; i < size; ++i) {
+                p_[0][c][i] += delta_t * p_[1][c][i];
+                p_[2][c][i] += delta_t * p_[3][c][i];
+            }
+        for (unsigned int r = 0; r < kNx; ++r)
+            for (unsigned int i = 0; i < size; ++i) {
+                p_[r][0][i] += delta_t * p_[r][1][i];
+                p_[r][2][i] += delta_t * p_[r][3][i];
+            }
+        for (unsigned int r = 0; r < kNx; ++r)
+            for (unsigned int i = 0; i < size; ++i)
+                p_[r][r][i] += predict_noise[r];
+
+        // Update: only columns of positions in measurement jacobian H are not zero, which are stored as h.
+        constexpr unsigned int kPosition[kNy] = {0, 2, 4};
+        for (unsigned int i = 0; i < size; ++i) {
+            const T mask = measured_[i];
+            T y[kNy], h[kNy][kNy];
+            MeasureSpherical(x_[0][i], x_[2][i], x_[4][i], y, h);
+            const T innovation[kNy] = {mask * (y_[0][i] - y[0]),
+                                       mask * (y_[1][i] - y[1]),
+                                       mask * (y_[2][i] - y[2])};
+
+            // H * P, masked for filters without measurement, so that their gain is zero.
+            T hp[kNy][kNx];
+            for (unsigned int r = 0; r < kNy; ++r)
+                for (unsigned int c = 0; c < kNx; ++c)
+                    hp[r][c] = mask * (h[r][0] * p_[kPosition[0]][c][i]
+                                       + h[r][1] * p_[kPosition[1]][c][i]
+                                       + h[r][2] * p_[kPosition[2]][c][i]);
+
+            // S = H * P * H^T + R, decomposed to L * L^T in place, only lower triangle is used.
+            T l[kNy][kNy];
+            for (unsigned int r = 0; r < kNy; ++r)
+                for (unsigned int c = 0; c <= r; ++c)
+                    l[r][c] = hp[r][kPosition[0]] * h[c][0] + hp[r][kPosition[1]] * h[c][1]
+                              + hp[r][kPosition[2]] * h[c][2] + (r == c ? measure_noise[r] : T(0));
+            for (unsigned int j = 0; j < kNy; ++j) {
+                for (unsigned int k = 0; k < j; ++k)
+                    l[j][j] -= l[j][k] * l[j][k];
+                l[j][j] = std::sqrt(l[j][j]);
+                for (unsigned int r = j + 1; r < kNy; ++r) {
+                    for (unsigned int k = 0; k < j; ++k)
+                        l[r][j] -= l[r][k] * l[j][k];
+                    l[r][j] /= l[j][j];
+                }
+            }
+
+            // K^T = S^-1 * (H * P), by forward and back substitution.
+            T gain[kNy][kNx];
+            for (unsigned int c = 0; c < kNx; ++c) {
+                for (unsigned int r = 0; r < kNy; ++r) {
+                    T value = hp[r][c];
+                    for (unsigned int k = 0; k < r; ++k)
+                        value -= l[r][k] * gain[k][c];
+                    gain[r][c] = value / l[r][r];
+                }
+                for (unsigned int r = kNy; r-- > 0;) {
+                    T value = gain[r][c];
+                    for (unsigned int k = r + 1; k < kNy; ++k)
+                        value -= l[k][r] * gain[k][c];
+                    gain[r][c] = value / l[r][r];
+                }
+            }
+
+            // x += K * (y - h(x)), P -= K * (H * P).
+            for (unsigned int r = 0; r < kNx; ++r) {
+                x_[r][i] += gain[0][r] * innovation[0] + gain[1][r] * innovation[1] + gain[2][r] * innovation[2];
+                for (unsigned int c = 0; c < kNx; ++c)
+                    p_[r][c][i] -= gain[0][r] * hp[0][c] + gain[1][r] * hp[1][c] + gain[2][r] * hp[2][c];
+            }
+            measured_[i] = 0;
+        }
+    }
+
+    /// \return Status of a filter.
+    [[nodiscard]] inline VectorX State(unsigned int i) const {
+        VectorX x;
+        for (unsigned int r = 0; r < kNx; ++r)
+            x[r] = x_[r][i];
+        return x;
+    }
+
+    /// \return Status covariance of a filter.
+    [[nodiscard]] inline MatrixXX Covariance(unsigned int i) const {
+        MatrixXX p;
+        for (unsigned int r = 0; r < kNx; ++r)
+            for (unsigned int c = 0; c < kNx; ++c)
+                p(r, c) = p_[r][c][i];
+        return p;
+    }
+
+    /// \return Position x, y, z of a filter.
+    [[nodiscard]] inline Eigen::Matrix<T, 3, 1> Position(unsigned int i) const {
+        return {x_[0][i], x_[2][i], x_[4][i]};
+    }
+
+private:
+    unsigned int size_;                     ///< Number of filters.
+    alignas(64) T x_[kNx][kCapacity];       ///< Status vars. [Xe]
+    alignas(64) T p_[kNx][kNx][kCapacity];  ///< Status covariance matrices. [P]
+    alignas(64) T y_[kNy][kCapacity];       ///< Measurements for the next step. [Y]
+    alignas(64) T measured_[kCapacity];     ///< 1 when measurement is set for the next step, otherwise 0.
+};
+
+#endif  // EKF_BANK_H_
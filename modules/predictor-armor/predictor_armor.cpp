@@ -6,6 +6,10 @@ const float kACSpeedYCoefficient = .5f;         ///< Coefficient of inherit anti
 const double kACInitMinLastingTime = 1;         ///< Minimal lasting time to enter anti-top candidates.
 const double kAccelerationThreshold = 100;        ///< Maximal acceleration allow to fire.
 const float kSwitchArmorAreaProportion = 1.1f;  ///< Minimal area of armor to switch to.
+const double kTrackGate = 0.3;                  ///< Max distance between an armor and its filter in track bank.
+const unsigned int kTrackMinHits = 5;           ///< Minimal updates of a filter in track bank to be converged.
+const unsigned int kTrackMaxMisses = 10;        ///< Maximal missing frames of a filter in track bank.
+const double kTrackMaxDeltaT = 0.5;             ///< Maximal time between frames to keep filters in track bank.
 
 bool ArmorPredictor::Initialize() {
     ArmorPredictorDebug::Instance().Initialize("../config/sentry/ekf-param.yaml",CmdlineArgParser::Instance().DebugUseTrackbar());
@@ -14,7 +18,7 @@ bool ArmorPredictor::Initialize() {
 
     machine_set_ = fsm::MachineSet::MakeMachineSet();
     if(machine_set_){
-        machine_set_->StartBackground(500);
+        // Armor machine is driven by Dispatch() on predicting thread, so no background thread is started.
         // add armor machine to machine set
         armor_machine_ = fsm::MakeStateMachine<ArmorMachine>("Armor Machine #1");
         if(armor_machine_){
@@ -22,7 +26,6 @@ bool ArmorPredictor::Initialize() {
 
             armor_machine_->one_->OnEnter = [&](fsm::MachineBase &machine,
                                                 const fsm::StateSharedPtr &state){
-                armor_machine_->is_transiting=false;
                 DLOG(INFO) << "Enter "<<state->name();
             };
             armor_machine_->one_->OnExit = [&](fsm::MachineBase &machine,
@@ -31,7 +34,6 @@ bool ArmorPredictor::Initialize() {
             };
             armor_machine_->two_without_antitop_->OnEnter = [&](fsm::MachineBase &machine,
                                                                 const fsm::StateSharedPtr &state){
-                armor_machine_->is_transiting=false;
                 DLOG(INFO) << "Enter "<<state->name();
             };
             armor_machine_->two_without_antitop_->OnExit = [&](fsm::MachineBase &machine,
@@ -40,7 +42,6 @@ bool ArmorPredictor::Initialize() {
             };
             armor_machine_->two_with_antitop_->OnEnter = [&](fsm::MachineBase &machine,
                                                              const fsm::StateSharedPtr &state){
-                armor_machine_->is_transiting=false;
                 DLOG(INFO) << "Enter "<<state->name();
             };
             armor_machine_->two_with_antitop_->OnExit = [&](fsm::MachineBase &machine,
@@ -240,7 +241,7 @@ bool ArmorPredictor::Initialize() {
                     }
                 }
             };
-            machine_set_->Enqueue(std::make_shared<fsm::MachineOperationEvent>(
+            machine_set_->Dispatch(std::make_shared<fsm::MachineOperationEvent>(
                     fsm::MachineOperator::kAdd,
                     armor_machine_));
             DLOG(INFO) << "armor machine created successfully.";
@@ -253,6 +254,15 @@ bool ArmorPredictor::Initialize() {
     return false;
 }
 
+bool ArmorPredictor::PredictedROI(const Eigen::Matrix3d &camera_matrix, cv::Rect2f &roi) const {
+    if (!target_locked_ || !target_.armor || translation_vector_cam_predict_(2, 0) <= 0)
+        return false;
+    Eigen::Vector3d point = camera_matrix * translation_vector_cam_predict_ / translation_vector_cam_predict_(2, 0);
+    auto size = GetROI(*target_.armor).size();
+    roi = {float(point[0]) - size.width / 2, float(point[1]) - size.height / 2, size.width, size.height};
+    return true;
+}
+
 SendPacket ArmorPredictor::Run(const Battlefield &battlefield, Modes mode) {
     auto &robots = battlefield.Robots();
 
@@ -308,9 +318,23 @@ SendPacket ArmorPredictor::Run(const Battlefield &battlefield, Modes mode) {
     double tm_cam_to_imu_data[] = {0, -0.026, -0.075};
     const static coordinate::TranslationMatrix camera_to_imu_translation_matrix(tm_cam_to_imu_data);
 
-    static uint64_t time_stamp = 0;
-    double delta_t = double(battlefield.TimeStamp() - time_stamp) * 1e-9;
-    time_stamp = battlefield.TimeStamp();
+    double delta_t = double(battlefield.TimeStamp() - time_stamp_) * 1e-9;
+    time_stamp_ = battlefield.TimeStamp();
+
+    std::vector<Armor> all_armors;  ///< All possible target armors.
+    if (exist_enemy)
+        for (auto &robot: robots.at(color_))
+            for (const auto &armor: robot.second->Armors())
+                all_armors.emplace_back(armor);
+    if (exist_grey)
+        for (auto &robot: robots.at(Entity::Colors::kGrey))
+            if (grey_count_[robot.first] < kMaxGreyCount)
+                for (const auto &armor: robot.second->Armors())
+                    all_armors.emplace_back(armor);
+
+    // Track all armors, so that any target is selected with a converged filter.
+    // ================================================
+    UpdateTracks(all_armors, delta_t);
 
     bool antitop = (mode == kAntiTop || (mode == kAutoAntitop && antitop_));    /// Is antitop
     uint8_t armor_num;
@@ -319,23 +343,17 @@ SendPacket ArmorPredictor::Run(const Battlefield &battlefield, Modes mode) {
     // ================================================
     if (target_locked_) {
         armor_num = GetSameIDArmorNum(color_, *target_.armor, robots, grey_count_, exist_enemy, exist_grey);
-        armor_machine_->is_transiting=true;
-        if(armor_num == 1) {
-            machine_set_->Enqueue(std::make_shared<ArmorEvent>(
-                    ArmorEventType::kOne,
-                    armor_machine_));
-        }else if(armor_num > 1 && mode) {
-            machine_set_->Enqueue(std::make_shared<ArmorEvent>(
-                    ArmorEventType::kTwoWithAntiTop,
-                    armor_machine_));
-        }else {
-            machine_set_->Enqueue(std::make_shared<ArmorEvent>(
-                    ArmorEventType::kTwoWithoutAntiTop,
-                    armor_machine_));
-        }
+        ArmorEventType event_type;
+        if(armor_num == 1)
+            event_type = ArmorEventType::kOne;
+        else if(armor_num > 1 && mode)
+            event_type = ArmorEventType::kTwoWithAntiTop;
+        else
+            event_type = ArmorEventType::kTwoWithoutAntiTop;
 
-        while(armor_machine_->is_transiting)    // waiting for armor machine finishing to transit.
-            std::this_thread::sleep_for(std::chrono::nanoseconds(1));
+        // Transit on this thread, state bits are ready when it returns.
+        if (!machine_set_->Dispatch(std::make_shared<ArmorEvent>(event_type, armor_machine_)))
+            DLOG(WARNING) << "Armor machine failed to transit.";
     }
 
     // Find and select the same target as pre-locked one by ROI and distance.
@@ -553,15 +571,22 @@ SendPacket ArmorPredictor::Run(const Battlefield &battlefield, Modes mode) {
                 0,
                 armor_machine_->target_->TranslationVectorWorld()[2];
 
-        target_.ekf.Initialize(x_real);
+        Eigen::Vector3d tv_world_predict = armor_machine_->target_->TranslationVectorWorld();
+        if (InitializeFilter(*armor_machine_->target_, target_.ekf, x_real)) {
+            // Warm-started filter already knows speed of this armor, so aim ahead as the same target.
+            Eigen::Matrix<double, 5, 1> x_predict;
+            predict.delta_t = tv_world_predict.norm() / bullet_speed + shoot_delay;
+            predict(target_.ekf.x_estimate_.data(), x_predict.data());
+            tv_world_predict << x_predict(0, 0), x_predict(2, 0), x_predict(4, 0);
+        }
         coordinate::TranslationVector shoot_point_rectangular = coordinate::transform::WorldToCamera(
-                armor_machine_->target_->TranslationVectorWorld(),
+                tv_world_predict,
                 coordinate::transform::QuaternionToRotationMatrix(battlefield.Quaternion()),
                 Eigen::Vector3d::Zero(),
                 Eigen::Matrix3d::Identity());
 
         translation_vector_cam_predict_ = coordinate::transform::WorldToCamera(
-                armor_machine_->target_->TranslationVectorWorld(),
+                tv_world_predict,
                 coordinate::transform::QuaternionToRotationMatrix(battlefield.Quaternion()),
                 camera_to_imu_translation_matrix,
                 Eigen::Matrix3d::Identity());
@@ -574,17 +599,6 @@ SendPacket ArmorPredictor::Run(const Battlefield &battlefield, Modes mode) {
         antitop_candidates_.clear();
     }
 
-    std::vector<Armor> all_armors;  ///< All possible target armors.
-    if (exist_enemy)
-        for (auto &robot: robots.at(color_))
-            for (const auto &armor: robot.second->Armors())
-                all_armors.emplace_back(armor);
-    if (exist_grey)
-        for (auto &robot: robots.at(Entity::Colors::kGrey))
-            if (grey_count_[robot.first] < kMaxGreyCount)
-                for (const auto &armor: robot.second->Armors())
-                    all_armors.emplace_back(armor);
-
     // Update anti-top candidates.
     // ================================================
     for (const auto &armor: all_armors) {
@@ -633,7 +647,7 @@ SendPacket ArmorPredictor::Run(const Battlefield &battlefield, Modes mode) {
                             -kACSpeedYCoefficient * target_.ekf.x_estimate_(3, 0),
                             tv_world_measure(2, 0);
 
-                    antitop_candidate.ekf.Initialize(x_real);
+                    InitializeFilter(*antitop_candidate.armor, antitop_candidate.ekf, x_real);
                     antitop_candidate.armor = std::make_shared<Armor>(armor);
                 } else {
                     antitop_candidate.need_init = false;
@@ -720,7 +734,7 @@ SendPacket ArmorPredictor::Run(const Battlefield &battlefield, Modes mode) {
                     0.25 * target_.ekf.x_estimate_(3, 0),
                     tv_world_measure(2, 0);
 
-            new_node.ekf.Initialize(x_real);
+            InitializeFilter(armor, new_node.ekf, x_real);
             new_node.armor = std::make_shared<Armor>(armor);
             new_node.need_update = true;
             new_node.need_init = true;
@@ -775,3 +789,88 @@ SendPacket ArmorPredictor::Run(const Battlefield &battlefield, Modes mode) {
     armor_num_ = armor_num;
     return target_.GenerateSendPacket(fire_);
 }
+
+void ArmorPredictor::UpdateTracks(const std::vector<Armor> &armors, double delta_t) {
+    // Filters are too old to predict after a long time, including the first frame and time stamps going back.
+    if (delta_t > kTrackMaxDeltaT) {
+        track_bank_.Clear();
+        tracks_.clear();
+        delta_t = 0;
+    }
+
+    // Match armors with predicted positions of filters of the same ID, nearest first.
+    MeasureFunction measure;
+    std::vector<bool> matched(tracks_.size(), false);
+    std::vector<const Armor *> unmatched_armors;
+    for (const auto &armor: armors) {
+        int nearest = -1;
+        double min_distance = kTrackGate;
+        for (unsigned int i = 0; i < tracks_.size(); ++i) {
+            if (matched[i] || tracks_[i].id != armor.ID())
+                continue;
+            const auto x = track_bank_.State(i);
+            const Eigen::Vector3d predicted_position{x[0] + delta_t * x[1], x[2] + delta_t * x[3], x[4]};
+            const double distance = (predicted_position - armor.TranslationVectorWorld()).norm();
+            if (distance < min_distance) {
+                min_distance = distance;
+                nearest = int(i);
+            }
+        }
+        if (nearest < 0) {
+            unmatched_armors.push_back(&armor);
+            continue;
+        }
+        const Eigen::Vector3d &position = armor.TranslationVectorWorld();
+        Eigen::Matrix<double, 5, 1> x_real;
+        Eigen::Matrix<double, 3, 1> y_real;
+        x_real << position[0], 0, position[1], 0, position[2];
+        measure(x_real.data(), y_real.data());
+        track_bank_.SetMeasurement(nearest, y_real);
+        matched[nearest] = true;
+        ++tracks_[nearest].hits;
+        tracks_[nearest].misses = 0;
+    }
+
+    track_bank_.Step(delta_t);
+
+    // Remove filters missing for a long time, the last filter is moved to the removed index.
+    for (unsigned int i = tracks_.size(); i-- > 0;)
+        if (!matched[i] && ++tracks_[i].misses > kTrackMaxMisses) {
+            track_bank_.Remove(i);
+            tracks_[i] = tracks_.back();
+            tracks_.pop_back();
+        }
+
+    for (const auto *armor: unmatched_armors) {
+        const Eigen::Vector3d &position = armor->TranslationVectorWorld();
+        Eigen::Matrix<double, 5, 1> x_real;
+        x_real << position[0], 0, position[1], 0, position[2];
+        if (track_bank_.Add(x_real) < 0) {
+            DLOG(WARNING) << "Track bank of armor predictor is full.";
+            break;
+        }
+        tracks_.push_back({armor->ID(), 1, 0});
+    }
+}
+
+bool ArmorPredictor::InitializeFilter(const Armor &armor, AnalyticExtendedKalmanFilter<double, 5, 3> &ekf,
+                                      const Eigen::Matrix<double, 5, 1> &x) const {
+    int nearest = -1;
+    double min_distance = kTrackGate;
+    for (unsigned int i = 0; i < tracks_.size(); ++i) {
+        if (tracks_[i].id != armor.ID() || tracks_[i].misses || tracks_[i].hits < kTrackMinHits)
+            continue;
+        const double distance = (track_bank_.Position(i) - armor.TranslationVectorWorld()).norm();
+        if (distance < min_distance) {
+            min_distance = distance;
+            nearest = int(i);
+        }
+    }
+    if (nearest < 0) {
+        ekf.Initialize(x);
+        return false;
+    }
+    ekf.x_estimate_ = track_bank_.State(nearest);
+    ekf.status_cov_ = track_bank_.Covariance(nearest);
+    return true;
+}
@@ -13,7 +13,8 @@
 #include "digital-twin/battlefield.h"
 #include "antitop_detector.h"
 #include "predictor_fsm.h"
-#include "ekf.h"
+#include "ekf_analytic.h"
+#include "ekf_bank.h"
 
 /// Predicting function template structure.
 struct PredictFunction {
@@ -35,6 +36,25 @@ struct PredictFunction {
         x[4] = x_0[4];  // 0.01
     }
 
+    /**
+     * \brief Uniform linear motion with its jacobian, for AnalyticExtendedKalmanFilter.
+     * \tparam T Scalar type.
+     * \param [in] x_0 Input original x.
+     * \param [out] x Output predicted x.
+     * \param [out] jacobian Jacobian of x with respect to x_0.
+     */
+    template<typename T>
+    void operator()(const Eigen::Matrix<T, 5, 1> &x_0, Eigen::Matrix<T, 5, 1> &x,
+                    Eigen::Matrix<T, 5, 5> &jacobian) const {
+        const T dt = T(delta_t);
+        x << x_0[0] + dt * x_0[1], x_0[1], x_0[2] + dt * x_0[3], x_0[3], x_0[4];
+        jacobian << 1, dt, 0, 0, 0,
+                0, 1, 0, 0, 0,
+                0, 0, 1, dt, 0,
+                0, 0, 0, 1, 0,
+                0, 0, 0, 0, 1;
+    }
+
     double delta_t;
 };
 
@@ -51,6 +71,25 @@ struct MeasureFunction {
         T _x[3] = {x[0], x[2], x[4]};
         coordinate::convert::Rectangular2Spherical<T>(_x, y);
     }
+
+    /**
+     * \brief Convert positioning data to spherical coordinate with its jacobian, for AnalyticExtendedKalmanFilter.
+     * \tparam T Scalar type.
+     * \param [in] x Input x data.
+     * \param [out] y Output target position in spherical coordinate system.
+     * \param [out] jacobian Jacobian of y with respect to x.
+     */
+    template<typename T>
+    void operator()(const Eigen::Matrix<T, 5, 1> &x, Eigen::Matrix<T, 3, 1> &y,
+                    Eigen::Matrix<T, 3, 5> &jacobian) const {
+        T h[3][3];
+        MeasureSpherical(x[0], x[2], x[4], y.data(), h);
+
+        // Columns of velocities are always zero.
+        jacobian << h[0][0], 0, h[0][1], 0, h[0][2],
+                h[1][0], 0, h[1][1], 0, h[1][2],
+                h[2][0], 0, h[2][1], 0, h[2][2];
+    }
 };
 
 class ArmorPredictor : NO_COPY, NO_MOVE {
@@ -81,7 +120,7 @@ public:
     struct Node {
         std::shared_ptr<Armor> armor;  ///< Armor data, shared pointer is used for deleted default constructor.
         /// EKF object. Order of data inside is X: x, v_x, y, v_y, z and Y: yaw, pitch, distance.
-        ExtendedKalmanFilter<5, 3> ekf;
+        AnalyticExtendedKalmanFilter<double, 5, 3> ekf;
         double yaw, pitch;
         int lasting_time;
 
@@ -135,6 +174,8 @@ public:
 
     ATTR_READER(bool(flag_ &kDebug), Debug)
 
+    ATTR_READER(target_locked_, TargetLocked)
+
     ArmorPredictor(Entity::Colors color, uint8_t flag) :
             color_(color),flag_(flag) {
         ClearStateBits();
@@ -144,6 +185,8 @@ public:
     inline void Clear() {
         target_locked_ = false;
         antitop_candidates_.clear();
+        track_bank_.Clear();
+        tracks_.clear();
     }
 
     inline void ClearStateBits(){
@@ -152,11 +195,47 @@ public:
 
     SendPacket Run(const Battlefield &battlefield, Modes mode = kNormal);
 
+    /**
+     * \brief Get the region where locked target will appear in image.
+     * \param [in] camera_matrix Camera intrinsic matrix.
+     * \param [out] roi ROI rect of target size, centered at predicted point.
+     * \return Whether a target is locked and predicted in front of camera.
+     */
+    bool PredictedROI(const Eigen::Matrix3d &camera_matrix, cv::Rect2f &roi) const;
+
     bool Initialize();
 
     ~ArmorPredictor() = default;
 
 private:
+    /// Max number of armors tracked in track bank.
+    constexpr static unsigned int kMaxTracks = 32;
+
+    /// Armor ID and counters of a filter in track bank.
+    struct Track {
+        unsigned int id;      ///< Armor ID.
+        unsigned int hits;    ///< Number of frames updated with measurements.
+        unsigned int misses;  ///< Number of consecutive frames without measurement.
+    };
+
+    /**
+     * \brief Associate armors to filters in track bank by ID and distance, then step all filters.
+     * \details Unmatched armors start new filters, and filters missing for several frames are removed.
+     * \param [in] armors All possible target armors in this frame.
+     * \param delta_t Time since the last frame in seconds.
+     */
+    void UpdateTracks(const std::vector<Armor> &armors, double delta_t);
+
+    /**
+     * \brief Initialize a filter from the converged filter of the same armor in track bank if possible.
+     * \param [in] armor Armor to filter.
+     * \param [out] ekf Filter to initialize.
+     * \param [in] x Initial status used when there's no converged filter of this armor.
+     * \return Whether filter is initialized from track bank.
+     */
+    bool InitializeFilter(const Armor &armor, AnalyticExtendedKalmanFilter<double, 5, 3> &ekf,
+                          const Eigen::Matrix<double, 5, 1> &x) const;
+
     /**
      * \brief Examine 2 armors by distance.
      * \param armor_1 First armor.
@@ -322,6 +401,9 @@ private:
     ArmorMachine::StateBits state_bits_;
     Eigen::Vector3d translation_vector_cam_predict_;
     std::vector<Node> antitop_candidates_;
+    EkfBank<double, kMaxTracks> track_bank_;  ///< Filters of all visible armors, stepped every frame.
+    std::vector<Track> tracks_;               ///< Tracks of filters in track bank, in the same order.
+    uint64_t time_stamp_ = 0;                 ///< Time stamp of the last frame.
     AntitopDetector antitop_detector_;
     fsm::MachineSetSharedPtr machine_set_;
     std::shared_ptr<ArmorMachine> armor_machine_;
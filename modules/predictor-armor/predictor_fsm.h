@@ -85,7 +85,6 @@ public:
 private:
     std::shared_ptr<Armor> target_; ///< Target selected in this round.
     bool exist_enemy_,exist_grey_;
-    bool is_transiting=true; /// if machine is transiting.
 
     const RobotMap *robots_;
 
@@ -1,4 +1,6 @@
+#include <algorithm>
 #include "predictor_rune.h"
+#include "clock/clock.h"
 #include "math-tools/algorithms.h"
 
 bool RunePredictor::Initialize(const std::string &config_path) {
@@ -8,7 +10,20 @@ bool RunePredictor::Initialize(const std::string &config_path) {
     try {
         config.open(config_path, cv::FileStorage::READ);
     } catch (const std::exception &) {
-        LOG(ERROR) << "Failed to open rune detector config file " << config_path << ".";
+        LOG(ERROR) << "Failed to open rune predictor config file " << config_path << ".";
+        return false;
+    }
+
+    // Read config data.
+    try {
+        config["REFIT_INTERVAL"] >> refit_interval_;
+    } catch (std::exception &) {
+        LOG(ERROR) << "Failed to load config of rune predictor.";
+        return false;
+    }
+    if (refit_interval_ < 0) {
+        LOG(ERROR) << "Invalid refit interval " << refit_interval_ << " of rune predictor.";
+        return false;
     }
 
     return true;
@@ -58,15 +73,12 @@ double RunePredictor::CalAngularVelocity() {
 
     float cal_angle;
     current_fan_angular_velocity_ = -1;
-    auto current_time = std::chrono::high_resolution_clock::now();                 // Used to calculate time gap in order to cal angular velocity.
-    present_time_ = double(
-            std::chrono::duration_cast<std::chrono::milliseconds>(  // Used to provide time_data in order to fit the curve.
-                    std::chrono::system_clock::now().time_since_epoch()).count());
-    present_time_ /= 1000;                                                         // ms to s
+    const uint64_t current_time = Clock::Global().Now();  // Follow frames in replays, see Clock.
+    present_time_ = double(current_time) * 1e-9;          // ns to s
     /// 滤掉无效帧
     if (last_RTG_vec_ != cv::Point2f(0.0, 0.0)) {
         cal_angle = algorithm::VectorAngle(last_RTG_vec_, rune_.RtgVec()); // 计算矢量夹角
-        double time_gap = (static_cast<std::chrono::duration<double, std::milli>>(current_time - last_time_)).count();
+        double time_gap = double(current_time - last_time_) * 1e-6;
         current_fan_angular_velocity_ = cal_angle / time_gap * 1000.0;
         circle_fan_palstance_queue.Push(std::make_pair(current_time, current_fan_angular_velocity_));
     }
@@ -75,8 +87,11 @@ double RunePredictor::CalAngularVelocity() {
     last_time_ = current_time;
     last_RTG_vec_ = rune_.RtgVec();
 
-    speed_data_.push_back(current_fan_angular_velocity_);
-    time_data_.push_back(present_time_);
+    /// Only speed of valid frames is used to estimate speed function
+    if (current_fan_angular_velocity_ >= 0) {
+        estimator_.Update(present_time_, current_fan_angular_velocity_ / 180 * CV_PI);
+        ++samples_since_submit_;
+    }
 
     return current_fan_angular_velocity_;
 }
@@ -108,70 +123,68 @@ void RunePredictor::CalCurrentFanAngle() {
 */
 double RunePredictor::CalRadIntegralFromSpeed(const double &integral_time) {
     const double c = 0;
+    const double time = integral_time - estimator_.TimeOrigin();  // Phase is relative to the estimator.
     return (-1.0) * rune_.Clockwise() *
-           (-amplitude_ / omega_ * cos(omega_ * integral_time + phi_) + b_ * integral_time + c);
+           (-amplitude_ / omega_ * cos(omega_ * time + phi_) + b_ * time + c);
 }
 
 /**
 * @Brief: calculate parameters
 */
 void RunePredictor::CalFunctionParameters() {
-    if (is_need_to_fit_ == 1) {
-        /// Prepare stage
-        if (speed_data_.size() < kPrepareNum && is_okay_to_fit_ == 0) {
-            return;
-        }
-        if (speed_data_.size() == kPrepareNum && is_okay_to_fit_ == 0) {
-            is_okay_to_fit_ = 1;
-            speed_data_.clear();
-            return;
-        }
-
-        /// Finish preparing and collect data
-        if (speed_data_.size() < 335 && is_okay_to_fit_ == 1) {
-            return;
-        }
-
-        /// Finishing collecting
-        if (speed_data_.size() == 335 && is_okay_to_fit_ == 1) {
-            for (double &speed: speed_data_) {
-                speed = speed / 180 * CV_PI;
-            }
-
-            ceres::Problem problem;
-            for (int i = 0; i < kNumObservation; ++i) {
-                problem.AddResidualBlock(
-                        new ceres::AutoDiffCostFunction<TrigonometricResidual, 1, 1, 1, 1>(
-                                new TrigonometricResidual(time_data_[i], speed_data_[i], rune_.Clockwise())),
-                        new ceres::CauchyLoss(0.5),
-                        &amplitude_,
-                        &omega_,
-                        &phi_
-                );
-            }
-            ceres::Solver::Options options;
-            options.max_num_iterations = 300;
-            options.linear_solver_type = ceres::DENSE_QR;
-            options.minimizer_progress_to_stdout = true;
-
-            if (debug_) {
-                ceres::Solver::Summary summary;
-                ceres::Solve(options, &problem, &summary);
-                std::cout << summary.BriefReport() << "\n";
-                std::cout << "Inference A = " << amplitude_ << " Omega = " << omega_ << " phi_ = " << phi_ << std::endl;
-            }
-            is_okay_to_fit_ = 0;
-            is_need_to_fit_ = 0;
-        }
+    /// Reseed estimator when a background fit lands and matches samples in window better.
+    /// In replays, it lands at a fixed number of samples after submitting instead, so that playback speed does not
+    /// change results.
+    if (!Clock::Global().Deterministic())
+        ApplyFit();
+    else if (fit_landing_ && samples_since_submit_ >= std::min(kFitLandingSamples, refit_interval_)) {
+        fitter_.Wait();
+        fit_landing_ = false;
+        ApplyFit();
     }
+
+    /// Parameters are refined on every valid frame
+    if (!estimator_.Valid())
+        return;
+    const auto &estimation = estimator_.GetParameters();
+    amplitude_ = estimation.amplitude;
+    omega_ = estimation.omega;
+    phi_ = estimation.phi;
+    b_ = estimation.b;
+    is_need_to_fit_ = 0;
+
+    /// Refine by a full fit on background periodically
+    if (refit_interval_ > 0 && samples_since_submit_ >= refit_interval_)
+        SubmitFit();
+}
+
+void RunePredictor::SubmitFit() {
+    std::vector<double> time_data, speed_data;
+    estimator_.Snapshot(time_data, speed_data);
+
+    // Busy fitter rejects the snapshot, then try again in the next frame.
+    if (fitter_.Submit(std::move(time_data), std::move(speed_data), {amplitude_, omega_, phi_})) {
+        samples_since_submit_ = 0;
+        fit_landing_ = Clock::Global().Deterministic();
+    }
+}
+
+void RunePredictor::ApplyFit() {
+    RuneFunctionFitter::Parameters parameters{};
+    const uint64_t version = fitter_.GetParameters(parameters);
+    if (version == fit_version_)
+        return;
+    fit_version_ = version;
+    if (estimator_.Reseed({parameters.amplitude, parameters.omega, parameters.phi, 2.090 - parameters.amplitude}))
+        DLOG(INFO) << "Rune speed estimator is reseeded by background fit.";
 }
 
 /**
 * @Brief: calculate rotated angle
 */
 void RunePredictor::CalPredictAngle() {
+    CalFunctionParameters();
     if (is_need_to_fit_) {
-        CalFunctionParameters();
         rotated_angle_ = 0;
         CalCurrentFanAngle();
         predicted_angle_ = current_fan_angle_;
@@ -189,10 +202,8 @@ void RunePredictor::CalPredictAngle() {
 * @Brief: calculate radius
 */
 double RunePredictor::CalRadius() const {
-    return sqrt((rune_.RtpVec().x - rune_.CenterR().x) *
-                (rune_.RtpVec().x - rune_.CenterR().x)
-                + (rune_.RtpVec().y - rune_.CenterR().y) *
-                  (rune_.RtpVec().y - rune_.CenterR().y));
+    // RtpVec is already the vector from center R to armor center P.
+    return std::hypot(rune_.RtpVec().x, rune_.RtpVec().y);
 }
 
 /**
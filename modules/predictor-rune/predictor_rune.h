@@ -7,28 +7,12 @@
 #ifndef PREDICTOR_RUNE_H_
 #define PREDICTOR_RUNE_H_
 
-#include <ceres/ceres.h>
 #include "data-structure/buffer.h"
 #include "data-structure/frame.h"
 #include "data-structure/communication.h"
 #include "digital-twin/facilities/power_rune.h"
-
-// Ceres.
-struct TrigonometricResidual {
-    TrigonometricResidual(double _x, double _y, int rotate_direction) :
-            x(_x), y(_y),
-            rotate_direction(rotate_direction) {}
-
-    template<typename T>
-    bool operator()(const T *const a, const T *const omega, const T *const phi, T *residual) const {
-        residual[0] = y - (-1.0) * rotate_direction * (a[0] * sin(omega[0] * x + phi[0]) + 2.090 - a[0]);
-        return true;
-    }
-
-    double x;
-    double y;
-    int rotate_direction;
-};
+#include "predictor_rune_fitter.h"
+#include "rune_speed_estimator.h"
 
 class RunePredictor : NO_COPY, NO_MOVE {
 public:
@@ -45,15 +29,26 @@ public:
               last_RTG_vec_(0, 0),
               is_target_changed_(false),
               is_small_model_(false),
-              is_big_model_(false) {};
+              is_big_model_(false),
+              fitter_({amplitude_, omega_, phi_}) {};
 
     ~RunePredictor() = default;
 
-    /// 参数初始化
-    [[nodiscard]] static bool Initialize(const std::string &config_path);
+    /**
+     * \brief Initialize predictor.
+     * \param [in] config_path Config file path.
+     * \return Whether predictor is initialized.
+     */
+    [[nodiscard]] bool Initialize(const std::string &config_path);
 
     SendPacket Predict(const PowerRune &power_rune);
 
+    /// \return Radius from center R to armor center P of last predicted power rune in pixels.
+    [[nodiscard]] double CalRadius() const;
+
+    /// \return Statistics of background fits of speed function.
+    [[nodiscard]] inline RuneFunctionFitter::Statistics GetFitStatistics() const { return fitter_.GetStatistics(); }
+
 private:
     PowerRune rune_;
 
@@ -70,8 +65,8 @@ private:
 
     double current_fan_angular_velocity_;
     cv::Point2f last_RTG_vec_;                                                  // 上一帧能量机关中心R指向扇叶中心G的矢量
-    std::chrono::high_resolution_clock::time_point last_time_;                  // 上一有效帧的时间戳
-    CircularBuffer<std::pair<std::chrono::high_resolution_clock::time_point, float>, 16> circle_fan_palstance_queue;
+    uint64_t last_time_{};                                                      // 上一有效帧的时间戳, in ns
+    SPSCBuffer<std::pair<uint64_t, float>, 16> circle_fan_palstance_queue;
 
     /// calculate current_fan_angle_
     void CalCurrentFanAngle();
@@ -82,17 +77,25 @@ private:
     /// calculate function parameters
     void CalFunctionParameters();
 
-    int is_okay_to_fit_ = 0;
-    std::vector<double> speed_data_;
-    std::vector<double> time_data_;
+    /// Submit samples in window of estimator to background fitter.
+    void SubmitFit();
+
+    /// Reseed estimator by the latest background fit if it is not used yet.
+    void ApplyFit();
+
+    /// New samples after submitting when a background fit is applied with deterministic clocks, see Clock.
+    static constexpr int kFitLandingSamples = 30;
+
+    RuneSpeedEstimator estimator_;  ///< Incremental estimator of speed function.
+    int refit_interval_ = 0;        ///< New samples between background fits, 0 to disable them.
+    int samples_since_submit_ = 0;  ///< New samples since the last submitted fit.
+    bool fit_landing_ = false;      ///< Whether a submitted fit is not applied yet, only with deterministic clocks.
+    uint64_t fit_version_ = 0;      ///< Version of the last background fit, see RuneFunctionFitter::GetParameters.
     double amplitude_ = 0.780;
     double omega_ = 1.884;
     double phi_ = 0;
     double b_ = 2.090 - amplitude_;
 
-    const int kNumObservation = 300;
-    const int kPrepareNum = 1000;
-
     /// calculate rotated angle
     double CalRadIntegralFromSpeed(const double &integral_time);
 
@@ -106,8 +109,6 @@ private:
     /// calculate predict point
     void CalPredictPoint();
 
-    double CalRadius() const;
-
     cv::Point2f predicted_target_point_;  // 旋转后的装甲板中心, without offset
 
     /// offset
@@ -125,6 +126,8 @@ private:
     bool is_target_changed_;  // 目标是否切换
     bool is_big_model_;       // 是否是大能量机关
     bool is_small_model_;     // 是否是小能量机关
+
+    RuneFunctionFitter fitter_;  ///< Background fitter, declared last to stop its worker first.
 };
 
 #endif  // PREDICTOR_RUNE_H_
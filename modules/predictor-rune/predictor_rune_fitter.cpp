@@ -0,0 +1,111 @@
+#include <algorithm>
+#include <chrono>
+#include <glog/logging.h>
+#include "predictor_rune_fitter.h"
+
+RuneFunctionFitter::RuneFunctionFitter(const Parameters &initial_parameters) :
+        parameters_(initial_parameters),
+        initial_parameters_(initial_parameters),
+        pending_(false),
+        busy_(false),
+        stop_flag_(false),
+        fits_(0),
+        failures_(0),
+        total_latency_(0),
+        max_latency_(0) {
+    worker_ = std::thread(&RuneFunctionFitter::WorkerLoop, this);
+}
+
+RuneFunctionFitter::~RuneFunctionFitter() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_flag_ = true;
+    }
+    submitted_.notify_one();
+    if (worker_.joinable())
+        worker_.join();
+}
+
+bool RuneFunctionFitter::Submit(std::vector<double> time_data, std::vector<double> speed_data,
+                                const Parameters &initial_parameters) {
+    if (time_data.empty() || time_data.size() != speed_data.size()) {
+        LOG(ERROR) << "Invalid snapshot with " << time_data.size() << " time samples and "
+                   << speed_data.size() << " speed samples to fit power rune speed function.";
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (busy_)
+            return false;
+        time_data_ = std::move(time_data);
+        speed_data_ = std::move(speed_data);
+        initial_parameters_ = initial_parameters;
+        pending_ = busy_ = true;
+    }
+    submitted_.notify_one();
+    return true;
+}
+
+void RuneFunctionFitter::Wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    finished_.wait(lock, [this] { return !busy_; });
+}
+
+RuneFunctionFitter::Statistics RuneFunctionFitter::GetStatistics() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return {fits_, failures_, fits_ ? total_latency_ / double(fits_) : 0, max_latency_};
+}
+
+void RuneFunctionFitter::WorkerLoop() {
+    std::vector<double> time_data, speed_data;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        submitted_.wait(lock, [this] { return stop_flag_ || pending_; });
+        if (stop_flag_)
+            return;
+        pending_ = false;
+        time_data.swap(time_data_);
+        speed_data.swap(speed_data_);
+        Parameters parameters = initial_parameters_;
+        lock.unlock();
+
+        const auto start_time = std::chrono::steady_clock::now();
+        ceres::Problem problem;
+        for (size_t i = 0; i < time_data.size(); ++i)
+            problem.AddResidualBlock(
+                    new ceres::AutoDiffCostFunction<TrigonometricResidual, 1, 1, 1, 1>(
+                            new TrigonometricResidual(time_data[i], speed_data[i])),
+                    new ceres::CauchyLoss(0.5),
+                    &parameters.amplitude,
+                    &parameters.omega,
+                    &parameters.phi);
+        ceres::Solver::Options options;
+        options.max_num_iterations = 300;
+        options.linear_solver_type = ceres::DENSE_QR;
+        options.minimizer_progress_to_stdout = false;
+        ceres::Solver::Summary summary;
+        ceres::Solve(options, &problem, &summary);
+        const bool usable = summary.IsSolutionUsable();
+        if (usable)
+            parameters_.Publish(parameters);
+        const double latency = std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - start_time).count();
+
+        if (usable)
+            LOG(INFO) << "Fitted power rune speed function with " << time_data.size() << " samples in "
+                      << latency << " ms, A = " << parameters.amplitude << ", omega = " << parameters.omega
+                      << ", phi = " << parameters.phi << ". " << summary.BriefReport();
+        else
+            LOG(WARNING) << "Failed to fit power rune speed function with " << time_data.size() << " samples in "
+                         << latency << " ms, keep previous parameters. " << summary.BriefReport();
+
+        lock.lock();
+        ++fits_;
+        if (!usable)
+            ++failures_;
+        total_latency_ += latency;
+        max_latency_ = std::max(max_latency_, latency);
+        busy_ = false;
+        finished_.notify_all();
+    }
+}
@@ -0,0 +1,108 @@
+/**
+ * Background fitter of power rune speed function header.
+ * \author trantuan-20048607
+ * \date 2022.3.30
+ * \details Fit speed function of power rune by Ceres in a worker thread, so that the frame loop never waits.
+ */
+
+#ifndef PREDICTOR_RUNE_FITTER_H_
+#define PREDICTOR_RUNE_FITTER_H_
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <ceres/ceres.h>
+#include "data-structure/double_buffer.h"
+#include "lang-feature-extension/disable_constructor.h"
+
+// Ceres.
+struct TrigonometricResidual {
+    TrigonometricResidual(double _x, double _y) :
+            x(_x), y(_y) {}
+
+    template<typename T>
+    bool operator()(const T *const a, const T *const omega, const T *const phi, T *residual) const {
+        residual[0] = y - (a[0] * sin(omega[0] * x + phi[0]) + 2.090 - a[0]);
+        return true;
+    }
+
+    double x;  ///< Time.
+    double y;  ///< Speed magnitude, direction is not included.
+};
+
+/**
+ * \brief Fit speed function of power rune in a worker thread.
+ * \details Callers submit snapshots of samples with initial parameters, and the worker solves them one at a time.
+ *   Parameters are published through a lock-free double buffer, so callers keep using the previous ones
+ *   until a new fit lands.
+ */
+class RuneFunctionFitter : NO_COPY, NO_MOVE {
+public:
+    /// \brief Parameters of speed function a * sin(omega * t + phi) + 2.090 - a.
+    struct Parameters {
+        double amplitude;  ///< Amplitude a.
+        double omega;      ///< Angular frequency omega.
+        double phi;        ///< Initial phase phi.
+    };
+
+    /// \brief Statistics of fits.
+    struct Statistics {
+        uint64_t fits;           ///< Number of finished fits.
+        uint64_t failures;       ///< Number of fits without usable solution.
+        double average_latency;  ///< Average solving time in milliseconds.
+        double max_latency;      ///< Max solving time in milliseconds.
+    };
+
+    /// \param [in] initial_parameters Parameters before any fit finishes.
+    explicit RuneFunctionFitter(const Parameters &initial_parameters);
+
+    ~RuneFunctionFitter();
+
+    /**
+     * \brief Submit a snapshot of samples to fit in worker thread.
+     * \param [in] time_data Time of samples in seconds.
+     * \param [in] speed_data Angular speed magnitude of samples in rad/s.
+     * \param [in] initial_parameters Start point of this fit.
+     * \return Whether snapshot is accepted, false when the last fit is still running.
+     */
+    bool Submit(std::vector<double> time_data, std::vector<double> speed_data, const Parameters &initial_parameters);
+
+    /**
+     * \brief Get parameters of the latest fit without locking.
+     * \param [out] parameters Latest parameters, initial parameters before any fit finishes.
+     * \return Number of published fits, which changes when new parameters land.
+     */
+    inline uint64_t GetParameters(Parameters &parameters) const { return parameters_.Read(parameters); }
+
+    /// \brief Wait until the submitted snapshot is solved and its parameters are published if usable.
+    void Wait();
+
+    /// \return Statistics of finished fits.
+    [[nodiscard]] Statistics GetStatistics() const;
+
+private:
+    /// \brief Solve submitted snapshots until stopped.
+    void WorkerLoop();
+
+    DoubleBuffer<Parameters> parameters_;  ///< Published parameters.
+
+    std::vector<double> time_data_;   ///< Time of samples of the pending snapshot.
+    std::vector<double> speed_data_;  ///< Speed of samples of the pending snapshot.
+    Parameters initial_parameters_;   ///< Start point of the pending snapshot.
+    bool pending_;                    ///< Whether a snapshot is waiting for the worker.
+    bool busy_;                       ///< Whether a snapshot is pending or being solved.
+    bool stop_flag_;                  ///< Stop worker thread.
+
+    uint64_t fits_;         ///< Number of finished fits.
+    uint64_t failures_;     ///< Number of failed fits.
+    double total_latency_;  ///< Sum of solving time in milliseconds.
+    double max_latency_;    ///< Max solving time in milliseconds.
+
+    mutable std::mutex mutex_;           ///< Mutex lock for all members above except parameters.
+    std::condition_variable submitted_;  ///< Notified when a snapshot is submitted or worker is stopped.
+    std::condition_variable finished_;   ///< Notified when a snapshot is solved.
+    std::thread worker_;                 ///< Worker thread running Ceres.
+};
+
+#endif  // PREDICTOR_RUNE_FITTER_H_
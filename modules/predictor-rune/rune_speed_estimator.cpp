@@ -0,0 +1,189 @@
+#include <algorithm>
+#include <cmath>
+#include <Eigen/Dense>
+#include "rune_speed_estimator.h"
+
+namespace {
+    constexpr double kMaxSpeed = 5;              ///< Max possible speed, larger samples come from fan switching.
+    constexpr double kMinOmega = 1.884;          ///< Min angular frequency of speed function.
+    constexpr double kMaxOmega = 2.000;          ///< Max angular frequency of speed function.
+    constexpr int kNumInitialOmegas = 13;        ///< Number of angular frequencies on initialization grid.
+    constexpr double kCauchyScale = 0.5;         ///< Scale of Cauchy loss in rad/s.
+    constexpr double kInitialLambda = 1e-3;      ///< Initial damping factor.
+    constexpr double kMinLambda = 1e-7;          ///< Min damping factor.
+    constexpr double kMaxLambda = 1e3;           ///< Max damping factor.
+    constexpr double kLambdaScale = 10;          ///< Scale of damping factor after a step.
+
+    /// \brief Keep amplitude non-negative, omega in range and phi in [-pi, pi].
+    RuneSpeedEstimator::Parameters Normalize(RuneSpeedEstimator::Parameters parameters) {
+        if (parameters.amplitude < 0) {
+            parameters.amplitude = -parameters.amplitude;
+            parameters.phi += M_PI;
+        }
+        parameters.omega = std::clamp(parameters.omega, kMinOmega, kMaxOmega);
+        parameters.phi = std::remainder(parameters.phi, 2 * M_PI);
+        return parameters;
+    }
+}
+
+RuneSpeedEstimator::RuneSpeedEstimator() :
+        bin_sum_{0, 0},
+        bin_begin_(0),
+        bin_size_(0),
+        parameters_{0, kMinOmega, 0, 0},
+        time_origin_(0),
+        lambda_(kInitialLambda),
+        bins_since_initialize_(0),
+        valid_(false) {}
+
+void RuneSpeedEstimator::Reset() {
+    window_.Clear();
+    bin_sum_ = {0, 0};
+    bin_begin_ = 0;
+    bin_size_ = 0;
+    parameters_ = {0, kMinOmega, 0, 0};
+    time_origin_ = 0;
+    lambda_ = kInitialLambda;
+    bins_since_initialize_ = 0;
+    valid_ = false;
+}
+
+bool RuneSpeedEstimator::Update(double time, double speed) {
+    if (!std::isfinite(time) || !(speed >= 0 && speed < kMaxSpeed))
+        return valid_;
+    if (window_.Empty() && bin_size_ == 0)
+        time_origin_ = time;
+    time -= time_origin_;
+
+    // Close the open bin when this sample is out of it, otherwise keep collecting.
+    if (bin_size_ == 0 || time - bin_begin_ < kBinWidth) {
+        if (bin_size_ == 0)
+            bin_begin_ = time;
+        bin_sum_.time += time;
+        bin_sum_.speed += speed;
+        ++bin_size_;
+        return valid_;
+    }
+    window_.Push({bin_sum_.time / bin_size_, bin_sum_.speed / bin_size_});
+    bin_sum_ = {time, speed};
+    bin_begin_ = time;
+    bin_size_ = 1;
+    ++bins_since_initialize_;
+    if (window_.Size() < kMinBins)
+        return valid_;
+
+    // Initialize again once the whole window is replaced, in case power rune is reset.
+    if (!valid_ || bins_since_initialize_ >= kWindowSize) {
+        const auto initial_parameters = Initialize();
+        if (!valid_ || Cost(initial_parameters) < Cost(parameters_)) {
+            parameters_ = initial_parameters;
+            lambda_ = kInitialLambda;
+        }
+        bins_since_initialize_ = 0;
+        valid_ = true;
+    }
+    Iterate();
+    return true;
+}
+
+bool RuneSpeedEstimator::Reseed(const Parameters &parameters) {
+    if (!valid_ || !std::isfinite(parameters.amplitude) || !std::isfinite(parameters.omega)
+        || !std::isfinite(parameters.phi) || !std::isfinite(parameters.b))
+        return false;
+    const auto candidate = Normalize(parameters);
+    if (Cost(candidate) >= Cost(parameters_))
+        return false;
+    parameters_ = candidate;
+    lambda_ = kInitialLambda;
+    return true;
+}
+
+void RuneSpeedEstimator::Snapshot(std::vector<double> &time_data, std::vector<double> &speed_data) const {
+    time_data.resize(window_.Size());
+    speed_data.resize(window_.Size());
+    for (unsigned int i = 0; i < window_.Size(); ++i) {
+        time_data[i] = window_[i].time;
+        speed_data[i] = window_[i].speed;
+    }
+}
+
+RuneSpeedEstimator::Parameters RuneSpeedEstimator::Initialize() const {
+    Parameters best_parameters = parameters_;
+    double best_cost = INFINITY;
+    for (int i = 0; i < kNumInitialOmegas; ++i) {
+        const double omega = kMinOmega + (kMaxOmega - kMinOmega) * i / (kNumInitialOmegas - 1);
+
+        // With fixed omega, speed is linear in (a * cos(phi), a * sin(phi), b) with basis (sin, cos, 1).
+        Eigen::Matrix3d normal = Eigen::Matrix3d::Zero();
+        Eigen::Vector3d projection = Eigen::Vector3d::Zero();
+        for (unsigned int j = 0; j < window_.Size(); ++j) {
+            const auto &sample = window_[j];
+            const Eigen::Vector3d basis(std::sin(omega * sample.time), std::cos(omega * sample.time), 1);
+            normal.noalias() += basis * basis.transpose();
+            projection.noalias() += sample.speed * basis;
+        }
+        const Eigen::Vector3d solution = normal.ldlt().solve(projection);
+        if (!solution.allFinite())
+            continue;
+
+        const auto parameters = Normalize({std::hypot(solution[0], solution[1]), omega,
+                                           std::atan2(solution[1], solution[0]), solution[2]});
+        const double cost = Cost(parameters);
+        if (cost < best_cost) {
+            best_cost = cost;
+            best_parameters = parameters;
+        }
+    }
+    return best_parameters;
+}
+
+void RuneSpeedEstimator::Iterate() {
+    // Linearize around the window center, so that omega and phase are not coupled by large time.
+    const double center = (window_.Front().time + window_.Back().time) / 2;
+    const double amplitude = parameters_.amplitude, omega = parameters_.omega;
+    const double phase = parameters_.phi + omega * center;
+
+    Eigen::Matrix4d hessian = Eigen::Matrix4d::Zero();
+    Eigen::Vector4d gradient = Eigen::Vector4d::Zero();
+    double cost = 0;
+    for (unsigned int i = 0; i < window_.Size(); ++i) {
+        const auto &sample = window_[i];
+        const double dt = sample.time - center;
+        const double sin_theta = std::sin(omega * dt + phase), cos_theta = std::cos(omega * dt + phase);
+        const double residual = sample.speed - amplitude * sin_theta - parameters_.b;
+        const double scaled_residual = residual / kCauchyScale;
+        const double weight = 1 / (1 + scaled_residual * scaled_residual);
+        cost += std::log1p(scaled_residual * scaled_residual);
+
+        const Eigen::Vector4d jacobian(sin_theta, amplitude * dt * cos_theta, amplitude * cos_theta, 1);
+        hessian.noalias() += weight * jacobian * jacobian.transpose();
+        gradient.noalias() += weight * residual * jacobian;
+    }
+    for (int i = 0; i < 4; ++i)
+        hessian(i, i) += lambda_ * hessian(i, i) + 1e-9;
+
+    const Eigen::Vector4d step = hessian.ldlt().solve(gradient);
+    if (!step.allFinite()) {
+        lambda_ = std::min(lambda_ * kLambdaScale, kMaxLambda);
+        return;
+    }
+    const double new_omega = std::clamp(omega + step[1], kMinOmega, kMaxOmega);
+    const auto candidate = Normalize({amplitude + step[0], new_omega,
+                                      phase + step[2] - new_omega * center, parameters_.b + step[3]});
+    if (Cost(candidate) < cost) {
+        parameters_ = candidate;
+        lambda_ = std::max(lambda_ / kLambdaScale, kMinLambda);
+    } else
+        lambda_ = std::min(lambda_ * kLambdaScale, kMaxLambda);
+}
+
+double RuneSpeedEstimator::Cost(const Parameters &parameters) const {
+    double cost = 0;
+    for (unsigned int i = 0; i < window_.Size(); ++i) {
+        const auto &sample = window_[i];
+        const double scaled_residual = (sample.speed - parameters.amplitude * std::sin(
+                parameters.omega * sample.time + parameters.phi) - parameters.b) / kCauchyScale;
+        cost += std::log1p(scaled_residual * scaled_residual);
+    }
+    return cost;
+}
@@ -0,0 +1,104 @@
+/**
+ * Incremental estimator of power rune speed function header.
+ * \author trantuan-20048607
+ * \date 2022.3.30
+ * \details Estimate speed function a * sin(omega * t + phi) + b of power rune over a sliding window of samples,
+ *   with one warm-started Levenberg-Marquardt iteration per window slot, so parameters follow drift continuously
+ *   at constant memory and microseconds per frame.
+ */
+
+#ifndef RUNE_SPEED_ESTIMATOR_H_
+#define RUNE_SPEED_ESTIMATOR_H_
+
+#include <vector>
+#include "data-structure/sliding_window.h"
+#include "lang-feature-extension/attr_reader.h"
+#include "lang-feature-extension/disable_constructor.h"
+
+/**
+ * \brief Incremental estimator of power rune speed function.
+ * \details Samples are averaged in time bins, and each bin takes a slot of window, so that window covers more than
+ *   one period of speed function regardless of frame rate. Parameters are initialized by linear least squares of
+ *   (a * cos(phi), a * sin(phi), b) on a grid of omega, once window holds enough bins. Then every new bin refines
+ *   them by a damped Gauss-Newton step with Cauchy weights, and the initialization is repeated once the whole window
+ *   is replaced, to escape from local minima after power rune is reset.
+ * \attention Time of samples is relative to the first sample after reset, see TimeOrigin().
+ */
+class RuneSpeedEstimator : NO_COPY, NO_MOVE {
+public:
+    /// \brief Parameters of speed function a * sin(omega * t + phi) + b, in rad/s.
+    struct Parameters {
+        double amplitude;  ///< Amplitude a.
+        double omega;      ///< Angular frequency omega.
+        double phi;        ///< Initial phase phi at TimeOrigin().
+        double b;          ///< Offset b.
+    };
+
+    /// \brief Average sample of speed in a time bin.
+    struct Sample {
+        double time;   ///< Time relative to TimeOrigin() in seconds.
+        double speed;  ///< Angular speed in rad/s.
+    };
+
+    static constexpr unsigned int kWindowSize = 256;  ///< Max number of bins in window.
+    static constexpr unsigned int kMinBins = 64;   ///< Min number of bins before parameters are valid.
+    static constexpr double kBinWidth = 0.02;         ///< Time width of bins in seconds.
+
+    ATTR_READER_REF(parameters_, GetParameters)
+
+    ATTR_READER(valid_, Valid)
+
+    ATTR_READER(time_origin_, TimeOrigin)
+
+    RuneSpeedEstimator();
+
+    ~RuneSpeedEstimator() = default;
+
+    /// \brief Drop all samples and parameters.
+    void Reset();
+
+    /**
+     * \brief Add a sample and refine parameters.
+     * \param [in] time Time of sample in seconds.
+     * \param [in] speed Angular speed in rad/s, samples out of possible range are dropped.
+     * \return Whether parameters are valid.
+     */
+    bool Update(double time, double speed);
+
+    /**
+     * \brief Replace parameters when they fit samples in window better, e.g. with result of a full fit.
+     * \param [in] parameters Parameters in the same time base as this estimator.
+     * \return Whether parameters are replaced.
+     */
+    bool Reseed(const Parameters &parameters);
+
+    /**
+     * \brief Copy bins in window, from the oldest to the latest.
+     * \param [out] time_data Time of samples relative to TimeOrigin().
+     * \param [out] speed_data Speed of samples.
+     */
+    void Snapshot(std::vector<double> &time_data, std::vector<double> &speed_data) const;
+
+private:
+    /// \brief Initialize parameters by linear least squares on a grid of omega.
+    /// \return Best parameters on the grid.
+    [[nodiscard]] Parameters Initialize() const;
+
+    /// \brief Refine parameters by one damped Gauss-Newton step.
+    void Iterate();
+
+    /// \return Robust cost of parameters over window.
+    [[nodiscard]] double Cost(const Parameters &parameters) const;
+
+    SlidingWindow<Sample, kWindowSize> window_;  ///< Latest bins.
+    Sample bin_sum_;                              ///< Sum of samples in the open bin.
+    double bin_begin_;                            ///< Time of the first sample in the open bin.
+    unsigned int bin_size_;                       ///< Number of samples in the open bin.
+    Parameters parameters_;                       ///< Current parameters.
+    double time_origin_;                          ///< Absolute time of the first sample after reset.
+    double lambda_;                               ///< Damping factor of Levenberg-Marquardt steps.
+    unsigned int bins_since_initialize_;          ///< Bins since the last grid initialization.
+    bool valid_;                                  ///< Whether parameters are valid.
+};
+
+#endif  // RUNE_SPEED_ESTIMATOR_H_
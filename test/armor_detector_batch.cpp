@@ -0,0 +1,113 @@
+#include <cstdio>
+#include <vector>
+#include <opencv2/core.hpp>
+#include <glog/logging.h>
+#include "detector-armor/detector_armor.h"
+#include "detector-armor/detector_armor_backend_factory.h"
+
+/**
+ * \brief Backend running a stub model instead of the network, to test batching without GPU.
+ * \details Every output box is placed by the average color of input, so outputs of different images differ.
+ */
+class StubBackend final : public ArmorDetectorBackend {
+public:
+    static std::vector<int> batch_sizes;  ///< Batch sizes of all inferences.
+    static bool fail;                     ///< Fail all inferences.
+
+    bool Initialize([[maybe_unused]] const std::string &onnx_file) final {
+        return true;
+    }
+
+    bool Infer(const cv::Mat &input, float *output_topk) final {
+        CHECK(input.isContinuous());
+        CHECK_EQ(input.type(), CV_32FC3);
+        CHECK_EQ(input.rows, kInputHeight);
+        CHECK_EQ(input.cols, kInputWidth);
+        if (fail)
+            return false;
+
+        const auto mean = cv::mean(input);
+        for (int i = 0; i < kTopkNum; ++i) {
+            auto *box = output_topk + i * kBoxSize;
+            const float x = 20.f * float(i) + float(mean[0]), y = 10.f + float(mean[1]);
+            const float corners[8] = {x, y, x, y + 4, x + 8, y + 4, x + 8, y};
+            std::copy(corners, corners + 8, box);
+            box[8] = 3.f - 0.05f * float(i);
+            std::fill(box + 9, box + kBoxSize, 0.f);
+            box[9 + i % 4] = 1.f;
+            box[13 + i % 7] = float(mean[2]);
+        }
+        return true;
+    }
+
+    [[nodiscard]] int MaxBatchSize() const final { return 8; }
+
+    bool InferBatch(const cv::Mat &input, int batch_size, float *output_topk) final {
+        CHECK_EQ(input.rows, batch_size * kInputHeight);
+        batch_sizes.push_back(batch_size);
+        return ArmorDetectorBackend::InferBatch(input, batch_size, output_topk);
+    }
+
+private:
+    [[maybe_unused]] static ArmorDetectorBackendRegistry<StubBackend> registry_;
+};
+
+std::vector<int> StubBackend::batch_sizes;
+bool StubBackend::fail = false;
+[[maybe_unused]] ArmorDetectorBackendRegistry<StubBackend> StubBackend::registry_ =
+        ArmorDetectorBackendRegistry<StubBackend>("stub");
+
+/// \brief Check batched prediction against image by image prediction.
+void TestBatch(ArmorDetector &detector, const std::vector<cv::Mat> &images, int max_batch_size,
+               const std::vector<int> &expected_batch_sizes) {
+    detector.SetMaxBatchSize(max_batch_size);
+
+    std::vector<std::vector<bbox_t>> expected(images.size());
+    for (size_t i = 0; i < images.size(); ++i)
+        detector(images[i], expected[i]);
+
+    StubBackend::batch_sizes.clear();
+    std::vector<std::vector<bbox_t>> boxes;
+    detector(images, boxes);
+    CHECK(StubBackend::batch_sizes == expected_batch_sizes) << "Unexpected batch sizes.";
+    CHECK_EQ(boxes.size(), images.size());
+    for (size_t i = 0; i < images.size(); ++i) {
+        CHECK(!boxes[i].empty());
+        CHECK(boxes[i] == expected[i]) << "Boxes of image " << i << " mismatch.";
+    }
+    printf("Passed %zu images with max batch size %d.\n", images.size(), max_batch_size);
+}
+
+int main(int argc, char *argv[]) {
+    google::InitGoogleLogging(argv[0]);
+
+    ArmorDetector detector;
+    CHECK(detector.Initialize("", "stub"));
+
+    // Images of different sizes and colors, including one of model input size.
+    std::vector<cv::Mat> images;
+    cv::RNG rng(0x5f3759df);
+    const cv::Size sizes[] = {{1280, 1024}, {640, 384}, {320, 192}, {800, 600}, {1280, 720}};
+    for (int i = 0; i < 9; ++i) {
+        images.emplace_back(sizes[i % 5], CV_8UC3);
+        rng.fill(images.back(), cv::RNG::UNIFORM, cv::Scalar::all(0), cv::Scalar::all(32 + 24 * i));
+    }
+
+    TestBatch(detector, images, 4, {3, 3, 3});
+    TestBatch(detector, images, 1, {1, 1, 1, 1, 1, 1, 1, 1, 1});
+    TestBatch(detector, images, 16, {4, 5});  // Limited by backend.
+    TestBatch(detector, {images.front()}, 4, {1});
+    TestBatch(detector, {}, 4, {});
+
+    // Failed batches output no boxes.
+    StubBackend::fail = true;
+    std::vector<std::vector<bbox_t>> boxes;
+    detector(images, boxes);
+    CHECK_EQ(boxes.size(), images.size());
+    for (const auto &image_boxes: boxes)
+        CHECK(image_boxes.empty());
+    printf("Passed failed inference.\n");
+
+    printf("All tests passed.\n");
+    return 0;
+}
@@ -0,0 +1,146 @@
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <opencv2/core.hpp>
+#include <glog/logging.h>
+#include "detector-armor/detector_armor_async.h"
+
+/**
+ * \brief Stub model doubling input values, failing on negative values.
+ * \details Each inference blocks until the test allows it, so that tests control when requests finish
+ *   instead of depending on timing. Requests preparing or inferring at the same time are counted.
+ */
+class StubModel {
+public:
+    /// \brief Inference, blocking until allowed.
+    bool Infer(const cv::Mat &input, float *output) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        ++started_;
+        ++in_flight_;
+        max_in_flight_ = std::max(max_in_flight_, in_flight_);
+        changed_.notify_all();
+        changed_.wait(lock, [this] { return allowed_ > 0; });
+        --allowed_;
+        --in_flight_;
+        output[0] = 2 * input.at<float>(0, 0);
+        return input.at<float>(0, 0) >= 0;
+    }
+
+    /// \brief Preparing writing a value, failing on NaN.
+    AsyncInference::PrepareFunction Prepare(float value) {
+        return [this, value](cv::Mat &input) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                max_in_flight_ = std::max(max_in_flight_, in_flight_ + 1);
+            }
+            input.create(1, 1, CV_32FC1);
+            input.at<float>(0, 0) = value;
+            return !std::isnan(value);
+        };
+    }
+
+    /// \brief Allow some more inferences to finish.
+    void Allow(int count) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        allowed_ += count;
+        changed_.notify_all();
+    }
+
+    /// \brief Wait until some inferences have started.
+    void WaitStarted(int count) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        changed_.wait(lock, [this, count] { return started_ >= count; });
+    }
+
+    /// \return Max number of requests preparing or inferring at the same time, and reset it.
+    int TakeMaxInFlight() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const int max_in_flight = max_in_flight_;
+        max_in_flight_ = 0;
+        return max_in_flight;
+    }
+
+private:
+    int allowed_ = 0;        ///< Number of inferences allowed to finish.
+    int started_ = 0;        ///< Number of started inferences.
+    int in_flight_ = 0;      ///< Number of blocked inferences.
+    int max_in_flight_ = 0;  ///< Max number of requests preparing or inferring at the same time.
+
+    std::mutex mutex_;
+    std::condition_variable changed_;
+};
+
+/// \brief Submit requests one by one and collect each after submitting the next, as a pipeline does.
+void TestPipelined(AsyncInference &async, StubModel &model, int num_requests) {
+    const float *output;
+    AsyncInference::Ticket last_ticket = 0;
+    for (int i = 0; i <= num_requests; ++i) {
+        // Preparing of each request happens while inference of the last one is blocked.
+        AsyncInference::Ticket ticket = 0;
+        if (i > 0)
+            model.WaitStarted(i);
+        if (i < num_requests)
+            ticket = async.Submit(model.Prepare(float(i)));
+        if (i > 0) {
+            model.Allow(1);
+            CHECK_EQ(async.Wait(last_ticket, output), AsyncInference::kDone);
+            CHECK_EQ(output[0], 2.f * float(i - 1)) << "Result of ticket " << last_ticket << " mismatches.";
+            async.Release(last_ticket);
+            CHECK_EQ(async.Poll(last_ticket, output), AsyncInference::kInvalid);
+        }
+        last_ticket = ticket;
+    }
+
+    CHECK_EQ(model.TakeMaxInFlight(), 2) << "Requests are not overlapped.";
+    printf("Passed %d pipelined requests.\n", num_requests);
+}
+
+int main(int argc, char *argv[]) {
+    google::InitGoogleLogging(argv[0]);
+
+    StubModel model;
+    AsyncInference async(3, 1, [&model](const cv::Mat &input, float *output) {
+        return model.Infer(input, output);
+    });
+    CHECK_EQ(async.NumSlots(), 3u);
+    TestPipelined(async, model, 20);
+
+    // Poll returns pending before inference is allowed to finish.
+    const float *output;
+    auto ticket = async.Submit(model.Prepare(1));
+    CHECK_EQ(async.Poll(ticket, output), AsyncInference::kPending);
+    model.Allow(1);
+    CHECK_EQ(async.Wait(ticket, output), AsyncInference::kDone);
+    CHECK_EQ(async.Poll(ticket, output), AsyncInference::kDone);
+    CHECK_EQ(output[0], 2.f);
+    async.Release(ticket);
+    printf("Passed polling.\n");
+
+    // Failed preparing and inference do not block following requests.
+    model.Allow(2);
+    const auto failed_prepare = async.Submit(model.Prepare(NAN));
+    const auto failed_infer = async.Submit(model.Prepare(-1));
+    ticket = async.Submit(model.Prepare(3));
+    CHECK_EQ(async.Wait(failed_prepare, output), AsyncInference::kFailed);
+    CHECK_EQ(async.Wait(failed_infer, output), AsyncInference::kFailed);
+    CHECK_EQ(async.Wait(ticket, output), AsyncInference::kDone);
+    CHECK_EQ(output[0], 6.f);
+    for (auto t: {failed_prepare, failed_infer, ticket})
+        async.Release(t);
+    printf("Passed failed requests.\n");
+
+    const auto statistics = async.GetStatistics();
+    CHECK_EQ(statistics.requests, 24u);
+    CHECK_EQ(statistics.failures, 2u);
+    CHECK_GE(statistics.average_queue_depth, 1);
+    CHECK_LE(statistics.average_queue_depth, 3);
+    CHECK_GE(statistics.max_latency, statistics.average_latency);
+    printf("Requests: %lu, failures: %lu, average queue depth: %lf, average latency: %lf ms, max latency: %lf ms.\n",
+           (unsigned long) statistics.requests, (unsigned long) statistics.failures,
+           statistics.average_queue_depth, statistics.average_latency, statistics.max_latency);
+
+    printf("All tests passed.\n");
+    return 0;
+}
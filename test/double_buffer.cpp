@@ -0,0 +1,55 @@
+#include <atomic>
+#include <cstdio>
+#include <thread>
+#include <vector>
+#include <glog/logging.h>
+#include "data-structure/double_buffer.h"
+
+constexpr uint64_t kPublishes = 2000000;  ///< Number of values published by the writer.
+constexpr int kReaders = 4;               ///< Number of concurrent readers.
+
+/// \brief Value larger than a word, torn copies have different fields.
+struct Value {
+    uint64_t a, b, c, d;
+};
+
+int main(int argc, char *argv[]) {
+    google::InitGoogleLogging(argv[0]);
+
+    DoubleBuffer<Value> buffer({0, 0, 0, 0});
+    std::atomic<bool> stop_flag(false);
+    std::vector<uint64_t> reads(kReaders, 0);
+    std::vector<std::thread> readers;
+    for (int i = 0; i < kReaders; ++i)
+        readers.emplace_back([&, i]() {
+            uint64_t last_version = 0;
+            Value value{};
+            while (!stop_flag.load(std::memory_order_relaxed)) {
+                const auto version = buffer.Read(value);
+                CHECK(value.a == value.b && value.b == value.c && value.c == value.d) << "Torn value at version "
+                                                                                       << version << ".";
+                CHECK_EQ(value.a, version) << "Value does not match its version.";
+                CHECK_GE(version, last_version) << "Version goes back.";
+                last_version = version;
+                ++reads[i];
+            }
+        });
+
+    // Value i is published as version i.
+    for (uint64_t i = 1; i <= kPublishes; ++i)
+        buffer.Publish({i, i, i, i});
+    stop_flag.store(true, std::memory_order_relaxed);
+    for (auto &reader: readers)
+        reader.join();
+
+    Value value{};
+    CHECK_EQ(buffer.Read(value), kPublishes);
+    CHECK_EQ(buffer.Version(), kPublishes);
+    CHECK_EQ(value.a, kPublishes);
+    uint64_t total_reads = 0;
+    for (auto count: reads)
+        total_reads += count;
+    printf("Passed %lu publishes with %d concurrent readers and %lu reads.\n",
+           (unsigned long) kPublishes, kReaders, (unsigned long) total_reads);
+    return 0;
+}
@@ -0,0 +1,177 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <glog/logging.h>
+#include "predictor-armor/ekf.h"
+#include "predictor-armor/ekf_bank.h"
+#include "predictor-armor/predictor_armor.h"
+
+constexpr int kSteps = 1000;  ///< Frames of each simulated target.
+
+/// \return Max absolute difference of two matrices, relative to the max absolute value of the former.
+template<typename A, typename B>
+double RelativeError(const A &expected, const B &actual) {
+    const auto expected_double = expected.template cast<double>(), actual_double = actual.template cast<double>();
+    return (expected_double - actual_double).cwiseAbs().maxCoeff()
+           / std::max(1.0, expected_double.cwiseAbs().maxCoeff());
+}
+
+/// \brief Closed-form jacobians should match automatic differentiation at random points.
+void TestJacobians(std::mt19937 &generator) {
+    std::uniform_real_distribution<double> position(-8, 8), speed(-3, 3), depth(0.5, 10), delta_t(0.001, 0.5);
+    PredictFunction predict;
+    MeasureFunction measure;
+    for (int i = 0; i < 1000; ++i) {
+        Eigen::Matrix<double, 5, 1> x;
+        x << position(generator), speed(generator), position(generator), speed(generator), depth(generator);
+        predict.delta_t = delta_t(generator);
+
+        ceres::Jet<double, 5> x_jet[5], x_predict_jet[5], y_jet[3];
+        for (int j = 0; j < 5; ++j) {
+            x_jet[j].a = x[j];
+            x_jet[j].v[j] = 1;
+        }
+        predict(x_jet, x_predict_jet);
+        measure(x_jet, y_jet);
+
+        Eigen::Matrix<double, 5, 1> x_predict;
+        Eigen::Matrix<double, 5, 5> predict_jacobian;
+        Eigen::Matrix<double, 3, 1> y;
+        Eigen::Matrix<double, 3, 5> measure_jacobian;
+        predict(x, x_predict, predict_jacobian);
+        measure(x, y, measure_jacobian);
+        for (int j = 0; j < 5; ++j) {
+            CHECK_NEAR(x_predict[j], x_predict_jet[j].a, 1e-12);
+            for (int k = 0; k < 5; ++k)
+                CHECK_NEAR(predict_jacobian(j, k), x_predict_jet[j].v[k], 1e-12) << "at row " << j << ", col " << k;
+        }
+        for (int j = 0; j < 3; ++j) {
+            CHECK_NEAR(y[j], y_jet[j].a, 1e-12);
+            for (int k = 0; k < 5; ++k)
+                CHECK_NEAR(measure_jacobian(j, k), y_jet[j].v[k], 1e-12) << "at row " << j << ", col " << k;
+        }
+    }
+    printf("Passed jacobians at 1000 random points.\n");
+}
+
+/// \brief Analytic filters in double and float should track the same estimates as automatic differentiation.
+void TestFilters(std::mt19937 &generator) {
+    std::uniform_real_distribution<double> position(-3, 3), speed(-2, 2), depth(3, 8), delta_t(0.005, 0.015);
+    std::normal_distribution<double> noise(0, 0.02);
+    PredictFunction predict;
+    MeasureFunction measure;
+
+    for (int run = 0; run < 20; ++run) {
+        ExtendedKalmanFilter<5, 3> jet_ekf;
+        AnalyticExtendedKalmanFilter<double, 5, 3> double_ekf;
+        AnalyticExtendedKalmanFilter<float, 5, 3> float_ekf;
+        Eigen::Matrix<double, 5, 1> x;
+        x << position(generator), speed(generator), position(generator), speed(generator), depth(generator);
+        jet_ekf.Initialize(x);
+        double_ekf.Initialize(x);
+        float_ekf.Initialize(x.cast<float>());
+
+        double max_double_error = 0, max_float_error = 0;
+        for (int i = 0; i < kSteps; ++i) {
+            predict.delta_t = delta_t(generator);
+            Eigen::Matrix<double, 5, 1> x_next;
+            predict(x.data(), x_next.data());
+            x = x_next;
+            Eigen::Matrix<double, 5, 1> x_measured = x;
+            x_measured[0] += noise(generator);
+            x_measured[2] += noise(generator);
+            x_measured[4] += noise(generator);
+            Eigen::Matrix<double, 3, 1> y;
+            measure(x_measured.data(), y.data());
+
+            jet_ekf.Predict(predict);
+            const auto expected = jet_ekf.Update(measure, y);
+            double_ekf.Predict(predict);
+            const auto actual_double = double_ekf.Update(measure, y);
+            float_ekf.Predict(predict);
+            const auto actual_float = float_ekf.Update(measure, Eigen::Matrix<float, 3, 1>(y.cast<float>()));
+
+            max_double_error = std::max(max_double_error, RelativeError(expected, actual_double));
+            max_float_error = std::max(max_float_error, RelativeError(expected, actual_float));
+            CHECK_LT(RelativeError(jet_ekf.status_cov_, double_ekf.status_cov_), 1e-8);
+        }
+        CHECK_LT(max_double_error, 1e-9) << "in run " << run;
+        CHECK_LT(max_float_error, 1e-3) << "in run " << run;
+
+        // Each filter should also follow the target.
+        CHECK_LT(std::abs(double_ekf.x_estimate_[0] - x[0]), 0.2);
+        CHECK_LT(std::abs(double_ekf.x_estimate_[2] - x[2]), 0.2);
+        CHECK_LT(std::abs(double_ekf.x_estimate_[4] - x[4]), 0.2);
+    }
+    printf("Passed filters on 20 targets of %d frames.\n", kSteps);
+}
+
+/// \brief Filters in bank should match separate analytic filters, with missing measurements and removal.
+void TestBank(std::mt19937 &generator) {
+    constexpr unsigned int kFilters = 12;
+    std::uniform_real_distribution<double> position(-3, 3), speed(-2, 2), depth(3, 8), delta_t(0.005, 0.015),
+            uniform(0, 1);
+    std::normal_distribution<double> noise(0, 0.02);
+    PredictFunction predict;
+    MeasureFunction measure;
+
+    EkfBank<double, 16> bank;
+    std::vector<AnalyticExtendedKalmanFilter<double, 5, 3>> filters(kFilters);
+    std::vector<Eigen::Matrix<double, 5, 1>> targets(kFilters);
+    for (unsigned int j = 0; j < kFilters; ++j) {
+        targets[j] << position(generator), speed(generator), position(generator), speed(generator), depth(generator);
+        filters[j].Initialize(targets[j]);
+        CHECK_EQ(bank.Add(targets[j]), int(j));
+    }
+
+    for (int i = 0; i < kSteps; ++i) {
+        predict.delta_t = delta_t(generator);
+        for (unsigned int j = 0; j < filters.size(); ++j) {
+            Eigen::Matrix<double, 5, 1> x_next;
+            predict(targets[j].data(), x_next.data());
+            targets[j] = x_next;
+            filters[j].Predict(predict);
+
+            // Some armors are missing in some frames.
+            if (uniform(generator) < 0.2) {
+                filters[j].x_estimate_ = filters[j].x_predict_;
+                continue;
+            }
+            Eigen::Matrix<double, 5, 1> x_measured = targets[j];
+            x_measured[0] += noise(generator);
+            x_measured[2] += noise(generator);
+            x_measured[4] += noise(generator);
+            Eigen::Matrix<double, 3, 1> y;
+            measure(x_measured.data(), y.data());
+            filters[j].Update(measure, y);
+            bank.SetMeasurement(j, y);
+        }
+        bank.Step(predict.delta_t);
+
+        for (unsigned int j = 0; j < filters.size(); ++j) {
+            CHECK_LT(RelativeError(filters[j].x_estimate_, bank.State(j)), 1e-9) << "of filter " << j;
+            CHECK_LT(RelativeError(filters[j].status_cov_, bank.Covariance(j)), 1e-9) << "of filter " << j;
+        }
+
+        // The last filter takes index of the removed one.
+        if (i == kSteps / 2) {
+            bank.Remove(3);
+            filters[3] = filters.back();
+            targets[3] = targets.back();
+            filters.pop_back();
+            targets.pop_back();
+            CHECK_EQ(bank.Size(), filters.size());
+        }
+    }
+    printf("Passed bank of %u filters on %d frames.\n", kFilters, kSteps);
+}
+
+int main(int argc, char *argv[]) {
+    google::InitGoogleLogging(argv[0]);
+    std::mt19937 generator(0);
+    TestJacobians(generator);
+    TestFilters(generator);
+    TestBank(generator);
+    return 0;
+}
@@ -0,0 +1,75 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+#include <glog/logging.h>
+#include "clock/clock.h"
+#include "predictor-rune/predictor_rune.h"
+
+constexpr int kFrames = 2000;              ///< Frames of the simulated replay.
+constexpr uint64_t kFrameTime = 10000000;  ///< Time between frames in nanoseconds.
+
+/// \brief Predicted outputs of a frame.
+struct Output {
+    cv::Point3f send_yaw_pitch_delay;
+    cv::Point2f predicted_target_point;
+};
+
+/**
+ * \brief Replay a simulated big power rune through rune predictor with frame-driven clock.
+ * \param [in] frame_delay Real time spent on each frame in microseconds, i.e. playback speed.
+ * \param [out] fits Number of finished background fits.
+ * \return Outputs of all frames.
+ */
+std::vector<Output> Replay(int frame_delay, uint64_t &fits) {
+    auto clock = std::make_shared<SimulatedClock>(1000000000);
+    Clock::SetGlobal(clock);
+
+    RunePredictor predictor;
+    CHECK(predictor.Initialize("../config/infantry/rune-predictor-param.yaml"));
+
+    std::mt19937 generator(0);
+    std::normal_distribution<float> noise(0, 0.5f);
+    const cv::Point2f center_r(640, 512), image_center(640, 512);
+    double angle = 0;
+    std::vector<Output> outputs;
+    for (int i = 0; i < kFrames; ++i) {
+        clock->Advance(kFrameTime);
+        const double time = double(i) * double(kFrameTime) * 1e-9;
+        angle += (0.785 * std::sin(1.884 * time) + 2.090 - 0.785) * double(kFrameTime) * 1e-9;
+        const cv::Point2f direction(float(std::cos(angle)), float(-std::sin(angle)));
+        const cv::Point2f rtp_vec = 150 * direction + cv::Point2f(noise(generator), noise(generator));
+        const cv::Point2f rtg_vec = 90 * direction;
+        PowerRune rune(Entity::Colors::kRed, 1, rtp_vec, rtg_vec, center_r, center_r + rtp_vec, center_r + rtg_vec,
+                       {0, 0, 0});
+        predictor.Predict(rune);
+        outputs.push_back({predictor.SendYawPitchDelay(), predictor.PredictedTargetPoint()});
+        if (frame_delay > 0)
+            std::this_thread::sleep_for(std::chrono::microseconds(frame_delay));
+    }
+    fits = predictor.GetFitStatistics().fits;
+
+    Clock::SetGlobal(nullptr);
+    return outputs;
+}
+
+int main(int argc, char *argv[]) {
+    google::InitGoogleLogging(argv[0]);
+
+    // Background fits finish at different frames of a fast replay and a slow replay.
+    uint64_t fast_fits, slow_fits;
+    const auto fast_outputs = Replay(0, fast_fits);
+    const auto slow_outputs = Replay(1000, slow_fits);
+    CHECK_GT(fast_fits, 0);
+    CHECK_GT(slow_fits, 0);
+    for (int i = 0; i < kFrames; ++i) {
+        CHECK(fast_outputs[i].send_yaw_pitch_delay == slow_outputs[i].send_yaw_pitch_delay) << "at frame " << i;
+        CHECK(fast_outputs[i].predicted_target_point == slow_outputs[i].predicted_target_point) << "at frame " << i;
+    }
+    printf("Passed replays at two speeds with %llu background fits in %d frames.\n",
+           (unsigned long long) fast_fits, kFrames);
+    return 0;
+}
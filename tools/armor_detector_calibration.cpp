@@ -0,0 +1,70 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+#include <glog/logging.h>
+#include "image-provider-base/image_provider_factory.h"
+#include "detector-armor/detector_armor_calibration.h"
+
+constexpr int kDefaultFrameStep = 10;  ///< Default interval of sampled frames.
+constexpr size_t kMaxSamples = 100;    ///< Max number of samples, about 74 MB of calibration data.
+
+/**
+ * \brief Sample frames of a video through video image provider.
+ * \param [in] video_init_file Initialization config file of video image provider.
+ * \param [in] frame_step Sample one of every frame_step frames.
+ * \param [in,out] samples Calibration samples, appended.
+ */
+void SampleVideo(const std::string &video_init_file, int frame_step, std::vector<cv::Mat> &samples) {
+    std::unique_ptr<ImageProvider> image_provider(CREATE_IMAGE_PROVIDER("video"));
+    if (!image_provider || !image_provider->Initialize(video_init_file)) {
+        printf("Failed to open video of %s.\n", video_init_file.c_str());
+        return;
+    }
+
+    Frame frame;
+    size_t num_frames = 0, num_samples = 0;
+    while (samples.size() < kMaxSamples && image_provider->GetFrame(frame)) {
+        if (num_frames++ % frame_step || frame.Image().empty())
+            continue;
+        samples.emplace_back();
+        calibration::ToSample(frame.Image(), samples.back());
+        ++num_samples;
+    }
+    printf("Sampled %lu of %lu frames from %s.\n",
+           (unsigned long) num_samples, (unsigned long) num_frames, video_init_file.c_str());
+}
+
+int main(int argc, char *argv[]) {
+    google::InitGoogleLogging(argv[0]);
+    const std::string model_file = argc > 1 ? argv[1] : "../assets/models/armor_detector_model.onnx";
+    const int frame_step = std::max(argc > 2 ? std::atoi(argv[2]) : kDefaultFrameStep, 1);
+    std::vector<std::string> video_init_files;
+    for (int i = 3; i < argc; ++i)
+        video_init_files.emplace_back(argv[i]);
+    if (video_init_files.empty())
+        video_init_files = {"../config/sentry/video-init.yaml"};
+
+    printf("Calibration tool for quantized armor detector.\n");
+    printf("Usage: %s [model file] [frame step] [video init files...]\n", argv[0]);
+    printf("================================================\n");
+
+    std::vector<cv::Mat> samples;
+    for (const auto &video_init_file: video_init_files)
+        SampleVideo(video_init_file, frame_step, samples);
+    if (samples.empty()) {
+        printf("No frame is sampled.\n");
+        return 1;
+    }
+
+    const auto calibration_file = calibration::CalibrationFile(model_file);
+    if (!calibration::Save(calibration_file, samples)) {
+        printf("Failed to save calibration file %s.\n", calibration_file.c_str());
+        return 1;
+    }
+    printf("================================================\n");
+    printf("Saved %lu samples to %s.\n", (unsigned long) samples.size(), calibration_file.c_str());
+    return 0;
+}